@@ -41,7 +41,14 @@ DMD::DMD(byte panelsWide, byte panelsHigh)
     row1 = DisplaysTotal << 4;
     row2 = DisplaysTotal << 5;
     row3 = ((DisplaysTotal << 2) * 3) << 2;
-    bDMDScreenRAM = (byte *)malloc(DisplaysTotal * DMD_RAM_SIZE_BYTES);
+    bDMDScanRAM = (byte *)malloc(DisplaysTotal * DMD_RAM_SIZE_BYTES);
+    bDMDScreenRAM = bDMDScanRAM;
+    bDMDBackRAM = NULL; // allocated on the first beginOffscreen()
+    glyphCache = NULL;  // allocated on the first compressed glyph
+    glyphCacheClock = 0;
+    glyphCacheHits = 0;
+    glyphCacheMisses = 0;
+    transitionStep = 0;
 
     // initialise instance of the SPIClass attached to vspi
     vspi = new SPIClass(VSPI);
@@ -142,9 +149,9 @@ void DMD::drawString(int bX, int bY, const char *bChars, byte length,
     int strWidth = 0;
     this->drawLine(bX - 1, bY, bX - 1, bY + height, GRAPHICS_INVERSE);
 
-    for (int i = 0; i < length; i++)
+    for (int i = 0; i < length;)
     {
-        int charWide = this->drawChar(bX + strWidth, bY, bChars[i], bGraphicsMode);
+        int charWide = this->drawCodePoint(bX + strWidth, bY, nextCodePoint(bChars, length, &i), bGraphicsMode);
         if (charWide > 0)
         {
             strWidth += charWide;
@@ -164,10 +171,9 @@ void DMD::drawMarquee(const char *bChars, byte length, int left, int top)
 {
     marqueeWidth = 0;
     for (int i = 0; i < length; i++)
-    {
         marqueeText[i] = bChars[i];
-        marqueeWidth += charWidth(bChars[i]) + 1;
-    }
+    for (int i = 0; i < length;)
+        marqueeWidth += codePointWidth(this->Font, nextCodePoint(bChars, length, &i)) + 1;
     marqueeHeight = pgm_read_byte(this->Font + FONT_HEIGHT);
     marqueeText[length] = '\0';
     marqueeOffsetY = top;
@@ -226,12 +232,13 @@ boolean DMD::stepMarquee(int amountX, int amountY)
 
         // Redraw last char on screen
         int strWidth = marqueeOffsetX;
-        for (byte i = 0; i < marqueeLength; i++)
+        for (int i = 0; i < marqueeLength;)
         {
-            int wide = charWidth(marqueeText[i]);
+            uint16_t c = nextCodePoint(marqueeText, marqueeLength, &i);
+            int wide = codePointWidth(this->Font, c);
             if (strWidth + wide >= DisplaysWide * DMD_PIXELS_ACROSS)
             {
-                drawChar(strWidth, marqueeOffsetY, marqueeText[i], GRAPHICS_NORMAL);
+                drawCodePoint(strWidth, marqueeOffsetY, c, GRAPHICS_NORMAL);
                 return ret;
             }
             strWidth += wide + 1;
@@ -254,12 +261,13 @@ boolean DMD::stepMarquee(int amountX, int amountY)
 
         // Redraw last char on screen
         int strWidth = marqueeOffsetX;
-        for (byte i = 0; i < marqueeLength; i++)
+        for (int i = 0; i < marqueeLength;)
         {
-            int wide = charWidth(marqueeText[i]);
+            uint16_t c = nextCodePoint(marqueeText, marqueeLength, &i);
+            int wide = codePointWidth(this->Font, c);
             if (strWidth + wide >= 0)
             {
-                drawChar(strWidth, marqueeOffsetY, marqueeText[i], GRAPHICS_NORMAL);
+                drawCodePoint(strWidth, marqueeOffsetY, c, GRAPHICS_NORMAL);
                 return ret;
             }
             strWidth += wide + 1;
@@ -484,10 +492,10 @@ void DMD::scanDisplayBySPI()
         {
 
             vspi->beginTransaction(SPISettings(spiClk, MSBFIRST, SPI_MODE0));
-            vspi->transfer(bDMDScreenRAM[offset + i + row3]);
-            vspi->transfer(bDMDScreenRAM[offset + i + row2]);
-            vspi->transfer(bDMDScreenRAM[offset + i + row1]);
-            vspi->transfer(bDMDScreenRAM[offset + i]);
+            vspi->transfer(bDMDScanRAM[offset + i + row3]);
+            vspi->transfer(bDMDScanRAM[offset + i + row2]);
+            vspi->transfer(bDMDScanRAM[offset + i + row1]);
+            vspi->transfer(bDMDScanRAM[offset + i]);
             vspi->endTransaction();
         }
 
@@ -517,6 +525,103 @@ void DMD::scanDisplayBySPI()
 }
 
 
+/*--------------------------------------------------------------------------------------
+ Redirect all drawing to an offscreen frame while the panel keeps showing the current one.
+ The offscreen frame starts cleared; call presentStep() until it returns true to show it.
+--------------------------------------------------------------------------------------*/
+void DMD::beginOffscreen()
+{
+    if (bDMDBackRAM == NULL)
+    {
+        bDMDBackRAM = (byte *)malloc(DisplaysTotal * DMD_RAM_SIZE_BYTES);
+        if (bDMDBackRAM == NULL)
+            return; // no memory: keep drawing straight to the panel
+    }
+    memset(bDMDBackRAM, 0xFF, DMD_RAM_SIZE_BYTES * DisplaysTotal);
+    bDMDScreenRAM = bDMDBackRAM;
+    transitionStep = 0;
+}
+
+boolean DMD::isOffscreen()
+{
+    return bDMDScreenRAM != bDMDScanRAM;
+}
+
+const byte *DMD::shownFrame()
+{
+    return bDMDScanRAM;
+}
+
+int DMD::frameBytes()
+{
+    return DMD_RAM_SIZE_BYTES * DisplaysTotal;
+}
+
+/*--------------------------------------------------------------------------------------
+ Copy one pixel column of src (srcX outside the display gives a blank column) into
+ column dstX of the scanned RAM
+--------------------------------------------------------------------------------------*/
+void DMD::copyColumn(int dstX, const byte *src, int srcX)
+{
+    int pixelsWide = DMD_PIXELS_ACROSS * DisplaysWide;
+    int pixelsDown = DMD_PIXELS_DOWN * DisplaysHigh;
+    for (int y = 0; y < pixelsDown; y++)
+    {
+        byte panel = (dstX / DMD_PIXELS_ACROSS) + (DisplaysWide * (y / DMD_PIXELS_DOWN));
+        unsigned int bX = (dstX % DMD_PIXELS_ACROSS) + (panel << 5);
+        unsigned int dst = bX / 8 + (y % DMD_PIXELS_DOWN) * (DisplaysTotal << 2);
+        byte dstBit = bPixelLookupTable[bX & 0x07];
+
+        byte off = dstBit; // one bit is pixel off
+        if (srcX >= 0 && srcX < pixelsWide)
+        {
+            panel = (srcX / DMD_PIXELS_ACROSS) + (DisplaysWide * (y / DMD_PIXELS_DOWN));
+            bX = (srcX % DMD_PIXELS_ACROSS) + (panel << 5);
+            unsigned int from = bX / 8 + (y % DMD_PIXELS_DOWN) * (DisplaysTotal << 2);
+            if ((src[from] & bPixelLookupTable[bX & 0x07]) == 0)
+                off = 0;
+        }
+        bDMDScanRAM[dst] = (bDMDScanRAM[dst] & ~dstBit) | off;
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+ Advance the transition from the offscreen frame to the panel by TRANSITION_STEP_PIXELS
+ columns. Returns true once the new frame is fully shown; drawing then goes straight
+ to the panel again. Call it with a short delay in between to animate the transition.
+--------------------------------------------------------------------------------------*/
+boolean DMD::presentStep(byte bTransition)
+{
+    if (!isOffscreen())
+        return true;
+
+    int pixelsWide = DMD_PIXELS_ACROSS * DisplaysWide;
+    transitionStep += TRANSITION_STEP_PIXELS;
+    if (bTransition == TRANSITION_NONE || transitionStep >= pixelsWide)
+    {
+        memcpy(bDMDScanRAM, bDMDBackRAM, DMD_RAM_SIZE_BYTES * DisplaysTotal);
+        bDMDScreenRAM = bDMDScanRAM;
+        return true;
+    }
+
+    switch (bTransition)
+    {
+    case TRANSITION_WIPE: // reveal the new frame left to right
+        for (int x = transitionStep - TRANSITION_STEP_PIXELS; x < transitionStep; x++)
+            copyColumn(x, bDMDBackRAM, x);
+        break;
+    case TRANSITION_SLIDE: // old frame moves out left, new frame follows from the right
+        for (int x = 0; x < pixelsWide; x++)
+        {
+            if (x < pixelsWide - transitionStep)
+                copyColumn(x, bDMDScanRAM, x + TRANSITION_STEP_PIXELS);
+            else
+                copyColumn(x, bDMDBackRAM, x - (pixelsWide - transitionStep));
+        }
+        break;
+    }
+    return false;
+}
 
 void DMD::selectFont(const uint8_t *font)
 {
@@ -524,17 +629,29 @@ void DMD::selectFont(const uint8_t *font)
 }
 
 int DMD::drawChar(const int bX, const int bY, const unsigned char letter, byte bGraphicsMode)
+{
+    return drawCodePoint(bX, bY, letter, bGraphicsMode);
+}
+
+int DMD::drawCodePoint(int bX, int bY, uint16_t codePoint, byte bGraphicsMode)
 {
     if (bX > (DMD_PIXELS_ACROSS * DisplaysWide) || bY > (DMD_PIXELS_DOWN * DisplaysHigh))
         return -1;
-    unsigned char c = letter;
     uint8_t height = pgm_read_byte(this->Font + FONT_HEIGHT);
-    if (c == ' ')
+    if (codePoint == ' ')
     {
         int charWide = charWidth(' ');
         this->drawFilledBox(bX, bY, bX + charWide, bY + height, GRAPHICS_INVERSE);
         return charWide;
     }
+    if (isPackedFont(this->Font))
+    {
+        int glyph = packedGlyphIndex(this->Font, codePoint);
+        return glyph < 0 ? 0 : drawPackedChar(bX, bY, glyph, bGraphicsMode);
+    }
+    if (codePoint > 0xFF)
+        return 0;
+    unsigned char c = codePoint;
     uint8_t width = 0;
     uint8_t bytes = (height + 7) / 8;
 
@@ -598,16 +715,33 @@ int DMD::drawChar(const int bX, const int bY, const unsigned char letter, byte b
 
 int DMD::charWidth(const unsigned char letter)
 {
-    unsigned char c = letter;
+    return charWidth(this->Font, letter);
+}
+
+int DMD::charWidth(const uint8_t *font, const unsigned char letter)
+{
+    return codePointWidth(font, letter);
+}
+
+int DMD::codePointWidth(const uint8_t *font, uint16_t codePoint)
+{
+    if (isPackedFont(font))
+    {
+        if (codePoint == ' ')
+            return pgm_read_byte(font + FONT_PACKED_SPACE);
+        int glyph = packedGlyphIndex(font, codePoint);
+        return glyph < 0 ? 0 : pgm_read_byte(packedEntry(font, glyph, NULL) + 2);
+    }
+    if (codePoint > 0xFF)
+        return 0;
+    unsigned char c = codePoint;
     // Space is often not included in font so use width of 'n'
     if (c == ' ')
         c = 'n';
     uint8_t width = 0;
 
-    uint8_t firstChar = pgm_read_byte(this->Font + FONT_FIRST_CHAR);
-    uint8_t charCount = pgm_read_byte(this->Font + FONT_CHAR_COUNT);
-
-    uint16_t index = 0;
+    uint8_t firstChar = pgm_read_byte(font + FONT_FIRST_CHAR);
+    uint8_t charCount = pgm_read_byte(font + FONT_CHAR_COUNT);
 
     if (c < firstChar || c >= (firstChar + charCount))
     {
@@ -615,15 +749,264 @@ int DMD::charWidth(const unsigned char letter)
     }
     c -= firstChar;
 
-    if (pgm_read_byte(this->Font + FONT_LENGTH) == 0 && pgm_read_byte(this->Font + FONT_LENGTH + 1) == 0)
+    if (pgm_read_byte(font + FONT_LENGTH) == 0 && pgm_read_byte(font + FONT_LENGTH + 1) == 0)
     {
         // zero length is flag indicating fixed width font (array does not contain width data entries)
-        width = pgm_read_byte(this->Font + FONT_FIXED_WIDTH);
+        width = pgm_read_byte(font + FONT_FIXED_WIDTH);
     }
     else
     {
         // variable width font, read width data
-        width = pgm_read_byte(this->Font + FONT_WIDTH_TABLE + c);
+        width = pgm_read_byte(font + FONT_WIDTH_TABLE + c);
     }
     return width;
 }
+
+boolean DMD::isPackedFont(const uint8_t *font)
+{
+    return pgm_read_byte(font + FONT_LENGTH) == FONT_PACKED_MAGIC0 &&
+           pgm_read_byte(font + FONT_LENGTH + 1) == FONT_PACKED_MAGIC1;
+}
+
+/*--------------------------------------------------------------------------------------
+ The UTF-8 character at text[*i], stepping *i past it. Code points past U+FFFF come
+ back as U+FFFD; a byte that does not start a complete, valid sequence is taken as it
+ is, so 8-bit text draws as it always did.
+--------------------------------------------------------------------------------------*/
+uint16_t DMD::nextCodePoint(const char *text, byte length, int *i)
+{
+    const uint8_t *s = (const uint8_t *)text + *i;
+    uint8_t b = s[0];
+    int more = (b >= 0xC2 && b <= 0xDF) ? 1 : (b >= 0xE0 && b <= 0xEF) ? 2 : (b >= 0xF0 && b <= 0xF4) ? 3 : 0;
+    if (!more || *i + more >= length)
+    {
+        (*i)++;
+        return b;
+    }
+    uint32_t codePoint = b & (0x3F >> more);
+    for (int k = 1; k <= more; k++)
+    {
+        if ((s[k] & 0xC0) != 0x80)
+        {
+            (*i)++;
+            return b;
+        }
+        codePoint = (codePoint << 6) | (s[k] & 0x3F);
+    }
+    static const uint32_t smallest[] = {0, 0x80, 0x800, 0x10000};
+    if (codePoint < smallest[more] || (codePoint >= 0xD800 && codePoint <= 0xDFFF) || codePoint > 0x10FFFF)
+    {
+        (*i)++;
+        return b;
+    }
+    *i += more + 1;
+    return codePoint > 0xFFFF ? 0xFFFD : codePoint;
+}
+
+// Entry `glyph` of a packed font's table (offset, advance[, first column, columns]); `data`
+// gets where the glyph data starts
+const uint8_t *DMD::packedEntry(const uint8_t *font, int glyph, const uint8_t **data)
+{
+    uint8_t flags = pgm_read_byte(font + FONT_PACKED_FLAGS);
+    int size = (flags & FONT_PACKED_BBOX) ? 5 : 3;
+    const uint8_t *table = font + FONT_PACKED_TABLE;
+    if (flags & FONT_PACKED_SPARSE)
+    {
+        size += 2; // code point first
+        table = font + FONT_PACKED_HASH + 2;
+    }
+    if (data)
+        *data = table + pgm_read_byte(font + FONT_CHAR_COUNT) * size;
+    return table + glyph * size + ((flags & FONT_PACKED_SPARSE) ? 2 : 0);
+}
+
+// Table index of a code point in a packed font, -1 if it has no glyph. Sparse fonts
+// hash it to a slot (multiplier chosen by tools/font-compiler so no two collide) and
+// check the code point stored there.
+int DMD::packedGlyphIndex(const uint8_t *font, uint16_t codePoint)
+{
+    if (!(pgm_read_byte(font + FONT_PACKED_FLAGS) & FONT_PACKED_SPARSE))
+    {
+        uint8_t first = pgm_read_byte(font + FONT_FIRST_CHAR);
+        if (codePoint < first || codePoint >= first + pgm_read_byte(font + FONT_CHAR_COUNT))
+            return -1;
+        return codePoint - first;
+    }
+    if (codePoint == FONT_PACKED_NO_GLYPH)
+        return -1;
+    uint8_t bits = pgm_read_byte(font + FONT_PACKED_HASH_BITS);
+    uint16_t multiplier = pgm_read_byte(font + FONT_PACKED_HASH) | (pgm_read_byte(font + FONT_PACKED_HASH + 1) << 8);
+    int slot = (uint16_t)((uint32_t)codePoint * multiplier) >> (16 - bits);
+    const uint8_t *entry = packedEntry(font, slot, NULL) - 2;
+    if ((pgm_read_byte(entry) | (pgm_read_byte(entry + 1) << 8)) != codePoint)
+        return -1;
+    return slot;
+}
+
+/*--------------------------------------------------------------------------------------
+ Draw glyph `index` of a packed font a row at a time, straight into the frame bytes.
+ GRAPHICS_NORMAL and GRAPHICS_INVERSE set the whole advance x rows cell like drawChar()
+ does for FontCreator fonts; the other modes only touch the stored columns.
+--------------------------------------------------------------------------------------*/
+int DMD::drawPackedChar(int bX, int bY, unsigned char index, byte bGraphicsMode)
+{
+    const uint8_t *font = this->Font;
+    uint8_t flags = pgm_read_byte(font + FONT_PACKED_FLAGS);
+    boolean bbox = flags & FONT_PACKED_BBOX;
+    const uint8_t *data;
+    const uint8_t *entry = packedEntry(font, index, &data);
+    int advance = pgm_read_byte(entry + 2);
+    int height = pgm_read_byte(font + FONT_HEIGHT);
+    if (bX < -advance || bY < -height || bGraphicsMode > GRAPHICS_NOR)
+        return advance;
+
+    int left = bbox ? pgm_read_byte(entry + 3) : 0;
+    int cols = bbox ? pgm_read_byte(entry + 4) : advance;
+    int rows = pgm_read_byte(font + FONT_PACKED_ROWS);
+    int bytesPerColumn = (rows + 7) / 8;
+    uint16_t offset = pgm_read_byte(entry) | (pgm_read_byte(entry + 1) << 8);
+    if (!(flags & FONT_PACKED_COMPRESSED))
+        data += offset;
+    else if (cols)
+    {
+        data = cachedGlyph(index, data + (offset & ~FONT_PACKED_RLE), offset & FONT_PACKED_RLE, cols, rows);
+        if (!data)
+            return advance;
+    }
+
+    boolean fill = bGraphicsMode == GRAPHICS_NORMAL || bGraphicsMode == GRAPHICS_INVERSE;
+    int x0 = fill ? bX : bX + left;
+    int x1 = fill ? bX + advance : bX + left + cols;
+    int y0 = bY < 0 ? 0 : bY;
+    int y1 = bY + rows;
+    if (x0 < 0)
+        x0 = 0;
+    if (x1 > DMD_PIXELS_ACROSS * DisplaysWide)
+        x1 = DMD_PIXELS_ACROSS * DisplaysWide;
+    if (y1 > DMD_PIXELS_DOWN * DisplaysHigh)
+        y1 = DMD_PIXELS_DOWN * DisplaysHigh;
+
+    for (int y = y0; y < y1; y++)
+    {
+        int r = y - bY;
+        const uint8_t *rowData = data + r / 8;
+        uint8_t rowBit = 1 << (r % 8);
+        byte *line = bDMDScreenRAM + (y % DMD_PIXELS_DOWN) * (DisplaysTotal << 2) +
+                     (y / DMD_PIXELS_DOWN) * DisplaysWide * (DMD_PIXELS_ACROSS / 8);
+        // Up to 56 pixels at a time, MSB first like the frame bytes
+        for (int cx = x0; cx < x1; cx += 56)
+        {
+            int base = cx & ~7, end = cx + 56 < x1 ? cx + 56 : x1;
+            uint64_t bits = 0, cell = 0;
+            for (int x = cx; x < end; x++)
+            {
+                uint64_t pos = 1ULL << (63 - (x - base));
+                cell |= pos;
+                int j = x - bX - left;
+                if (j >= 0 && j < cols && (pgm_read_byte(rowData + j * bytesPerColumn) & rowBit))
+                    bits |= pos;
+            }
+            byte *p = line + base / 8;
+            for (int k = 0; base + 8 * k < end; k++)
+            {
+                byte b = bits >> (56 - 8 * k), m = cell >> (56 - 8 * k);
+                switch (bGraphicsMode)
+                {
+                case GRAPHICS_NORMAL: // zero bit is pixel on
+                    p[k] = (p[k] & ~m) | (~b & m);
+                    break;
+                case GRAPHICS_INVERSE:
+                    p[k] = (p[k] & ~m) | b;
+                    break;
+                case GRAPHICS_TOGGLE:
+                    p[k] ^= b;
+                    break;
+                case GRAPHICS_OR:
+                    p[k] &= ~b;
+                    break;
+                case GRAPHICS_NOR:
+                    p[k] |= b;
+                    break;
+                }
+            }
+        }
+    }
+    return advance;
+}
+
+/*--------------------------------------------------------------------------------------
+ Compressed glyphs: the cols x rows pixels column after column, top row first, either
+ bit-packed (LSB first, no padding between columns) or as nibble runs (low nibble first).
+ Runs alternate unlit/lit starting with unlit; a run of 15 continues in the same colour.
+--------------------------------------------------------------------------------------*/
+void DMD::decodeGlyph(const uint8_t *src, boolean rle, int cols, int rows, byte *dst)
+{
+    int bytesPerColumn = (rows + 7) / 8;
+    int total = cols * rows;
+    memset(dst, 0, cols * bytesPerColumn);
+    int i = 0;
+    if (!rle)
+    {
+        for (; i < total; i++)
+            if (pgm_read_byte(src + i / 8) & (1 << (i % 8)))
+                dst[(i / rows) * bytesPerColumn + (i % rows) / 8] |= 1 << (i % rows % 8);
+        return;
+    }
+    boolean lit = false;
+    for (int nibble = 0; i < total && nibble <= 2 * total; nibble++)
+    {
+        uint8_t b = pgm_read_byte(src + nibble / 2);
+        int run = (nibble & 1) ? b >> 4 : b & 0x0F;
+        if (lit)
+            for (int k = 0; k < run && i < total; k++, i++)
+                dst[(i / rows) * bytesPerColumn + (i % rows) / 8] |= 1 << (i % rows % 8);
+        else
+            i += run;
+        if (run != 15)
+            lit = !lit;
+    }
+}
+
+// Glyph `index` of the selected (compressed) font, decoded; NULL if it is too big to cache
+const byte *DMD::cachedGlyph(unsigned char index, const uint8_t *src, boolean rle, int cols, int rows)
+{
+    if (cols * ((rows + 7) / 8) > GLYPH_CACHE_BYTES)
+        return NULL;
+    if (!glyphCache)
+    {
+        glyphCache = (GlyphCacheSlot *)calloc(GLYPH_CACHE_SLOTS, sizeof(GlyphCacheSlot));
+        if (!glyphCache)
+            return NULL;
+    }
+    GlyphCacheSlot *oldest = glyphCache;
+    for (int i = 0; i < GLYPH_CACHE_SLOTS; i++)
+    {
+        GlyphCacheSlot *slot = glyphCache + i;
+        if (slot->font == this->Font && slot->index == index)
+        {
+            slot->used = ++glyphCacheClock;
+            glyphCacheHits++;
+            return slot->data;
+        }
+        if (slot->used < oldest->used)
+            oldest = slot;
+    }
+    glyphCacheMisses++;
+    decodeGlyph(src, rle, cols, rows, oldest->data);
+    oldest->font = this->Font;
+    oldest->index = index;
+    oldest->used = ++glyphCacheClock;
+    return oldest->data;
+}
+
+void DMD::flushGlyphCache()
+{
+    if (glyphCache)
+        memset(glyphCache, 0, GLYPH_CACHE_SLOTS * sizeof(GlyphCacheSlot));
+}
+
+void DMD::glyphCacheStats(uint32_t *hits, uint32_t *misses)
+{
+    *hits = glyphCacheHits;
+    *misses = glyphCacheMisses;
+}
@@ -107,6 +107,12 @@ LED Panel Layout in RAM
 #define PATTERN_STRIPE_0	2
 #define PATTERN_STRIPE_1	3
 
+//present() transitions from the offscreen frame to the panel
+#define TRANSITION_NONE	0
+#define TRANSITION_WIPE	1      //new frame is revealed left to right
+#define TRANSITION_SLIDE	2      //new frame pushes the old one out to the left
+#define TRANSITION_STEP_PIXELS	4      //columns moved per presentStep() call
+
 //display screen (and subscreen) sizing
 #define DMD_PIXELS_ACROSS	32      //pixels across x axis (base 2 size expected)
 #define DMD_PIXELS_DOWN	16      //pixels down y axis
@@ -134,8 +140,38 @@ static byte bPixelLookupTable[8] __attribute__((unused)) =
 #define FONT_CHAR_COUNT 	5
 #define FONT_WIDTH_TABLE	6
 
+// Packed fonts (tools/font-compiler): FONT_HEIGHT, FONT_FIRST_CHAR and FONT_CHAR_COUNT as
+// above, so drawString() and the marquee take either kind. A glyph table gives each glyph's
+// data offset directly; glyph data is column masks, bit 0 = top row, (rows + 7) / 8 bytes
+// per column, little endian.
+#define FONT_PACKED_MAGIC0	0xFF	//at FONT_LENGTH, never a FontCreator size
+#define FONT_PACKED_MAGIC1	0x50
+#define FONT_PACKED_FLAGS	2
+#define FONT_PACKED_ROWS	6	//rows of a glyph cell
+#define FONT_PACKED_SPACE	7	//advance of ' '
+#define FONT_PACKED_TABLE	8	//per glyph: offset (uint16 LE, from the end of the table), advance
+#define FONT_PACKED_BBOX	0x01	//flag: table also has first stored column, stored columns
+#define FONT_PACKED_COMPRESSED	0x02	//flag: glyph data compressed, see DMD::decodeGlyph()
+#define FONT_PACKED_RLE		0x8000	//compressed: offset bit set = nibble runs, clear = bit-packed
+#define FONT_PACKED_SPARSE	0x04	//flag: glyphs by code point, hashed (UTF-8 text)
+#define FONT_PACKED_HASH_BITS	4	//sparse: at FONT_FIRST_CHAR; FONT_CHAR_COUNT = 1 << bits slots
+#define FONT_PACKED_HASH	8	//sparse: multiplier (uint16 LE), then the table, each entry led by its code point
+#define FONT_PACKED_NO_GLYPH	0xFFFF	//sparse: code point of an empty slot
+
+//Decoded glyphs of compressed fonts are kept in RAM, least recently used evicted
+#define GLYPH_CACHE_SLOTS	16
+#define GLYPH_CACHE_BYTES	64	//columns x (rows + 7) / 8, the most a compressed glyph may decode to
+
 typedef uint8_t (*FontCallback)(const uint8_t*);
 
+struct GlyphCacheSlot
+{
+  const uint8_t* font;
+  uint8_t index;
+  uint32_t used;
+  byte data[GLYPH_CACHE_BYTES];
+};
+
 
 //The main class of DMD library functions
 class DMD
@@ -157,9 +193,33 @@ class DMD
   //Draw a single character
   int drawChar(const int bX, const int bY, const unsigned char letter, byte bGraphicsMode);
 
+  //Draw a single character given by its Unicode code point (sparse packed fonts go past 0xFF)
+  int drawCodePoint(int bX, int bY, uint16_t codePoint, byte bGraphicsMode);
+
   //Find the width of a character
   int charWidth(const unsigned char letter);
 
+  //Find the width of a character in the given font (no selected font needed)
+  static int charWidth(const uint8_t* font, const unsigned char letter);
+
+  //Find the width of a code point in the given font
+  static int codePointWidth(const uint8_t* font, uint16_t codePoint);
+
+  //Is the font in the packed layout (FONT_PACKED_*)
+  static boolean isPackedFont(const uint8_t* font);
+
+  //Decode the UTF-8 character at text[*i] and step past it (drawString and the marquee take UTF-8)
+  static uint16_t nextCodePoint(const char* text, byte length, int* i);
+
+  //Forget the decoded glyphs of compressed fonts (they are kept by font address)
+  void flushGlyphCache();
+
+  //Glyph cache hits and misses since the start
+  void glyphCacheStats(uint32_t* hits, uint32_t* misses);
+
+  //Decode one compressed glyph of cols x rows pixels into column masks, (rows + 7) / 8 bytes each
+  static void decodeGlyph(const uint8_t* src, boolean rle, int cols, int rows, byte* dst);
+
   //Draw a scrolling string
   void drawMarquee( const char* bChars, byte length, int left, int top);
 
@@ -189,12 +249,36 @@ class DMD
   //Insert the calls to this function into the main loop for the highest call rate, or from a timer interrupt
   void scanDisplayBySPI();
 
+  //Redirect all drawing to an offscreen frame while the panel keeps showing the current one
+  void beginOffscreen();
+
+  //Advance the transition from the offscreen frame to the panel by one step.
+  //Returns true once the new frame is fully shown and drawing is back on screen.
+  boolean presentStep( byte bTransition );
+
+  //Is drawing currently going to the offscreen frame
+  boolean isOffscreen();
+
+  //The frame the panel is showing (one bit per pixel, 0 = lit) and its size in bytes
+  const byte *shownFrame();
+  int frameBytes();
+
 
   private:
     void drawCircleSub( int cx, int cy, int x, int y, byte bGraphicsMode );
+    void copyColumn( int dstX, const byte *src, int srcX );
+    int drawPackedChar( int bX, int bY, unsigned char index, byte bGraphicsMode );
+    static const uint8_t *packedEntry( const uint8_t *font, int glyph, const uint8_t **data );
+    static int packedGlyphIndex( const uint8_t *font, uint16_t codePoint );
+    const byte *cachedGlyph( unsigned char index, const uint8_t *src, boolean rle, int cols, int rows );
 
     //Mirror of DMD pixels in RAM, ready to be clocked out by the main loop or high speed timer calls
+    byte *bDMDScanRAM;
+
+    //Buffer all drawing goes to: bDMDScanRAM normally, bDMDBackRAM while offscreen
     byte *bDMDScreenRAM;
+    byte *bDMDBackRAM;
+    int transitionStep;
 
     //Marquee values
     char marqueeText[256];
@@ -206,6 +290,12 @@ class DMD
 
     //Pointer to current font
     const uint8_t* Font;
+
+    //Decoded glyphs of compressed fonts, allocated on the first one drawn
+    GlyphCacheSlot *glyphCache;
+    uint32_t glyphCacheClock;
+    uint32_t glyphCacheHits;
+    uint32_t glyphCacheMisses;
     
 
     //Display information
@@ -0,0 +1,191 @@
+/*--------------------------------------------------------------------------------------
+ Arduino.h - host (Linux) stand-in for the ESP32 Arduino core, used by [env:native].
+ Only what this project calls is provided. Time comes from the host clock.
+--------------------------------------------------------------------------------------*/
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x02
+#define INPUT_PULLUP 0x05
+#define OUTPUT_OPEN_DRAIN 0x12
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+#define SS 5
+#define IRAM_ATTR
+
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+double ledcSetup(uint8_t channel, double freq, uint8_t resolution_bits);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcWrite(uint8_t channel, uint32_t duty);
+
+// Simulated devices on the pins: the write hook sees every digitalWrite(), the read hook
+// gives the level digitalRead() returns (`level` is what the pin was last driven to).
+// Wire's stuck-SDA model uses them.
+typedef void (*PinWriteHook)(uint8_t pin, uint8_t val);
+typedef int (*PinReadHook)(uint8_t pin, int level);
+extern PinWriteHook pinWriteHook;
+extern PinReadHook pinReadHook;
+
+// GPIO output set/clear registers, written directly by the DMD32 scan macros.
+// A write updates GPIO.out and is reported to the hook, so host tools can watch the pins.
+typedef void (*GPIOWriteHook)(uint32_t setMask, uint32_t clearMask);
+
+struct gpio_w1_reg
+{
+    bool set; // w1ts, else w1tc
+    gpio_w1_reg &operator=(uint32_t mask);
+};
+
+struct gpio_dev_t
+{
+    volatile uint32_t out;
+    gpio_w1_reg out_w1ts{true};
+    gpio_w1_reg out_w1tc{false};
+    static GPIOWriteHook hook;
+};
+extern gpio_dev_t GPIO;
+
+// System time runs on the shim's clock (sntp.cpp), which SNTP steps and virtual time moves
+int nativeGettimeofday(struct timeval *tv, void *tz);
+int nativeSettimeofday(const struct timeval *tv, const void *tz);
+#define gettimeofday(tv, tz) nativeGettimeofday(tv, tz)
+#define settimeofday(tv, tz) nativeSettimeofday(tv, tz)
+
+// esp32-hal-time: configTime() restarts SNTP (lwip/apps/sntp.h)
+void configTime(long gmtOffset_sec, int daylightOffset_sec, const char *server1,
+                const char *server2 = nullptr, const char *server3 = nullptr);
+void configTzTime(const char *tz, const char *server1,
+                  const char *server2 = nullptr, const char *server3 = nullptr);
+bool getLocalTime(struct tm *info, uint32_t ms = 5000);
+
+// Minimal Arduino String over std::string
+class String
+{
+public:
+    String() {}
+    String(const char *s) : str(s ? s : "") {}
+    String(const std::string &s) : str(s) {}
+    String(int v) : str(std::to_string(v)) {}
+    String(unsigned int v) : str(std::to_string(v)) {}
+    String(long v) : str(std::to_string(v)) {}
+    String(unsigned long v) : str(std::to_string(v)) {}
+    const char *c_str() const { return str.c_str(); }
+    unsigned int length() const { return str.size(); }
+    long toInt() const { return strtol(str.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(str.c_str(), nullptr); }
+    bool equals(const char *s) const { return str == s; }
+    bool operator==(const char *s) const { return str == s; }
+    bool operator==(const String &s) const { return str == s.str; }
+    bool operator!=(const char *s) const { return str != s; }
+    String &operator+=(const String &s) { str += s.str; return *this; }
+    String &operator+=(const char *s) { str += s; return *this; }
+    String &operator+=(char c) { str += c; return *this; }
+    friend String operator+(const String &a, const String &b) { return String(a.str + b.str); }
+    char operator[](unsigned int i) const { return i < str.size() ? str[i] : 0; }
+    int indexOf(char c, unsigned int from = 0) const
+    {
+        size_t p = str.find(c, from);
+        return p == std::string::npos ? -1 : (int)p;
+    }
+    String substring(unsigned int from, unsigned int to = 0xFFFFFFFF) const
+    {
+        if (from > str.size())
+            return String();
+        return String(str.substr(from, to == 0xFFFFFFFF ? std::string::npos : to - from));
+    }
+
+private:
+    std::string str;
+};
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    size_t print(const char *s) { return write(s); }
+    size_t print(const std::string &s) { return write(s.c_str()); }
+    size_t print(const String &s) { return write(s.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int n) { return printf("%d", n); }
+    size_t print(unsigned int n) { return printf("%u", n); }
+    size_t print(long n) { return printf("%ld", n); }
+    size_t print(unsigned long n) { return printf("%lu", n); }
+    size_t print(long long n) { return printf("%lld", n); }
+    size_t print(unsigned long long n) { return printf("%llu", n); }
+    size_t print(double n, int digits = 2) { return printf("%.*f", digits, n); }
+    template <typename T>
+    size_t println(const T &v) { return print(v) + println(); }
+    size_t println(double n, int digits) { return print(n, digits) + println(); }
+    size_t println() { return write((uint8_t)'\n'); }
+};
+
+class HardwareSerial : public Print
+{
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int available() { return 0; }
+    int read() { return -1; }
+};
+extern HardwareSerial Serial;
+
+class EspClass
+{
+public:
+    void restart();
+    uint32_t getFreeHeap() { return 320 * 1024; }
+    uint32_t getCycleCount();
+    uint64_t getEfuseMac();
+};
+extern EspClass ESP;
+
+// Host entry points: shim main() runs setup() once and loop() forever
+void setup();
+void loop();
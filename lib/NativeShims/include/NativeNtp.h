@@ -0,0 +1,37 @@
+/*--------------------------------------------------------------------------------------
+ NativeNtp.h - an NTP server stand-in on 127.0.0.1 for host tests. It answers SNTP
+ requests with the shim's own clock shifted by `offsetUs`, and can hold each request and
+ reply to give the path a chosen (and lopsided) delay. Point the firmware's SNTP client
+ at it with nativeSntpServer("127.0.0.1", port). Delays are host time: use it with
+ virtual time off.
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+// Reference clock the stand-in serves: UTC microseconds, never stepped by the firmware
+int64_t nativeTrueMicros();
+// System time as gettimeofday() gives it, UTC microseconds
+int64_t nativeSystemMicros();
+
+class NativeNtpServer
+{
+public:
+    ~NativeNtpServer() { stop(); }
+    // Listen on an ephemeral port. Returns it, 0 on failure.
+    uint16_t start();
+    void stop();
+
+    std::atomic<int64_t> offsetUs{0};        // served time minus nativeTrueMicros()
+    std::atomic<uint32_t> requestDelayMs{0}; // client to server
+    std::atomic<uint32_t> replyDelayMs{0};   // server to client
+    std::atomic<bool> silent{false};         // drop every request
+    std::atomic<uint32_t> requests{0};       // received, answered or not
+
+private:
+    void serve();
+    int fd = -1;
+    std::atomic<bool> running{false};
+    std::thread thread;
+};
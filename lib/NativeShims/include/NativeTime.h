@@ -0,0 +1,28 @@
+/*--------------------------------------------------------------------------------------
+ NativeTime.h - virtual time for host tools. Call nativeVirtualTime() first thing in
+ main(), before any task is created: main() becomes a task itself, and from then on
+ millis(), micros(), esp_timer_get_time() and the tick count follow a virtual clock that
+ only moves while every task is blocked (see freertos.cpp). vTaskDelay() from main()
+ is how a tool lets the firmware run for a while.
+
+ Each task's turns and the host CPU time spent in them are counted
+ (nativeTaskUsage()); with one task running at a time, that is its own work.
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+void nativeVirtualTime();
+bool nativeVirtualTimeOn();
+int64_t nativeVirtualMicros();
+// Busy-wait in virtual time (delayMicroseconds): the clock moves, no other task runs
+void nativeVirtualBusy(int64_t us);
+
+struct NativeTaskUsage
+{
+    uint64_t turns; // times the task got the CPU
+    int64_t cpuNs;  // host CPU time used in them
+};
+// False unless virtual time is on
+bool nativeTaskUsage(TaskHandle_t task, NativeTaskUsage &usage);
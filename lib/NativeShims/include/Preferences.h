@@ -0,0 +1,35 @@
+/*--------------------------------------------------------------------------------------
+ Preferences.h - host stand-in for the ESP32 NVS Preferences store (in memory).
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include "Arduino.h"
+
+class Preferences
+{
+public:
+    bool begin(const char *name, bool readOnly = false);
+    void end() {}
+    bool clear();
+    bool remove(const char *key);
+    bool isKey(const char *key);
+
+    size_t putChar(const char *key, int8_t value);
+    int8_t getChar(const char *key, int8_t defaultValue = 0);
+    size_t putInt(const char *key, int32_t value);
+    int32_t getInt(const char *key, int32_t defaultValue = 0);
+    size_t putUShort(const char *key, uint16_t value);
+    uint16_t getUShort(const char *key, uint16_t defaultValue = 0);
+    size_t putUInt(const char *key, uint32_t value);
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0);
+    size_t putFloat(const char *key, float value);
+    float getFloat(const char *key, float defaultValue = NAN);
+    size_t putBool(const char *key, bool value);
+    bool getBool(const char *key, bool defaultValue = false);
+    size_t putString(const char *key, const char *value);
+    size_t getString(const char *key, char *value, size_t maxLen);
+    size_t putBytes(const char *key, const void *value, size_t len);
+    size_t getBytes(const char *key, void *buf, size_t maxLen);
+
+private:
+    std::string ns;
+};
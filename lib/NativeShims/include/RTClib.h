@@ -0,0 +1,59 @@
+/*--------------------------------------------------------------------------------------
+ RTClib.h - host stand-in for the Adafruit RTClib subset used here. RTC_DS3231 talks to
+ the simulated DS3231 through Wire exactly like the real library.
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include "Arduino.h"
+#include "Wire.h"
+
+#define DS3231_ADDRESS 0x68
+#define SECONDS_FROM_1970_TO_2000 946684800
+
+class TimeSpan;
+
+class DateTime
+{
+public:
+    DateTime(uint32_t t = SECONDS_FROM_1970_TO_2000);
+    DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0);
+    DateTime(const char *date, const char *time);
+
+    uint16_t year() const { return 2000U + yOff; }
+    uint8_t month() const { return m; }
+    uint8_t day() const { return d; }
+    uint8_t hour() const { return hh; }
+    uint8_t minute() const { return mm; }
+    uint8_t second() const { return ss; }
+    uint8_t dayOfTheWeek() const;
+    uint32_t unixtime() const;
+    bool isValid() const;
+
+    DateTime operator+(const TimeSpan &span) const;
+    DateTime operator-(const TimeSpan &span) const;
+
+protected:
+    uint8_t yOff, m, d, hh, mm, ss;
+};
+
+class TimeSpan
+{
+public:
+    TimeSpan(int32_t seconds = 0) : _seconds(seconds) {}
+    int32_t totalseconds() const { return _seconds; }
+
+protected:
+    int32_t _seconds;
+};
+
+class RTC_DS3231
+{
+public:
+    bool begin(TwoWire *wireInstance = &Wire);
+    void adjust(const DateTime &dt);
+    bool lostPower();
+    DateTime now();
+    float getTemperature();
+
+private:
+    TwoWire *wire = &Wire;
+};
@@ -0,0 +1,50 @@
+/*--------------------------------------------------------------------------------------
+ SPI.h - host stand-in for the ESP32 SPIClass. Transfers are counted, not sent anywhere.
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include "Arduino.h"
+
+#define VSPI 3
+#define HSPI 2
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0
+
+class SPISettings
+{
+public:
+    SPISettings(uint32_t clock = 1000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0)
+        : clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+    uint32_t clock;
+    uint8_t bitOrder;
+    uint8_t dataMode;
+};
+
+// Called for every byte shifted out, so host tools can watch the bus
+typedef void (*SPITransferHook)(uint8_t data, uint32_t clock);
+
+class SPIClass
+{
+public:
+    explicit SPIClass(uint8_t bus = HSPI) : bus(bus) {}
+    void begin() {}
+    void end() {}
+    void beginTransaction(SPISettings settings) { current = settings; transactions++; }
+    void endTransaction() {}
+    uint8_t transfer(uint8_t data)
+    {
+        bytesOut++;
+        if (hook)
+            hook(data, current.clock);
+        return 0;
+    }
+
+    static SPITransferHook hook;
+    static uint32_t transactions;
+    static uint32_t bytesOut;
+
+private:
+    uint8_t bus;
+    SPISettings current;
+};
+extern SPIClass SPI;
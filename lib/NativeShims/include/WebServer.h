@@ -0,0 +1,71 @@
+/*--------------------------------------------------------------------------------------
+ WebServer.h - host stand-in for the ESP32 synchronous WebServer. Serves real HTTP/1.0
+ over a non-blocking loopback socket; handleClient() handles at most one request.
+ The port can be moved with the WEBSERVER_PORT environment variable.
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include <functional>
+#include <map>
+#include <vector>
+#include "Arduino.h"
+
+enum HTTPMethod
+{
+    HTTP_ANY,
+    HTTP_GET,
+    HTTP_POST,
+    HTTP_PUT,
+    HTTP_DELETE
+};
+
+class WebServer
+{
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    explicit WebServer(int port = 80) : port(port) {}
+    ~WebServer() { close(); }
+
+    void begin();
+    void close();
+    void handleClient();
+
+    void on(const String &uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void on(const String &uri, HTTPMethod method, THandlerFunction handler)
+    {
+        routes.push_back({uri.c_str(), method, handler});
+    }
+    void onNotFound(THandlerFunction handler) { notFound = handler; }
+
+    String uri() { return String(reqUri); }
+    HTTPMethod method() { return reqMethod; }
+    String arg(const String &name);
+    String arg(int i);
+    String argName(int i);
+    int args() { return argList.size(); }
+    bool hasArg(const String &name);
+    void sendHeader(const String &name, const String &value, bool first = false);
+    void send(int code, const char *contentType = NULL, const String &content = String(""));
+    void send(int code, const String &contentType, const String &content) { send(code, contentType.c_str(), content); }
+
+    // Simulation/statistics
+    uint32_t requestsHandled = 0;
+
+private:
+    struct Route
+    {
+        std::string uri;
+        HTTPMethod method;
+        THandlerFunction handler;
+    };
+    int port;
+    int listenFd = -1;
+    int clientFd = -1;
+    std::vector<Route> routes;
+    THandlerFunction notFound;
+    std::string reqUri;
+    HTTPMethod reqMethod = HTTP_GET;
+    std::vector<std::pair<std::string, std::string>> argList;
+    std::string extraHeaders;
+    bool responded = false;
+};
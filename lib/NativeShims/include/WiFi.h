@@ -0,0 +1,66 @@
+/*--------------------------------------------------------------------------------------
+ WiFi.h - host stand-in for the ESP32 WiFi station. The link is a small state machine:
+ begin() connects after connectDelayMs, unless the link is marked unavailable.
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include "Arduino.h"
+
+typedef enum
+{
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} wifi_mode_t;
+
+typedef enum
+{
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+class IPAddress
+{
+public:
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : bytes{a, b, c, d} {}
+    uint8_t operator[](int i) const { return bytes[i]; }
+    uint8_t &operator[](int i) { return bytes[i]; }
+    bool fromString(const char *s);
+    std::string toString() const;
+    uint32_t toUint32() const { return (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 | (uint32_t)bytes[2] << 8 | bytes[3]; }
+
+private:
+    uint8_t bytes[4];
+};
+
+class WiFiClass
+{
+public:
+    bool mode(wifi_mode_t m);
+    wifi_mode_t getMode() { return currentMode; }
+    wl_status_t begin();
+    wl_status_t begin(const char *ssid, const char *passphrase = nullptr);
+    bool disconnect(bool wifioff = false);
+    wl_status_t status();
+    bool setSleep(bool enable) { sleepEnabled = enable; return true; }
+    bool getSleep() { return sleepEnabled; }
+    IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+    IPAddress broadcastIP() { return IPAddress(127, 255, 255, 255); }
+    int8_t RSSI() { return -55; }
+
+    // Simulation controls
+    bool linkAvailable = true;
+    uint32_t connectDelayMs = 1500;
+    uint32_t beginCalls = 0;
+
+private:
+    wifi_mode_t currentMode = WIFI_OFF;
+    bool connecting = false;
+    unsigned long connectStart = 0;
+    bool sleepEnabled = false;
+};
+extern WiFiClass WiFi;
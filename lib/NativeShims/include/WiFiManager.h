@@ -0,0 +1,58 @@
+/*--------------------------------------------------------------------------------------
+ WiFiManager.h - host stand-in for tzapu/WiFiManager. The portal never receives
+ credentials unless simulateSave() is called.
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include "WiFi.h"
+
+class WiFiManagerParameter
+{
+public:
+    WiFiManagerParameter(const char *id, const char *label, const char *defaultValue, int length)
+        : id(id), label(label), value(defaultValue ? defaultValue : ""), length(length) {}
+    const char *getID() const { return id; }
+    const char *getValue() const { return value.c_str(); }
+    int getValueLength() const { return length; }
+    // Simulation control: pretend the user typed into the field
+    void setValue(const char *v, int len) { value = std::string(v).substr(0, len); }
+
+private:
+    const char *id;
+    const char *label;
+    std::string value;
+    int length;
+};
+
+class WiFiManager
+{
+public:
+    void addParameter(WiFiManagerParameter *p) { params.push_back(p); }
+    std::vector<WiFiManagerParameter *> params;
+    void setClass(const char *) {}
+    void setTitle(const char *) {}
+    void setConnectTimeout(unsigned long seconds) { connectTimeout = seconds; }
+    void setCustomHeadElement(const char *) {}
+    void setMenu(std::vector<const char *> &) {}
+    void setConfigPortalTimeout(unsigned long seconds) { portalTimeout = seconds; }
+    void setConfigPortalBlocking(bool shouldBlock) { blocking = shouldBlock; }
+    void setSaveConfigCallback(std::function<void()> func) { saveCallback = func; }
+    bool startConfigPortal(const char *apName, const char *apPassword = nullptr);
+    bool process();
+    bool stopConfigPortal();
+    bool getConfigPortalActive() { return active; }
+
+    // Simulation control: pretend the user submitted credentials
+    void simulateSave() { pendingSave = true; }
+
+private:
+    unsigned long connectTimeout = 0;
+    unsigned long portalTimeout = 0;
+    unsigned long portalStart = 0;
+    bool blocking = true;
+    bool active = false;
+    bool pendingSave = false;
+    std::function<void()> saveCallback;
+};
@@ -0,0 +1,36 @@
+/*--------------------------------------------------------------------------------------
+ WiFiUdp.h - host stand-in for the ESP32 WiFiUDP class over a real UDP socket.
+ Packets to 255.255.255.255 go to the loopback broadcast address, so every process
+ on the host listening on the port gets a copy.
+ As on the ESP32, parsePacket() returns 0 while the last packet is not yet read to the
+ end; read() to the end or flush() it to get the next one.
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include "Arduino.h"
+#include "WiFi.h"
+#include <vector>
+
+class WiFiUDP
+{
+public:
+    ~WiFiUDP() { stop(); }
+    uint8_t begin(uint16_t port);
+    void stop();
+    int beginPacket(IPAddress ip, uint16_t port);
+    size_t write(const uint8_t *buf, size_t size);
+    int endPacket();
+    int parsePacket();
+    int read(uint8_t *buf, size_t len);
+    int available() { return rx.size() - rxPos; }
+    void flush();
+    IPAddress remoteIP() { return remote; }
+    uint16_t remotePort() { return remotePortNum; }
+
+private:
+    bool open();
+    int fd = -1;
+    IPAddress destIp, remote;
+    uint16_t destPort = 0, remotePortNum = 0;
+    std::vector<uint8_t> packet, rx;
+    size_t rxPos = 0;
+};
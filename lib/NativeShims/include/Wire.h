@@ -0,0 +1,97 @@
+/*--------------------------------------------------------------------------------------
+ Wire.h - host stand-in for the ESP32 TwoWire driver. Slaves are simulated devices
+ attached by address; a fault hook lets tools inject NACKs and timeouts, and
+ sdaHeldPulses a slave that holds SDA low until the bus is recovered.
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include "Arduino.h"
+
+#define I2C_BUFFER_LENGTH 128
+
+// A register-level device on the simulated bus
+class I2CDevice
+{
+public:
+    virtual ~I2CDevice() {}
+    // Master wrote bytes (first byte is usually the register pointer)
+    virtual bool onWrite(const uint8_t *data, size_t len) = 0;
+    // Master reads len bytes from the current register pointer
+    virtual size_t onRead(uint8_t *data, size_t len) = 0;
+};
+
+// What the fault hook makes of a transfer
+enum I2CFault : uint8_t
+{
+    I2C_FAULT_NONE,
+    I2C_FAULT_NACK,   // address NACK
+    I2C_FAULT_TIMEOUT // no response: fails once the bus timeout (setTimeOut()) has passed
+};
+typedef I2CFault (*I2CFaultHook)(uint8_t address, bool isRead);
+
+class TwoWire
+{
+public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+    void end() {}
+    bool setClock(uint32_t frequency);
+    uint32_t getClock() { return clock; }
+    void setTimeOut(uint16_t timeOutMillis) { timeout = timeOutMillis; }
+
+    void beginTransmission(uint8_t address);
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t quantity);
+    int available();
+    int read();
+
+    // Simulation controls
+    void attach(uint8_t address, I2CDevice *device);
+    I2CFaultHook faultHook = nullptr;
+    // A slave holding SDA low: every transfer times out until SCL has been pulsed this
+    // many times by hand (digitalWrite on the SCL pin, as a bus recovery does)
+    uint8_t sdaHeldPulses = 0;
+    uint32_t transfers = 0;
+    uint32_t bytesOnBus = 0;
+    uint32_t timeouts = 0;
+
+private:
+    I2CFault fault(uint8_t address, bool isRead);
+    static void pinWrite(uint8_t pin, uint8_t val);
+    static int pinRead(uint8_t pin, int level);
+    int sdaPin = 21, sclPin = 22; // ESP32 defaults
+    uint8_t sclLevel = 1;
+    I2CDevice *devices[128] = {};
+    uint32_t clock = 100000;
+    uint16_t timeout = 50;
+    uint8_t txAddress = 0;
+    uint8_t txBuffer[I2C_BUFFER_LENGTH];
+    size_t txLength = 0;
+    uint8_t rxBuffer[I2C_BUFFER_LENGTH];
+    size_t rxLength = 0;
+    size_t rxIndex = 0;
+};
+extern TwoWire Wire;
+
+// DS3231 register model attached at 0x68 by default. Runs from the host clock with an
+// optional frequency error so drift and aging-offset trimming can be exercised.
+class DS3231Sim : public I2CDevice
+{
+public:
+    DS3231Sim();
+    bool onWrite(const uint8_t *data, size_t len) override;
+    size_t onRead(uint8_t *data, size_t len) override;
+
+    double driftPpm = 0;  // oscillator error before the aging trim
+    double tempC = 25.25; // reported on-chip temperature
+    uint8_t regs[0x13];
+    uint32_t registerWrites = 0;
+
+private:
+    void sync();
+    uint8_t pointer = 0;
+    int64_t baseUnix = 946684800; // 2000-01-01
+    double baseFrac = 0;
+    uint64_t baseUs = 0;
+};
+extern DS3231Sim ds3231Sim;
@@ -0,0 +1,7 @@
+/*--------------------------------------------------------------------------------------
+ esp_timer.h - host stand-in: microseconds since boot, 64 bit.
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include <stdint.h>
+
+int64_t esp_timer_get_time();
@@ -0,0 +1,44 @@
+/*--------------------------------------------------------------------------------------
+ FreeRTOS.h - host stand-in for the ESP32 FreeRTOS port. Tasks run as std::threads,
+ ticks are milliseconds of host time.
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define errQUEUE_FULL 0
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t)(((TickType_t)(xTimeInMs) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define portYIELD() taskYIELD()
+
+// Critical sections: a spinlock per mux, as on the ESP32 SMP port
+#ifdef __cplusplus
+#include <atomic>
+struct portMUX_TYPE
+{
+    portMUX_TYPE(int = 0) {}
+    std::atomic_flag locked = ATOMIC_FLAG_INIT;
+};
+inline void portEnterCritical(portMUX_TYPE *mux)
+{
+    while (mux->locked.test_and_set(std::memory_order_acquire))
+        ;
+}
+inline void portExitCritical(portMUX_TYPE *mux) { mux->locked.clear(std::memory_order_release); }
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) portEnterCritical(mux)
+#define portEXIT_CRITICAL(mux) portExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux) portEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux) portExitCritical(mux)
+#endif
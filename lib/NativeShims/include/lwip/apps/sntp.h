@@ -0,0 +1,28 @@
+/*--------------------------------------------------------------------------------------
+ lwip/apps/sntp.h - host stand-in for the lwIP SNTP client of ESP-IDF. configTime()
+ restarts it; see sntp.cpp for where the time comes from.
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include <stdint.h>
+#include <sys/time.h>
+
+typedef enum
+{
+    SNTP_SYNC_STATUS_RESET,      // no sync since the status was last read
+    SNTP_SYNC_STATUS_COMPLETED,  // time was set
+    SNTP_SYNC_STATUS_IN_PROGRESS // smooth sync still adjusting (never, here)
+} sntp_sync_status_t;
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval *tv);
+
+void sntp_init();
+void sntp_stop();
+bool sntp_enabled();
+// Called from the SNTP client each time it sets the system time
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
+// COMPLETED once after each sync, RESET after that is read
+sntp_sync_status_t sntp_get_sync_status();
+void sntp_set_sync_status(sntp_sync_status_t sync_status);
+
+// Host only: send SNTP requests to host:port (port 0 = none: the host clock counts as synced)
+void nativeSntpServer(const char *host, uint16_t port);
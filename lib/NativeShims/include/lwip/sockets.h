@@ -0,0 +1,11 @@
+/*--------------------------------------------------------------------------------------
+ lwip/sockets.h - host stand-in for lwIP's BSD socket API, which is the POSIX one.
+ A blocking call (select(), recv()) waits in real time: virtual time (NativeTime.h)
+ does not move on while a task sits in one.
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
@@ -0,0 +1,205 @@
+/*--------------------------------------------------------------------------------------
+ Arduino core shims: timing, GPIO, LEDC, Serial and esp32-hal-time on the host.
+--------------------------------------------------------------------------------------*/
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include "Arduino.h"
+#include "esp_timer.h"
+#include "NativeTime.h"
+#include "SPI.h"
+#include "lwip/apps/sntp.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+gpio_dev_t GPIO;
+GPIOWriteHook gpio_dev_t::hook = nullptr;
+SPIClass SPI(VSPI);
+SPITransferHook SPIClass::hook = nullptr;
+uint32_t SPIClass::transactions = 0;
+uint32_t SPIClass::bytesOut = 0;
+
+PinWriteHook pinWriteHook = nullptr;
+PinReadHook pinReadHook = nullptr;
+
+static const auto bootTime = std::chrono::steady_clock::now();
+static uint8_t pinLevel[64];
+static uint8_t pinModes[64];
+static uint32_t ledcDuty[16];
+static long tzOffsetSec = 0;
+static int dstOffsetSec = 0;
+
+long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// Microseconds since boot, host or virtual
+static int64_t nowUs()
+{
+    if (nativeVirtualTimeOn())
+        return nativeVirtualMicros();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(nowUs() / 1000);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)nowUs();
+}
+
+void delay(uint32_t ms)
+{
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    if (nativeVirtualTimeOn())
+        nativeVirtualBusy(us);
+    else
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    pinModes[pin & 63] = mode;
+    if (mode == INPUT_PULLUP)
+        pinLevel[pin & 63] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    pinLevel[pin & 63] = val ? HIGH : LOW;
+    if (pinWriteHook)
+        pinWriteHook(pin, pinLevel[pin & 63]);
+}
+
+int digitalRead(uint8_t pin)
+{
+    // Buttons (pull-ups) and the foreign SPI chip select idle high
+    int level = pin == SS ? HIGH : pinLevel[pin & 63];
+    return pinReadHook ? pinReadHook(pin, level) : level;
+}
+
+gpio_w1_reg &gpio_w1_reg::operator=(uint32_t mask)
+{
+    if (gpio_dev_t::hook)
+        gpio_dev_t::hook(set ? mask : 0, set ? 0 : mask); // before the write, so the hook sees the old levels
+    if (set)
+        GPIO.out |= mask;
+    else
+        GPIO.out &= ~mask;
+    return *this;
+}
+
+double ledcSetup(uint8_t channel, double freq, uint8_t resolution_bits)
+{
+    (void)channel;
+    (void)resolution_bits;
+    return freq;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel)
+{
+    (void)pin;
+    (void)channel;
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty)
+{
+    ledcDuty[channel & 15] = duty;
+}
+
+// ------------------- esp32-hal-time -------------------
+void configTime(long gmtOffset_sec, int daylightOffset_sec, const char *server1, const char *server2,
+                const char *server3)
+{
+    (void)server1;
+    (void)server2;
+    (void)server3;
+    tzOffsetSec = gmtOffset_sec;
+    dstOffsetSec = daylightOffset_sec;
+    sntp_stop();
+    sntp_init();
+}
+
+void configTzTime(const char *tz, const char *server1, const char *server2, const char *server3)
+{
+    configTime(0, 0, server1, server2, server3);
+    setenv("TZ", tz, 1);
+    tzset();
+}
+
+bool getLocalTime(struct tm *info, uint32_t ms)
+{
+    (void)ms;
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    time_t t = tv.tv_sec + tzOffsetSec + dstOffsetSec;
+    gmtime_r(&t, info);
+    return true;
+}
+
+// ------------------- Print / Serial -------------------
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--)
+        n += write(*buffer++);
+    return n;
+}
+
+size_t Print::printf(const char *format, ...)
+{
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len < 0)
+        return 0;
+    return write((const uint8_t *)buf, std::min<size_t>(len, sizeof(buf) - 1));
+}
+
+static std::mutex serialLock;
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    std::lock_guard<std::mutex> lk(serialLock);
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void EspClass::restart()
+{
+    fflush(stdout);
+    Serial.println("[native] ESP.restart() requested, exiting");
+    exit(0);
+}
+
+uint32_t EspClass::getCycleCount()
+{
+    return (uint32_t)(micros() * 240); // 240 MHz core
+}
+
+int64_t esp_timer_get_time()
+{
+    return nowUs();
+}
+
+// NATIVE_MAC=<hex> gives each process on one host its own identity (default: from the pid)
+uint64_t EspClass::getEfuseMac()
+{
+    const char *mac = getenv("NATIVE_MAC");
+    return mac ? strtoull(mac, nullptr, 16) : 0x24A1600000ULL + getpid();
+}
@@ -0,0 +1,506 @@
+/*--------------------------------------------------------------------------------------
+ FreeRTOS on std::thread. vTaskDelete() of another task marks it; the task unwinds the
+ next time it blocks (vTaskDelay, semaphore, queue or notification wait).
+
+ Virtual time (nativeVirtualTime(), NativeTime.h): tasks take turns instead of running
+ in parallel. The running task keeps the CPU until it blocks; then the task with the
+ earliest wake-up runs next (higher priority first, then the one that became ready
+ first), and when every task is waiting the clock jumps straight to that wake-up. Code
+ takes no virtual time, so a run is deterministic and a simulated day costs only the
+ work done in it. Scheduling is cooperative: a task that spins without blocking stops
+ the clock.
+--------------------------------------------------------------------------------------*/
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Arduino.h"
+#include "NativeTime.h"
+
+struct TaskDeleted
+{
+};
+
+struct tskTaskControlBlock
+{
+    TaskFunction_t code;
+    void *params;
+    const char *name;
+    std::thread thread;
+    std::atomic<bool> deleted{false};
+    std::mutex lock;
+    std::condition_variable notifyCv;
+    uint32_t notifyCount = 0;
+
+    // Virtual time
+    UBaseType_t priority = 0;
+    int64_t wakeUs = INT64_MAX; // may run from then on; INT64_MAX = waiting for an event only
+    uint64_t readySeq = 0;      // orders tasks that become ready together
+    const void *waitingOn = nullptr;
+    std::condition_variable turn;
+    uint64_t turns = 0;     // times it got the CPU
+    int64_t cpuNs = 0;      // host CPU used in those turns
+    int64_t turnStartNs = 0;
+};
+
+struct QueueDefinition
+{
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    bool isSemaphore;
+};
+
+static thread_local tskTaskControlBlock *currentTask = nullptr;
+
+static void checkDeleted()
+{
+    if (currentTask && currentTask->deleted.load())
+        throw TaskDeleted();
+}
+
+// ------------------- Virtual time -------------------
+static bool virtualOn = false;
+static std::atomic<int64_t> virtualNowUs{0};
+static std::mutex virtualLock;
+static std::vector<tskTaskControlBlock *> virtualTasks;
+static tskTaskControlBlock *virtualRunning = nullptr;
+static uint64_t virtualSeq = 0;
+
+static int64_t threadCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void turnStarted(tskTaskControlBlock *self)
+{
+    self->turns++;
+    self->turnStartNs = threadCpuNs();
+}
+
+static void turnEnded(tskTaskControlBlock *self)
+{
+    self->cpuNs += threadCpuNs() - self->turnStartNs;
+}
+
+static bool runsBefore(const tskTaskControlBlock *a, const tskTaskControlBlock *b)
+{
+    if (a->wakeUs != b->wakeUs)
+        return a->wakeUs < b->wakeUs;
+    if (a->priority != b->priority)
+        return a->priority > b->priority;
+    return a->readySeq < b->readySeq;
+}
+
+// Hand the CPU to the next task; the caller has blocked or is exiting
+static void virtualSwitch()
+{
+    tskTaskControlBlock *next = nullptr;
+    for (tskTaskControlBlock *t : virtualTasks)
+        if (!next || runsBefore(t, next))
+            next = t;
+    if (!next || next->wakeUs == INT64_MAX)
+    {
+        fprintf(stderr, "[native] every task is waiting forever at %lld us\n", (long long)virtualNowUs.load());
+        abort();
+    }
+    if (next->wakeUs > virtualNowUs)
+        virtualNowUs = next->wakeUs;
+    next->wakeUs = INT64_MAX;
+    next->waitingOn = nullptr;
+    virtualRunning = next;
+    next->turn.notify_one();
+}
+
+static void virtualWaitTurn(std::unique_lock<std::mutex> &lk, tskTaskControlBlock *self)
+{
+    self->turn.wait(lk, [self]() { return virtualRunning == self; });
+    turnStarted(self);
+}
+
+// Block the running task until `untilUs`, or until `event` is signalled
+static void virtualBlock(int64_t untilUs, const void *event)
+{
+    tskTaskControlBlock *self = currentTask;
+    std::unique_lock<std::mutex> lk(virtualLock);
+    self->wakeUs = untilUs;
+    self->readySeq = ++virtualSeq;
+    self->waitingOn = event;
+    turnEnded(self);
+    virtualSwitch();
+    virtualWaitTurn(lk, self);
+}
+
+static void virtualWake(const void *event)
+{
+    std::lock_guard<std::mutex> lk(virtualLock);
+    for (tskTaskControlBlock *t : virtualTasks)
+        if (t->waitingOn == event && t != virtualRunning)
+        {
+            t->wakeUs = virtualNowUs;
+            t->readySeq = ++virtualSeq;
+            t->waitingOn = nullptr;
+        }
+}
+
+static int64_t virtualDeadline(TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY)
+        return INT64_MAX;
+    return virtualNowUs + (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+}
+
+void nativeVirtualTime()
+{
+    tskTaskControlBlock *tcb = new tskTaskControlBlock();
+    tcb->name = "main";
+    currentTask = tcb;
+    virtualTasks.push_back(tcb);
+    virtualRunning = tcb;
+    virtualOn = true;
+    turnStarted(tcb);
+}
+
+bool nativeVirtualTimeOn()
+{
+    return virtualOn;
+}
+
+int64_t nativeVirtualMicros()
+{
+    return virtualNowUs;
+}
+
+void nativeVirtualBusy(int64_t us)
+{
+    virtualNowUs += us;
+}
+
+bool nativeTaskUsage(TaskHandle_t task, NativeTaskUsage &usage)
+{
+    if (!virtualOn || task == nullptr)
+        return false;
+    std::lock_guard<std::mutex> lk(virtualLock);
+    usage.turns = task->turns;
+    usage.cpuNs = task->cpuNs;
+    if (task == virtualRunning)
+        usage.cpuNs += threadCpuNs() - task->turnStartNs; // only right when asked by the task itself
+    return true;
+}
+
+// ------------------- Waiting -------------------
+static std::chrono::steady_clock::time_point deadline(TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY)
+        return std::chrono::steady_clock::time_point::max();
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds(ticks * portTICK_PERIOD_MS);
+}
+
+// Wait on cv in short slices so a deleted task notices promptly
+template <typename Pred>
+static bool waitUntil(std::unique_lock<std::mutex> &lk, std::condition_variable &cv, TickType_t ticks, Pred pred)
+{
+    if (virtualOn)
+    {
+        int64_t until = virtualDeadline(ticks);
+        while (!pred())
+        {
+            checkDeleted();
+            if (virtualNowUs >= until)
+                return false;
+            lk.unlock();
+            virtualBlock(until, &cv);
+            lk.lock();
+        }
+        return true;
+    }
+    auto until = deadline(ticks);
+    while (!pred())
+    {
+        checkDeleted();
+        auto now = std::chrono::steady_clock::now();
+        if (now >= until)
+            return false;
+        auto slice = std::min<std::chrono::steady_clock::duration>(until - now, std::chrono::milliseconds(10));
+        cv.wait_for(lk, slice);
+    }
+    return true;
+}
+
+static void wakeAll(std::condition_variable &cv)
+{
+    cv.notify_all();
+    if (virtualOn)
+        virtualWake(&cv);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth,
+                                   void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask,
+                                   BaseType_t xCoreID)
+{
+    (void)usStackDepth;
+    (void)xCoreID;
+    tskTaskControlBlock *tcb = new tskTaskControlBlock();
+    tcb->code = pvTaskCode;
+    tcb->params = pvParameters;
+    tcb->name = pcName;
+    tcb->priority = uxPriority;
+    if (pvCreatedTask)
+        *pvCreatedTask = tcb;
+    if (virtualOn)
+    {
+        std::lock_guard<std::mutex> lk(virtualLock);
+        tcb->wakeUs = virtualNowUs;
+        tcb->readySeq = ++virtualSeq;
+        virtualTasks.push_back(tcb);
+    }
+    tcb->thread = std::thread([tcb]() {
+        currentTask = tcb;
+        if (virtualOn)
+        {
+            std::unique_lock<std::mutex> lk(virtualLock);
+            virtualWaitTurn(lk, tcb);
+        }
+        try
+        {
+            tcb->code(tcb->params);
+        }
+        catch (const TaskDeleted &)
+        {
+        }
+        if (virtualOn)
+        {
+            std::lock_guard<std::mutex> lk(virtualLock);
+            turnEnded(tcb);
+            virtualTasks.erase(std::find(virtualTasks.begin(), virtualTasks.end(), tcb));
+            virtualSwitch();
+        }
+    });
+    tcb->thread.detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth,
+                       void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask)
+{
+    return xTaskCreatePinnedToCore(pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pvCreatedTask,
+                                   tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+    if (xTaskToDelete == nullptr || xTaskToDelete == currentTask)
+    {
+        if (currentTask)
+            throw TaskDeleted();
+        return;
+    }
+    // The control block is leaked on purpose: the thread may still be unwinding
+    xTaskToDelete->deleted = true;
+    xTaskToDelete->notifyCv.notify_all();
+    if (virtualOn)
+    {
+        std::lock_guard<std::mutex> lk(virtualLock);
+        xTaskToDelete->wakeUs = virtualNowUs; // run it, so it unwinds
+        xTaskToDelete->readySeq = ++virtualSeq;
+    }
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+    checkDeleted();
+    if (virtualOn)
+    {
+        virtualBlock(virtualDeadline(xTicksToDelay), nullptr);
+        checkDeleted();
+        return;
+    }
+    auto until = deadline(xTicksToDelay);
+    while (std::chrono::steady_clock::now() < until)
+    {
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+            until - std::chrono::steady_clock::now(), std::chrono::milliseconds(10)));
+        checkDeleted();
+    }
+}
+
+void vTaskDelayUntil(TickType_t *pxPreviousWakeTime, TickType_t xTimeIncrement)
+{
+    *pxPreviousWakeTime += xTimeIncrement;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(*pxPreviousWakeTime - now) > 0)
+        vTaskDelay(*pxPreviousWakeTime - now);
+    else
+        checkDeleted();
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return (TickType_t)millis();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return currentTask;
+}
+
+void taskYIELD()
+{
+    checkDeleted();
+    if (virtualOn)
+        virtualBlock(virtualNowUs, nullptr);
+    else
+        std::this_thread::yield();
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    std::lock_guard<std::mutex> lk(xTaskToNotify->lock);
+    xTaskToNotify->notifyCount++;
+    wakeAll(xTaskToNotify->notifyCv);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    tskTaskControlBlock *self = currentTask;
+    if (!self)
+        return 0;
+    std::unique_lock<std::mutex> lk(self->lock);
+    waitUntil(lk, self->notifyCv, xTicksToWait, [self]() { return self->notifyCount > 0; });
+    uint32_t count = self->notifyCount;
+    if (count > 0)
+        self->notifyCount = xClearCountOnExit ? 0 : count - 1;
+    return count;
+}
+
+// ------------------- Queues and semaphores -------------------
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize)
+{
+    QueueDefinition *q = new QueueDefinition();
+    q->length = uxQueueLength;
+    q->itemSize = uxItemSize;
+    q->isSemaphore = false;
+    return q;
+}
+
+static BaseType_t queueSend(QueueHandle_t q, const void *item, TickType_t ticks, bool front)
+{
+    std::unique_lock<std::mutex> lk(q->lock);
+    if (!waitUntil(lk, q->changed, ticks, [q]() { return q->items.size() < q->length; }))
+        return errQUEUE_FULL;
+    std::vector<uint8_t> data(q->itemSize);
+    if (q->itemSize)
+        memcpy(data.data(), item, q->itemSize);
+    if (front)
+        q->items.push_front(std::move(data));
+    else
+        q->items.push_back(std::move(data));
+    wakeAll(q->changed);
+    return pdPASS;
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait)
+{
+    return queueSend(xQueue, pvItemToQueue, xTicksToWait, false);
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait)
+{
+    return queueSend(xQueue, pvItemToQueue, xTicksToWait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait)
+{
+    return queueSend(xQueue, pvItemToQueue, xTicksToWait, true);
+}
+
+// Length-1 queues only, as in FreeRTOS
+BaseType_t xQueueOverwrite(QueueHandle_t xQueue, const void *pvItemToQueue)
+{
+    std::unique_lock<std::mutex> lk(xQueue->lock);
+    xQueue->items.clear();
+    std::vector<uint8_t> data(xQueue->itemSize);
+    if (xQueue->itemSize)
+        memcpy(data.data(), pvItemToQueue, xQueue->itemSize);
+    xQueue->items.push_back(std::move(data));
+    wakeAll(xQueue->changed);
+    return pdPASS;
+}
+
+BaseType_t xQueuePeek(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait)
+{
+    std::unique_lock<std::mutex> lk(xQueue->lock);
+    if (!waitUntil(lk, xQueue->changed, xTicksToWait, [xQueue]() { return !xQueue->items.empty(); }))
+        return pdFALSE;
+    if (xQueue->itemSize)
+        memcpy(pvBuffer, xQueue->items.front().data(), xQueue->itemSize);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait)
+{
+    std::unique_lock<std::mutex> lk(xQueue->lock);
+    if (!waitUntil(lk, xQueue->changed, xTicksToWait, [xQueue]() { return !xQueue->items.empty(); }))
+        return pdFALSE;
+    if (xQueue->itemSize)
+        memcpy(pvBuffer, xQueue->items.front().data(), xQueue->itemSize);
+    xQueue->items.pop_front();
+    wakeAll(xQueue->changed);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue)
+{
+    std::lock_guard<std::mutex> lk(xQueue->lock);
+    return xQueue->items.size();
+}
+
+void vQueueDelete(QueueHandle_t xQueue)
+{
+    delete xQueue;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount)
+{
+    QueueDefinition *q = new QueueDefinition();
+    q->length = uxMaxCount;
+    q->itemSize = 0;
+    q->isSemaphore = true;
+    for (UBaseType_t i = 0; i < uxInitialCount; i++)
+        q->items.emplace_back();
+    return q;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime)
+{
+    return xQueueReceive(xSemaphore, nullptr, xBlockTime);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore)
+{
+    return queueSend(xSemaphore, nullptr, 0, false);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t xSemaphore)
+{
+    delete xSemaphore;
+}
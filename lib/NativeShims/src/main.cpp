@@ -0,0 +1,23 @@
+/*--------------------------------------------------------------------------------------
+ Host entry point: run the sketch's setup() once, then loop() forever, in a task of
+ its own like the ESP32 Arduino core's loopTask. Left out of unit tests (pio test
+ defines UNIT_TEST), which bring their own main().
+--------------------------------------------------------------------------------------*/
+#ifndef UNIT_TEST
+#include "Arduino.h"
+
+static void loopTask(void *pvParameters)
+{
+    setup();
+    for (;;)
+        loop();
+}
+
+int main()
+{
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    xTaskCreatePinnedToCore(loopTask, "loopTask", 8192, NULL, 1, NULL, 1);
+    for (;;)
+        vTaskDelay(portMAX_DELAY);
+}
+#endif
@@ -0,0 +1,86 @@
+/*--------------------------------------------------------------------------------------
+ In-memory Preferences store shared by every namespace handle.
+--------------------------------------------------------------------------------------*/
+#include <map>
+#include <mutex>
+#include <vector>
+#include "Preferences.h"
+
+static std::mutex storeLock;
+static std::map<std::string, std::vector<uint8_t>> store;
+
+bool Preferences::begin(const char *name, bool readOnly)
+{
+    (void)readOnly;
+    ns = std::string(name) + ":";
+    return true;
+}
+
+bool Preferences::clear()
+{
+    std::lock_guard<std::mutex> lk(storeLock);
+    for (auto it = store.begin(); it != store.end();)
+        it = it->first.compare(0, ns.size(), ns) == 0 ? store.erase(it) : std::next(it);
+    return true;
+}
+
+bool Preferences::remove(const char *key)
+{
+    std::lock_guard<std::mutex> lk(storeLock);
+    return store.erase(ns + key) > 0;
+}
+
+bool Preferences::isKey(const char *key)
+{
+    std::lock_guard<std::mutex> lk(storeLock);
+    return store.count(ns + key) > 0;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len)
+{
+    std::lock_guard<std::mutex> lk(storeLock);
+    const uint8_t *p = (const uint8_t *)value;
+    store[ns + key] = std::vector<uint8_t>(p, p + len);
+    return len;
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen)
+{
+    std::lock_guard<std::mutex> lk(storeLock);
+    auto it = store.find(ns + key);
+    if (it == store.end() || it->second.size() > maxLen)
+        return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+template <typename T>
+static T getValue(Preferences *p, const char *key, T defaultValue)
+{
+    T value;
+    return p->getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+size_t Preferences::putChar(const char *key, int8_t value) { return putBytes(key, &value, sizeof(value)); }
+int8_t Preferences::getChar(const char *key, int8_t defaultValue) { return getValue(this, key, defaultValue); }
+size_t Preferences::putInt(const char *key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+int32_t Preferences::getInt(const char *key, int32_t defaultValue) { return getValue(this, key, defaultValue); }
+size_t Preferences::putUShort(const char *key, uint16_t value) { return putBytes(key, &value, sizeof(value)); }
+uint16_t Preferences::getUShort(const char *key, uint16_t defaultValue) { return getValue(this, key, defaultValue); }
+size_t Preferences::putUInt(const char *key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+uint32_t Preferences::getUInt(const char *key, uint32_t defaultValue) { return getValue(this, key, defaultValue); }
+size_t Preferences::putFloat(const char *key, float value) { return putBytes(key, &value, sizeof(value)); }
+float Preferences::getFloat(const char *key, float defaultValue) { return getValue(this, key, defaultValue); }
+size_t Preferences::putBool(const char *key, bool value) { return putBytes(key, &value, sizeof(value)); }
+bool Preferences::getBool(const char *key, bool defaultValue) { return getValue(this, key, defaultValue); }
+
+size_t Preferences::putString(const char *key, const char *value)
+{
+    return putBytes(key, value, strlen(value) + 1);
+}
+
+size_t Preferences::getString(const char *key, char *value, size_t maxLen)
+{
+    // Like NVS: a missing key leaves the buffer untouched
+    return getBytes(key, value, maxLen);
+}
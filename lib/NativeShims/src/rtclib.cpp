@@ -0,0 +1,203 @@
+/*--------------------------------------------------------------------------------------
+ RTClib subset: DateTime arithmetic and an RTC_DS3231 that talks over Wire.
+--------------------------------------------------------------------------------------*/
+#include "RTClib.h"
+
+static const uint8_t daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30};
+
+static uint8_t bin2bcd(uint8_t v) { return v + 6 * (v / 10); }
+static uint8_t bcd2bin(uint8_t v) { return v - 6 * (v >> 4); }
+
+static uint16_t date2days(uint16_t y, uint8_t m, uint8_t d)
+{
+    if (y >= 2000U)
+        y -= 2000U;
+    uint16_t days = d;
+    for (uint8_t i = 1; i < m; ++i)
+        days += daysInMonth[i - 1];
+    if (m > 2 && y % 4 == 0)
+        ++days;
+    return days + 365 * y + (y + 3) / 4 - 1;
+}
+
+static uint8_t conv2d(const char *p)
+{
+    uint8_t v = 0;
+    if ('0' <= *p && *p <= '9')
+        v = *p - '0';
+    return 10 * v + *++p - '0';
+}
+
+DateTime::DateTime(uint32_t t)
+{
+    t -= SECONDS_FROM_1970_TO_2000;
+    ss = t % 60;
+    t /= 60;
+    mm = t % 60;
+    t /= 60;
+    hh = t % 24;
+    uint16_t days = t / 24;
+    uint8_t leap;
+    for (yOff = 0;; ++yOff)
+    {
+        leap = yOff % 4 == 0;
+        if (days < 365U + leap)
+            break;
+        days -= 365 + leap;
+    }
+    for (m = 1; m < 12; ++m)
+    {
+        uint8_t daysPerMonth = daysInMonth[m - 1];
+        if (leap && m == 2)
+            ++daysPerMonth;
+        if (days < daysPerMonth)
+            break;
+        days -= daysPerMonth;
+    }
+    d = days + 1;
+}
+
+DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec)
+{
+    if (year >= 2000U)
+        year -= 2000U;
+    yOff = year;
+    m = month;
+    d = day;
+    hh = hour;
+    mm = min;
+    ss = sec;
+}
+
+DateTime::DateTime(const char *date, const char *time)
+{
+    yOff = conv2d(date + 9);
+    switch (date[0])
+    {
+    case 'J':
+        m = (date[1] == 'a') ? 1 : ((date[2] == 'n') ? 6 : 7);
+        break;
+    case 'F':
+        m = 2;
+        break;
+    case 'A':
+        m = date[2] == 'r' ? 4 : 8;
+        break;
+    case 'M':
+        m = date[2] == 'r' ? 3 : 5;
+        break;
+    case 'S':
+        m = 9;
+        break;
+    case 'O':
+        m = 10;
+        break;
+    case 'N':
+        m = 11;
+        break;
+    case 'D':
+        m = 12;
+        break;
+    }
+    d = conv2d(date + 4);
+    hh = conv2d(time);
+    mm = conv2d(time + 3);
+    ss = conv2d(time + 6);
+}
+
+uint8_t DateTime::dayOfTheWeek() const
+{
+    uint16_t day = date2days(yOff, m, d);
+    return (day + 6) % 7; // Jan 1, 2000 is a Saturday
+}
+
+uint32_t DateTime::unixtime() const
+{
+    uint16_t days = date2days(yOff, m, d);
+    return ((days * 24UL + hh) * 60 + mm) * 60 + ss + SECONDS_FROM_1970_TO_2000;
+}
+
+bool DateTime::isValid() const
+{
+    if (yOff >= 100)
+        return false;
+    DateTime other(unixtime());
+    return yOff == other.yOff && m == other.m && d == other.d && hh == other.hh && mm == other.mm &&
+           ss == other.ss;
+}
+
+DateTime DateTime::operator+(const TimeSpan &span) const
+{
+    return DateTime(unixtime() + span.totalseconds());
+}
+
+DateTime DateTime::operator-(const TimeSpan &span) const
+{
+    return DateTime(unixtime() - span.totalseconds());
+}
+
+// ------------------- RTC_DS3231 -------------------
+bool RTC_DS3231::begin(TwoWire *wireInstance)
+{
+    wire = wireInstance;
+    wire->beginTransmission(DS3231_ADDRESS);
+    return wire->endTransmission() == 0;
+}
+
+void RTC_DS3231::adjust(const DateTime &dt)
+{
+    wire->beginTransmission(DS3231_ADDRESS);
+    wire->write((uint8_t)0x00);
+    wire->write(bin2bcd(dt.second()));
+    wire->write(bin2bcd(dt.minute()));
+    wire->write(bin2bcd(dt.hour()));
+    wire->write(bin2bcd(dt.dayOfTheWeek() == 0 ? 7 : dt.dayOfTheWeek()));
+    wire->write(bin2bcd(dt.day()));
+    wire->write(bin2bcd(dt.month()));
+    wire->write(bin2bcd(dt.year() - 2000U));
+    wire->endTransmission();
+
+    // Clear the oscillator-stop flag
+    wire->beginTransmission(DS3231_ADDRESS);
+    wire->write((uint8_t)0x0F);
+    wire->endTransmission();
+    wire->requestFrom(DS3231_ADDRESS, 1);
+    uint8_t status = wire->read();
+    wire->beginTransmission(DS3231_ADDRESS);
+    wire->write((uint8_t)0x0F);
+    wire->write((uint8_t)(status & ~0x80));
+    wire->endTransmission();
+}
+
+bool RTC_DS3231::lostPower()
+{
+    wire->beginTransmission(DS3231_ADDRESS);
+    wire->write((uint8_t)0x0F);
+    wire->endTransmission();
+    wire->requestFrom(DS3231_ADDRESS, 1);
+    return (wire->read() >> 7) & 1;
+}
+
+DateTime RTC_DS3231::now()
+{
+    uint8_t buffer[7] = {};
+    wire->beginTransmission(DS3231_ADDRESS);
+    wire->write((uint8_t)0x00);
+    wire->endTransmission();
+    wire->requestFrom(DS3231_ADDRESS, 7);
+    for (int i = 0; i < 7; i++)
+        buffer[i] = wire->read();
+    return DateTime(bcd2bin(buffer[6]) + 2000U, bcd2bin(buffer[5] & 0x7F), bcd2bin(buffer[4]),
+                    bcd2bin(buffer[2]), bcd2bin(buffer[1]), bcd2bin(buffer[0] & 0x7F));
+}
+
+float RTC_DS3231::getTemperature()
+{
+    wire->beginTransmission(DS3231_ADDRESS);
+    wire->write((uint8_t)0x11);
+    wire->endTransmission();
+    wire->requestFrom(DS3231_ADDRESS, 2);
+    int8_t msb = (int8_t)wire->read();
+    uint8_t lsb = wire->read();
+    return (float)msb + (lsb >> 6) * 0.25f;
+}
@@ -0,0 +1,261 @@
+/*--------------------------------------------------------------------------------------
+ System time and SNTP on the host. gettimeofday() and settimeofday() (redirected in
+ Arduino.h) run on a clock of their own: the host's UTC at start-up plus the time since
+ boot, so virtual time moves it too, plus every step settimeofday() or a sync made.
+
+ configTime() restarts the SNTP client. With a server set (nativeSntpServer() or
+ NATIVE_NTP=host:port) it runs real NTP exchanges against it on a host thread, retrying
+ until one is answered, and steps the clock by the offset the exchange gives, as lwIP
+ does. Without one the clock is taken as synced at once.
+--------------------------------------------------------------------------------------*/
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <chrono>
+#include <mutex>
+#include "Arduino.h"
+#include "esp_timer.h"
+#include "NativeNtp.h"
+#include "lwip/apps/sntp.h"
+
+#define NTP_PACKET_SIZE 48
+#define NTP_UNIX_OFFSET 2208988800ULL // seconds from 1900 to 1970
+#define SNTP_RETRY_MS 2000            // wait for a reply this long before asking again
+
+static const int64_t bootUtcUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                                     std::chrono::system_clock::now().time_since_epoch())
+                                     .count();
+static std::atomic<int64_t> clockStepUs{0};
+
+int64_t nativeTrueMicros()
+{
+    return bootUtcUs + esp_timer_get_time();
+}
+
+int64_t nativeSystemMicros()
+{
+    return nativeTrueMicros() + clockStepUs.load();
+}
+
+int nativeGettimeofday(struct timeval *tv, void *tz)
+{
+    (void)tz;
+    int64_t us = nativeSystemMicros();
+    tv->tv_sec = us / 1000000;
+    tv->tv_usec = us % 1000000;
+    return 0;
+}
+
+int nativeSettimeofday(const struct timeval *tv, const void *tz)
+{
+    (void)tz;
+    clockStepUs += (int64_t)tv->tv_sec * 1000000 + tv->tv_usec - nativeSystemMicros();
+    return 0;
+}
+
+// ------------------- NTP timestamps -------------------
+static void ntpPut(uint8_t *p, int64_t unixUs)
+{
+    uint64_t sec = unixUs / 1000000 + NTP_UNIX_OFFSET;
+    uint64_t frac = ((uint64_t)(unixUs % 1000000) << 32) / 1000000;
+    for (int i = 0; i < 4; i++)
+    {
+        p[i] = sec >> (24 - 8 * i);
+        p[4 + i] = frac >> (24 - 8 * i);
+    }
+}
+
+static int64_t ntpGet(const uint8_t *p)
+{
+    uint64_t sec = 0, frac = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        sec = sec << 8 | p[i];
+        frac = frac << 8 | p[4 + i];
+    }
+    return (int64_t)(sec - NTP_UNIX_OFFSET) * 1000000 + (int64_t)((frac * 1000000) >> 32);
+}
+
+// ------------------- Client -------------------
+static std::mutex sntpLock;
+static std::string serverHost;
+static uint16_t serverPort = 0;
+static std::atomic<uint32_t> sntpRun{0}; // bumped by init/stop, so an old exchange gives up
+static std::atomic<bool> sntpOn{false};
+static std::atomic<int> syncStatus{SNTP_SYNC_STATUS_RESET};
+static std::atomic<sntp_sync_time_cb_t> syncCallback{nullptr};
+
+void nativeSntpServer(const char *host, uint16_t port)
+{
+    std::lock_guard<std::mutex> lk(sntpLock);
+    serverHost = host ? host : "";
+    serverPort = port;
+}
+
+static bool sntpServer(std::string &host, uint16_t &port)
+{
+    std::lock_guard<std::mutex> lk(sntpLock);
+    if (serverPort == 0)
+    {
+        const char *env = getenv("NATIVE_NTP");
+        const char *colon = env ? strrchr(env, ':') : nullptr;
+        if (colon == nullptr)
+            return false;
+        serverHost.assign(env, colon - env);
+        serverPort = atoi(colon + 1);
+    }
+    host = serverHost;
+    port = serverPort;
+    return port != 0;
+}
+
+static void synced()
+{
+    syncStatus = SNTP_SYNC_STATUS_COMPLETED;
+    sntp_sync_time_cb_t cb = syncCallback.load();
+    if (cb)
+    {
+        struct timeval tv;
+        nativeGettimeofday(&tv, nullptr);
+        cb(&tv);
+    }
+}
+
+// Ask until answered or restarted, then step the clock by the measured offset
+static void sntpExchange(uint32_t run, std::string host, uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct timeval poll = {0, 50000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &poll, sizeof(poll));
+    sockaddr_in to = {};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(port);
+    to.sin_addr.s_addr = inet_addr(host.c_str());
+
+    while (sntpRun.load() == run)
+    {
+        uint8_t req[NTP_PACKET_SIZE] = {0x23}; // version 4, client
+        int64_t t1 = nativeSystemMicros();
+        ntpPut(req + 40, t1);
+        sendto(fd, req, sizeof(req), 0, (sockaddr *)&to, sizeof(to));
+
+        int64_t askedUs = nativeTrueMicros();
+        while (sntpRun.load() == run && nativeTrueMicros() - askedUs < SNTP_RETRY_MS * 1000LL)
+        {
+            uint8_t reply[NTP_PACKET_SIZE];
+            ssize_t n = recv(fd, reply, sizeof(reply), 0);
+            if (n != NTP_PACKET_SIZE || memcmp(reply + 24, req + 40, 8) != 0)
+                continue; // nothing yet, or the answer to an older request
+            int64_t t4 = nativeSystemMicros();
+            int64_t t2 = ntpGet(reply + 32), t3 = ntpGet(reply + 40);
+            if (sntpRun.load() != run)
+                break;
+            clockStepUs += ((t2 - t1) + (t3 - t4)) / 2;
+            close(fd);
+            synced();
+            return;
+        }
+    }
+    close(fd);
+}
+
+void sntp_init()
+{
+    uint32_t run = ++sntpRun;
+    sntpOn = true;
+    std::string host;
+    uint16_t port;
+    if (!sntpServer(host, port))
+    {
+        synced();
+        return;
+    }
+    std::thread(sntpExchange, run, host, port).detach();
+}
+
+void sntp_stop()
+{
+    sntpRun++;
+    sntpOn = false;
+}
+
+bool sntp_enabled()
+{
+    return sntpOn;
+}
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback)
+{
+    syncCallback = callback;
+}
+
+sntp_sync_status_t sntp_get_sync_status()
+{
+    int expected = SNTP_SYNC_STATUS_COMPLETED;
+    if (syncStatus.compare_exchange_strong(expected, SNTP_SYNC_STATUS_RESET))
+        return SNTP_SYNC_STATUS_COMPLETED;
+    return (sntp_sync_status_t)syncStatus.load();
+}
+
+void sntp_set_sync_status(sntp_sync_status_t sync_status)
+{
+    syncStatus = sync_status;
+}
+
+// ------------------- Server stand-in -------------------
+uint16_t NativeNtpServer::start()
+{
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+        return 0;
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    struct timeval poll = {0, 50000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &poll, sizeof(poll));
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0 || getsockname(fd, (sockaddr *)&addr, &len) < 0)
+    {
+        close(fd);
+        fd = -1;
+        return 0;
+    }
+    running = true;
+    thread = std::thread(&NativeNtpServer::serve, this);
+    return ntohs(addr.sin_port);
+}
+
+void NativeNtpServer::stop()
+{
+    if (!running)
+        return;
+    running = false;
+    thread.join();
+    close(fd);
+    fd = -1;
+}
+
+void NativeNtpServer::serve()
+{
+    while (running)
+    {
+        uint8_t pkt[NTP_PACKET_SIZE];
+        sockaddr_in from;
+        socklen_t fromLen = sizeof(from);
+        ssize_t n = recvfrom(fd, pkt, sizeof(pkt), 0, (sockaddr *)&from, &fromLen);
+        if (n != NTP_PACKET_SIZE)
+            continue;
+        requests++;
+        if (silent)
+            continue;
+        std::this_thread::sleep_for(std::chrono::milliseconds(requestDelayMs.load()));
+        int64_t now = nativeTrueMicros() + offsetUs.load();
+        uint8_t reply[NTP_PACKET_SIZE] = {0x24, 1}; // version 4, server, stratum 1
+        memcpy(reply + 24, pkt + 40, 8);            // originate = the client's transmit time
+        ntpPut(reply + 32, now);                    // receive
+        ntpPut(reply + 40, now);                    // transmit
+        std::this_thread::sleep_for(std::chrono::milliseconds(replyDelayMs.load()));
+        sendto(fd, reply, sizeof(reply), 0, (sockaddr *)&from, fromLen);
+    }
+}
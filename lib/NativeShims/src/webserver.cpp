@@ -0,0 +1,199 @@
+/*--------------------------------------------------------------------------------------
+ Loopback HTTP server behind the WebServer stand-in.
+--------------------------------------------------------------------------------------*/
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "WebServer.h"
+
+void WebServer::begin()
+{
+    const char *env = getenv("WEBSERVER_PORT");
+    int p = env ? atoi(env) : port;
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(p);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listenFd, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenFd, 16) != 0)
+    {
+        fprintf(stderr, "WebServer: cannot listen on port %d\n", p);
+        ::close(listenFd);
+        listenFd = -1;
+        return;
+    }
+    fcntl(listenFd, F_SETFL, O_NONBLOCK);
+}
+
+void WebServer::close()
+{
+    if (listenFd >= 0)
+        ::close(listenFd);
+    listenFd = -1;
+}
+
+static std::string urlDecode(const std::string &s)
+{
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++)
+    {
+        if (s[i] == '+')
+            out += ' ';
+        else if (s[i] == '%' && i + 2 < s.size())
+        {
+            out += (char)strtol(s.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        }
+        else
+            out += s[i];
+    }
+    return out;
+}
+
+static void parseArgs(const std::string &query, std::vector<std::pair<std::string, std::string>> &args)
+{
+    size_t start = 0;
+    while (start < query.size())
+    {
+        size_t end = query.find('&', start);
+        if (end == std::string::npos)
+            end = query.size();
+        std::string pair = query.substr(start, end - start);
+        size_t eq = pair.find('=');
+        if (!pair.empty())
+            args.push_back({urlDecode(pair.substr(0, eq)), eq == std::string::npos ? "" : urlDecode(pair.substr(eq + 1))});
+        start = end + 1;
+    }
+}
+
+void WebServer::handleClient()
+{
+    if (listenFd < 0)
+        return;
+    int fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0)
+        return;
+
+    // Read headers and body (a second at most)
+    std::string req;
+    size_t headerEnd = std::string::npos, contentLength = 0;
+    unsigned long start = millis();
+    while (millis() - start < 1000)
+    {
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, 50) <= 0)
+            continue;
+        char buf[1024];
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+            break;
+        req.append(buf, n);
+        if (headerEnd == std::string::npos && (headerEnd = req.find("\r\n\r\n")) != std::string::npos)
+        {
+            size_t cl = req.find("Content-Length:");
+            if (cl == std::string::npos)
+                cl = req.find("content-length:");
+            if (cl != std::string::npos && cl < headerEnd)
+                contentLength = strtoul(req.c_str() + cl + 15, nullptr, 10);
+        }
+        if (headerEnd != std::string::npos && req.size() >= headerEnd + 4 + contentLength)
+            break;
+    }
+    if (headerEnd == std::string::npos)
+    {
+        ::close(fd);
+        return;
+    }
+
+    std::string line = req.substr(0, req.find("\r\n"));
+    size_t sp1 = line.find(' '), sp2 = line.find(' ', sp1 + 1);
+    std::string m = line.substr(0, sp1), target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    reqMethod = m == "POST" ? HTTP_POST : m == "PUT" ? HTTP_PUT : m == "DELETE" ? HTTP_DELETE : HTTP_GET;
+    size_t q = target.find('?');
+    reqUri = target.substr(0, q);
+    argList.clear();
+    if (q != std::string::npos)
+        parseArgs(target.substr(q + 1), argList);
+    std::string body = req.substr(headerEnd + 4);
+    if (reqMethod != HTTP_GET && !body.empty() && body[0] != '{')
+        parseArgs(body, argList);
+    else if (!body.empty())
+        argList.push_back({"plain", body});
+
+    clientFd = fd;
+    responded = false;
+    extraHeaders.clear();
+    bool found = false;
+    for (auto &r : routes)
+    {
+        if (r.uri == reqUri && (r.method == HTTP_ANY || r.method == reqMethod))
+        {
+            r.handler();
+            found = true;
+            break;
+        }
+    }
+    if (!found)
+    {
+        if (notFound)
+            notFound();
+        else
+            send(404, "text/plain", "Not found");
+    }
+    if (!responded)
+        send(500, "text/plain", "No response");
+    requestsHandled++;
+    ::close(fd);
+    clientFd = -1;
+}
+
+String WebServer::arg(const String &name)
+{
+    for (auto &a : argList)
+        if (a.first == name.c_str())
+            return String(a.second);
+    return String();
+}
+
+String WebServer::arg(int i) { return i < (int)argList.size() ? String(argList[i].second) : String(); }
+String WebServer::argName(int i) { return i < (int)argList.size() ? String(argList[i].first) : String(); }
+
+bool WebServer::hasArg(const String &name)
+{
+    for (auto &a : argList)
+        if (a.first == name.c_str())
+            return true;
+    return false;
+}
+
+void WebServer::sendHeader(const String &name, const String &value, bool first)
+{
+    std::string h = std::string(name.c_str()) + ": " + value.c_str() + "\r\n";
+    extraHeaders = first ? h + extraHeaders : extraHeaders + h;
+}
+
+void WebServer::send(int code, const char *contentType, const String &content)
+{
+    if (clientFd < 0 || responded)
+        return;
+    responded = true;
+    char head[256];
+    int n = snprintf(head, sizeof(head), "HTTP/1.0 %d %s\r\nContent-Type: %s\r\nContent-Length: %u\r\nConnection: close\r\n",
+                     code, code < 300 ? "OK" : code < 500 ? "Bad Request" : "Error", contentType ? contentType : "text/plain",
+                     content.length());
+    std::string out(head, n);
+    out += extraHeaders + "\r\n" + content.c_str();
+    size_t sent = 0;
+    while (sent < out.size())
+    {
+        ssize_t w = ::send(clientFd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+        if (w <= 0)
+            break;
+        sent += w;
+    }
+}
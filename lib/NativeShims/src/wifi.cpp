@@ -0,0 +1,110 @@
+/*--------------------------------------------------------------------------------------
+ WiFi station state machine and WiFiManager portal stand-ins.
+--------------------------------------------------------------------------------------*/
+#include "WiFi.h"
+#include "WiFiManager.h"
+
+WiFiClass WiFi;
+
+bool IPAddress::fromString(const char *s)
+{
+    unsigned a, b, c, d;
+    if (sscanf(s, "%u.%u.%u.%u", &a, &b, &c, &d) != 4 || a > 255 || b > 255 || c > 255 || d > 255)
+        return false;
+    bytes[0] = a;
+    bytes[1] = b;
+    bytes[2] = c;
+    bytes[3] = d;
+    return true;
+}
+
+std::string IPAddress::toString() const
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+    return buf;
+}
+
+bool WiFiClass::mode(wifi_mode_t m)
+{
+    currentMode = m;
+    if (m == WIFI_OFF)
+        connecting = false;
+    return true;
+}
+
+wl_status_t WiFiClass::begin()
+{
+    beginCalls++;
+    if (currentMode == WIFI_OFF)
+        currentMode = WIFI_STA;
+    connecting = true;
+    connectStart = millis();
+    return status();
+}
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *passphrase)
+{
+    (void)ssid;
+    (void)passphrase;
+    return begin();
+}
+
+bool WiFiClass::disconnect(bool wifioff)
+{
+    connecting = false;
+    if (wifioff)
+        currentMode = WIFI_OFF;
+    return true;
+}
+
+wl_status_t WiFiClass::status()
+{
+    if (!connecting || currentMode == WIFI_OFF)
+        return WL_DISCONNECTED;
+    if (!linkAvailable)
+        return WL_NO_SSID_AVAIL;
+    return millis() - connectStart >= connectDelayMs ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+// ------------------- WiFiManager -------------------
+bool WiFiManager::startConfigPortal(const char *apName, const char *apPassword)
+{
+    (void)apName;
+    (void)apPassword;
+    active = true;
+    portalStart = millis();
+    if (!blocking)
+        return false;
+    while (!process())
+    {
+        if (!active)
+            return false;
+        delay(10);
+    }
+    return true;
+}
+
+bool WiFiManager::process()
+{
+    if (!active)
+        return false;
+    if (pendingSave)
+    {
+        pendingSave = false;
+        active = false;
+        if (saveCallback)
+            saveCallback();
+        WiFi.begin();
+        return true;
+    }
+    if (portalTimeout && millis() - portalStart >= portalTimeout * 1000UL)
+        active = false;
+    return false;
+}
+
+bool WiFiManager::stopConfigPortal()
+{
+    active = false;
+    return true;
+}
@@ -0,0 +1,100 @@
+#include "WiFiUdp.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+bool WiFiUDP::open()
+{
+    if (fd >= 0)
+        return true;
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+        return false;
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &yes, sizeof(yes));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    return true;
+}
+
+uint8_t WiFiUDP::begin(uint16_t port)
+{
+    stop();
+    if (!open())
+        return 0;
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        stop();
+        return 0;
+    }
+    return 1;
+}
+
+void WiFiUDP::stop()
+{
+    if (fd >= 0)
+        close(fd);
+    fd = -1;
+    flush();
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+    if (!open())
+        return 0;
+    destIp = ip;
+    destPort = port;
+    packet.clear();
+    return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t *buf, size_t size)
+{
+    packet.insert(packet.end(), buf, buf + size);
+    return size;
+}
+
+int WiFiUDP::endPacket()
+{
+    sockaddr_in to = {};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(destPort);
+    to.sin_addr.s_addr = destIp.toUint32() == 0xFFFFFFFF ? inet_addr("127.255.255.255") : (in_addr_t)htonl(destIp.toUint32());
+    return sendto(fd, packet.data(), packet.size(), 0, (sockaddr *)&to, sizeof(to)) == (ssize_t)packet.size();
+}
+
+int WiFiUDP::parsePacket()
+{
+    if (fd < 0 || available() > 0)
+        return 0;
+    uint8_t buf[1500];
+    sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    ssize_t n = recvfrom(fd, buf, sizeof(buf), MSG_DONTWAIT, (sockaddr *)&from, &fromLen);
+    if (n <= 0)
+        return 0;
+    rx.assign(buf, buf + n);
+    rxPos = 0;
+    uint32_t a = ntohl(from.sin_addr.s_addr);
+    remote = IPAddress(a >> 24, a >> 16, a >> 8, a);
+    remotePortNum = ntohs(from.sin_port);
+    return n;
+}
+
+int WiFiUDP::read(uint8_t *buf, size_t len)
+{
+    size_t n = std::min(len, rx.size() - rxPos);
+    memcpy(buf, rx.data() + rxPos, n);
+    rxPos += n;
+    return n;
+}
+
+void WiFiUDP::flush()
+{
+    rx.clear();
+    rxPos = 0;
+}
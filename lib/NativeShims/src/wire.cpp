@@ -0,0 +1,219 @@
+/*--------------------------------------------------------------------------------------
+ Simulated I2C bus and DS3231 register model.
+--------------------------------------------------------------------------------------*/
+#include "Wire.h"
+
+TwoWire Wire;
+DS3231Sim ds3231Sim;
+
+static uint8_t bin2bcd(uint8_t v) { return v + 6 * (v / 10); }
+static uint8_t bcd2bin(uint8_t v) { return v - 6 * (v >> 4); }
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency)
+{
+    if (sda >= 0)
+        sdaPin = sda;
+    if (scl >= 0)
+        sclPin = scl;
+    if (frequency)
+        clock = frequency;
+    if (devices[0x68] == nullptr)
+        devices[0x68] = &ds3231Sim;
+    pinWriteHook = pinWrite;
+    pinReadHook = pinRead;
+    return true;
+}
+
+// A held SDA lets go one SCL pulse at a time
+void TwoWire::pinWrite(uint8_t pin, uint8_t val)
+{
+    if (pin != Wire.sclPin)
+        return;
+    if (val && !Wire.sclLevel && Wire.sdaHeldPulses)
+        Wire.sdaHeldPulses--;
+    Wire.sclLevel = val;
+}
+
+int TwoWire::pinRead(uint8_t pin, int level)
+{
+    return pin == Wire.sdaPin && Wire.sdaHeldPulses ? LOW : level;
+}
+
+I2CFault TwoWire::fault(uint8_t address, bool isRead)
+{
+    I2CFault f = sdaHeldPulses ? I2C_FAULT_TIMEOUT : faultHook ? faultHook(address, isRead) : I2C_FAULT_NONE;
+    if (f == I2C_FAULT_TIMEOUT)
+    {
+        timeouts++;
+        delay(timeout);
+    }
+    return f;
+}
+
+bool TwoWire::setClock(uint32_t frequency)
+{
+    clock = frequency;
+    return true;
+}
+
+void TwoWire::attach(uint8_t address, I2CDevice *device)
+{
+    devices[address & 0x7F] = device;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    txAddress = address & 0x7F;
+    txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if (txLength >= I2C_BUFFER_LENGTH)
+        return 0;
+    txBuffer[txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity)
+{
+    size_t n = 0;
+    while (quantity-- && write(*data++))
+        n++;
+    return n;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    (void)sendStop;
+    transfers++;
+    bytesOnBus += txLength + 1;
+    I2CDevice *dev = devices[txAddress];
+    I2CFault f = fault(txAddress, false);
+    if (f == I2C_FAULT_TIMEOUT)
+        return 5;
+    if (dev == nullptr || f == I2C_FAULT_NACK)
+        return 2; // address NACK
+    if (txLength && !dev->onWrite(txBuffer, txLength))
+        return 3; // data NACK
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop)
+{
+    (void)sendStop;
+    transfers++;
+    rxIndex = rxLength = 0;
+    I2CDevice *dev = devices[address & 0x7F];
+    if (dev == nullptr || fault(address & 0x7F, true) != I2C_FAULT_NONE)
+        return 0;
+    rxLength = dev->onRead(rxBuffer, std::min<size_t>(quantity, I2C_BUFFER_LENGTH));
+    bytesOnBus += rxLength + 1;
+    return rxLength;
+}
+
+int TwoWire::available()
+{
+    return rxLength - rxIndex;
+}
+
+int TwoWire::read()
+{
+    if (rxIndex >= rxLength)
+        return -1;
+    return rxBuffer[rxIndex++];
+}
+
+// ------------------- DS3231 model -------------------
+DS3231Sim::DS3231Sim()
+{
+    memset(regs, 0, sizeof(regs));
+    regs[0x0E] = 0x1C; // INTCN, RS2, RS1 after power-up
+    regs[0x0F] = 0x88; // OSF set: oscillator stopped since power-up, EN32kHz
+    baseUs = micros();
+}
+
+static double simSeconds(double baseSeconds, uint64_t baseUs, double ppm)
+{
+    double elapsed = (double)(micros() - baseUs) / 1e6;
+    return baseSeconds + elapsed * (1.0 + ppm * 1e-6);
+}
+
+// Refresh the time and temperature registers from the model clock
+void DS3231Sim::sync()
+{
+    double ppm = driftPpm - (int8_t)regs[0x10] * 0.1;
+    time_t t = (time_t)simSeconds((double)baseUnix + baseFrac, baseUs, ppm);
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    regs[0x00] = bin2bcd(tm.tm_sec);
+    regs[0x01] = bin2bcd(tm.tm_min);
+    regs[0x02] = bin2bcd(tm.tm_hour);
+    regs[0x03] = tm.tm_wday + 1;
+    regs[0x04] = bin2bcd(tm.tm_mday);
+    regs[0x05] = bin2bcd(tm.tm_mon + 1) | (tm.tm_year >= 200 ? 0x80 : 0);
+    regs[0x06] = bin2bcd(tm.tm_year % 100);
+    int quarters = (int)lround(tempC * 4);
+    regs[0x11] = (uint8_t)(int8_t)(quarters >> 2);
+    regs[0x12] = (uint8_t)((quarters & 3) << 6);
+}
+
+bool DS3231Sim::onWrite(const uint8_t *data, size_t len)
+{
+    sync();
+    pointer = data[0];
+    bool timeWritten = false;
+    bool agingWritten = false;
+    double ppmBefore = driftPpm - (int8_t)regs[0x10] * 0.1;
+    for (size_t i = 1; i < len; i++, pointer++)
+    {
+        if (pointer >= sizeof(regs))
+            pointer = 0;
+        if (pointer <= 0x06)
+            timeWritten = true;
+        if (pointer == 0x10)
+            agingWritten = true;
+        if (pointer == 0x11 || pointer == 0x12)
+            continue; // temperature is read-only
+        if (pointer == 0x0F)
+            regs[0x0F] = (regs[0x0F] & data[i]) | (data[i] & 0x7F & ~0x04); // OSF can only be cleared
+        else
+            regs[pointer] = data[i];
+        registerWrites++;
+    }
+    if (timeWritten)
+    {
+        // Writing the time registers restarts the seconds countdown chain
+        struct tm tm = {};
+        tm.tm_sec = bcd2bin(regs[0x00] & 0x7F);
+        tm.tm_min = bcd2bin(regs[0x01] & 0x7F);
+        tm.tm_hour = bcd2bin(regs[0x02] & 0x3F);
+        tm.tm_mday = bcd2bin(regs[0x04] & 0x3F);
+        tm.tm_mon = bcd2bin(regs[0x05] & 0x1F) - 1;
+        tm.tm_year = bcd2bin(regs[0x06]) + 100 + ((regs[0x05] & 0x80) ? 100 : 0);
+        baseUnix = timegm(&tm);
+        baseFrac = 0;
+        baseUs = micros();
+    }
+    else if (agingWritten)
+    {
+        // Keep the current time continuous across the rate change
+        double now = simSeconds((double)baseUnix + baseFrac, baseUs, ppmBefore);
+        baseUnix = (int64_t)now;
+        baseFrac = now - (double)baseUnix;
+        baseUs = micros();
+    }
+    return true;
+}
+
+size_t DS3231Sim::onRead(uint8_t *data, size_t len)
+{
+    sync();
+    for (size_t i = 0; i < len; i++)
+    {
+        if (pointer >= sizeof(regs))
+            pointer = 0;
+        data[i] = regs[pointer++];
+    }
+    return len;
+}
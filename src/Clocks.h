@@ -7,6 +7,10 @@
 #include <SPI.h>
 #include <time.h>
 #include <RTClib.h>
+#include "functions/renderQueue.h"
+#include "functions/i2cService.h"
+#include "functions/frameClock.h"
+#include "functions/messageQueue.h"
 
 // Fonts
 #include "fonts/SystemFont5x7.h"
@@ -17,6 +21,7 @@
 #include "fonts/SystemFont3x5.h"
 #include "fonts/Font5x10Nbox.h"
 #include "fonts/Font5x10Sbox.h"
+#include "fonts/Bangla8.h"
 // ================================================================
 //                        CLOCK TASKS
 // ================================================================
@@ -28,46 +33,87 @@ int _hour12, _hour24, _minute, _second;
 int currentMode = 0; // 0=Clock1, 1=Clock2, 2=Clock3
 
 // --- Config ---
-// Bangladesh Time (UTC +6)
-const long gmtOffset_sec = 6 * 3600;
-const int daylightOffset_sec = 0;
+// Time zone: POSIX TZ string saved as "tz" (default Bangladesh, UTC +6), see timezone.h
+// Offset the RTC was kept at before it switched to UTC
+#define LEGACY_RTC_OFFSET_SEC (6 * 3600)
 
 // NTP Servers
 const char *ntpServer1 = "time.google.com";
 const char *ntpServer2 = "time.nist.gov";
 const char *ntpServer3 = "pool.ntp.org";
-extern SemaphoreHandle_t i2cMutex;
-// ------------------- Helper: Get Time -------------------
-bool myGetLocalTime(struct tm *timeinfo)
+
+// --- Mode transitions ---
+// changeClockMode() starts the new face offscreen; its first frame is shown by presentFrame()
+byte modeTransition = TRANSITION_SLIDE;
+byte switchTransition = TRANSITION_SLIDE; // the pending switch's, see changeClockMode()
+volatile bool transitionPending = false;
+unsigned long modeSwitchMillis = 0;
+unsigned long lastSwitchLatency = 0; // ms from the mode switch to the new face's first frame
+
+// --- Language ---
+// Clock4 draws digits and the weekday in Bengali (Bangla8) when set; saved as "lang"
+volatile bool banglaText = false;
+// Bangla8 has the weekday names as whole words (U+E000 = Sunday): a glyph blitter cannot
+// reorder vowel signs or build conjuncts
+const char *banglaDayNames[] = {"\uE000", "\uE001", "\uE002", "\uE003", "\uE004", "\uE005", "\uE006"};
+// ------------------- Helper: Bengali Digits -------------------
+// `value` as `digits` Bengali digits (U+09E6..U+09EF) in UTF-8; `out` needs 3 * digits + 1 bytes
+int banglaNumber(char *out, int value, int digits)
+{
+  for (int i = digits - 1; i >= 0; i--, value /= 10)
+  {
+    uint16_t c = 0x09E6 + value % 10;
+    out[i * 3] = 0xE0 | (c >> 12);
+    out[i * 3 + 1] = 0x80 | ((c >> 6) & 0x3F);
+    out[i * 3 + 2] = 0x80 | (c & 0x3F);
+  }
+  out[digits * 3] = '\0';
+  return digits * 3;
+}
+// ------------------- Helper: Text Width -------------------
+// Columns the UTF-8 character at text[*i] takes in drawString() with the selected font,
+// the gap after it included (none for a glyph the font lacks); steps *i past it
+int charAdvance(RenderClient &gfx, const char *text, int len, int *i)
+{
+  int width = gfx.codePointWidth(DMD::nextCodePoint(text, len, i));
+  return width > 0 ? width + 1 : 0;
+}
+
+int textColumns(RenderClient &gfx, const char *text)
+{
+  int len = strlen(text), width = 0;
+  for (int i = 0; i < len;)
+    width += charAdvance(gfx, text, len, &i);
+  return width;
+}
+// ------------------- Helper: Show First Frame -------------------
+// Call after a face has queued a frame; a no-op unless a mode switch is waiting for it.
+void presentFrame(RenderClient &gfx)
 {
-  return getLocalTime(timeinfo, 100);
+  if (!transitionPending)
+    return;
+  transitionPending = false;
+  lastSwitchLatency = millis() - modeSwitchMillis;
+  gfx.present(switchTransition);
 }
 // --- Clock 1 ---
 
 void Clock1Task(void *pvParameters)
 {
+  RenderClient gfx;
   const long interval = 1000;
-  unsigned long previousMillis = 0;
+  unsigned long previousMillis = frameMillis() - interval;
   char hr_24[3], mn[3];
 
   for (;;)
   {
-    unsigned long currentMillis = millis();
-    if (currentMillis - previousMillis >= interval)
+    unsigned long currentMillis = frameMillis();
+    if (frameTick(previousMillis, currentMillis, interval))
     {
-      previousMillis = currentMillis;
-
       DateTime now;
-      if (xSemaphoreTake(i2cMutex, pdMS_TO_TICKS(200))) {
-        now = rtc.now();
-        xSemaphoreGive(i2cMutex);
-      } else {
-        // I2C busy; back off and skip this update
-        vTaskDelay(pdMS_TO_TICKS(200));
-        continue;
-      }
-      // Basic read validation to detect garbage reads
-      if (now.year() <= 2000 || now.hour() > 23 || now.minute() > 59) {
+      if (!readClock(now)) {
+        // No valid RTC read published yet; show what there is so a mode switch is not held up
+        presentFrame(gfx);
         vTaskDelay(pdMS_TO_TICKS(200));
         continue;
       }
@@ -75,56 +121,49 @@ void Clock1Task(void *pvParameters)
       _minute = now.minute();
       _second = now.second();
 
-      dmd.selectFont(Font6x16);
+      gfx.selectFont(Font6x16);
       _hour12 = _hour24 % 12;
       if (_hour12 == 0)
         _hour12 = 12;
 
       sprintf(hr_24, "%02d", _hour12);
-      dmd.drawString(1, 0, hr_24, 2, GRAPHICS_NORMAL);
+      gfx.drawString(1, 0, hr_24, 2, GRAPHICS_NORMAL);
 
       sprintf(mn, "%02d", _minute);
-      dmd.drawString(18, 0, mn, 2, GRAPHICS_NORMAL);
+      gfx.drawString(18, 0, mn, 2, GRAPHICS_NORMAL);
 
-      if (_second % 2 == 0)
+      if (frameColonOn(_second))
       {
-        dmd.drawFilledBox(15, 2, 16, 3, GRAPHICS_OR);
-        dmd.drawFilledBox(15, 12, 16, 13, GRAPHICS_OR);
+        gfx.drawFilledBox(15, 2, 16, 3, GRAPHICS_OR);
+        gfx.drawFilledBox(15, 12, 16, 13, GRAPHICS_OR);
       }
       else
       {
-        dmd.drawFilledBox(15, 2, 16, 3, GRAPHICS_NOR);
-        dmd.drawFilledBox(15, 12, 16, 13, GRAPHICS_NOR);
+        gfx.drawFilledBox(15, 2, 16, 3, GRAPHICS_NOR);
+        gfx.drawFilledBox(15, 12, 16, 13, GRAPHICS_NOR);
       }
     }
-    vTaskDelay(pdMS_TO_TICKS(50));
+    presentFrame(gfx);
+    frameSleep(50);
   }
 }
 // --- Clock 2 ---
 void Clock2Task(void *pvParameters)
 {
+  RenderClient gfx;
   const long interval = 1000;
-  unsigned long previousMillis = 0;
+  unsigned long previousMillis = frameMillis() - interval;
   char hr_24[3], mn[3];
 
   for (;;)
   {
-    unsigned long currentMillis = millis();
-    if (currentMillis - previousMillis >= interval)
+    unsigned long currentMillis = frameMillis();
+    if (frameTick(previousMillis, currentMillis, interval))
     {
-      previousMillis = currentMillis;
-
       DateTime now;
-      if (xSemaphoreTake(i2cMutex, pdMS_TO_TICKS(200))) {
-        now = rtc.now();
-        xSemaphoreGive(i2cMutex);
-      } else {
-        // I2C busy; back off and skip this update
-        vTaskDelay(pdMS_TO_TICKS(200));
-        continue;
-      }
-      // Basic read validation to detect garbage reads
-      if (now.year() <= 2000 || now.hour() > 23 || now.minute() > 59) {
+      if (!readClock(now)) {
+        // No valid RTC read published yet; show what there is so a mode switch is not held up
+        presentFrame(gfx);
         vTaskDelay(pdMS_TO_TICKS(200));
         continue;
       }
@@ -132,36 +171,38 @@ void Clock2Task(void *pvParameters)
       _minute = now.minute();
       _second = now.second();
 
-      dmd.selectFont(Font12x6);
+      gfx.selectFont(Font12x6);
 
       _hour12 = _hour24 % 12;
       if (_hour12 == 0)
         _hour12 = 12;
 
       sprintf(hr_24, "%02d", _hour12);
-      dmd.drawString(1, 2, hr_24, 2, GRAPHICS_NORMAL);
+      gfx.drawString(1, 2, hr_24, 2, GRAPHICS_NORMAL);
 
       sprintf(mn, "%02d", _minute);
-      dmd.drawString(18, 2, mn, 2, GRAPHICS_NORMAL);
+      gfx.drawString(18, 2, mn, 2, GRAPHICS_NORMAL);
 
-      if (_second % 2 == 0)
+      if (frameColonOn(_second))
       {
-        dmd.drawFilledBox(15, 4, 16, 5, GRAPHICS_OR);
-        dmd.drawFilledBox(15, 10, 16, 11, GRAPHICS_OR);
+        gfx.drawFilledBox(15, 4, 16, 5, GRAPHICS_OR);
+        gfx.drawFilledBox(15, 10, 16, 11, GRAPHICS_OR);
       }
       else
       {
-        dmd.drawFilledBox(15, 4, 16, 5, GRAPHICS_NOR);
-        dmd.drawFilledBox(15, 10, 16, 11, GRAPHICS_NOR);
+        gfx.drawFilledBox(15, 4, 16, 5, GRAPHICS_NOR);
+        gfx.drawFilledBox(15, 10, 16, 11, GRAPHICS_NOR);
       }
     }
-    vTaskDelay(pdMS_TO_TICKS(50));
+    presentFrame(gfx);
+    frameSleep(50);
   }
 }
 
  // NEW: declared in main.cpp
 void Clock3Task(void *pvParameters)
 {
+  RenderClient gfx;
   char hr_24[3], mn[3];
   char tens_str[2], units_str[2];
 
@@ -176,26 +217,14 @@ void Clock3Task(void *pvParameters)
 
   for (;;)
   {
+    // The I2C task only publishes validated reads, so no garbage check is needed here
     DateTime now;
-    if (xSemaphoreTake(i2cMutex, pdMS_TO_TICKS(200))) {
-      now = rtc.now();
-      xSemaphoreGive(i2cMutex);
-    } else {
-      // I2C busy; back off and retry
+    if (!readClock(now))
+    {
+      presentFrame(gfx);
       vTaskDelay(pdMS_TO_TICKS(500));
       continue;
     }
-    // =========================================================
-    // FIX: DATA VALIDATION CHECK
-    // If the read failed, the year is usually 2000 or 165. 
-    // If so, skip this loop iteration and try again.
-    // =========================================================
-    if (now.year() <= 2000 || now.hour() > 23 || now.minute() > 59)
-    {
-       // Read failed or returned garbage data. Back off and retry.
-      vTaskDelay(pdMS_TO_TICKS(500)); // avoid hammering I2C and prevent divide-by-zero
-       continue;
-    }
 
     _second = now.second();
 
@@ -205,7 +234,7 @@ void Clock3Task(void *pvParameters)
       _minute = now.minute();
 
       // 1. PREPARE STRINGS
-      dmd.selectFont(Font5x7Nbox);
+      gfx.selectFont(Font5x7Nbox);
       _hour12 = _hour24 % 12;
       if (_hour12 == 0)
         _hour12 = 12;
@@ -213,10 +242,10 @@ void Clock3Task(void *pvParameters)
       sprintf(mn, "%02d", _minute);
 
       // 2. DRAW STATIC PART
-      dmd.drawString(3, -1, hr_24, 2, GRAPHICS_NORMAL);
-      dmd.drawString(3, 8, mn, 2, GRAPHICS_NORMAL);
-      dmd.drawFilledBox(15, 4, 16, 5, GRAPHICS_OR);
-      dmd.drawFilledBox(15, 10, 16, 11, GRAPHICS_OR);
+      gfx.drawString(3, -1, hr_24, 2, GRAPHICS_NORMAL);
+      gfx.drawString(3, 8, mn, 2, GRAPHICS_NORMAL);
+      gfx.drawFilledBox(15, 4, 16, 5, GRAPHICS_OR);
+      gfx.drawFilledBox(15, 10, 16, 11, GRAPHICS_OR);
 
       // 3. CALCULATE DIGITS
       int new_tens = _second / 10;
@@ -228,13 +257,13 @@ void Clock3Task(void *pvParameters)
       // 4. DETERMINE ANIMATION AREA
       int clearStart_X;
 
-      dmd.selectFont(Font12x6);
+      gfx.selectFont(Font12x6);
 
       if (new_tens == old_tens)
       {
         // Tens didn't change: Draw it static NOW
         sprintf(tens_str, "%d", new_tens);
-        dmd.drawString(secX_Tens, secY, tens_str, 1, GRAPHICS_NORMAL);
+        gfx.drawString(secX_Tens, secY, tens_str, 1, GRAPHICS_NORMAL);
         clearStart_X = secX_Units;
       }
       else
@@ -246,27 +275,28 @@ void Clock3Task(void *pvParameters)
       // 15 steps * 60ms = 900ms Total Duration
       for (int i = 0; i <= fontHeight + gap; i++)
       {
-        dmd.drawFilledBox(clearStart_X, 0, 31, 15, GRAPHICS_NOR);
+        gfx.drawFilledBox(clearStart_X, 0, 31, 15, GRAPHICS_NOR);
 
-        dmd.selectFont(Font12x6);
+        gfx.selectFont(Font12x6);
 
         // B. Animate TENS (Only if changed)
         if (new_tens != old_tens)
         {
           sprintf(tens_str, "%d", old_tens);
-          dmd.drawString(secX_Tens, secY - i, tens_str, 1, GRAPHICS_OR);
+          gfx.drawString(secX_Tens, secY - i, tens_str, 1, GRAPHICS_OR);
 
           sprintf(tens_str, "%d", new_tens);
-          dmd.drawString(secX_Tens, (secY + fontHeight + gap) - i, tens_str, 1, GRAPHICS_OR);
+          gfx.drawString(secX_Tens, (secY + fontHeight + gap) - i, tens_str, 1, GRAPHICS_OR);
         }
 
         // C. Animate UNITS (Always animate)
         sprintf(units_str, "%d", old_units);
-        dmd.drawString(secX_Units, secY - i, units_str, 1, GRAPHICS_OR);
+        gfx.drawString(secX_Units, secY - i, units_str, 1, GRAPHICS_OR);
 
         sprintf(units_str, "%d", new_units);
-        dmd.drawString(secX_Units, (secY + fontHeight + gap) - i, units_str, 1, GRAPHICS_OR);
+        gfx.drawString(secX_Units, (secY + fontHeight + gap) - i, units_str, 1, GRAPHICS_OR);
 
+        presentFrame(gfx);
         vTaskDelay(pdMS_TO_TICKS(60));
       }
 
@@ -279,81 +309,97 @@ void Clock3Task(void *pvParameters)
 // --- Clock 4 ---
 void Clock4Task(void *pvParameters)
 {
+  RenderClient gfx;
   const long interval = 1000;
-  unsigned long previousMillis = 0;
-  char hr_24[3], mn[3], dateStr[3];
+  unsigned long previousMillis = frameMillis() - interval;
+  char hr_24[7], mn[7], dateStr[7];
   const char *dayNames[] = {"SUN", "MON", "TUE", "WED", "THU", "FRI", "SAT"};
 
   for (;;)
   {
-    unsigned long currentMillis = millis();
-    if (currentMillis - previousMillis >= interval)
+    unsigned long currentMillis = frameMillis();
+    if (frameTick(previousMillis, currentMillis, interval))
     {
-      previousMillis = currentMillis;
-
-      DateTime now = rtc.now();
+      DateTime now;
+      if (!readClock(now)) {
+        // No valid RTC read published yet; show what there is so a mode switch is not held up
+        presentFrame(gfx);
+        vTaskDelay(pdMS_TO_TICKS(200));
+        continue;
+      }
       _hour24 = now.hour();
       _minute = now.minute();
       _second = now.second();
 
-        dmd.selectFont(Font5x7Nbox);
+        bool bangla = banglaText;
+        gfx.selectFont(bangla ? Bangla8 : Font5x7Nbox);
         _hour12 = _hour24 % 12;
         if (_hour12 == 0)
           _hour12 = 12;
 
-        sprintf(hr_24, "%02d", _hour12);
-        dmd.drawString(3, -1, hr_24, 2, GRAPHICS_NORMAL);
+        if (bangla)
+          banglaNumber(hr_24, _hour12, 2);
+        else
+          sprintf(hr_24, "%02d", _hour12);
+        gfx.drawString(3, bangla ? 0 : -1, hr_24, strlen(hr_24), GRAPHICS_NORMAL);
 
-        sprintf(mn, "%02d", _minute);
-        dmd.drawString(18, -1, mn, 2, GRAPHICS_NORMAL);
+        if (bangla)
+          banglaNumber(mn, _minute, 2);
+        else
+          sprintf(mn, "%02d", _minute);
+        gfx.drawString(18, bangla ? 0 : -1, mn, strlen(mn), GRAPHICS_NORMAL);
 
-        if (_second % 2 == 0)
+        if (frameColonOn(_second))
         {
-          dmd.drawFilledBox(15, 1, 16, 2, GRAPHICS_OR);
-          dmd.drawFilledBox(15, 4, 16, 5, GRAPHICS_OR);
+          gfx.drawFilledBox(15, 1, 16, 2, GRAPHICS_OR);
+          gfx.drawFilledBox(15, 4, 16, 5, GRAPHICS_OR);
         }
         else
         {
-          dmd.drawFilledBox(15, 1, 16, 2, GRAPHICS_NOR);
-          dmd.drawFilledBox(15, 4, 16, 5, GRAPHICS_NOR);
+          gfx.drawFilledBox(15, 1, 16, 2, GRAPHICS_NOR);
+          gfx.drawFilledBox(15, 4, 16, 5, GRAPHICS_NOR);
         }
 
-        dmd.selectFont(System5x7);
-        dmd.drawString(0, 9, dayNames[now.dayOfTheWeek()], 3, GRAPHICS_NORMAL);
-
-        dmd.selectFont(Font5x7Nbox);
-        sprintf(dateStr, "%02d", now.day());
-        dmd.drawString(20, 8, dateStr, 2, GRAPHICS_NORMAL);
+        // Bengali day names differ in width
+        gfx.drawFilledBox(0, 8, 18, 15, GRAPHICS_INVERSE);
+        if (bangla)
+        {
+          gfx.selectFont(Bangla8);
+          const char *day = banglaDayNames[now.dayOfTheWeek()];
+          gfx.drawString(0, 8, day, strlen(day), GRAPHICS_NORMAL);
+          banglaNumber(dateStr, now.day(), 2);
+        }
+        else
+        {
+          gfx.selectFont(System5x7);
+          gfx.drawString(0, 9, dayNames[now.dayOfTheWeek()], 3, GRAPHICS_NORMAL);
+          gfx.selectFont(Font5x7Nbox);
+          sprintf(dateStr, "%02d", now.day());
+        }
+        gfx.drawString(20, 8, dateStr, strlen(dateStr), GRAPHICS_NORMAL);
       }
-    vTaskDelay(pdMS_TO_TICKS(50));
+    presentFrame(gfx);
+    frameSleep(50);
   }
 }
 
 void Clock5Task(void *pvParameters)
 {
+  RenderClient gfx;
   const long interval = 1000;
-  unsigned long previousMillis = 0;
+  unsigned long previousMillis = frameMillis() - interval;
   char hr_24[3], mn[3], date[3], month[3];
   const char *dayNames[] = {"SUN", "MON", "TUE", "WED", "THU", "FRI", "SAT"};
 
   for (;;)
   {
-    unsigned long currentMillis = millis();
-    if (currentMillis - previousMillis >= interval)
+    unsigned long currentMillis = frameMillis();
+    if (frameTick(previousMillis, currentMillis, interval))
     {
-      previousMillis = currentMillis;
-
       DateTime now;
-      if (xSemaphoreTake(i2cMutex, pdMS_TO_TICKS(200))) {
-        now = rtc.now();
-        xSemaphoreGive(i2cMutex);
-      } else {
-        // I2C busy; back off and skip this update
-        vTaskDelay(pdMS_TO_TICKS(200));
-        continue;
-      }
-      // Basic read validation to detect garbage reads
-      if (now.year() <= 2000 || now.hour() > 23 || now.minute() > 59) {
+      if (!readClock(now)) {
+        // No valid RTC read published yet; show what there is so a mode switch is not held up
+        presentFrame(gfx);
         vTaskDelay(pdMS_TO_TICKS(200));
         continue;
       }
@@ -362,65 +408,67 @@ void Clock5Task(void *pvParameters)
       _second = now.second();
 
         // --- TOP ROW: TIME ---
-        dmd.selectFont(Font5x10Nbox); // Large font for numbers
+        gfx.selectFont(Font5x10Nbox); // Large font for numbers
         _hour12 = _hour24 % 12;
         if (_hour12 == 0)
           _hour12 = 12;
 
         sprintf(hr_24, "%02d", _hour12);
-        dmd.drawString(0, 0, hr_24, 2, GRAPHICS_NORMAL);
+        gfx.drawString(0, 0, hr_24, 2, GRAPHICS_NORMAL);
 
         sprintf(mn, "%02d", _minute);
-        dmd.drawString(15, 0, mn, 2, GRAPHICS_NORMAL);
+        gfx.drawString(15, 0, mn, 2, GRAPHICS_NORMAL);
 
         // --- AM/PM ADDITION ---
         // We switch to the smaller font to fit 'A' or 'P' on the edge (x=28)
-        dmd.selectFont(SystemFont3x5);
+        gfx.selectFont(SystemFont3x5);
         if (_hour24 >= 12)
         {
-          dmd.drawString(27, 3, "P", 1, GRAPHICS_NORMAL); // Draw 'P' at bottom-right of numbers
+          gfx.drawString(27, 3, "P", 1, GRAPHICS_NORMAL); // Draw 'P' at bottom-right of numbers
         }
         else
         {
-          dmd.drawString(28, 3, "A", 1, GRAPHICS_NORMAL); // Draw 'A'
+          gfx.drawString(28, 3, "A", 1, GRAPHICS_NORMAL); // Draw 'A'
         }
 
         // --- BLINKING COLON ---
         // Switch logic back to fill boxes (Graphics mode doesn't depend on font, but good to keep organized)
-        if (_second % 2 == 0)
+        if (frameColonOn(_second))
         {
-          dmd.drawFilledBox(12, 1, 13, 2, GRAPHICS_OR);
-          dmd.drawFilledBox(12, 7, 13, 8, GRAPHICS_OR);
+          gfx.drawFilledBox(12, 1, 13, 2, GRAPHICS_OR);
+          gfx.drawFilledBox(12, 7, 13, 8, GRAPHICS_OR);
         }
         else
         {
-          dmd.drawFilledBox(12, 1, 13, 2, GRAPHICS_NOR);
-          dmd.drawFilledBox(12, 7, 13, 8, GRAPHICS_NOR);
+          gfx.drawFilledBox(12, 1, 13, 2, GRAPHICS_NOR);
+          gfx.drawFilledBox(12, 7, 13, 8, GRAPHICS_NOR);
         }
 
         // --- BOTTOM ROW: DATE.MONTH & WEEKDAY ---
-        dmd.selectFont(SystemFont3x5); // Ensure small font is selected for date
+        gfx.selectFont(SystemFont3x5); // Ensure small font is selected for date
 
         // 1. Format Date as DD.MM
         sprintf(date, "%02d", now.day());
-        dmd.drawString(0, 11, date, 3, GRAPHICS_NORMAL);
+        gfx.drawString(0, 11, date, 2, GRAPHICS_NORMAL);
 
-        dmd.drawFilledBox(8, 15, 8, 15, GRAPHICS_OR); // The dot
+        gfx.drawFilledBox(8, 15, 8, 15, GRAPHICS_OR); // The dot
 
         sprintf(month, "%02d", now.month());
-        dmd.drawString(10, 11, month, 3, GRAPHICS_NORMAL);
+        gfx.drawString(10, 11, month, 2, GRAPHICS_NORMAL);
 
         // 2. Draw Week Day Name
-        dmd.drawString(21, 11, dayNames[now.dayOfTheWeek()], 3, GRAPHICS_NORMAL);
+        gfx.drawString(21, 11, dayNames[now.dayOfTheWeek()], 3, GRAPHICS_NORMAL);
       }
-    vTaskDelay(pdMS_TO_TICKS(50));
+    presentFrame(gfx);
+    frameSleep(50);
   }
 }
 // --- Clock 6 ---
 void Clock6Task(void *pvParameters)
 {
+  RenderClient gfx;
   const long interval = 1000;
-  unsigned long previousMillis = 0;
+  unsigned long previousMillis = frameMillis() - interval;
   char hr_24[3], mn[3], dateStr[3];
 
   // CHANGED: Defined month names instead of day names
@@ -428,61 +476,57 @@ void Clock6Task(void *pvParameters)
 
   for (;;)
   {
-    unsigned long currentMillis = millis();
-    if (currentMillis - previousMillis >= interval)
+    unsigned long currentMillis = frameMillis();
+    if (frameTick(previousMillis, currentMillis, interval))
     {
-      previousMillis = currentMillis;
-
       DateTime now;
-      if (xSemaphoreTake(i2cMutex, pdMS_TO_TICKS(200))) {
-        now = rtc.now();
-        xSemaphoreGive(i2cMutex);
-      } else {
-        // I2C busy; back off and skip this update
-        vTaskDelay(pdMS_TO_TICKS(200));
-        continue;
-      }
-      // Basic read validation to detect garbage reads
-      if (now.year() <= 2000 || now.hour() > 23 || now.minute() > 59) {
+      if (!readClock(now)) {
+        // No valid RTC read published yet; show what there is so a mode switch is not held up
+        presentFrame(gfx);
         vTaskDelay(pdMS_TO_TICKS(200));
         continue;
       }
       _hour24 = now.hour();
       _minute = now.minute();
       
-        dmd.selectFont(Font5x7Nbox);
+        gfx.selectFont(Font5x7Nbox);
         _hour12 = _hour24 % 12;
         if (_hour12 == 0)
           _hour12 = 12;
 
         sprintf(hr_24, "%02d", _hour12);
-        dmd.drawString(0, -1, hr_24, 2, GRAPHICS_NORMAL);
+        gfx.drawString(0, -1, hr_24, 2, GRAPHICS_NORMAL);
 
         sprintf(mn, "%02d", _minute);
-        dmd.drawString(0, 8, mn, 2, GRAPHICS_NORMAL);
+        gfx.drawString(0, 8, mn, 2, GRAPHICS_NORMAL);
 
-        dmd.selectFont(System5x7);
-        dmd.drawFilledBox(13, 0, 13, 15, GRAPHICS_OR);
+        gfx.selectFont(System5x7);
+        gfx.drawFilledBox(13, 0, 13, 15, GRAPHICS_OR);
 
         // CHANGED: Now printing Month Name based on tm_mon
-        dmd.drawString(15, 0, monthNames[now.month() - 1], 3, GRAPHICS_NORMAL);
+        gfx.drawString(15, 0, monthNames[now.month() - 1], 3, GRAPHICS_NORMAL);
 
-        dmd.selectFont(Font5x7Nbox);
+        gfx.selectFont(Font5x7Nbox);
         sprintf(dateStr, "%02d", now.day());
-        dmd.drawString(18, 8, dateStr, 2, GRAPHICS_NORMAL);
+        gfx.drawString(18, 8, dateStr, 2, GRAPHICS_NORMAL);
       }
-    vTaskDelay(pdMS_TO_TICKS(50));
+    presentFrame(gfx);
+    frameSleep(50);
   }
 }
 //...............Clock7...................//
 void Clock7Task(void* pvParameters) {
+  RenderClient gfx;
   const long interval = 1000;       
   const long scrollInterval = 100;  
-  unsigned long previousMillis = 0;
-  unsigned long lastScrollMillis = 0;
+  unsigned long previousMillis = frameMillis() - interval;
+  unsigned long lastScrollMillis = frameMillis() - scrollInterval;
 
   char hr_24[3], mn[3];
   char dateScrollBuffer[80];
+  TickerMessage message;
+  message.id = 0; // showing the date
+  const char *scrollText = dateScrollBuffer;
 
   int scrollX = 32;     
   int textWidth = 0;    
@@ -497,23 +541,14 @@ void Clock7Task(void* pvParameters) {
   };
 
   for (;;) {
-    unsigned long currentMillis = millis();
+    unsigned long currentMillis = frameMillis();
 
     // 1. CLOCK UPDATE
-    if (currentMillis - previousMillis >= interval) {
-      previousMillis = currentMillis;
-
+    if (frameTick(previousMillis, currentMillis, interval)) {
       DateTime now;
-      if (xSemaphoreTake(i2cMutex, pdMS_TO_TICKS(200))) {
-        now = rtc.now();
-        xSemaphoreGive(i2cMutex);
-      } else {
-        // I2C busy; back off and skip this update
-        vTaskDelay(pdMS_TO_TICKS(200));
-        continue;
-      }
-      // Basic read validation to detect garbage reads
-      if (now.year() <= 2000 || now.hour() > 23 || now.minute() > 59) {
+      if (!readClock(now)) {
+        // No valid RTC read published yet; show what there is so a mode switch is not held up
+        presentFrame(gfx);
         vTaskDelay(pdMS_TO_TICKS(200));
         continue;
       }
@@ -529,54 +564,84 @@ void Clock7Task(void* pvParameters) {
                 fullMonthNames[now.month() - 1], 
                 now.year());
 
-        dmd.selectFont(System5x7);
-        textWidth = 0;
-        for (int i = 0; i < strlen(dateScrollBuffer); i++) {
-          textWidth += dmd.charWidth(dateScrollBuffer[i]) + 1;
+        if (scrollText == dateScrollBuffer) {
+          gfx.selectFont(System5x7);
+          textWidth = textColumns(gfx, dateScrollBuffer);
         }
       }
 
-      dmd.selectFont(Font5x7Nbox);
+      gfx.selectFont(Font5x7Nbox);
       _hour12 = _hour24 % 12;
       if (_hour12 == 0) _hour12 = 12;
 
       sprintf(hr_24, "%02d", _hour12);
-      dmd.drawString(3, -1, hr_24, 2, GRAPHICS_NORMAL);
+      gfx.drawString(3, -1, hr_24, 2, GRAPHICS_NORMAL);
 
       sprintf(mn, "%02d", _minute);
-      dmd.drawString(18, -1, mn, 2, GRAPHICS_NORMAL);
+      gfx.drawString(18, -1, mn, 2, GRAPHICS_NORMAL);
 
-      if (_second % 2 == 0) {
-        dmd.drawFilledBox(15, 1, 16, 2, GRAPHICS_OR);
-        dmd.drawFilledBox(15, 4, 16, 5, GRAPHICS_OR);
+      if (frameColonOn(_second)) {
+        gfx.drawFilledBox(15, 1, 16, 2, GRAPHICS_OR);
+        gfx.drawFilledBox(15, 4, 16, 5, GRAPHICS_OR);
       } else {
-        dmd.drawFilledBox(15, 1, 16, 2, GRAPHICS_NOR);
-        dmd.drawFilledBox(15, 4, 16, 5, GRAPHICS_NOR);
+        gfx.drawFilledBox(15, 1, 16, 2, GRAPHICS_NOR);
+        gfx.drawFilledBox(15, 4, 16, 5, GRAPHICS_NOR);
       }
     }
 
-    // 2. SCROLL ANIMATION
-    if (currentMillis - lastScrollMillis >= scrollInterval) {
-      lastScrollMillis = currentMillis;
-      dmd.drawFilledBox(0, 9, 31, 15, GRAPHICS_NOR); 
+    // 2. SCROLL ANIMATION (a message sets its own speed)
+    if (frameTick(lastScrollMillis, currentMillis, message.id ? message.speedMs : scrollInterval)) {
+      gfx.drawFilledBox(0, 9, 31, 15, GRAPHICS_NOR); 
+      gfx.selectFont(System5x7);
       scrollX--;
-      if (scrollX < -textWidth) {
-        scrollX = 32;
+      bool passDone = message.id && scrollX < -textWidth;
+      if (passDone) {
+        tickerPassDone(message.id);
+      }
+      // The top message takes the ticker; one it interrupts resumes later where it stopped
+      TickerMessage top;
+      if (!tickerTop(top)) {
+        top.id = 0;
+      }
+      if (top.id != message.id || passDone) {
+        if (message.id && !passDone) {
+          tickerPause(message.id, scrollX);
+        }
+        message = top;
+        scrollX = message.id ? message.resumeX : TICKER_START_X;
+        scrollText = message.id ? message.text : dateScrollBuffer;
+        textWidth = textColumns(gfx, scrollText);
+      }
+      // The date's position comes from the frame counter, so clocks locked by frame sync scroll it in step
+      if (scrollText == dateScrollBuffer) {
+        scrollX = 32 - (int)((currentMillis / scrollInterval) % (33 + textWidth));
+      }
+      // Skip characters already off the left edge (a draw command carries DRAW_TEXT_MAX bytes),
+      // a whole UTF-8 sequence at a time
+      int x = scrollX;
+      int len = strlen(scrollText), visible = 0;
+      for (int i = 0; i < len;) {
+        int advance = charAdvance(gfx, scrollText, len, &i);
+        if (x + advance > 0)
+          break;
+        x += advance;
+        visible = i;
       }
-      dmd.selectFont(System5x7);
-      dmd.drawString(scrollX, 9, dateScrollBuffer, strlen(dateScrollBuffer), GRAPHICS_NORMAL);
+      gfx.drawString(x, 9, scrollText + visible, len - visible, GRAPHICS_NORMAL);
     }
-    vTaskDelay(pdMS_TO_TICKS(10));
+    presentFrame(gfx);
+    frameSleep(10);
   }
 }
 //==============Clock8===============//
 void Clock8Task(void *pvParameters)
 {
+  RenderClient gfx;
   const long interval = 1000;
   const long switchInterval = 2000; // Change text every 2 seconds
 
-  unsigned long previousMillis = 0;
-  unsigned long lastSwitchMillis = 0;
+  unsigned long previousMillis = frameMillis() - interval;
+  unsigned long lastSwitchMillis = frameMillis() - switchInterval;
 
   char hr_24[3], mn[3];
   int displayState = 0;
@@ -586,98 +651,82 @@ void Clock8Task(void *pvParameters)
 
   for (;;)
   {
-    unsigned long currentMillis = millis();
+    unsigned long currentMillis = frameMillis();
 
     // ============================================================
     // 1. CLOCK UPDATE (Top Row)
     // ============================================================
-    if (currentMillis - previousMillis >= interval)
+    if (frameTick(previousMillis, currentMillis, interval))
     {
-      previousMillis = currentMillis;
-
       // GET TIME FROM RTC
       DateTime now;
-      if (xSemaphoreTake(i2cMutex, pdMS_TO_TICKS(200))) {
-        now = rtc.now();
-        xSemaphoreGive(i2cMutex);
-      } else {
-        // I2C busy; back off and skip this update
+      if (!readClock(now)) {
+        // No valid RTC read published yet; show what there is so a mode switch is not held up
+        presentFrame(gfx);
         vTaskDelay(pdMS_TO_TICKS(200));
         continue;
       }
-      // Basic read validation to detect garbage reads
-      if (now.year() <= 2000 || now.hour() > 23 || now.minute() > 59) {
-        vTaskDelay(pdMS_TO_TICKS(200));
-        continue;
-      } 
       _hour24 = now.hour();
       _minute = now.minute();
       _second = now.second();
 
-      dmd.selectFont(Font5x7Nbox);
+      gfx.selectFont(Font5x7Nbox);
 
       _hour12 = _hour24 % 12;
       if (_hour12 == 0)
         _hour12 = 12;
 
       sprintf(hr_24, "%02d", _hour12);
-      dmd.drawString(3, -1, hr_24, 2, GRAPHICS_NORMAL);
+      gfx.drawString(3, -1, hr_24, 2, GRAPHICS_NORMAL);
 
       sprintf(mn, "%02d", _minute);
-      dmd.drawString(18, -1, mn, 2, GRAPHICS_NORMAL);
+      gfx.drawString(18, -1, mn, 2, GRAPHICS_NORMAL);
 
-      if (_second % 2 == 0)
+      if (frameColonOn(_second))
       {
-        dmd.drawFilledBox(15, 1, 16, 2, GRAPHICS_OR);
-        dmd.drawFilledBox(15, 4, 16, 5, GRAPHICS_OR);
+        gfx.drawFilledBox(15, 1, 16, 2, GRAPHICS_OR);
+        gfx.drawFilledBox(15, 4, 16, 5, GRAPHICS_OR);
       }
       else
       {
-        dmd.drawFilledBox(15, 1, 16, 2, GRAPHICS_NOR);
-        dmd.drawFilledBox(15, 4, 16, 5, GRAPHICS_NOR);
+        gfx.drawFilledBox(15, 1, 16, 2, GRAPHICS_NOR);
+        gfx.drawFilledBox(15, 4, 16, 5, GRAPHICS_NOR);
       }
     }
 
     // ============================================================
     // 2. BOTTOM TEXT SWITCHER (RTC Based)
     // ============================================================
-    if (currentMillis - lastSwitchMillis >= switchInterval)
+    if (frameTick(lastSwitchMillis, currentMillis, switchInterval))
     {
-      lastSwitchMillis = currentMillis;
       
       // Get time again for bottom section ensuring sync
       DateTime now;
-      if (xSemaphoreTake(i2cMutex, pdMS_TO_TICKS(200))) {
-        now = rtc.now();
-        xSemaphoreGive(i2cMutex);
-      } else {
-        // I2C busy; back off and skip this update
+      if (!readClock(now)) {
+        // No valid RTC read published yet; show what there is so a mode switch is not held up
+        presentFrame(gfx);
         vTaskDelay(pdMS_TO_TICKS(200));
         continue;
       }
-      // Basic read validation to detect garbage reads
-      if (now.year() <= 2000 || now.hour() > 23 || now.minute() > 59) {
-        vTaskDelay(pdMS_TO_TICKS(200));
-        continue;
-      } 
       // 1. Clear the bottom area
-      dmd.drawFilledBox(0, 9, 31, 15, GRAPHICS_NOR);
+      gfx.drawFilledBox(0, 9, 31, 15, GRAPHICS_NOR);
+
+      // Page from the frame counter, so clocks locked by frame sync show the same one
+      displayState = (currentMillis / switchInterval) % 4;
 
       // --------------------------------------------------------
       // STATE 0: WEEK DAY NAME (e.g., "MON")
       // --------------------------------------------------------
       if (displayState == 0)
       {
-        dmd.selectFont(System5x7);
+        gfx.selectFont(System5x7);
         char weekBuf[5];
         sprintf(weekBuf, "%s", dayNames[now.dayOfTheWeek()]);
 
         // >>> CONTROL: Set Position for Week Name <<<
         int x = 8;
         int y = 9;
-        dmd.drawString(x, y, weekBuf, strlen(weekBuf), GRAPHICS_NORMAL);
-
-        displayState = 1;
+        gfx.drawString(x, y, weekBuf, strlen(weekBuf), GRAPHICS_NORMAL);
       }
       // --------------------------------------------------------
       // STATE 1: DATE and MONTH (Separate but same screen)
@@ -689,10 +738,10 @@ void Clock8Task(void *pvParameters)
         sprintf(dateBuf, "%02d", now.day());
 
         // >>> CONTROL: Set Position for Date Number <<<
-        dmd.selectFont(Font5x7Nbox);
+        gfx.selectFont(Font5x7Nbox);
         int dateX = 0;
         int dateY = 8;
-        dmd.drawString(dateX, dateY, dateBuf, strlen(dateBuf), GRAPHICS_NORMAL);
+        gfx.drawString(dateX, dateY, dateBuf, strlen(dateBuf), GRAPHICS_NORMAL);
 
         // --- PART B: Draw Month (e.g., "DEC") ---
         char monthBuf[4];
@@ -700,31 +749,51 @@ void Clock8Task(void *pvParameters)
         sprintf(monthBuf, "%s", monthNames[now.month() - 1]);
 
         // >>> CONTROL: Set Position for Month Name <<<
-        dmd.selectFont(System5x7);
+        gfx.selectFont(System5x7);
         int monthX = 15;
         int monthY = 9;
-        dmd.drawString(monthX, monthY, monthBuf, strlen(monthBuf), GRAPHICS_NORMAL);
-
-        displayState = 2;
+        gfx.drawString(monthX, monthY, monthBuf, strlen(monthBuf), GRAPHICS_NORMAL);
       }
       // --------------------------------------------------------
       // STATE 2: YEAR (e.g., "2025")
       // --------------------------------------------------------
-      else
+      else if (displayState == 2)
       {
-        dmd.selectFont(Font5x7Nbox); // Different font for year
+        gfx.selectFont(Font5x7Nbox); // Different font for year
         char yearBuf[5];
         sprintf(yearBuf, "%d", now.year());
 
         // >>> CONTROL: Set Position for Year <<<
         int yearX = 5;
         int yearY = 8;
-        dmd.drawString(yearX, yearY, yearBuf, strlen(yearBuf), GRAPHICS_NORMAL);
-
-        displayState = 0;
+        gfx.drawString(yearX, yearY, yearBuf, strlen(yearBuf), GRAPHICS_NORMAL);
+      }
+      // --------------------------------------------------------
+      // STATE 3: TEMPERATURE (e.g., "27 C") from the same RTC burst read
+      // --------------------------------------------------------
+      else
+      {
+        Ds3231State rtcState;
+        if (readRtcState(rtcState))
+        {
+          char tempBuf[4];
+          sprintf(tempBuf, "%d", constrain((int)lroundf(rtcState.temperature), 0, 99));
+
+          // >>> CONTROL: Set Position for Temperature <<<
+          gfx.selectFont(Font5x7Nbox);
+          int tempX = 5;
+          int tempY = 8;
+          gfx.drawString(tempX, tempY, tempBuf, strlen(tempBuf), GRAPHICS_NORMAL);
+
+          // Degree mark and unit
+          gfx.drawBox(18, 9, 19, 10, GRAPHICS_OR);
+          gfx.selectFont(System5x7);
+          gfx.drawString(21, 9, "C", 1, GRAPHICS_NORMAL);
+        }
       }
     }
 
-    vTaskDelay(pdMS_TO_TICKS(50));
+    presentFrame(gfx);
+    frameSleep(50);
   }
 }
\ No newline at end of file
@@ -0,0 +1,56 @@
+/*--------------------------------------------------------------------------------------
+ Bangla8 - packed DMD32 font (FONT_PACKED_*, see DMD32.h), generated from
+ Bangla8.bdf by tools/font-compiler. Do not edit; regenerate with
+   font_compiler src/fonts/Bangla8.bdf
+ height 8, rows 8, 17 code points in 32 hash slots, 17 glyphs stored, 309 bytes
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include <Arduino.h>
+
+static constexpr uint8_t Bangla8[] PROGMEM = {
+    0xFF, 0x50, 0x04, 0x08, 0x05, 0x20, 0x08, 0x02, // magic, flags, height, hash bits, slots, rows, space
+    0x01, 0x08, // hash multiplier
+    // code point, offset, advance
+    0x04, 0xE0, 0x00, 0x00, 0x0B, // U+E004
+    0x05, 0xE0, 0x0B, 0x00, 0x0B, // U+E005
+    0x06, 0xE0, 0x16, 0x00, 0x0C, // U+E006
+    0xFF, 0xFF, 0x00, 0x00, 0x00, // empty
+    0xFF, 0xFF, 0x00, 0x00, 0x00, // empty
+    0xFF, 0xFF, 0x00, 0x00, 0x00, // empty
+    0xFF, 0xFF, 0x00, 0x00, 0x00, // empty
+    0xE6, 0x09, 0x22, 0x00, 0x05, // U+09E6
+    0xE7, 0x09, 0x27, 0x00, 0x05, // U+09E7
+    0xE8, 0x09, 0x2C, 0x00, 0x05, // U+09E8
+    0xE9, 0x09, 0x31, 0x00, 0x05, // U+09E9
+    0xEA, 0x09, 0x36, 0x00, 0x05, // U+09EA
+    0xEB, 0x09, 0x3B, 0x00, 0x05, // U+09EB
+    0xEC, 0x09, 0x40, 0x00, 0x05, // U+09EC
+    0xED, 0x09, 0x45, 0x00, 0x05, // U+09ED
+    0xEE, 0x09, 0x4A, 0x00, 0x05, // U+09EE
+    0xEF, 0x09, 0x4F, 0x00, 0x05, // U+09EF
+    0xFF, 0xFF, 0x00, 0x00, 0x00, // empty
+    0xFF, 0xFF, 0x00, 0x00, 0x00, // empty
+    0xFF, 0xFF, 0x00, 0x00, 0x00, // empty
+    0xFF, 0xFF, 0x00, 0x00, 0x00, // empty
+    0xFF, 0xFF, 0x00, 0x00, 0x00, // empty
+    0xFF, 0xFF, 0x00, 0x00, 0x00, // empty
+    0xFF, 0xFF, 0x00, 0x00, 0x00, // empty
+    0xFF, 0xFF, 0x00, 0x00, 0x00, // empty
+    0xFF, 0xFF, 0x00, 0x00, 0x00, // empty
+    0xFF, 0xFF, 0x00, 0x00, 0x00, // empty
+    0xFF, 0xFF, 0x00, 0x00, 0x00, // empty
+    0x00, 0xE0, 0x54, 0x00, 0x0B, // U+E000
+    0x01, 0xE0, 0x5F, 0x00, 0x11, // U+E001
+    0x02, 0xE0, 0x70, 0x00, 0x11, // U+E002
+    0x03, 0xE0, 0x81, 0x00, 0x0A, // U+E003
+    // column masks, 1 byte per column, bit 0 = top row
+    0x62, 0xD2, 0x4A, 0xFE, 0x02, 0x26, 0x54, 0x48, 0x50, 0xA0, 0x24, 0x1E, 0xAA, 0xD6, 0x82, 0x7E,
+    0x02, 0xB2, 0xCA, 0x7E, 0x4A, 0x32, 0x1E, 0x2A, 0x56, 0x02, 0x7E, 0x02, 0x7E, 0x03, 0x33, 0x4B,
+    0x53, 0x7E, 0x3E, 0x41, 0x41, 0x41, 0x3E, 0x09, 0x0D, 0x12, 0x20, 0x40, 0x31, 0x49, 0x45, 0x43,
+    0x20, 0x21, 0x45, 0x45, 0x4A, 0x30, 0x22, 0x55, 0x49, 0x55, 0x22, 0x37, 0x48, 0x48, 0x54, 0x23,
+    0x31, 0x4A, 0x44, 0x48, 0x30, 0x03, 0x04, 0x08, 0x08, 0x7F, 0x78, 0x06, 0x01, 0x06, 0x78, 0x06,
+    0x09, 0x49, 0x2E, 0x18, 0x62, 0xD2, 0x4A, 0x7E, 0x02, 0x7F, 0x03, 0x63, 0x53, 0x4B, 0x7E, 0x1A,
+    0x26, 0x22, 0x02, 0x26, 0x56, 0x5A, 0x62, 0x3E, 0x42, 0x7E, 0x02, 0x1E, 0x2A, 0x12, 0x22, 0x7E,
+    0x36, 0x1A, 0x22, 0x42, 0x7E, 0x02, 0x0A, 0x96, 0x56, 0x2A, 0xFE, 0x06, 0x36, 0x4A, 0x42, 0x52,
+    0x3E, 0x62, 0x52, 0xCA, 0xFE, 0x82, 0x3E, 0x48, 0x50, 0x7E, 0x02,
+};
@@ -49,7 +49,7 @@ const static uint8_t SystemFont3x5[] PROGMEM = {
     0x03, // width
     0x05, // height
     0x20, // first char
-    0x64, // char count
+    0x41, // char count (0x20..0x60; the header used to claim 100, reading past the array)
     
     // Fixed width; char width table not used !!!!
     
@@ -0,0 +1,147 @@
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+#include <RTClib.h>
+
+// ================================================================
+//                DS3231 SINGLE-BURST REGISTER READ
+// ================================================================
+// rtc.now() reads only 0x00-0x06; temperature and the oscillator-stop flag
+// each cost another transaction. ds3231ReadAll() fetches the whole map
+// (0x00-0x12) in one burst and decodes everything at once.
+
+#define DS3231_I2C_ADDR 0x68
+#define DS3231_REG_COUNT 0x13
+
+// Register addresses
+#define DS3231_REG_SECONDS 0x00
+#define DS3231_REG_ALARM1 0x07
+#define DS3231_REG_ALARM2 0x0B
+#define DS3231_REG_CONTROL 0x0E
+#define DS3231_REG_STATUS 0x0F
+#define DS3231_REG_AGING 0x10
+#define DS3231_REG_TEMP_MSB 0x11
+
+// Control register bits
+#define DS3231_CONTROL_CONV 0x20
+
+// Status register bits
+#define DS3231_STATUS_OSF 0x80
+#define DS3231_STATUS_A2F 0x02
+#define DS3231_STATUS_A1F 0x01
+
+struct Ds3231State
+{
+    DateTime time;
+    float temperature;   // on-chip sensor, 0.25 C steps, updated by the chip every 64 s
+    int8_t aging;        // aging offset register
+    uint8_t control;     // control register
+    uint8_t status;      // status register
+    bool oscStopped;     // OSF: oscillator stopped since the flag was last cleared
+    bool alarm1Fired;    // A1F
+    bool alarm2Fired;    // A2F
+};
+
+static inline uint8_t ds3231Bcd2Bin(uint8_t v) { return v - 6 * (v >> 4); }
+
+static inline bool ds3231BcdValid(uint8_t v) { return (v & 0x0F) <= 9 && (v >> 4) <= 9; }
+
+// Decode a raw register image. False if the time fields are not valid BCD or out of range.
+bool ds3231Decode(const uint8_t *regs, Ds3231State &state)
+{
+    uint8_t sec = regs[0x00] & 0x7F;
+    uint8_t min = regs[0x01] & 0x7F;
+    uint8_t hourReg = regs[0x02];
+    uint8_t date = regs[0x04] & 0x3F;
+    uint8_t month = regs[0x05] & 0x1F;
+    uint8_t year = regs[0x06];
+    if (!ds3231BcdValid(sec) || !ds3231BcdValid(min) || !ds3231BcdValid(hourReg & 0x3F) ||
+        !ds3231BcdValid(date) || !ds3231BcdValid(month) || !ds3231BcdValid(year))
+        return false;
+
+    uint8_t hour;
+    if (hourReg & 0x40)
+    {
+        // 12 hour mode: bit 5 is PM
+        hour = ds3231Bcd2Bin(hourReg & 0x1F) % 12;
+        if (hourReg & 0x20)
+            hour += 12;
+    }
+    else
+    {
+        hour = ds3231Bcd2Bin(hourReg & 0x3F);
+    }
+
+    sec = ds3231Bcd2Bin(sec);
+    min = ds3231Bcd2Bin(min);
+    date = ds3231Bcd2Bin(date);
+    month = ds3231Bcd2Bin(month);
+    if (sec > 59 || min > 59 || hour > 23 || date < 1 || date > 31 || month < 1 || month > 12)
+        return false;
+
+    state.time = DateTime(2000 + ds3231Bcd2Bin(year), month, date, hour, min, sec);
+    state.control = regs[DS3231_REG_CONTROL];
+    state.status = regs[DS3231_REG_STATUS];
+    state.aging = (int8_t)regs[DS3231_REG_AGING];
+    state.temperature = (int8_t)regs[DS3231_REG_TEMP_MSB] + (regs[DS3231_REG_TEMP_MSB + 1] >> 6) * 0.25f;
+    state.oscStopped = state.status & DS3231_STATUS_OSF;
+    state.alarm1Fired = state.status & DS3231_STATUS_A1F;
+    state.alarm2Fired = state.status & DS3231_STATUS_A2F;
+    return true;
+}
+
+// Read registers 0x00-0x12 in one I2C burst. `regs` receives the raw image if given.
+bool ds3231ReadAll(TwoWire &wire, Ds3231State &state, uint8_t *regs = NULL)
+{
+    uint8_t buf[DS3231_REG_COUNT];
+    wire.beginTransmission(DS3231_I2C_ADDR);
+    wire.write((uint8_t)DS3231_REG_SECONDS);
+    if (wire.endTransmission() != 0)
+        return false;
+    if (wire.requestFrom((uint8_t)DS3231_I2C_ADDR, (uint8_t)DS3231_REG_COUNT) != DS3231_REG_COUNT)
+        return false;
+    for (uint8_t i = 0; i < DS3231_REG_COUNT; i++)
+        buf[i] = wire.read();
+    if (regs != NULL)
+        memcpy(regs, buf, DS3231_REG_COUNT);
+    return ds3231Decode(buf, state);
+}
+
+// Read just the seconds register (binary). One short transaction, for edge timing.
+bool ds3231ReadSeconds(TwoWire &wire, uint8_t &sec)
+{
+    wire.beginTransmission(DS3231_I2C_ADDR);
+    wire.write((uint8_t)DS3231_REG_SECONDS);
+    if (wire.endTransmission() != 0)
+        return false;
+    if (wire.requestFrom((uint8_t)DS3231_I2C_ADDR, (uint8_t)1) != 1)
+        return false;
+    uint8_t v = wire.read() & 0x7F;
+    if (!ds3231BcdValid(v))
+        return false;
+    sec = ds3231Bcd2Bin(v);
+    return true;
+}
+
+// Write the aging offset and start a temperature conversion, which is when the
+// chip applies a new aging value.
+bool ds3231WriteAging(TwoWire &wire, int8_t aging)
+{
+    wire.beginTransmission(DS3231_I2C_ADDR);
+    wire.write((uint8_t)DS3231_REG_AGING);
+    wire.write((uint8_t)aging);
+    if (wire.endTransmission() != 0)
+        return false;
+
+    wire.beginTransmission(DS3231_I2C_ADDR);
+    wire.write((uint8_t)DS3231_REG_CONTROL);
+    if (wire.endTransmission() != 0)
+        return false;
+    if (wire.requestFrom((uint8_t)DS3231_I2C_ADDR, (uint8_t)1) != 1)
+        return false;
+    uint8_t control = wire.read();
+    wire.beginTransmission(DS3231_I2C_ADDR);
+    wire.write((uint8_t)DS3231_REG_CONTROL);
+    wire.write((uint8_t)(control | DS3231_CONTROL_CONV));
+    return wire.endTransmission() == 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <Arduino.h>
+#include <esp_timer.h>
+
+// ================================================================
+//                     SHARED FRAME TIMEBASE
+// ================================================================
+// Faces schedule their redraws on frameMillis() instead of millis(). On its own
+// a clock runs on its local timer; with frame sync on (frameSync.h) every clock
+// on the LAN follows the master's timebase, so ticks that land on the same
+// multiple of an interval happen together on all panels: colons blink in step
+// and scrollers move together.
+//
+// frameTick() fires when frameMillis() enters a new interval slot, and
+// frameSleep() wakes a face just after the next slot boundary rather than at an
+// arbitrary point up to a poll period later.
+
+#define FRAME_SLEEP_MARGIN_MS 1 // vTaskDelay() may wake up to one tick early
+
+// Added to the local timer; set by frameSync.h. A 64 bit atomic is not lock-free
+// on the Xtensa cores, so it is guarded by a critical section instead.
+static int64_t frameOffsetUs = 0;
+static portMUX_TYPE frameOffsetMux = portMUX_INITIALIZER_UNLOCKED;
+volatile bool frameShared = false; // frame sync is on: blink from the timebase
+
+int64_t frameOffset()
+{
+    portENTER_CRITICAL(&frameOffsetMux);
+    int64_t offset = frameOffsetUs;
+    portEXIT_CRITICAL(&frameOffsetMux);
+    return offset;
+}
+
+void frameSetOffset(int64_t offset)
+{
+    portENTER_CRITICAL(&frameOffsetMux);
+    frameOffsetUs = offset;
+    portEXIT_CRITICAL(&frameOffsetMux);
+}
+
+// Microseconds on the shared timebase
+int64_t frameMicros()
+{
+    return esp_timer_get_time() + frameOffset();
+}
+
+// Milliseconds on the shared timebase (wraps like millis())
+unsigned long frameMillis()
+{
+    return (unsigned long)(frameMicros() / 1000);
+}
+
+// True when `now` has moved into a new `interval` slot since `last`; `last` is
+// then set to the start of that slot. Small steps back (timebase corrections)
+// are ignored; a step back of a whole interval or more counts as a new slot.
+bool frameTick(unsigned long &last, unsigned long now, unsigned long interval)
+{
+    long since = (long)(now - last);
+    if (since > -(long)interval && since < (long)interval)
+        return false;
+    last = now - now % interval;
+    return true;
+}
+
+// Sleep until just after the next multiple of `period` ms on the timebase
+void frameSleep(unsigned long period)
+{
+    unsigned long left = period - frameMillis() % period;
+    vTaskDelay(pdMS_TO_TICKS(left + FRAME_SLEEP_MARGIN_MS));
+}
+
+// Colon phase for a face: the RTC second, or the timebase second when clocks are locked together
+bool frameColonOn(int second)
+{
+    if (frameShared)
+        return (frameMillis() / 1000) % 2 == 0;
+    return second % 2 == 0;
+}
@@ -0,0 +1,204 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ================================================================
+//                 FRAMEBUFFER MIRROR PACKET CODEC
+// ================================================================
+// Plain C++ with no Arduino dependencies, so host tools can include it too.
+//
+// A packet is an 8 byte header, ops that rebuild the frame and a CRC-16:
+//   0 'P'  1 'M'  2 version  3 flags  4-5 sequence (LE)  6-7 frame bytes (LE)
+//   ops...  CRC-16/CCITT of everything before it (LE)
+// Ops, each with a 6 bit count n (1..64 bytes):
+//   00nnnnnn           skip n bytes (unchanged since the previous frame)
+//   01nnnnnn b1..bn    n literal bytes
+//   10nnnnnn b         n copies of b
+// Bytes past the last op are unchanged. A keyframe (FRAME_FLAG_KEY) has no
+// skips and describes every byte, so a receiver can start or resync on it.
+// Without the CRC a delta cut short at an op boundary, or with a flipped
+// literal, would still decode.
+
+#define FRAME_MAGIC0 'P'
+#define FRAME_MAGIC1 'M'
+#define FRAME_VERSION 2
+#define FRAME_HEADER_SIZE 8
+#define FRAME_CRC_SIZE 2
+#define FRAME_FLAG_KEY 0x01
+
+#define FRAME_OP_SKIP 0x00
+#define FRAME_OP_LITERAL 0x40
+#define FRAME_OP_REPEAT 0x80
+#define FRAME_OP_MASK 0xC0
+#define FRAME_RUN_MAX 64
+#define FRAME_REPEAT_MIN 3 // shorter runs are cheaper as literals
+
+// Worst case packet size for a frame of `len` bytes
+#define FRAME_PACKET_MAX(len) (FRAME_HEADER_SIZE + (len) + ((len) + FRAME_RUN_MAX - 1) / FRAME_RUN_MAX + FRAME_CRC_SIZE)
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+static uint16_t frameCrc(const uint8_t *data, size_t n)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < n; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++)
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+static size_t frameRepeatRun(const uint8_t *cur, size_t i, size_t len)
+{
+    size_t n = 1;
+    while (i + n < len && n < FRAME_RUN_MAX && cur[i + n] == cur[i])
+        n++;
+    return n;
+}
+
+static size_t frameSameRun(const uint8_t *prev, const uint8_t *cur, size_t i, size_t len)
+{
+    size_t n = 0;
+    while (i + n < len && cur[i + n] == prev[i + n])
+        n++;
+    return n;
+}
+
+// Encode `cur` as a packet. `prev` is the frame the receiver already has; pass
+// NULL (or keyframe = true) for a keyframe. Returns the packet size, 0 if `out`
+// is too small.
+size_t frameEncode(const uint8_t *prev, const uint8_t *cur, size_t len, uint16_t seq,
+                   bool keyframe, uint8_t *out, size_t outMax)
+{
+    if (prev == NULL)
+        keyframe = true;
+    if (outMax < FRAME_HEADER_SIZE + FRAME_CRC_SIZE || len > 0xFFFF)
+        return 0;
+    outMax -= FRAME_CRC_SIZE;
+    out[0] = FRAME_MAGIC0;
+    out[1] = FRAME_MAGIC1;
+    out[2] = FRAME_VERSION;
+    out[3] = keyframe ? FRAME_FLAG_KEY : 0;
+    out[4] = seq & 0xFF;
+    out[5] = seq >> 8;
+    out[6] = len & 0xFF;
+    out[7] = len >> 8;
+    size_t n = FRAME_HEADER_SIZE;
+
+    size_t i = 0;
+    while (i < len)
+    {
+        if (!keyframe)
+        {
+            size_t same = frameSameRun(prev, cur, i, len);
+            if (i + same == len)
+                break; // nothing left changes
+            // Skip any unchanged stretch
+            while (same > 0)
+            {
+                size_t k = same > FRAME_RUN_MAX ? FRAME_RUN_MAX : same;
+                if (n + 1 > outMax)
+                    return 0;
+                out[n++] = FRAME_OP_SKIP | (k - 1);
+                i += k;
+                same -= k;
+            }
+        }
+
+        size_t run = frameRepeatRun(cur, i, len);
+        if (run >= FRAME_REPEAT_MIN)
+        {
+            if (n + 2 > outMax)
+                return 0;
+            out[n++] = FRAME_OP_REPEAT | (run - 1);
+            out[n++] = cur[i];
+            i += run;
+            continue;
+        }
+
+        // Literal up to the next repeat run or (for deltas) unchanged pair
+        size_t start = i;
+        while (i < len && i - start < FRAME_RUN_MAX)
+        {
+            if (frameRepeatRun(cur, i, len) >= FRAME_REPEAT_MIN)
+                break;
+            if (!keyframe && frameSameRun(prev, cur, i, len) >= 2)
+                break;
+            i++;
+        }
+        size_t count = i - start;
+        if (n + 1 + count > outMax)
+            return 0;
+        out[n++] = FRAME_OP_LITERAL | (count - 1);
+        memcpy(out + n, cur + start, count);
+        n += count;
+    }
+    uint16_t crc = frameCrc(out, n);
+    out[n++] = crc & 0xFF;
+    out[n++] = crc >> 8;
+    return n;
+}
+
+// Read a packet header. False if it is not a mirror packet of a known version.
+// The CRC is not checked here; frameDecode() does that.
+bool frameHeader(const uint8_t *pkt, size_t n, bool &keyframe, uint16_t &seq, uint16_t &len)
+{
+    if (n < FRAME_HEADER_SIZE + FRAME_CRC_SIZE || pkt[0] != FRAME_MAGIC0 || pkt[1] != FRAME_MAGIC1 || pkt[2] != FRAME_VERSION)
+        return false;
+    keyframe = pkt[3] & FRAME_FLAG_KEY;
+    seq = pkt[4] | (pkt[5] << 8);
+    len = pkt[6] | (pkt[7] << 8);
+    return true;
+}
+
+// Apply a packet to `frame` (`len` bytes, holding the previous frame unless
+// the packet is a keyframe). False if the packet is damaged, malformed or sized
+// for a different frame; a damaged one leaves `frame` alone, a malformed one
+// with a good CRC (a broken encoder) may leave it partly updated.
+bool frameDecode(const uint8_t *pkt, size_t n, uint8_t *frame, size_t len)
+{
+    bool keyframe;
+    uint16_t seq, frameLen;
+    if (!frameHeader(pkt, n, keyframe, seq, frameLen) || frameLen != len)
+        return false;
+    n -= FRAME_CRC_SIZE;
+    if (frameCrc(pkt, n) != (pkt[n] | pkt[n + 1] << 8))
+        return false;
+
+    size_t i = 0, p = FRAME_HEADER_SIZE;
+    while (p < n)
+    {
+        uint8_t op = pkt[p] & FRAME_OP_MASK;
+        size_t count = (pkt[p] & ~FRAME_OP_MASK) + 1;
+        p++;
+        if (i + count > len)
+            return false;
+        if (op == FRAME_OP_SKIP)
+        {
+            if (keyframe)
+                return false;
+        }
+        else if (op == FRAME_OP_LITERAL)
+        {
+            if (p + count > n)
+                return false;
+            memcpy(frame + i, pkt + p, count);
+            p += count;
+        }
+        else if (op == FRAME_OP_REPEAT)
+        {
+            if (p >= n)
+                return false;
+            memset(frame + i, pkt[p++], count);
+        }
+        else
+        {
+            return false;
+        }
+        i += count;
+    }
+    // A keyframe must cover the whole frame
+    return !keyframe || i == len;
+}
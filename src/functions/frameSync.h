@@ -0,0 +1,301 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <Preferences.h>
+#include <lwip/sockets.h>
+#include "frameClock.h"
+#include "radioScheduler.h"
+
+// ================================================================
+//                 FRAME SYNC BETWEEN CLOCKS ON A LAN
+// ================================================================
+// Locks the frame timebase (frameClock.h) of every clock on the network to one
+// master. The master broadcasts a beacon every FSYNC_BEACON_MS holding its
+// timebase in microseconds; followers phase-lock to it.
+//
+// Packet, 20 bytes, little endian:
+//   0 'F'  1 'S'  2 version  3 flags (0)  4-7 sender id  8-11 beacon seq  12-19 timebase us
+//
+// Election: a clock that hears no beacon for FSYNC_MASTER_TIMEOUT_MS becomes
+// master. If two masters hear each other, the lower id keeps the role; a clock
+// that joins later follows whoever is already master, so it never moves the
+// others' timebase.
+//
+// Each beacon gives one offset sample (master time minus local time on receipt).
+// The task sleeps in select() on the port until a datagram arrives or the next
+// beacon is due, so the receive time is taken on wake-up rather than at the next
+// poll, and the task does not run every tick. Beacons go out through WiFiUDP.
+// Network and wake-up delay only ever make a sample smaller, so the follower
+// uses the largest of the last FSYNC_WINDOW samples and slews towards it,
+// stepping only when it is more than FSYNC_STEP_US away (first lock, new master).
+// FrameSyncStats.skewUs is what is left after the slew; jitterUs is the spread
+// of the window, i.e. how far the delay varied.
+
+#define FSYNC_PORT 5006
+#define FSYNC_VERSION 1
+#define FSYNC_PACKET_SIZE 20
+#define FSYNC_BEACON_MS 250
+#define FSYNC_IDLE_MS 50 // longest sleep on the port: WiFi, on/off and the master timeout are checked this often
+#define FSYNC_MASTER_TIMEOUT_MS 1500 // six missed beacons
+#define FSYNC_WINDOW 8
+#define FSYNC_STEP_US 20000
+#define FSYNC_SLEW_SHIFT 2 // move a quarter of the error per beacon
+#define FSYNC_LOG_MS 60000
+
+extern Preferences preferences;
+
+enum FrameSyncRole : uint8_t
+{
+    FSYNC_OFF,
+    FSYNC_LISTENING, // waiting to hear a master
+    FSYNC_MASTER,
+    FSYNC_FOLLOWER
+};
+
+struct FrameSyncStats
+{
+    uint8_t role;
+    uint32_t masterId;
+    uint32_t beaconsSent;
+    uint32_t beaconsReceived;
+    uint32_t masterChanges;
+    uint32_t steps;       // timebase jumps
+    int32_t skewUs;       // follower: best estimate of master minus us, after the slew
+    uint32_t maxSkewUs;   // largest |skewUs| since the last step
+    uint32_t jitterUs;    // spread of the sample window
+};
+
+FrameSyncStats frameSyncStats;
+volatile bool frameSyncEnabled = false;
+TaskHandle_t frameSyncTaskHandle = NULL;
+
+static uint32_t frameSyncId = 0;
+static int64_t fsyncSamples[FSYNC_WINDOW];
+static uint8_t fsyncSampleCount = 0, fsyncSampleNext = 0;
+
+static void fsyncPut32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        p[i] = v >> (8 * i);
+}
+
+static uint32_t fsyncGet32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void fsyncSetRole(uint8_t role, uint32_t masterId)
+{
+    if (role == FSYNC_FOLLOWER && (frameSyncStats.role != FSYNC_FOLLOWER || masterId != frameSyncStats.masterId))
+    {
+        frameSyncStats.masterChanges++;
+        fsyncSampleCount = 0;
+        fsyncSampleNext = 0;
+    }
+    frameSyncStats.role = role;
+    frameSyncStats.masterId = masterId;
+}
+
+static void fsyncSendBeacon(WiFiUDP &udp)
+{
+    uint8_t pkt[FSYNC_PACKET_SIZE] = {'F', 'S', FSYNC_VERSION, 0};
+    fsyncPut32(pkt + 4, frameSyncId);
+    fsyncPut32(pkt + 8, frameSyncStats.beaconsSent);
+    int64_t now = frameMicros();
+    fsyncPut32(pkt + 12, (uint32_t)now);
+    fsyncPut32(pkt + 16, (uint32_t)((uint64_t)now >> 32));
+    if (udp.beginPacket(IPAddress(255, 255, 255, 255), FSYNC_PORT) && udp.write(pkt, sizeof(pkt)) == sizeof(pkt) &&
+        udp.endPacket())
+        frameSyncStats.beaconsSent++;
+}
+
+// Follower: fold in one offset sample and correct the timebase
+static void fsyncTrack(int64_t sample)
+{
+    fsyncSamples[fsyncSampleNext] = sample;
+    fsyncSampleNext = (fsyncSampleNext + 1) % FSYNC_WINDOW;
+    if (fsyncSampleCount < FSYNC_WINDOW)
+        fsyncSampleCount++;
+
+    int64_t best = fsyncSamples[0], worst = fsyncSamples[0];
+    for (int i = 1; i < fsyncSampleCount; i++)
+    {
+        if (fsyncSamples[i] > best)
+            best = fsyncSamples[i];
+        if (fsyncSamples[i] < worst)
+            worst = fsyncSamples[i];
+    }
+    frameSyncStats.jitterUs = best - worst;
+
+    int64_t offset = frameOffset();
+    int64_t error = best - offset;
+    if (error > FSYNC_STEP_US || error < -FSYNC_STEP_US)
+    {
+        offset = best;
+        frameSyncStats.steps++;
+        frameSyncStats.maxSkewUs = 0;
+    }
+    else
+    {
+        offset += error / (1 << FSYNC_SLEW_SHIFT);
+    }
+    frameSetOffset(offset);
+    frameSyncStats.skewUs = best - offset;
+    uint32_t skew = abs(frameSyncStats.skewUs);
+    if (skew > frameSyncStats.maxSkewUs)
+        frameSyncStats.maxSkewUs = skew;
+}
+
+// Bound to FSYNC_PORT for broadcasts. -1 on failure.
+static int fsyncOpen()
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0)
+        return -1;
+    int yes = 1;
+    setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &yes, sizeof(yes));
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(FSYNC_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// Wait up to `waitMs` for beacons, then take every datagram queued on the port.
+// Returns false if nothing came from the master we follow (or one to follow).
+static bool fsyncReceive(int sock, uint32_t waitMs)
+{
+    fd_set ready;
+    FD_ZERO(&ready);
+    FD_SET(sock, &ready);
+    timeval tv = {(time_t)(waitMs / 1000), (suseconds_t)(waitMs % 1000 * 1000)};
+    if (select(sock + 1, &ready, NULL, NULL, &tv) <= 0)
+        return false;
+
+    // Take the receive time first: every microsecond spent after it is skew. A
+    // datagram of any other size is dropped whole by recv() (one byte more than a
+    // beacon is room enough to tell).
+    uint8_t pkt[FSYNC_PACKET_SIZE + 1];
+    bool heard = false;
+    int size;
+    while ((size = recv(sock, pkt, sizeof(pkt), MSG_DONTWAIT)) >= 0)
+    {
+        int64_t local = esp_timer_get_time();
+        if (size != FSYNC_PACKET_SIZE || pkt[0] != 'F' || pkt[1] != 'S' || pkt[2] != FSYNC_VERSION)
+            continue;
+        uint32_t id = fsyncGet32(pkt + 4);
+        if (id == frameSyncId)
+            continue; // our own broadcast
+        int64_t master = (int64_t)((uint64_t)fsyncGet32(pkt + 16) << 32 | fsyncGet32(pkt + 12));
+        frameSyncStats.beaconsReceived++;
+
+        if (frameSyncStats.role == FSYNC_MASTER && id > frameSyncId)
+            continue; // we outrank it; it will hear us and give way
+        if (frameSyncStats.role == FSYNC_FOLLOWER && id != frameSyncStats.masterId && id > frameSyncStats.masterId)
+            continue; // losing side of a master election
+        heard = true;
+        fsyncSetRole(FSYNC_FOLLOWER, id);
+        fsyncTrack(master - local);
+    }
+    return heard;
+}
+
+// ------------------- Task -------------------
+void frameSyncTask(void *pvParameters)
+{
+    WiFiUDP udp; // sends the beacons
+    int sock = -1;
+    unsigned long lastHeard = millis(), lastBeacon = 0, lastLog = millis();
+
+    for (;;)
+    {
+        if (!frameSyncEnabled || WiFi.status() != WL_CONNECTED)
+        {
+            if (sock >= 0)
+            {
+                close(sock);
+                udp.stop();
+            }
+            sock = -1;
+            vTaskDelay(pdMS_TO_TICKS(FSYNC_IDLE_MS));
+            continue;
+        }
+        if (sock < 0)
+        {
+            sock = fsyncOpen();
+            lastHeard = millis();
+            fsyncSetRole(FSYNC_LISTENING, 0);
+            if (sock < 0)
+                vTaskDelay(pdMS_TO_TICKS(FSYNC_IDLE_MS));
+            continue;
+        }
+
+        // Sleep on the port until a beacon comes in, or until our own is due
+        uint32_t waitMs = FSYNC_IDLE_MS;
+        if (frameSyncStats.role == FSYNC_MASTER)
+        {
+            unsigned long sinceBeacon = millis() - lastBeacon;
+            uint32_t untilBeacon = sinceBeacon >= FSYNC_BEACON_MS ? 0 : FSYNC_BEACON_MS - sinceBeacon;
+            if (untilBeacon < waitMs)
+                waitMs = untilBeacon;
+        }
+        if (fsyncReceive(sock, waitMs))
+            lastHeard = millis();
+
+        unsigned long now = millis();
+        if (frameSyncStats.role != FSYNC_MASTER && now - lastHeard >= FSYNC_MASTER_TIMEOUT_MS)
+        {
+            // Keep the timebase we have, so followers of the old master do not jump
+            fsyncSetRole(FSYNC_MASTER, frameSyncId);
+            Serial.printf("[FrameSync] No master heard, now master (id %08x)\n", frameSyncId);
+        }
+        if (frameSyncStats.role == FSYNC_MASTER && now - lastBeacon >= FSYNC_BEACON_MS)
+        {
+            lastBeacon = now;
+            fsyncSendBeacon(udp);
+        }
+        if (now - lastLog >= FSYNC_LOG_MS)
+        {
+            lastLog = now;
+            if (frameSyncStats.role == FSYNC_FOLLOWER)
+                Serial.printf("[FrameSync] Following %08x: skew %d us (max %u), jitter %u us, %u steps\n",
+                              frameSyncStats.masterId, frameSyncStats.skewUs, frameSyncStats.maxSkewUs,
+                              frameSyncStats.jitterUs, frameSyncStats.steps);
+            else if (frameSyncStats.role == FSYNC_MASTER)
+                Serial.printf("[FrameSync] Master, %u beacons sent\n", frameSyncStats.beaconsSent);
+        }
+    }
+}
+
+// Switch frame sync on or off (HTTP API). Keeps the radio up while on.
+void frameSyncSetEnabled(bool on)
+{
+    frameSyncEnabled = on;
+    frameShared = on;
+    radioHold(RADIO_HOLD_FRAMESYNC, on);
+    if (!on)
+    {
+        frameSyncStats.role = FSYNC_OFF;
+        return;
+    }
+    if (frameSyncTaskHandle == NULL)
+    {
+        frameSyncId = (uint32_t)ESP.getEfuseMac() ^ (uint32_t)(ESP.getEfuseMac() >> 32);
+        xTaskCreatePinnedToCore(frameSyncTask, "fsync", 3072, NULL, 2, &frameSyncTaskHandle, 0);
+    }
+    radioSyncNow();
+}
+
+// Call from setup(). Does nothing unless frame sync was left on.
+void startFrameSync()
+{
+    if (preferences.getBool("fsync", false))
+        frameSyncSetEnabled(true);
+}
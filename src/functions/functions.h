@@ -8,6 +8,9 @@
 #include <time.h>
 #include <Preferences.h> // NEW: For saving settings
 #include "Clocks.h"
+#include "ntpSync.h"
+#include "radioScheduler.h"
+#include "httpApi.h"
 
 // ------------------- Global Variables -------------------
 Preferences preferences; // NEW: Create preferences object
@@ -21,6 +24,14 @@ const int PWM_RES = 8;
 // --- NEW VARIABLES FOR BUTTON & BRIGHTNESS ---
 int brightnessIndex = 0;              // 0=Low, 1=Mid, 2=High
 int brightnessValues[] = {5, 30, 50}; // The 3 levels you requested
+// Night dimming: hours [nightStartHour, nightEndHour) run at nightLevel
+int nightStartHour = 0;
+int nightEndHour = 8;
+int nightLevel = 5;
+// A press at night shows the new level this long before loop() goes back to nightLevel
+#define BRIGHT_PREVIEW_MS 1000
+unsigned long brightPreviewUntil = 0;
+std::atomic<int> apiRequestedMode{-1}; // set by the HTTP API, taken by loop()
 int clickCount = 0;                   // Counts how many times button is clicked
 unsigned long lastClickTime = 0;      // Timer for double click speed
 const int DOUBLE_CLICK_GAP = 400;     // Time (ms) to wait for a second click
@@ -28,7 +39,12 @@ const int DOUBLE_CLICK_GAP = 400;     // Time (ms) to wait for a second click
 TaskHandle_t refreshTaskHandle = NULL;
 TaskHandle_t clockTaskHandle = NULL;
 TaskHandle_t ntpTaskHandle = NULL;
-SemaphoreHandle_t i2cMutex = NULL; // NEW: protect Wire/RTC access
+
+// WiFi setup portal (non-blocking, see wifimanager())
+WiFiManager wm;
+WiFiManagerParameter tzParam("tz", "Time zone (POSIX TZ)", TZ_DEFAULT, TZ_STRING_MAX - 1);
+WiFiManagerParameter apiParam("api", "HTTP API (1 = on, keeps WiFi up)", "0", 1);
+volatile bool portalActive = false;
 
 // Forward Declarations
 void Clock1Task(void *pvParameters);
@@ -39,11 +55,11 @@ void Clock5Task(void *pvParameters);
 void Clock6Task(void *pvParameters);
 void Clock7Task(void *pvParameters);
 void Clock8Task(void *pvParameters);
-bool myGetLocalTime(struct tm *timeinfo);
-void changeClockMode(int mode);
+void changeClockMode(int mode, byte transition = modeTransition);
 void backgroundSyncTask(void *pvParameters);
 void bright();
 void wifimanager();
+void wifiPortalLoop();
 void modeChange();
 
 // ------------------- Refresh Task -------------------
@@ -62,8 +78,16 @@ void setBrightness(int level)
     ledcWrite(PWM_CHANNEL, map(level, 0, 255, 0, (1 << PWM_RES) - 1));
 }
 
+// Is `hour` inside the night dimming window (which may wrap past midnight)?
+bool isNightHour(int hour)
+{
+    if (nightStartHour <= nightEndHour)
+        return hour >= nightStartHour && hour < nightEndHour;
+    return hour >= nightStartHour || hour < nightEndHour;
+}
+
 // ------------------- Helper: Switch Clock Mode -------------------
-void changeClockMode(int mode)
+void changeClockMode(int mode, byte transition)
 {
     // 1. Delete the currently running clock task if it exists
     if (clockTaskHandle != NULL)
@@ -72,8 +96,13 @@ void changeClockMode(int mode)
         clockTaskHandle = NULL;
     }
 
-    // 2. Clear Screen
-    dmd.clearScreen(true);
+    // 2. Draw the new face offscreen; the old one stays up until presentFrame() swaps it in
+    //    (the face is gone, so this task owns faceRing until the new one starts)
+    modeSwitchMillis = millis();
+    RenderClient gfx;
+    gfx.beginOffscreen();
+    switchTransition = transition;
+    transitionPending = true;
 
     // 3. Start the new task
     if (mode == 0)
@@ -111,51 +140,15 @@ void changeClockMode(int mode)
 }
 
 // ------------------- BACKGROUND WIFI/NTP TASK -------------------
-// Runs FOREVER. Checks connection every 10 seconds.
+// Runs FOREVER. Sleeps with the radio off between sync windows (radioScheduler.h);
+// a notification (new WiFi credentials) starts the next window early.
 void backgroundSyncTask(void *pvParameters)
 {
-    // Set NTP config once at the start
-    configTime(gmtOffset_sec, daylightOffset_sec, ntpServer1, ntpServer2, ntpServer3);
-
-    // Ensure we are in Station mode
-    WiFi.mode(WIFI_STA);
-
+    radioBegin();
     for (;;)
-    { // Infinite Loop
-
-        // 1. CHECK CONNECTION
-        if (WiFi.status() == WL_CONNECTED)
-        {
-            // --- We are Connected ---
-            struct tm timeinfo;
-            // Try to get time with short timeout (wait up to 200ms)
-            Serial.println("[Background] WiFi Connected. Fetching NTP...");
-            if (getLocalTime(&timeinfo, 200))
-            {
-                // Update RTC (try to take i2c mutex; skip if bus busy)
-                if (xSemaphoreTake(i2cMutex, pdMS_TO_TICKS(500)))
-                {
-                    rtc.adjust(DateTime(timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
-                                        timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec));
-                    xSemaphoreGive(i2cMutex);
-                    Serial.println("[Background] WiFi OK. RTC Updated.");
-                }
-                else
-                {
-                    Serial.println("[Background] I2C busy: skipping RTC update.");
-                }
-            }
-        }
-        else
-        {
-            // --- We are Disconnected ---
-            Serial.println("[Background] WiFi lost! Attempting Reconnect...");
-            // Try to reconnect using credentials saved by WiFiManager
-            WiFi.begin();
-        }
-
-        // 2. WAIT 10 SECONDS
-        vTaskDelay(pdMS_TO_TICKS(10000));
+    {
+        uint32_t next = radioSyncWindow();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(next * 1000UL));
     }
     // We never reach here, so no vTaskDelete needed.
 }
@@ -167,7 +160,9 @@ void modeChange()
         currentMode = 0;
 
     preferences.putInt("mode", currentMode);
-    Serial.println("Action: Switch Clock Mode");
+    Serial.print("Action: Switch Clock Mode (last switch took ");
+    Serial.print(lastSwitchLatency);
+    Serial.println(" ms)");
     changeClockMode(currentMode);
 }
 void bright()
@@ -182,45 +177,105 @@ void bright()
     preferences.putInt("brightIdx", brightnessIndex);
     Serial.print("Action: Brightness Level ");
     Serial.println(newLevel);
-    if (newLevel != 5){
-        if(_hour24 >= 0 && _hour24 <= 7)vTaskDelay(pdMS_TO_TICKS(1000));
+    // At night, show it for a moment; loop() holds off the night level meanwhile
+    if (newLevel != nightLevel && isNightHour(_hour24))
+        brightPreviewUntil = millis() + BRIGHT_PREVIEW_MS;
+}
+// ------------------- WiFi Setup Portal -------------------
+// A long press opens the portal in the background: wifiPortalLoop() services it
+// from loop() while the face keeps running, and a WiFi icon shows it is open.
+// New credentials are used straight away; no restart.
+static void finishPortal()
+{
+    portalActive = false;
+    setStatusIcon(STATUS_ICON_WIFI_SETUP, false);
+    // Sync now with whatever the portal left us (also turns the radio back off)
+    radioSyncNow();
+
+    // Against the saved setting, not apiEnabled: an off that is waiting for a restart
+    // leaves the server running, and turning it back on must still be saved
+    bool api = apiParam.getValue()[0] == '1';
+    if (api != preferences.getBool("api", false))
+    {
+        preferences.putBool("api", api);
+        if (api)
+        {
+            if (!apiEnabled)
+                startApi();
+        }
+        else
+        {
+            // The server task can't be stopped cleanly mid-request; takes effect after a restart
+            Serial.println("HTTP API off after the next restart");
+        }
+    }
+
+    const char *spec = tzParam.getValue();
+    if (strcmp(spec, tzString) == 0)
+        return;
+    TimeZone tz;
+    if (tzParse(spec, tz) && i2cSetTimeZone(tz))
+    {
+        strncpy(tzString, spec, TZ_STRING_MAX - 1);
+        preferences.putString("tz", tzString);
+        Serial.printf("Time zone set: %s\n", tzString);
+    }
+    else
+    {
+        Serial.printf("Ignoring bad time zone: %s\n", spec);
     }
-        
 }
+
 void wifimanager()
 {
+    // A second long press closes the portal
+    if (portalActive)
+    {
+        Serial.println("Long Press: Closing WiFi Config Portal");
+        wm.stopConfigPortal();
+        finishPortal();
+        return;
+    }
     Serial.println("Long Press: Entering WiFi Config Portal");
 
-    // Stop other tasks
-    if (clockTaskHandle != NULL)
-        vTaskDelete(clockTaskHandle);
-    if (ntpTaskHandle != NULL)
-        vTaskDelete(ntpTaskHandle);
+    static bool configured = false;
+    if (!configured)
+    {
+        wm.setClass("invert");
+        wm.setTitle("Setup WiFi");
+        wm.setConnectTimeout(20);
 
-    dmd.clearScreen(true);
-    dmd.selectFont(SystemFont5x7);
-    dmd.drawString(5, 0, "WIFI", 4, GRAPHICS_NORMAL);
-    dmd.drawString(1, 8, "SETUP", 5, GRAPHICS_NORMAL);
+        const char *customHead = "<style>body{background:#e0ffe0;}button{background-color:red !important;}</style>";
+        wm.setCustomHeadElement(customHead);
 
-    WiFiManager wm;
-    wm.setClass("invert");
-    wm.setTitle("Setup WiFi");
-    wm.setConnectTimeout(20);
+        std::vector<const char *> menu = {"wifi", "restart", "exit"};
+        wm.setMenu(menu);
+        wm.setConfigPortalTimeout(120);
+        wm.setConfigPortalBlocking(false);
 
-    const char *customHead = "<style>body{background:#e0ffe0;}button{background-color:red !important;}</style>";
-    wm.setCustomHeadElement(customHead);
+        // Time zone field on the WiFi page, e.g. CET-1CEST,M3.5.0,M10.5.0/3
+        wm.addParameter(&tzParam);
+        wm.addParameter(&apiParam);
+        configured = true;
+    }
+    tzParam.setValue(tzString, TZ_STRING_MAX - 1);
+    apiParam.setValue(preferences.getBool("api", false) ? "1" : "0", 1);
 
-    std::vector<const char *> menu = {"wifi", "restart", "exit"};
-    wm.setMenu(menu);
-    wm.setConfigPortalTimeout(120);
+    wm.startConfigPortal("Smart Clock");
+    portalActive = true;
+    setStatusIcon(STATUS_ICON_WIFI_SETUP, true);
+}
 
-    if (!wm.startConfigPortal("Smart Clock"))
-    {
-        Serial.println("Setup timed out");
-    }
-    else
-    {
+// Call from loop(). Returns at once when the portal is closed.
+void wifiPortalLoop()
+{
+    if (!portalActive)
+        return;
+    if (wm.process())
         Serial.println("WiFi Saved");
+    if (!wm.getConfigPortalActive())
+    {
+        Serial.println(WiFi.status() == WL_CONNECTED ? "WiFi Connected" : "Setup closed");
+        finishPortal();
     }
-    ESP.restart();
-}
\ No newline at end of file
+}
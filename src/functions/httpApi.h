@@ -0,0 +1,385 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WebServer.h>
+#include "Clocks.h"
+#include "timezone.h"
+#include "i2cService.h"
+#include "ntpSync.h"
+#include "radioScheduler.h"
+#include "mirror.h"
+#include "frameSync.h"
+
+// ================================================================
+//                    LOCAL HTTP/JSON CONTROL API
+// ================================================================
+// Served by apiTask() on core 0, so a slow client never touches the display
+// tasks on core 1. Parameters come as query string or form fields; every reply
+// is JSON. Handlers never call into the face or render tasks directly: a mode
+// change is handed to loop() through apiRequestedMode, brightness is applied
+// by loop() on its next pass, and a message goes into the ticker queue.
+//
+//   GET  /api/status                       everything below in one object
+//   POST /api/mode        mode=0..7
+//   POST /api/brightness  index=0..2  levels=a,b,c (0-255)
+//   POST /api/schedule    start=h  end=h  level=0-255   night dimming, end exclusive
+//   POST /api/timezone    tz=<POSIX TZ>
+//   POST /api/message     text=...  priority=0-9  repeat=0-255  speed=ms  ttl=s
+//                                                       shown on the Clock7 ticker, see messageQueue.h
+//   POST /api/mirror      enabled=0|1  host=a.b.c.d  port=n   framebuffer stream, see mirror.h
+//   POST /api/framesync   enabled=0|1                   lock frame ticks to other clocks, see frameSync.h
+//   POST /api/language    lang=en|bn                    Clock4 digits and weekday in English or Bengali
+//   GET  /api/stats                        request latency, I2C, sync, radio, mirror, ticker and frame sync counters
+//   GET  /api/sync                         the last SYNC_HISTORY_LEN NTP measurements, oldest first
+//
+// The API keeps the radio up (RADIO_HOLD_API), so it is off by default; it is
+// switched on from the WiFi setup portal and saved as "api".
+
+#define API_PORT 80
+#define API_POLL_MS 5
+#define API_BURST_MAX 8 // requests served back to back before the task sleeps again
+#define API_JSON_MAX 1152
+
+extern Preferences preferences;
+extern int currentMode;
+extern int brightnessIndex;
+extern int brightnessValues[3];
+extern int nightStartHour, nightEndHour, nightLevel;
+extern std::atomic<int> apiRequestedMode;
+
+struct ApiStats
+{
+    uint32_t requests;
+    uint32_t errors;     // 4xx replies
+    uint32_t avgLatencyUs; // handler start to reply sent, running average
+    uint32_t maxLatencyUs;
+};
+
+WebServer apiServer(API_PORT);
+ApiStats apiStats;
+bool apiEnabled = false;
+TaskHandle_t apiTaskHandle = NULL;
+
+static uint32_t apiStartMicros = 0;
+
+static void apiReply(int code, const char *json)
+{
+    apiServer.send(code, "application/json", json);
+    uint32_t latency = (uint32_t)micros() - apiStartMicros;
+    apiStats.requests++;
+    if (code >= 400)
+        apiStats.errors++;
+    apiStats.avgLatencyUs = apiStats.avgLatencyUs ? (apiStats.avgLatencyUs * 7 + latency) / 8 : latency;
+    if (latency > apiStats.maxLatencyUs)
+        apiStats.maxLatencyUs = latency;
+}
+
+static void apiError(const char *message)
+{
+    char json[96];
+    snprintf(json, sizeof(json), "{\"error\":\"%s\"}", message);
+    apiReply(400, json);
+}
+
+// Integer argument in [lo, hi]. False if missing or out of range.
+static bool apiIntArg(const char *name, int lo, int hi, int &value)
+{
+    if (!apiServer.hasArg(name))
+        return false;
+    String s = apiServer.arg(name);
+    char *end;
+    long v = strtol(s.c_str(), &end, 10);
+    if (s.length() == 0 || *end != '\0' || v < lo || v > hi)
+        return false;
+    value = v;
+    return true;
+}
+
+// Copy `s` into a JSON string body, escaping quotes, backslashes and control characters
+static void apiEscape(char *out, size_t size, const char *s)
+{
+    size_t n = 0;
+    for (; *s && n + 7 < size; s++)
+    {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\')
+        {
+            out[n++] = '\\';
+            out[n++] = c;
+        }
+        else if (c < 0x20)
+        {
+            n += snprintf(out + n, size - n, "\\u%04x", c);
+        }
+        else
+        {
+            out[n++] = c;
+        }
+    }
+    out[n] = '\0';
+}
+
+// ------------------- Handlers -------------------
+static void apiStatus()
+{
+    apiStartMicros = micros();
+    char tz[TZ_STRING_MAX * 2];
+    apiEscape(tz, sizeof(tz), tzString);
+    DateTime now;
+    bool timeValid = readClock(now);
+    char json[API_JSON_MAX];
+    snprintf(json, sizeof(json),
+             "{\"mode\":%d,\"brightness\":{\"index\":%d,\"levels\":[%d,%d,%d]},"
+             "\"schedule\":{\"start\":%d,\"end\":%d,\"level\":%d},\"tz\":\"%s\","
+             "\"time\":\"%04d-%02d-%02d %02d:%02d:%02d\",\"timeValid\":%s,\"lang\":\"%s\"}",
+             currentMode, brightnessIndex, brightnessValues[0], brightnessValues[1], brightnessValues[2],
+             nightStartHour, nightEndHour, nightLevel, tz,
+             now.year(), now.month(), now.day(), now.hour(), now.minute(), now.second(),
+             timeValid ? "true" : "false", banglaText ? "bn" : "en");
+    apiReply(200, json);
+}
+
+static void apiMode()
+{
+    apiStartMicros = micros();
+    int mode;
+    if (!apiIntArg("mode", 0, 7, mode))
+        return apiError("mode must be 0-7");
+    apiRequestedMode = mode;
+    char json[32];
+    snprintf(json, sizeof(json), "{\"mode\":%d}", mode);
+    apiReply(200, json);
+}
+
+static void apiBrightness()
+{
+    apiStartMicros = micros();
+    int index = brightnessIndex;
+    if (apiServer.hasArg("index") && !apiIntArg("index", 0, 2, index))
+        return apiError("index must be 0-2");
+
+    int levels[3] = {brightnessValues[0], brightnessValues[1], brightnessValues[2]};
+    if (apiServer.hasArg("levels"))
+    {
+        String s = apiServer.arg("levels");
+        if (sscanf(s.c_str(), "%d,%d,%d", &levels[0], &levels[1], &levels[2]) != 3)
+            return apiError("levels must be a,b,c");
+        for (int i = 0; i < 3; i++)
+            if (levels[i] < 0 || levels[i] > 255)
+                return apiError("levels must be 0-255");
+        for (int i = 0; i < 3; i++)
+            brightnessValues[i] = levels[i];
+        uint8_t stored[3] = {(uint8_t)levels[0], (uint8_t)levels[1], (uint8_t)levels[2]};
+        preferences.putBytes("brightLvls", stored, sizeof(stored));
+    }
+    if (index != brightnessIndex)
+    {
+        brightnessIndex = index;
+        preferences.putInt("brightIdx", brightnessIndex);
+    }
+    // loop() applies it on its next pass
+    char json[96];
+    snprintf(json, sizeof(json), "{\"index\":%d,\"levels\":[%d,%d,%d]}",
+             brightnessIndex, brightnessValues[0], brightnessValues[1], brightnessValues[2]);
+    apiReply(200, json);
+}
+
+static void apiSchedule()
+{
+    apiStartMicros = micros();
+    int start = nightStartHour, end = nightEndHour, level = nightLevel;
+    if ((apiServer.hasArg("start") && !apiIntArg("start", 0, 23, start)) ||
+        (apiServer.hasArg("end") && !apiIntArg("end", 0, 24, end)) ||
+        (apiServer.hasArg("level") && !apiIntArg("level", 0, 255, level)))
+        return apiError("start 0-23, end 0-24, level 0-255");
+    nightStartHour = start;
+    nightEndHour = end;
+    nightLevel = level;
+    preferences.putInt("nightStart", start);
+    preferences.putInt("nightEnd", end);
+    preferences.putInt("nightLevel", level);
+    char json[80];
+    snprintf(json, sizeof(json), "{\"start\":%d,\"end\":%d,\"level\":%d}", start, end, level);
+    apiReply(200, json);
+}
+
+static void apiTimezone()
+{
+    apiStartMicros = micros();
+    String spec = apiServer.arg("tz");
+    TimeZone tz;
+    if (spec.length() == 0 || spec.length() >= TZ_STRING_MAX || !tzParse(spec.c_str(), tz))
+        return apiError("tz must be a POSIX TZ string");
+    if (!i2cSetTimeZone(tz))
+        return apiError("time zone not applied");
+    strcpy(tzString, spec.c_str());
+    preferences.putString("tz", tzString);
+    char escaped[TZ_STRING_MAX * 2], json[TZ_STRING_MAX * 2 + 16];
+    apiEscape(escaped, sizeof(escaped), tzString);
+    snprintf(json, sizeof(json), "{\"tz\":\"%s\"}", escaped);
+    apiReply(200, json);
+}
+
+static void apiMessage()
+{
+    apiStartMicros = micros();
+    String text = apiServer.arg("text");
+    if (text.length() == 0 || text.length() >= TICKER_TEXT_MAX)
+        return apiError("text must be 1-63 characters");
+    int priority = 5, repeats = 1, speed = TICKER_SPEED_DEFAULT_MS, ttl = 0;
+    if ((apiServer.hasArg("priority") && !apiIntArg("priority", 0, TICKER_PRIORITY_MAX, priority)) ||
+        (apiServer.hasArg("repeat") && !apiIntArg("repeat", 0, 255, repeats)) ||
+        (apiServer.hasArg("speed") && !apiIntArg("speed", TICKER_SPEED_MIN_MS, TICKER_SPEED_MAX_MS, speed)) ||
+        (apiServer.hasArg("ttl") && !apiIntArg("ttl", 0, 86400, ttl)))
+        return apiError("priority 0-9, repeat 0-255, speed 20-500 ms, ttl 0-86400 s");
+    uint32_t id = tickerPost(text.c_str(), priority, repeats, speed, ttl * 1000UL);
+    if (id == 0)
+        return apiError("queue full of higher priority messages");
+    char json[48];
+    snprintf(json, sizeof(json), "{\"queued\":true,\"id\":%u}", id);
+    apiReply(200, json);
+}
+
+static void apiMirror()
+{
+    apiStartMicros = micros();
+    int enabled = mirrorEnabled, port = mirrorPort;
+    IPAddress host = mirrorHost;
+    if ((apiServer.hasArg("enabled") && !apiIntArg("enabled", 0, 1, enabled)) ||
+        (apiServer.hasArg("port") && !apiIntArg("port", 1, 65535, port)) ||
+        (apiServer.hasArg("host") && !host.fromString(apiServer.arg("host").c_str())))
+        return apiError("enabled 0-1, host a.b.c.d, port 1-65535");
+    mirrorHost = host;
+    mirrorPort = port;
+    preferences.putString("mirrorHost", host.toString().c_str());
+    preferences.putUShort("mirrorPort", port);
+    preferences.putBool("mirror", enabled);
+    mirrorSetEnabled(enabled);
+    char json[80];
+    snprintf(json, sizeof(json), "{\"enabled\":%s,\"host\":\"%s\",\"port\":%d}",
+             enabled ? "true" : "false", host.toString().c_str(), port);
+    apiReply(200, json);
+}
+
+static void apiFrameSync()
+{
+    apiStartMicros = micros();
+    int enabled;
+    if (!apiIntArg("enabled", 0, 1, enabled))
+        return apiError("enabled must be 0-1");
+    preferences.putBool("fsync", enabled);
+    frameSyncSetEnabled(enabled);
+    apiReply(200, enabled ? "{\"enabled\":true}" : "{\"enabled\":false}");
+}
+
+static void apiLanguage()
+{
+    apiStartMicros = micros();
+    String lang = apiServer.arg("lang");
+    if (lang != "en" && lang != "bn")
+        return apiError("lang must be en or bn");
+    banglaText = lang == "bn";
+    preferences.putString("lang", lang.c_str());
+    apiReply(200, banglaText ? "{\"lang\":\"bn\"}" : "{\"lang\":\"en\"}");
+}
+
+static void apiStatsHandler()
+{
+    apiStartMicros = micros();
+    char json[API_JSON_MAX];
+    snprintf(json, sizeof(json),
+             "{\"api\":{\"requests\":%u,\"errors\":%u,\"avgLatencyUs\":%u,\"maxLatencyUs\":%u},"
+             "\"i2c\":{\"jobs\":%u,\"jobErrors\":%u,\"busErrors\":%u,\"recoveries\":%u,\"avgLatencyUs\":%u,"
+             "\"retries\":%u,\"implausible\":%u,\"timeReadErrors\":%u,\"timeJumps\":%u},"
+             "\"sync\":{\"measurements\":%u,\"rtcWrites\":%u,\"intervalS\":%u,\"driftPpm\":%.2f,\"aging\":%d,"
+             "\"lastResidualUs\":%d},"
+             "\"radio\":{\"windows\":%u,\"failedWindows\":%u,\"onS\":%u,\"offS\":%u,\"savedMah\":%.1f},"
+             "\"mirror\":{\"packets\":%u,\"keyframes\":%u,\"bytes\":%u,\"rateLimited\":%u,\"sendErrors\":%u},"
+             "\"ticker\":{\"posted\":%u,\"rejected\":%u,\"replaced\":%u,\"expired\":%u,\"preempted\":%u},"
+             "\"framesync\":{\"role\":%u,\"master\":\"%08x\",\"skewUs\":%d,\"maxSkewUs\":%u,\"jitterUs\":%u,"
+             "\"steps\":%u,\"beaconsSent\":%u,\"beaconsReceived\":%u}}",
+             apiStats.requests, apiStats.errors, apiStats.avgLatencyUs, apiStats.maxLatencyUs,
+             i2cStats.jobs, i2cStats.jobErrors, i2cStats.busErrors, i2cStats.recoveries, i2cStats.avgLatencyUs,
+             i2cStats.retries, i2cStats.implausible, i2cStats.timeReadErrors, i2cStats.timeJumps,
+             syncStats.measurements, syncStats.rtcWrites, syncStats.intervalS, syncStats.driftPpm, syncStats.aging,
+             syncStats.lastResidualUs,
+             radioStats.windows, radioStats.failedWindows, radioStats.radioOnMs / 1000, radioStats.radioOffMs / 1000,
+             radioStats.energySavedMah,
+             mirrorStats.packets, mirrorStats.keyframes, mirrorStats.bytes, mirrorStats.rateLimited,
+             mirrorStats.sendErrors,
+             tickerStats.posted, tickerStats.rejected, tickerStats.replaced, tickerStats.expired, tickerStats.preempted,
+             frameSyncStats.role, frameSyncStats.masterId, frameSyncStats.skewUs, frameSyncStats.maxSkewUs,
+             frameSyncStats.jitterUs, frameSyncStats.steps, frameSyncStats.beaconsSent, frameSyncStats.beaconsReceived);
+    apiReply(200, json);
+}
+
+static void apiSync()
+{
+    apiStartMicros = micros();
+    // The sync task may add a sample meanwhile: work from one count and start
+    uint8_t count = syncHistoryCount;
+    uint8_t first = (syncHistoryNext + SYNC_HISTORY_LEN - count) % SYNC_HISTORY_LEN;
+    char json[API_JSON_MAX];
+    int n = snprintf(json, sizeof(json), "{\"history\":[");
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const SyncSample &s = syncHistory[(first + i) % SYNC_HISTORY_LEN];
+        n += snprintf(json + n, sizeof(json) - n, "%s{\"t\":%u,\"offsetMs\":%d,\"written\":%s}", i ? "," : "",
+                      s.ntpTime, s.offsetMs, s.rtcWritten ? "true" : "false");
+    }
+    snprintf(json + n, sizeof(json) - n, "]}");
+    apiReply(200, json);
+}
+
+static void apiNotFound()
+{
+    apiStartMicros = micros();
+    apiError("unknown endpoint");
+}
+
+// ------------------- Task -------------------
+void apiTask(void *pvParameters)
+{
+    apiServer.on("/api/status", HTTP_GET, apiStatus);
+    apiServer.on("/api/mode", HTTP_POST, apiMode);
+    apiServer.on("/api/brightness", HTTP_POST, apiBrightness);
+    apiServer.on("/api/schedule", HTTP_POST, apiSchedule);
+    apiServer.on("/api/timezone", HTTP_POST, apiTimezone);
+    apiServer.on("/api/message", HTTP_POST, apiMessage);
+    apiServer.on("/api/mirror", HTTP_POST, apiMirror);
+    apiServer.on("/api/framesync", HTTP_POST, apiFrameSync);
+    apiServer.on("/api/language", HTTP_POST, apiLanguage);
+    apiServer.on("/api/stats", HTTP_GET, apiStatsHandler);
+    apiServer.on("/api/sync", HTTP_GET, apiSync);
+    apiServer.onNotFound(apiNotFound);
+
+    // The network stack is up once the radio scheduler has connected
+    while (WiFi.status() != WL_CONNECTED)
+        vTaskDelay(pdMS_TO_TICKS(500));
+    apiServer.begin();
+    Serial.println("[API] Listening on port 80");
+
+    for (;;)
+    {
+        // handleClient() serves at most one request: keep going while they queue up,
+        // rather than making each one wait out a poll
+        for (int i = 0; i < API_BURST_MAX; i++)
+        {
+            uint32_t served = apiStats.requests;
+            apiServer.handleClient();
+            if (apiStats.requests == served)
+                break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(API_POLL_MS));
+    }
+}
+
+// Call from setup(). Does nothing unless the API is switched on.
+void startApi()
+{
+    apiEnabled = preferences.getBool("api", false);
+    if (!apiEnabled)
+        return;
+    radioHold(RADIO_HOLD_API, true);
+    xTaskCreatePinnedToCore(apiTask, "api", 8192, NULL, 1, &apiTaskHandle, 0);
+}
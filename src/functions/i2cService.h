@@ -0,0 +1,371 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <Wire.h>
+#include <RTClib.h>
+#include "ds3231.h"
+#include "timezone.h"
+
+// ================================================================
+//                    I2C BUS-OWNER TASK
+// ================================================================
+// i2cServiceTask() is the only code that touches Wire after setup().
+// - It polls the RTC every I2C_TIME_POLL_MS and publishes the result as a
+//   snapshot. Faces read the snapshot (readClock()) and never wait for the bus.
+//   Each poll is one burst of the whole DS3231 register map, so temperature
+//   and status come with the time at no extra bus cost (readRtcState()).
+//   The RTC keeps UTC; the snapshot also carries the local offset for that
+//   instant, worked out here once per poll from `timeZone`.
+// - Other clients queue jobs. A job is a function run in the I2C task with a
+//   completion callback. High and normal priority jobs have a queue each; every
+//   high job waiting runs before the next normal one, and each queue is first in,
+//   first out. The time poll runs between jobs once it is due.
+// - The bus runs at 400 kHz. A failed or implausible read is retried at once
+//   (no sleeping); repeated failures trigger a stuck-bus recovery that clocks
+//   SCL until the slave lets go of SDA.
+
+#define I2C_QUEUE_LEN 8
+#define I2C_TIME_POLL_MS 50
+
+#define I2C_SDA_PIN 21
+#define I2C_SCL_PIN 22
+#define I2C_FAST_HZ 400000
+#define I2C_READ_TRIES 3         // attempts per poll before giving up on it
+#define I2C_RECOVER_AFTER 3      // failed polls in a row before a bus recovery
+#define I2C_MAX_TIME_SKEW_S 2    // allowed gap between a read and the time we expect
+
+enum I2cPriority : uint8_t
+{
+    I2C_PRIO_NORMAL,
+    I2C_PRIO_HIGH
+};
+
+typedef bool (*I2cJobFn)(void *arg);            // runs in the I2C task; true on success
+typedef void (*I2cDoneFn)(bool ok, void *arg); // completion, also runs in the I2C task
+
+struct I2cJob
+{
+    I2cJobFn fn;
+    I2cDoneFn done;
+    void *arg;
+    uint32_t queuedMicros;
+};
+
+struct I2cStats
+{
+    uint32_t jobs;           // jobs completed
+    uint32_t jobErrors;      // jobs whose fn returned false
+    uint32_t rejected;       // submits refused because the queue was full
+    uint32_t timeReads;      // RTC polls
+    uint32_t timeReadErrors; // polls that gave up after I2C_READ_TRIES attempts
+    uint32_t busErrors;      // NACKs and short reads
+    uint32_t implausible;    // reads rejected by the BCD/range/continuity checks
+    uint32_t retries;        // immediate re-reads
+    uint32_t recoveries;     // stuck-bus recoveries run
+    uint32_t timeJumps;      // confirmed steps in RTC time (e.g. after an NTP set)
+    uint32_t avgLatencyUs;   // submit to completion, running average
+    uint32_t maxLatencyUs;
+};
+
+struct RtcSnapshot
+{
+    Ds3231State state;
+    int32_t utcOffsetS;  // local minus UTC at state.time
+    uint32_t readMillis; // millis() when the registers were read
+    bool valid;
+};
+
+QueueHandle_t i2cQueue = NULL;     // I2C_PRIO_NORMAL
+QueueHandle_t i2cHighQueue = NULL; // I2C_PRIO_HIGH
+TaskHandle_t i2cTaskHandle = NULL;
+I2cStats i2cStats;
+
+// Seqlock around the snapshot: odd while the I2C task is writing it
+static std::atomic<uint32_t> rtcSnapshotSeq{0};
+static RtcSnapshot rtcSnapshot;
+
+static TzCache snapshotTzCache = {0};
+static uint8_t failedPolls = 0;
+static bool expectTimeJump = true; // no baseline yet
+
+// ------------------- Client API -------------------
+// Queue a job for the I2C task. Returns false (and counts it) if the queue is full.
+bool i2cSubmit(I2cJobFn fn, I2cDoneFn done, void *arg, uint8_t priority = I2C_PRIO_NORMAL)
+{
+    I2cJob job = {fn, done, arg, (uint32_t)micros()};
+    if (xQueueSend(priority == I2C_PRIO_HIGH ? i2cHighQueue : i2cQueue, &job, 0) != pdPASS)
+    {
+        i2cStats.rejected++;
+        return false;
+    }
+    xTaskNotifyGive(i2cTaskHandle); // wake the service task
+    return true;
+}
+
+struct I2cWait
+{
+    I2cJobFn fn;
+    void *arg;
+    TaskHandle_t waiter;
+    bool ok;
+    std::atomic<bool> done;
+};
+
+static bool i2cWaitRun(void *arg)
+{
+    I2cWait *w = (I2cWait *)arg;
+    return w->fn(w->arg);
+}
+
+static void i2cWaitDone(bool ok, void *arg)
+{
+    I2cWait *w = (I2cWait *)arg;
+    TaskHandle_t waiter = w->waiter; // `w` may be gone once done is set
+    w->ok = ok;
+    w->done.store(true, std::memory_order_release);
+    xTaskNotifyGive(waiter);
+}
+
+// Run a job and block until it has finished. `arg` may live on the caller's stack.
+bool i2cTransact(I2cJobFn fn, void *arg, uint8_t priority = I2C_PRIO_NORMAL)
+{
+    I2cWait w = {fn, arg, xTaskGetCurrentTaskHandle(), false, {false}};
+    // Wait for room rather than fail: the caller is prepared to block anyway
+    while (!i2cSubmit(i2cWaitRun, i2cWaitDone, &w, priority))
+        vTaskDelay(pdMS_TO_TICKS(5));
+    // Other tasks notify the caller too (radioSyncNow()): wait for the job itself, then
+    // give back a notification that was meant for someone else
+    bool stray = false;
+    while (!w.done.load(std::memory_order_acquire))
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        stray |= !w.done.load(std::memory_order_acquire);
+    }
+    if (stray)
+        xTaskNotifyGive(w.waiter);
+    return w.ok;
+}
+
+static RtcSnapshot readSnapshot()
+{
+    RtcSnapshot snap;
+    uint32_t seq;
+    do
+    {
+        seq = rtcSnapshotSeq.load(std::memory_order_acquire);
+        snap = rtcSnapshot;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || seq != rtcSnapshotSeq.load(std::memory_order_relaxed));
+    return snap;
+}
+
+// Latest decoded DS3231 registers (time in UTC). False until the first plausible read.
+bool readRtcState(Ds3231State &state)
+{
+    RtcSnapshot snap = readSnapshot();
+    if (!snap.valid)
+        return false;
+    state = snap.state;
+    return true;
+}
+
+// Latest RTC time in UTC. False until the first plausible read.
+bool readClockUtc(DateTime &now)
+{
+    RtcSnapshot snap = readSnapshot();
+    if (!snap.valid)
+        return false;
+    now = snap.state.time;
+    return true;
+}
+
+// Latest local time. False until the first plausible read.
+bool readClock(DateTime &now)
+{
+    RtcSnapshot snap = readSnapshot();
+    if (!snap.valid)
+        return false;
+    now = snap.state.time + TimeSpan(snap.utcOffsetS);
+    return true;
+}
+
+static bool setTimeZoneJob(void *arg)
+{
+    timeZone = *(const TimeZone *)arg;
+    snapshotTzCache.year = 0;
+    return true;
+}
+
+// Switch time zone at run time. Done in the I2C task, which owns the snapshot's cache.
+bool i2cSetTimeZone(const TimeZone &tz)
+{
+    TimeZone copy = tz;
+    return i2cTransact(setTimeZoneJob, &copy);
+}
+
+// ------------------- Service Task -------------------
+static void publishSnapshot(const Ds3231State &state)
+{
+    rtcSnapshotSeq.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    rtcSnapshot.state = state;
+    rtcSnapshot.utcOffsetS = tzOffset(timeZone, snapshotTzCache, state.time.unixtime());
+    rtcSnapshot.readMillis = millis();
+    rtcSnapshot.valid = true;
+    rtcSnapshotSeq.fetch_add(1, std::memory_order_release);
+}
+
+// ------------------- Bus Recovery -------------------
+// A slave reset mid-read can hold SDA low forever. Clock SCL (up to 9 pulses)
+// until SDA is released, send a STOP, then hand the pins back to Wire.
+bool i2cBusRecover()
+{
+    pinMode(I2C_SDA_PIN, INPUT_PULLUP);
+    pinMode(I2C_SCL_PIN, OUTPUT_OPEN_DRAIN);
+    digitalWrite(I2C_SCL_PIN, HIGH);
+    delayMicroseconds(5);
+
+    for (uint8_t i = 0; i < 9 && digitalRead(I2C_SDA_PIN) == LOW; i++)
+    {
+        digitalWrite(I2C_SCL_PIN, LOW);
+        delayMicroseconds(5);
+        digitalWrite(I2C_SCL_PIN, HIGH);
+        delayMicroseconds(5);
+    }
+    bool released = digitalRead(I2C_SDA_PIN) == HIGH;
+
+    // STOP: SDA low -> high while SCL is high
+    pinMode(I2C_SDA_PIN, OUTPUT_OPEN_DRAIN);
+    digitalWrite(I2C_SDA_PIN, LOW);
+    delayMicroseconds(5);
+    digitalWrite(I2C_SDA_PIN, HIGH);
+    delayMicroseconds(5);
+
+    Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN, I2C_FAST_HZ);
+    return released;
+}
+
+// Tell the poller the RTC time is about to step (after rtc.adjust())
+void i2cExpectTimeJump()
+{
+    expectTimeJump = true;
+}
+
+// ------------------- Time Poll -------------------
+// Is `state` where the previous snapshot says the clock should be by now?
+static bool continuous(const Ds3231State &state)
+{
+    if (expectTimeJump || !rtcSnapshot.valid)
+        return true;
+    int32_t expected = rtcSnapshot.state.time.unixtime() + (millis() - rtcSnapshot.readMillis) / 1000;
+    int32_t skew = (int32_t)state.time.unixtime() - expected;
+    return skew >= -I2C_MAX_TIME_SKEW_S && skew <= I2C_MAX_TIME_SKEW_S;
+}
+
+static bool readPlausible(Ds3231State &state)
+{
+    if (!ds3231ReadAll(Wire, state))
+    {
+        i2cStats.busErrors++;
+        return false;
+    }
+    if (state.time.year() <= 2000)
+    {
+        i2cStats.implausible++;
+        return false;
+    }
+    return true;
+}
+
+static void pollTime()
+{
+    Ds3231State state;
+    i2cStats.timeReads++;
+    for (uint8_t attempt = 0; attempt < I2C_READ_TRIES; attempt++)
+    {
+        if (attempt > 0)
+            i2cStats.retries++;
+        if (!readPlausible(state))
+            continue;
+        if (!continuous(state))
+        {
+            // A jump is real only if an immediate second read agrees with it
+            Ds3231State again;
+            i2cStats.retries++;
+            if (!readPlausible(again))
+                continue;
+            uint32_t a = state.time.unixtime(), b = again.time.unixtime();
+            if (b != a && b != a + 1)
+            {
+                i2cStats.implausible++;
+                continue;
+            }
+            i2cStats.timeJumps++;
+            state = again;
+        }
+        expectTimeJump = false;
+        failedPolls = 0;
+        publishSnapshot(state);
+        return;
+    }
+
+    i2cStats.timeReadErrors++;
+    if (++failedPolls >= I2C_RECOVER_AFTER)
+    {
+        failedPolls = 0;
+        i2cStats.recoveries++;
+        i2cBusRecover();
+    }
+}
+
+static void runJob(const I2cJob &job)
+{
+    bool ok = job.fn(job.arg);
+    uint32_t latency = (uint32_t)micros() - job.queuedMicros;
+    i2cStats.jobs++;
+    if (!ok)
+        i2cStats.jobErrors++;
+    i2cStats.avgLatencyUs = i2cStats.avgLatencyUs ? (i2cStats.avgLatencyUs * 7 + latency) / 8 : latency;
+    if (latency > i2cStats.maxLatencyUs)
+        i2cStats.maxLatencyUs = latency;
+    if (job.done)
+        job.done(ok, job.arg);
+}
+
+void i2cServiceTask(void *pvParameters)
+{
+    TickType_t lastPoll = xTaskGetTickCount();
+    pollTime();
+    for (;;)
+    {
+        TickType_t elapsed = xTaskGetTickCount() - lastPoll;
+        TickType_t wait = elapsed >= pdMS_TO_TICKS(I2C_TIME_POLL_MS) ? 0 : pdMS_TO_TICKS(I2C_TIME_POLL_MS) - elapsed;
+
+        // Woken by a submit, or by the timeout for the next poll
+        ulTaskNotifyTake(pdTRUE, wait);
+        I2cJob job;
+        while (xQueueReceive(i2cHighQueue, &job, 0) == pdTRUE)
+            runJob(job);
+        if (xQueueReceive(i2cQueue, &job, 0) == pdTRUE)
+        {
+            runJob(job);
+            xTaskNotifyGive(xTaskGetCurrentTaskHandle()); // come straight back for the rest
+        }
+
+        if (xTaskGetTickCount() - lastPoll >= pdMS_TO_TICKS(I2C_TIME_POLL_MS))
+        {
+            lastPoll = xTaskGetTickCount();
+            pollTime();
+        }
+    }
+}
+
+// Call from setup() once Wire and the RTC are initialised
+bool startI2cService()
+{
+    i2cQueue = xQueueCreate(I2C_QUEUE_LEN, sizeof(I2cJob));
+    i2cHighQueue = xQueueCreate(I2C_QUEUE_LEN, sizeof(I2cJob));
+    if (i2cQueue == NULL || i2cHighQueue == NULL)
+        return false;
+    return xTaskCreatePinnedToCore(i2cServiceTask, "i2c", 4096, NULL, 3, &i2cTaskHandle, 0) == pdPASS;
+}
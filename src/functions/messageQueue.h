@@ -0,0 +1,179 @@
+#pragma once
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+// ================================================================
+//                  PRIORITY TICKER MESSAGE QUEUE
+// ================================================================
+// Messages for the Clock7 ticker (posted by the HTTP API). A fixed table of
+// TICKER_QUEUE_LEN slots, no heap: posting copies the text into a free slot.
+//
+// The ticker always shows the highest-priority live message (oldest first on
+// a tie), and the date when there is none. A message posted with a higher
+// priority than the one scrolling takes over at the next scroll step; the one
+// it interrupted keeps its scroll position in its slot and carries on from
+// there when it is back on top.
+//
+// A message leaves the table after `repeats` full passes, or when it expires,
+// whichever comes first (repeats 0 = until it expires). When the table is full
+// a new message replaces the lowest-priority one, if it outranks it.
+//
+// Locked with a critical section rather than a mutex: changeClockMode() deletes
+// Clock7 at arbitrary points, and a task cannot be switched out inside one.
+
+#define TICKER_QUEUE_LEN 8
+#define TICKER_TEXT_MAX 64
+#define TICKER_PRIORITY_MAX 9
+#define TICKER_SPEED_MIN_MS 20   // per pixel step
+#define TICKER_SPEED_MAX_MS 500
+#define TICKER_SPEED_DEFAULT_MS 100
+#define TICKER_START_X 32        // enters from the right edge
+
+struct TickerMessage
+{
+    char text[TICKER_TEXT_MAX];
+    uint32_t id;        // 0 = free slot; also orders messages of equal priority
+    uint8_t priority;   // 0..TICKER_PRIORITY_MAX, higher first
+    uint8_t repeats;    // passes left, 0 = until expiry
+    uint16_t speedMs;   // ms per pixel step
+    uint32_t expiresAt; // millis(), 0 = never
+    int16_t resumeX;    // where the scroll stopped if it was interrupted
+};
+
+struct TickerStats
+{
+    uint32_t posted;
+    uint32_t rejected;   // table full of messages that outrank it
+    uint32_t replaced;   // dropped to make room
+    uint32_t expired;
+    uint32_t preempted;  // scrolls interrupted by a higher priority
+};
+
+TickerStats tickerStats;
+
+static TickerMessage tickerSlots[TICKER_QUEUE_LEN];
+static uint32_t tickerNextId = 1;
+static portMUX_TYPE tickerMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Does slot a come before slot b?
+static inline bool tickerBefore(const TickerMessage &a, const TickerMessage &b)
+{
+    return a.priority != b.priority ? a.priority > b.priority : (int32_t)(a.id - b.id) < 0;
+}
+
+static inline bool tickerExpired(const TickerMessage &m, uint32_t now)
+{
+    return m.expiresAt != 0 && (int32_t)(now - m.expiresAt) >= 0;
+}
+
+// Queue a message. Returns its id, 0 if the table is full of messages that outrank it.
+uint32_t tickerPost(const char *text, uint8_t priority, uint8_t repeats, uint16_t speedMs, uint32_t ttlMs)
+{
+    if (repeats == 0 && ttlMs == 0)
+        repeats = 1; // would never leave
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&tickerMux);
+    int slot = -1;
+    for (int i = 0; i < TICKER_QUEUE_LEN; i++)
+    {
+        TickerMessage &m = tickerSlots[i];
+        if (m.id != 0 && tickerExpired(m, now))
+        {
+            m.id = 0;
+            tickerStats.expired++;
+        }
+        if (m.id == 0)
+        {
+            if (slot < 0 || tickerSlots[slot].id != 0)
+                slot = i;
+        }
+        else if (slot < 0 || (tickerSlots[slot].id != 0 && tickerBefore(tickerSlots[slot], m)))
+        {
+            slot = i; // lowest ranked so far, the one to replace if nothing is free
+        }
+    }
+    TickerMessage &m = tickerSlots[slot];
+    if (m.id != 0)
+    {
+        if (m.priority >= priority)
+        {
+            tickerStats.rejected++;
+            portEXIT_CRITICAL(&tickerMux);
+            return 0;
+        }
+        tickerStats.replaced++;
+    }
+    strncpy(m.text, text, TICKER_TEXT_MAX - 1);
+    m.text[TICKER_TEXT_MAX - 1] = '\0';
+    m.priority = priority > TICKER_PRIORITY_MAX ? TICKER_PRIORITY_MAX : priority;
+    m.repeats = repeats;
+    m.speedMs = constrain(speedMs, TICKER_SPEED_MIN_MS, TICKER_SPEED_MAX_MS);
+    m.expiresAt = ttlMs ? (now + ttlMs) | 1 : 0; // 0 is never
+    m.resumeX = TICKER_START_X;
+    m.id = tickerNextId++;
+    if (tickerNextId == 0)
+        tickerNextId = 1;
+    tickerStats.posted++;
+    uint32_t id = m.id;
+    portEXIT_CRITICAL(&tickerMux);
+    return id;
+}
+
+// ------------------- Ticker Side -------------------
+// Copy of the message that should be on screen now. False if there is none (show the date).
+bool tickerTop(TickerMessage &out)
+{
+    uint32_t now = millis();
+    portENTER_CRITICAL(&tickerMux);
+    int top = -1;
+    for (int i = 0; i < TICKER_QUEUE_LEN; i++)
+    {
+        TickerMessage &m = tickerSlots[i];
+        if (m.id == 0)
+            continue;
+        if (tickerExpired(m, now))
+        {
+            m.id = 0;
+            tickerStats.expired++;
+            continue;
+        }
+        if (top < 0 || tickerBefore(m, tickerSlots[top]))
+            top = i;
+    }
+    if (top >= 0)
+        out = tickerSlots[top];
+    portEXIT_CRITICAL(&tickerMux);
+    return top >= 0;
+}
+
+// Remember where message `id` stopped, when something else takes the ticker
+void tickerPause(uint32_t id, int16_t x)
+{
+    portENTER_CRITICAL(&tickerMux);
+    for (int i = 0; i < TICKER_QUEUE_LEN; i++)
+    {
+        if (tickerSlots[i].id == id)
+        {
+            tickerSlots[i].resumeX = x;
+            tickerStats.preempted++;
+        }
+    }
+    portEXIT_CRITICAL(&tickerMux);
+}
+
+// Message `id` finished a full pass: count it off, and drop it when no passes are left
+void tickerPassDone(uint32_t id)
+{
+    portENTER_CRITICAL(&tickerMux);
+    for (int i = 0; i < TICKER_QUEUE_LEN; i++)
+    {
+        TickerMessage &m = tickerSlots[i];
+        if (m.id != id)
+            continue;
+        m.resumeX = TICKER_START_X;
+        if (m.repeats > 0 && --m.repeats == 0)
+            m.id = 0;
+    }
+    portEXIT_CRITICAL(&tickerMux);
+}
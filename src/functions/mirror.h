@@ -0,0 +1,185 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <Preferences.h>
+#include <DMD32.h>
+#include "frameCodec.h"
+#include "radioScheduler.h"
+
+// ================================================================
+//                  FRAMEBUFFER MIRROR OVER UDP
+// ================================================================
+// Streams what the panel shows to a dashboard, using frameCodec.h packets.
+// The render task calls mirrorCapture() after each batch of draw commands; it
+// only copies the frame into a seqlocked slot and wakes mirrorTask() on core 0,
+// which does the encoding and sending. Each packet is a delta against the last
+// frame sent, so a frame skipped by the rate limit is not lost, just merged.
+// - At most one packet per MIRROR_MIN_INTERVAL_MS.
+// - A byte budget (MIRROR_BYTES_PER_S, bursts up to MIRROR_BURST_BYTES).
+// - A keyframe every MIRROR_KEYFRAME_MS, and after any send failure, so a
+//   receiver that joined late or lost a packet catches up.
+// tools/mirror-decoder shows the stream on a PC.
+
+#define MIRROR_PORT 5005
+#define MIRROR_MIN_INTERVAL_MS 200
+#define MIRROR_KEYFRAME_MS 10000
+#define MIRROR_BYTES_PER_S 400
+#define MIRROR_BURST_BYTES 800
+#define MIRROR_FRAME_MAX DMD_RAM_SIZE_BYTES // one panel (dmd is 1x1)
+
+extern DMD dmd;
+extern Preferences preferences;
+
+struct MirrorStats
+{
+    uint32_t packets;
+    uint32_t keyframes;
+    uint32_t bytes;         // payload bytes sent, headers included
+    uint32_t rateLimited;   // sends put off by the interval or the byte budget
+    uint32_t sendErrors;
+};
+
+MirrorStats mirrorStats;
+volatile bool mirrorEnabled = false;
+IPAddress mirrorHost(255, 255, 255, 255); // broadcast unless configured
+uint16_t mirrorPort = MIRROR_PORT;
+TaskHandle_t mirrorTaskHandle = NULL;
+
+// Latest shown frame, written by the render task only
+static std::atomic<uint32_t> mirrorFrameSeq{0};
+static uint8_t mirrorFrame[MIRROR_FRAME_MAX];
+static int mirrorFrameLen = 0;
+
+// ------------------- Render Task Side -------------------
+// Copy the shown frame for the mirror task. Cheap: one memcpy and a notify.
+void mirrorCapture()
+{
+    if (!mirrorEnabled || mirrorTaskHandle == NULL)
+        return;
+    int len = dmd.frameBytes();
+    if (len > MIRROR_FRAME_MAX)
+        len = MIRROR_FRAME_MAX;
+    mirrorFrameSeq.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(mirrorFrame, dmd.shownFrame(), len);
+    mirrorFrameLen = len;
+    mirrorFrameSeq.fetch_add(1, std::memory_order_release);
+    xTaskNotifyGive(mirrorTaskHandle);
+}
+
+static int mirrorReadFrame(uint8_t *out)
+{
+    uint32_t seq;
+    int len;
+    do
+    {
+        seq = mirrorFrameSeq.load(std::memory_order_acquire);
+        len = mirrorFrameLen;
+        memcpy(out, mirrorFrame, MIRROR_FRAME_MAX);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || seq != mirrorFrameSeq.load(std::memory_order_relaxed));
+    return len;
+}
+
+// ------------------- Mirror Task -------------------
+void mirrorTask(void *pvParameters)
+{
+    WiFiUDP udp;
+    uint8_t frame[MIRROR_FRAME_MAX];
+    uint8_t sent[MIRROR_FRAME_MAX];
+    uint8_t packet[FRAME_PACKET_MAX(MIRROR_FRAME_MAX)];
+    bool haveSent = false;
+    uint16_t seq = 0;
+    unsigned long lastSend = 0, lastKey = 0, lastRefill = millis();
+    uint32_t budget = MIRROR_BURST_BYTES;
+    bool pending = true; // a frame not yet sent
+
+    for (;;)
+    {
+        // Woken by a new frame, or by the timeout for the next keyframe
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MIRROR_KEYFRAME_MS)) > 0)
+            pending = true;
+
+        unsigned long now = millis();
+        budget += (now - lastRefill) * MIRROR_BYTES_PER_S / 1000;
+        if (budget > MIRROR_BURST_BYTES)
+            budget = MIRROR_BURST_BYTES;
+        lastRefill = now;
+
+        bool keyframe = !haveSent || now - lastKey >= MIRROR_KEYFRAME_MS;
+        if (!mirrorEnabled || WiFi.status() != WL_CONNECTED)
+        {
+            haveSent = false; // start again with a keyframe
+            continue;
+        }
+        if (!pending && !keyframe)
+            continue;
+        if (now - lastSend < MIRROR_MIN_INTERVAL_MS)
+        {
+            mirrorStats.rateLimited++;
+            vTaskDelay(pdMS_TO_TICKS(MIRROR_MIN_INTERVAL_MS - (now - lastSend)));
+            xTaskNotifyGive(xTaskGetCurrentTaskHandle()); // come straight back round
+            continue;
+        }
+
+        int len = mirrorReadFrame(frame);
+        if (len == 0)
+            continue;
+        size_t n = frameEncode(haveSent ? sent : NULL, frame, len, seq, keyframe, packet, sizeof(packet));
+        if (n > budget && !keyframe)
+        {
+            // Wait for the budget; the delta grows but nothing is lost
+            mirrorStats.rateLimited++;
+            vTaskDelay(pdMS_TO_TICKS((n - budget) * 1000 / MIRROR_BYTES_PER_S + 1));
+            xTaskNotifyGive(xTaskGetCurrentTaskHandle());
+            continue;
+        }
+
+        if (!udp.beginPacket(mirrorHost, mirrorPort) || udp.write(packet, n) != n || !udp.endPacket())
+        {
+            mirrorStats.sendErrors++;
+            haveSent = false; // the receiver may be out of step: next one is a keyframe
+            continue;
+        }
+        budget = budget > n ? budget - n : 0;
+        memcpy(sent, frame, len);
+        haveSent = true;
+        pending = false;
+        seq++;
+        lastSend = now;
+        if (keyframe)
+        {
+            lastKey = now;
+            mirrorStats.keyframes++;
+        }
+        mirrorStats.packets++;
+        mirrorStats.bytes += n;
+    }
+}
+
+// Switch streaming on or off (HTTP API). Keeps the radio up while on.
+void mirrorSetEnabled(bool on)
+{
+    mirrorEnabled = on;
+    radioHold(RADIO_HOLD_MIRROR, on);
+    if (!on)
+        return;
+    if (mirrorTaskHandle == NULL)
+        xTaskCreatePinnedToCore(mirrorTask, "mirror", 4096, NULL, 1, &mirrorTaskHandle, 0);
+    radioSyncNow(); // bring the link up now rather than at the next window
+}
+
+// Call from setup(). Does nothing unless the mirror was left on.
+void startMirror()
+{
+    char text[16] = "";
+    IPAddress host;
+    preferences.getString("mirrorHost", text, sizeof(text));
+    if (host.fromString(text))
+        mirrorHost = host;
+    mirrorPort = preferences.getUShort("mirrorPort", MIRROR_PORT);
+    if (preferences.getBool("mirror", false))
+        mirrorSetEnabled(true);
+}
@@ -0,0 +1,350 @@
+#pragma once
+#include <Arduino.h>
+#include <sys/time.h>
+#include <RTClib.h>
+#include <Preferences.h>
+#include "Clocks.h"
+#include "i2cService.h"
+
+// ================================================================
+//                DRIFT-AWARE NTP -> RTC SYNC SCHEDULER
+// ================================================================
+// Each run measures how far the RTC is from NTP time and only writes the RTC
+// when the offset passes SYNC_WRITE_THRESHOLD_MS. The gap to the next run
+// adapts: it doubles while the RTC stays in tolerance, and once the drift
+// rate is known it is stretched to about half the time the RTC needs to drift
+// out of tolerance, up to SYNC_MAX_INTERVAL_S.
+//
+// An RTC write lands exactly on an NTP second edge: writing the seconds
+// register restarts the DS3231's one-second countdown, so the RTC then ticks in
+// step with NTP. The result is checked by timing the RTC's next tick.
+//
+// Offsets are measured to well under a millisecond by timing an RTC tick, and
+// a least-squares line through them gives the RTC's rate error. Once that fit
+// covers SYNC_CAL_MIN_SPAN_S, the error is trimmed out with the DS3231 aging
+// register (saved in Preferences and restored at boot), so the RTC keeps time
+// on its own and checks become rare.
+
+extern Preferences preferences;
+
+#define SYNC_MIN_INTERVAL_S 60
+#define SYNC_MAX_INTERVAL_S (6 * 3600)
+#define SYNC_WRITE_THRESHOLD_MS 500
+#define SYNC_DRIFT_MIN_SPAN_S 600 // least time between samples to estimate a rate
+#define SYNC_HISTORY_LEN 16
+#define SYNC_EDGE_LEAD_MS 20      // queue the edge-aligned write this long before the edge
+#define SYNC_VERIFY_WINDOW_MS 60  // how long either side of the expected tick to watch for it
+#define SYNC_CAL_MIN_SPAN_S (6 * 3600) // least fit span before the aging register is changed
+#define SYNC_CAL_MIN_SAMPLES 3
+#define SYNC_CAL_MIN_PPM 0.15f    // smaller errors are left alone (one aging step ~0.1 ppm)
+
+struct SyncSample
+{
+    uint32_t ntpTime;  // unix seconds (UTC) of the measurement
+    int32_t offsetMs;  // RTC minus NTP
+    bool rtcWritten;   // the RTC was corrected after this measurement
+};
+
+struct SyncStats
+{
+    uint32_t measurements;
+    uint32_t failedMeasurements;
+    uint32_t rtcWrites;
+    int32_t lastResidualUs; // RTC tick minus NTP edge after the last write, positive = RTC late
+    bool residualKnown;     // false if the tick was not seen inside the verify window
+    uint32_t intervalS; // current gap between runs
+    float driftPpm;     // RTC rate error, positive = RTC runs fast
+    bool driftKnown;
+    uint32_t calibrations; // aging register changes
+    int8_t aging;          // aging value last written
+};
+
+SyncSample syncHistory[SYNC_HISTORY_LEN];
+uint8_t syncHistoryCount = 0;
+uint8_t syncHistoryNext = 0;
+SyncStats syncStats = {0, 0, 0, 0, false, SYNC_MIN_INTERVAL_S, 0, false, 0, 0};
+
+// ------------------- Drift Fit -------------------
+// Least-squares line through (time, offset) samples. The slope is the RTC
+// rate error. Sums are kept relative to the first sample so doubles stay exact.
+struct DriftFit
+{
+    uint16_t count;
+    double t0, lastT;
+    double st, sy, stt, sty;
+
+    void reset() { count = 0; }
+
+    void add(double tS, double offsetMs)
+    {
+        if (count == 0)
+        {
+            t0 = tS;
+            st = sy = stt = sty = 0;
+        }
+        double t = tS - t0;
+        st += t;
+        sy += offsetMs;
+        stt += t * t;
+        sty += t * offsetMs;
+        lastT = tS;
+        count++;
+    }
+
+    double spanS() const { return count ? lastT - t0 : 0; }
+
+    // Rate in ppm (ms per 1000 s). False with fewer than two distinct times.
+    bool ppm(float &out) const
+    {
+        double d = count * stt - st * st;
+        if (count < 2 || d <= 0)
+            return false;
+        out = (float)((count * sty - st * sy) / d * 1000.0);
+        return true;
+    }
+};
+
+DriftFit driftFit = {0, 0, 0, 0, 0, 0, 0};
+// Sum of the steps the RTC writes made, so the fit sees one continuous line across them
+static double offsetCorrectionMs = 0;
+
+// NTP-disciplined system time as UTC microseconds since 1970
+int64_t ntpNowUs()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+// NTP-disciplined system time as UTC milliseconds since 1970
+int64_t ntpNowMs()
+{
+    return ntpNowUs() / 1000;
+}
+
+struct RtcEdgeWrite
+{
+    int64_t edgeUs; // NTP second edge to write on
+    DateTime time;  // RTC value for that edge
+};
+
+// I2C job: spin until the edge, then write. Runs in the I2C task so nothing
+// else can get onto the bus between the edge and the write.
+static bool rtcEdgeWriteJob(void *arg)
+{
+    RtcEdgeWrite *w = (RtcEdgeWrite *)arg;
+    while (ntpNowUs() < w->edgeUs)
+    {
+    }
+    rtc.adjust(w->time);
+    i2cExpectTimeJump();
+    return true;
+}
+
+struct RtcEdgeProbe
+{
+    int64_t untilUs; // give up at this time
+    int64_t tickUs;  // out: NTP time the seconds register was seen to change
+};
+
+// I2C job: poll the seconds register until it changes
+static bool rtcEdgeProbeJob(void *arg)
+{
+    RtcEdgeProbe *p = (RtcEdgeProbe *)arg;
+    uint8_t first, sec;
+    if (!ds3231ReadSeconds(Wire, first))
+        return false;
+    while (ntpNowUs() < p->untilUs)
+    {
+        if (ds3231ReadSeconds(Wire, sec) && sec != first)
+        {
+            p->tickUs = ntpNowUs();
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sleep until `lead` ms before the NTP time `atUs`
+static void sleepUntilNtp(int64_t atUs, uint32_t leadMs)
+{
+    int64_t waitMs = (atUs - ntpNowUs()) / 1000 - leadMs;
+    if (waitMs > 0)
+        vTaskDelay(pdMS_TO_TICKS(waitMs));
+}
+
+// Poll the RTC around `expectUs` (NTP UTC) and return when it ticked
+static bool probeRtcTick(int64_t expectUs, int64_t &tickUs)
+{
+    RtcEdgeProbe p = {expectUs + SYNC_VERIFY_WINDOW_MS * 1000LL, 0};
+    sleepUntilNtp(expectUs, SYNC_VERIFY_WINDOW_MS);
+    if (!i2cTransact(rtcEdgeProbeJob, &p, I2C_PRIO_HIGH))
+        return false;
+    tickUs = p.tickUs;
+    return true;
+}
+
+// RTC minus NTP in ms. The RTC second edge seen in the I2C task's snapshots
+// gives the offset to one poll period (I2C_TIME_POLL_MS); the following tick is
+// then timed directly on the bus to refine it to the probe's read time.
+bool measureRtcOffset(double &offsetMs)
+{
+    DateTime first, now;
+    if (!readClockUtc(first))
+        return false;
+    int32_t coarseMs = 0;
+    bool seen = false;
+    unsigned long start = millis();
+    while (!seen && millis() - start < 1500)
+    {
+        vTaskDelay(pdMS_TO_TICKS(5));
+        if (readClockUtc(now) && now.unixtime() != first.unixtime())
+        {
+            coarseMs = (int32_t)((int64_t)now.unixtime() * 1000 - ntpNowMs());
+            seen = true;
+        }
+    }
+    if (!seen)
+        return false;
+
+    // The RTC ticks where NTP time + offset is a whole second
+    int64_t phaseUs = ((coarseMs * 1000LL) % 1000000 + 1000000) % 1000000;
+    int64_t nowUs = ntpNowUs();
+    int64_t expectUs = (nowUs / 1000000 + 1) * 1000000 - phaseUs;
+    while (expectUs - nowUs < SYNC_VERIFY_WINDOW_MS * 2000LL)
+        expectUs += 1000000;
+
+    int64_t tickUs;
+    if (!probeRtcTick(expectUs, tickUs))
+    {
+        offsetMs = coarseMs;
+        return true;
+    }
+    // Whole seconds from the coarse value, fraction from the tick time
+    int64_t rtcSec = (tickUs + coarseMs * 1000LL + 500000) / 1000000;
+    offsetMs = (double)(rtcSec * 1000000 - tickUs) / 1000.0;
+    return true;
+}
+
+static void recordSample(uint32_t ntpTime, int32_t offsetMs, bool written)
+{
+    syncHistory[syncHistoryNext] = {ntpTime, offsetMs, written};
+    syncHistoryNext = (syncHistoryNext + 1) % SYNC_HISTORY_LEN;
+    if (syncHistoryCount < SYNC_HISTORY_LEN)
+        syncHistoryCount++;
+}
+
+// Set the RTC on the next NTP second edge, then time the RTC's following tick
+// to see how far from the edge the write really landed.
+static void writeRtcFromNtp()
+{
+    const int64_t nowUs = ntpNowUs();
+    int64_t edgeUs = (nowUs / 1000000 + 1) * 1000000;
+    if (edgeUs - nowUs < SYNC_EDGE_LEAD_MS * 2000LL)
+        edgeUs += 1000000; // too close to get the job queued in time
+    RtcEdgeWrite w = {edgeUs, DateTime((uint32_t)(edgeUs / 1000000))};
+    sleepUntilNtp(edgeUs, SYNC_EDGE_LEAD_MS);
+    i2cTransact(rtcEdgeWriteJob, &w, I2C_PRIO_HIGH);
+
+    // The RTC should tick exactly one second after the edge
+    const int64_t expectUs = edgeUs + 1000000;
+    int64_t tickUs;
+    syncStats.residualKnown = probeRtcTick(expectUs, tickUs);
+    if (syncStats.residualKnown)
+        syncStats.lastResidualUs = (int32_t)(tickUs - expectUs);
+}
+
+// ------------------- Aging Calibration -------------------
+// I2C job: write the aging register in arg and apply it at once
+bool agingWriteJob(void *arg)
+{
+    return ds3231WriteAging(Wire, *(int8_t *)arg);
+}
+
+// Trim the measured rate error out with the aging register.
+// A positive aging step slows the oscillator by about 0.1 ppm.
+static void calibrateAging(float ppm)
+{
+    Ds3231State state;
+    if (!readRtcState(state))
+        return;
+    int step = (int)lroundf(ppm / 0.1f);
+    int aging = constrain((int)state.aging + step, -127, 127);
+    if (aging == state.aging)
+        return;
+    int8_t value = (int8_t)aging;
+    if (!i2cTransact(agingWriteJob, &value, I2C_PRIO_HIGH))
+        return;
+    preferences.putChar("aging", value);
+    syncStats.aging = value;
+    syncStats.calibrations++;
+    // The old line no longer applies to the trimmed oscillator
+    driftFit.reset();
+    syncStats.driftKnown = false;
+}
+
+// One scheduler run. NTP time must be valid. Returns seconds until the next run.
+uint32_t ntpSyncStep()
+{
+    double offsetMs;
+    if (!measureRtcOffset(offsetMs))
+    {
+        syncStats.failedMeasurements++;
+        return SYNC_MIN_INTERVAL_S;
+    }
+    syncStats.measurements++;
+    const double nowS = ntpNowUs() / 1e6;
+
+    driftFit.add(nowS, offsetMs - offsetCorrectionMs);
+    float ppm;
+    if (driftFit.spanS() >= SYNC_DRIFT_MIN_SPAN_S && driftFit.ppm(ppm))
+    {
+        syncStats.driftPpm = ppm;
+        syncStats.driftKnown = true;
+    }
+
+    bool write = fabs(offsetMs) > SYNC_WRITE_THRESHOLD_MS;
+    recordSample((uint32_t)nowS, (int32_t)offsetMs, write);
+
+    uint32_t interval;
+    if (write)
+    {
+        writeRtcFromNtp();
+        syncStats.rtcWrites++;
+        if (syncStats.residualKnown)
+        {
+            // Offset after the write is minus the residual: a late tick means a slow RTC
+            double afterMs = -syncStats.lastResidualUs / 1000.0;
+            offsetCorrectionMs += afterMs - offsetMs;
+        }
+        else
+        {
+            driftFit.reset(); // can't join the line across an unknown step
+            offsetCorrectionMs = 0;
+        }
+        interval = SYNC_MIN_INTERVAL_S;
+    }
+    else if (syncStats.driftKnown && fabsf(syncStats.driftPpm) > 0.01f)
+    {
+        // Half the time left until the offset crosses the threshold
+        float msPerSecond = fabsf(syncStats.driftPpm) / 1000.0f;
+        float secondsLeft = (SYNC_WRITE_THRESHOLD_MS - fabs(offsetMs)) / msPerSecond;
+        interval = (uint32_t)constrain(secondsLeft / 2, (float)SYNC_MIN_INTERVAL_S, (float)SYNC_MAX_INTERVAL_S);
+    }
+    else
+    {
+        interval = syncStats.intervalS * 2;
+        if (interval > SYNC_MAX_INTERVAL_S)
+            interval = SYNC_MAX_INTERVAL_S;
+    }
+
+    if (syncStats.driftKnown && driftFit.count >= SYNC_CAL_MIN_SAMPLES &&
+        driftFit.spanS() >= SYNC_CAL_MIN_SPAN_S && fabsf(syncStats.driftPpm) >= SYNC_CAL_MIN_PPM)
+    {
+        calibrateAging(syncStats.driftPpm);
+        interval = SYNC_MIN_INTERVAL_S * 2; // start the new fit soon
+    }
+
+    syncStats.intervalS = interval;
+    return interval;
+}
@@ -0,0 +1,242 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <WiFi.h>
+#include <time.h>
+#include <lwip/apps/sntp.h>
+#include "ntpSync.h"
+
+// ================================================================
+//                  DUTY-CYCLED WIFI RADIO
+// ================================================================
+// Time is needed only when the sync scheduler (ntpSync.h) asks for it, so the
+// radio is off the rest of the time. radioSyncWindow() powers the station up,
+// connects (modem sleep on), restarts SNTP and waits for its sync callback, runs
+// one sync step on that fresh time and powers the radio down again. Without a
+// sync inside the window the step is skipped: the system clock may be stale. The setup portal owns the radio while it is
+// open; windows are skipped until it closes. While anything holds the radio
+// (radioHold(): the HTTP API, the frame mirror, frame sync) the link is kept up
+// between windows and checked every RADIO_AWAKE_CHECK_S instead.
+//
+// RadioStats compares against the old behaviour (station always associated,
+// woken every RADIO_LEGACY_POLL_S): the current and CPU figures are estimates.
+
+extern volatile bool portalActive;
+
+#define RADIO_CONNECT_TIMEOUT_MS 20000
+#define RADIO_NTP_TIMEOUT_MS 5000     // SNTP asks at once when restarted; allow for a slow reply
+#define RADIO_RETRY_MIN_S 60          // first retry after a failed window, doubled per failure
+#define RADIO_RETRY_MAX_S 3600
+#define RADIO_PORTAL_RECHECK_S 10
+#define RADIO_AWAKE_CHECK_S 30
+#define RADIO_LEGACY_POLL_S 10
+#define RADIO_ASSOCIATED_EXTRA_MA 30  // estimate: associated in modem sleep vs radio off
+#define RADIO_STACK_CPU_PERMILLE 10   // estimate: share of a core the WiFi/LwIP tasks use while associated
+
+// Users that need the link up between sync windows, see radioHold()
+#define RADIO_HOLD_API 0x01
+#define RADIO_HOLD_MIRROR 0x02
+#define RADIO_HOLD_FRAMESYNC 0x04
+
+struct RadioStats
+{
+    uint32_t windows;        // sync windows run
+    uint32_t failedWindows;  // no connection or no NTP time
+    uint32_t ntpWaitMs;      // SNTP restart to its sync, last window
+    uint32_t radioOnMs;      // total time the radio was up
+    uint32_t radioOffMs;     // total time the radio was down
+    uint32_t wakeups;        // scheduler wakeups
+    uint32_t wakeupsSaved;   // against one every RADIO_LEGACY_POLL_S
+    float energySavedMah;    // radio-off time at RADIO_ASSOCIATED_EXTRA_MA
+    uint32_t cpuSavedMs;     // radio-off time at RADIO_STACK_CPU_PERMILLE
+};
+
+RadioStats radioStats;
+std::atomic<uint8_t> radioHolds{0};
+TaskHandle_t radioTaskHandle = NULL;
+
+static bool radioUp = false;
+static unsigned long radioChangedMillis = 0;
+static unsigned long radioStartMillis = 0;
+static uint32_t radioRetryS = RADIO_RETRY_MIN_S;
+static unsigned long syncDueMillis = 0;
+static volatile bool syncForced = true; // first window at once
+static std::atomic<bool> ntpFresh{false}; // SNTP set the clock since the window began
+
+// SNTP callback, from the LwIP task
+static void radioNtpSynced(struct timeval *tv)
+{
+    (void)tv;
+    ntpFresh = true;
+}
+
+// Restart SNTP and wait for it to set the clock. False if it did not in time.
+static bool radioWaitForNtp()
+{
+    ntpFresh = false;
+    configTime(0, 0, ntpServer1, ntpServer2, ntpServer3);
+    unsigned long start = millis();
+    while (!ntpFresh.load())
+    {
+        if (millis() - start >= RADIO_NTP_TIMEOUT_MS)
+            return false;
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    radioStats.ntpWaitMs = millis() - start;
+    return true;
+}
+
+// Add the time since the last on/off change to the right counter
+static void radioAccount()
+{
+    unsigned long now = millis();
+    uint32_t span = now - radioChangedMillis;
+    radioChangedMillis = now;
+    if (radioUp)
+    {
+        radioStats.radioOnMs += span;
+    }
+    else
+    {
+        radioStats.radioOffMs += span;
+        radioStats.energySavedMah = radioStats.radioOffMs / 3600000.0f * RADIO_ASSOCIATED_EXTRA_MA;
+        radioStats.cpuSavedMs = (uint64_t)radioStats.radioOffMs * RADIO_STACK_CPU_PERMILLE / 1000;
+    }
+}
+
+// Connect with the saved credentials. False on timeout.
+static bool radioOn()
+{
+    if (radioUp && WiFi.status() == WL_CONNECTED)
+        return true;
+    radioAccount();
+    radioUp = true;
+    WiFi.mode(WIFI_STA);
+    WiFi.setSleep(true); // modem sleep between DTIM beacons while associated
+    WiFi.begin();
+    unsigned long start = millis();
+    while (WiFi.status() != WL_CONNECTED)
+    {
+        if (millis() - start >= RADIO_CONNECT_TIMEOUT_MS)
+            return false;
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    return true;
+}
+
+// Drop the link unless someone else needs it
+static void radioOff()
+{
+    if (!radioUp || portalActive || radioHolds.load())
+        return;
+    radioAccount();
+    radioUp = false;
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+}
+
+// Seconds to sleep before the next wakeup, given the next window is `windowS` away
+static uint32_t radioSleepFor(uint32_t windowS)
+{
+    syncDueMillis = millis() + windowS * 1000UL;
+    if (radioHolds.load() && windowS > RADIO_AWAKE_CHECK_S)
+        return RADIO_AWAKE_CHECK_S;
+    return windowS;
+}
+
+static uint32_t radioWindowFailed()
+{
+    radioStats.failedWindows++;
+    uint32_t retry = radioRetryS;
+    radioRetryS = radioRetryS * 2 > RADIO_RETRY_MAX_S ? RADIO_RETRY_MAX_S : radioRetryS * 2;
+    return radioSleepFor(retry);
+}
+
+// Call once when the scheduler task starts: the radio stays off until the first window
+void radioBegin()
+{
+    radioTaskHandle = xTaskGetCurrentTaskHandle();
+    radioStartMillis = millis();
+    radioChangedMillis = radioStartMillis;
+    radioUp = true; // so the first off is counted as a change
+    radioOff();
+    sntp_set_time_sync_notification_cb(radioNtpSynced);
+}
+
+// Keep the link up between windows on behalf of `who` (RADIO_HOLD_*), or release it
+void radioHold(uint8_t who, bool on)
+{
+    if (on)
+        radioHolds.fetch_or(who);
+    else
+        radioHolds.fetch_and(~who);
+}
+
+// Run a sync window now (e.g. new credentials)
+void radioSyncNow()
+{
+    syncForced = true;
+    if (radioTaskHandle != NULL)
+        xTaskNotifyGive(radioTaskHandle);
+}
+
+// One sync window. Returns seconds until the next one.
+uint32_t radioSyncWindow()
+{
+    radioStats.wakeups++;
+    uint32_t legacyWakeups = (millis() - radioStartMillis) / (RADIO_LEGACY_POLL_S * 1000UL);
+    radioStats.wakeupsSaved = legacyWakeups > radioStats.wakeups ? legacyWakeups - radioStats.wakeups : 0;
+
+    if (portalActive)
+        return RADIO_PORTAL_RECHECK_S;
+
+    // Kept awake between windows: just hold the link up
+    if (!syncForced && (long)(millis() - syncDueMillis) < 0)
+    {
+        if (radioHolds.load())
+            radioOn();
+        else
+            radioOff();
+        uint32_t left = (syncDueMillis - millis()) / 1000 + 1;
+        return left > RADIO_AWAKE_CHECK_S ? RADIO_AWAKE_CHECK_S : left;
+    }
+    syncForced = false;
+
+    radioStats.windows++;
+    if (!radioOn())
+    {
+        Serial.println("[Background] WiFi connect failed");
+        radioOff();
+        return radioWindowFailed();
+    }
+
+    // Only a sync from this window counts, not the time that survived the last one
+    if (!radioWaitForNtp())
+    {
+        Serial.println("[Background] No NTP time");
+        radioOff();
+        return radioWindowFailed();
+    }
+    radioRetryS = RADIO_RETRY_MIN_S;
+    uint32_t next = ntpSyncStep();
+    radioOff();
+
+    const SyncSample &last = syncHistory[(syncHistoryNext + SYNC_HISTORY_LEN - 1) % SYNC_HISTORY_LEN];
+    Serial.printf("[Background] RTC offset %d ms, drift %.2f ppm, aging %d, next check in %u s\n",
+                  last.offsetMs, syncStats.driftPpm, syncStats.aging, next);
+    if (last.rtcWritten)
+    {
+        if (syncStats.residualKnown)
+            Serial.printf("[Background] RTC updated, tick %d us from NTP edge\n", syncStats.lastResidualUs);
+        else
+            Serial.println("[Background] RTC updated, tick not seen near NTP edge");
+    }
+    Serial.printf("[Background] Radio on %u s, off %u s, saved ~%.1f mAh, ~%u ms CPU, %u wakeups\n",
+                  radioStats.radioOnMs / 1000, radioStats.radioOffMs / 1000, radioStats.energySavedMah,
+                  radioStats.cpuSavedMs, radioStats.wakeupsSaved);
+    Serial.printf("[Background] I2C jobs %u, errors %u, avg %u us, max %u us\n",
+                  i2cStats.jobs, i2cStats.jobErrors, i2cStats.avgLatencyUs, i2cStats.maxLatencyUs);
+    Serial.printf("[Background] I2C bus errors %u, implausible %u, retries %u, recoveries %u\n",
+                  i2cStats.busErrors, i2cStats.implausible, i2cStats.retries, i2cStats.recoveries);
+    return radioSleepFor(next);
+}
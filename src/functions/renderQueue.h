@@ -0,0 +1,277 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <DMD32.h>
+
+// ================================================================
+//                  RENDER TASK & DRAW COMMAND RING
+// ================================================================
+// Only renderTask() touches `dmd`. Everyone else draws through a RenderClient,
+// which packs each call into a DrawCommand and pushes it onto a ring.
+//
+// The ring is single-producer/single-consumer and lock-free: the producer owns
+// `head`, the render task owns `tail`. A command is published only when `head`
+// moves, so a producer deleted half-way through a push (changeClockMode() deletes
+// face tasks at arbitrary points) leaves nothing behind for the render task.
+//
+// Ownership of faceRing is handed over, never shared: the running face task
+// produces while it exists; setup() and changeClockMode() only push after the
+// face task has been deleted (both run on core 1).
+//
+// Status icons (statusIcons) are drawn by the render task itself on top of
+// whatever the face drew, so they need no producer at all. The corner is blanked
+// only while an icon is on; when the last one goes, loop() restarts the face
+// (faceRedrawRequested) so it repaints what the icons covered.
+
+extern DMD dmd;
+extern TaskHandle_t renderTaskHandle;
+void mirrorCapture(); // mirror.h
+
+#define DRAW_RING_SIZE 64 // commands, power of two
+#define DRAW_TEXT_MAX 40  // longest string one command carries (Clock7 date ~27)
+
+enum DrawOp : uint8_t
+{
+    DRAW_STRING,
+    DRAW_LINE,
+    DRAW_BOX,
+    DRAW_FILLED_BOX,
+    DRAW_CLEAR,
+    DRAW_BEGIN_OFFSCREEN,
+    DRAW_PRESENT
+};
+
+struct DrawCommand
+{
+    uint8_t op;
+    uint8_t mode; // graphics mode, clear flag or transition
+    int16_t x1, y1, x2, y2;
+    const uint8_t *font; // captured at submit time, so selectFont() can't race a draw
+    uint8_t length;
+    char text[DRAW_TEXT_MAX];
+};
+
+class DrawRing
+{
+public:
+    // Producer side. Waits (yielding) while the ring is full.
+    void push(const DrawCommand &cmd)
+    {
+        uint16_t h = head.load(std::memory_order_relaxed);
+        while ((uint16_t)(h - tail.load(std::memory_order_acquire)) >= DRAW_RING_SIZE)
+        {
+            stalls++;
+            vTaskDelay(1);
+        }
+        slots[h & (DRAW_RING_SIZE - 1)] = cmd;
+        head.store(h + 1, std::memory_order_release);
+        if (renderTaskHandle != NULL)
+            xTaskNotifyGive(renderTaskHandle);
+    }
+
+    // Consumer side (render task only)
+    bool pop(DrawCommand &cmd)
+    {
+        uint16_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return false;
+        cmd = slots[t & (DRAW_RING_SIZE - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint32_t stalls = 0; // pushes that found the ring full
+
+private:
+    DrawCommand slots[DRAW_RING_SIZE];
+    std::atomic<uint16_t> head{0};
+    std::atomic<uint16_t> tail{0};
+};
+
+DrawRing faceRing;
+TaskHandle_t renderTaskHandle = NULL;
+
+// Timing of DRAW_PRESENT: the render task draws nothing else while a transition runs
+struct RenderStats
+{
+    uint32_t presents;      // offscreen frames shown
+    uint32_t lastPresentMs; // how long the last transition took
+    uint32_t maxStepMs;     // longest gap between two transition steps
+};
+
+RenderStats renderStats;
+
+// Status icons, top right corner
+#define STATUS_ICON_WIFI_SETUP 0x01 // config portal is open
+
+std::atomic<uint8_t> statusIcons{0};
+std::atomic<bool> faceRedrawRequested{false}; // set when the last icon goes, taken by loop()
+
+void setStatusIcon(uint8_t icon, bool on)
+{
+    if (on)
+        statusIcons.fetch_or(icon);
+    else if (statusIcons.fetch_and((uint8_t)~icon) == icon)
+        faceRedrawRequested = true;
+    if (renderTaskHandle != NULL)
+        xTaskNotifyGive(renderTaskHandle);
+}
+
+// ------------------- Render Client -------------------
+// Same calls as DMD, queued instead of drawn. Each task keeps its own client,
+// so the selected font is per task rather than shared.
+class RenderClient
+{
+public:
+    explicit RenderClient(DrawRing &ring = faceRing) : ring(ring) {}
+
+    void selectFont(const uint8_t *f) { font = f; }
+
+    int charWidth(const unsigned char letter) { return DMD::charWidth(font, letter); }
+    int codePointWidth(uint16_t codePoint) { return DMD::codePointWidth(font, codePoint); }
+
+    void drawString(int bX, int bY, const char *bChars, byte length, byte bGraphicsMode)
+    {
+        DrawCommand cmd = make(DRAW_STRING, bX, bY, 0, 0, bGraphicsMode);
+        if (length > DRAW_TEXT_MAX)
+            length = DRAW_TEXT_MAX;
+        // Stop at the terminator: callers pass lengths longer than their strings
+        uint8_t n = 0;
+        while (n < length && bChars[n] != '\0')
+        {
+            cmd.text[n] = bChars[n];
+            n++;
+        }
+        cmd.length = n;
+        ring.push(cmd);
+    }
+
+    void drawLine(int x1, int y1, int x2, int y2, byte bGraphicsMode)
+    {
+        ring.push(make(DRAW_LINE, x1, y1, x2, y2, bGraphicsMode));
+    }
+
+    void drawBox(int x1, int y1, int x2, int y2, byte bGraphicsMode)
+    {
+        ring.push(make(DRAW_BOX, x1, y1, x2, y2, bGraphicsMode));
+    }
+
+    void drawFilledBox(int x1, int y1, int x2, int y2, byte bGraphicsMode)
+    {
+        ring.push(make(DRAW_FILLED_BOX, x1, y1, x2, y2, bGraphicsMode));
+    }
+
+    void clearScreen(byte bNormal) { ring.push(make(DRAW_CLEAR, 0, 0, 0, 0, bNormal)); }
+
+    void beginOffscreen() { ring.push(make(DRAW_BEGIN_OFFSCREEN, 0, 0, 0, 0, 0)); }
+
+    // Show the offscreen frame; TRANSITION_NONE cuts over at once
+    void present(byte bTransition) { ring.push(make(DRAW_PRESENT, 0, 0, 0, 0, bTransition)); }
+
+private:
+    DrawCommand make(uint8_t op, int x1, int y1, int x2, int y2, uint8_t mode)
+    {
+        DrawCommand cmd;
+        cmd.op = op;
+        cmd.mode = mode;
+        cmd.x1 = x1;
+        cmd.y1 = y1;
+        cmd.x2 = x2;
+        cmd.y2 = y2;
+        cmd.font = font;
+        cmd.length = 0;
+        return cmd;
+    }
+
+    DrawRing &ring;
+    const uint8_t *font = NULL;
+};
+
+// ------------------- Render Task -------------------
+void executeDrawCommand(const DrawCommand &cmd)
+{
+    switch (cmd.op)
+    {
+    case DRAW_STRING:
+        if (cmd.font == NULL)
+            break;
+        dmd.selectFont(cmd.font);
+        dmd.drawString(cmd.x1, cmd.y1, cmd.text, cmd.length, cmd.mode);
+        break;
+    case DRAW_LINE:
+        dmd.drawLine(cmd.x1, cmd.y1, cmd.x2, cmd.y2, cmd.mode);
+        break;
+    case DRAW_BOX:
+        dmd.drawBox(cmd.x1, cmd.y1, cmd.x2, cmd.y2, cmd.mode);
+        break;
+    case DRAW_FILLED_BOX:
+        dmd.drawFilledBox(cmd.x1, cmd.y1, cmd.x2, cmd.y2, cmd.mode);
+        break;
+    case DRAW_CLEAR:
+        dmd.clearScreen(cmd.mode);
+        break;
+    case DRAW_BEGIN_OFFSCREEN:
+        dmd.beginOffscreen();
+        break;
+    case DRAW_PRESENT:
+    {
+        unsigned long start = millis(), step = start;
+        while (!dmd.presentStep(cmd.mode))
+        {
+            vTaskDelay(pdMS_TO_TICKS(15));
+            unsigned long now = millis();
+            if (now - step > renderStats.maxStepMs)
+                renderStats.maxStepMs = now - step;
+            step = now;
+        }
+        renderStats.presents++;
+        renderStats.lastPresentMs = millis() - start;
+        break;
+    }
+    }
+}
+
+// Redraw the icon corner. Called after the face's commands, so icons stay on top.
+static void drawStatusIcons(uint8_t icons)
+{
+    dmd.drawFilledBox(26, 0, 31, 3, GRAPHICS_INVERSE);
+    if (icons & STATUS_ICON_WIFI_SETUP)
+    {
+        // .###.
+        // #...#
+        // ..#..
+        dmd.drawLine(28, 0, 30, 0, GRAPHICS_NORMAL);
+        dmd.writePixel(27, 1, GRAPHICS_NORMAL, 1);
+        dmd.writePixel(31, 1, GRAPHICS_NORMAL, 1);
+        dmd.writePixel(29, 2, GRAPHICS_NORMAL, 1);
+    }
+}
+
+void renderTask(void *pvParameters)
+{
+    DrawCommand cmd;
+    uint8_t drawnIcons = 0;
+    for (;;)
+    {
+        // Sleep until a producer pushes something
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+        bool drew = false;
+        while (faceRing.pop(cmd))
+        {
+            executeDrawCommand(cmd);
+            drew = true;
+        }
+        // Repaint icons when they change, or when the face may have drawn over them.
+        // With none left the corner is the face's again: its redraw clears the icon.
+        uint8_t icons = statusIcons.load();
+        if (icons && (icons != drawnIcons || drew))
+        {
+            drawStatusIcons(icons);
+            drew = true;
+        }
+        drawnIcons = icons;
+        // Hand the new frame to the dashboard mirror, if one is streaming
+        if (drew)
+            mirrorCapture();
+    }
+}
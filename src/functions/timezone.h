@@ -0,0 +1,309 @@
+#pragma once
+#include <Arduino.h>
+
+// ================================================================
+//                    POSIX TZ TIME ZONES
+// ================================================================
+// The RTC keeps UTC. Local time comes from a POSIX TZ string such as
+// "<+06>-6" (Bangladesh) or "CET-1CEST,M3.5.0,M10.5.0/3" (central Europe).
+// tzParse() turns the string into a TimeZone once; tzOffset() then needs only
+// the DST start/end instants of the current year, which a TzCache holds, so a
+// conversion is two compares until the year rolls over.
+//
+// Offsets are stored as seconds EAST of UTC; POSIX writes them the other way
+// round ("-6" means UTC+6).
+
+#define TZ_DEFAULT "<+06>-6"
+#define TZ_STRING_MAX 48
+#define TZ_NAME_MAX 8
+
+enum TzRuleKind : uint8_t
+{
+    TZ_RULE_JULIAN1, // Jn: day 1..365, Feb 29 never counted
+    TZ_RULE_JULIAN0, // n: day 0..365, Feb 29 counted in leap years
+    TZ_RULE_MWD      // Mm.w.d: day d (0 = Sunday) of week w (5 = last) of month m
+};
+
+struct TzRule
+{
+    uint8_t kind;
+    uint8_t month, week, weekday;
+    uint16_t day;
+    int32_t timeS; // local time of day of the change, may be negative or past 24 h
+};
+
+struct TimeZone
+{
+    char stdName[TZ_NAME_MAX];
+    char dstName[TZ_NAME_MAX];
+    int32_t stdOffsetS;
+    int32_t dstOffsetS;
+    bool hasDst;
+    TzRule start, end;
+};
+
+// DST boundaries of one UTC year
+struct TzCache
+{
+    int16_t year;           // 0 = empty
+    uint32_t yearStartUtc;
+    uint32_t yearEndUtc;
+    uint32_t dstStartUtc;
+    uint32_t dstEndUtc;
+};
+
+TimeZone timeZone;
+char tzString[TZ_STRING_MAX] = TZ_DEFAULT;
+
+// ------------------- Calendar Helpers -------------------
+static inline bool tzLeapYear(int y) { return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0; }
+
+static inline int tzMonthDays(int y, int m)
+{
+    static const uint8_t days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return (m == 2 && tzLeapYear(y)) ? 29 : days[m - 1];
+}
+
+// Days from 1970-01-01 to y-m-d
+static int32_t tzDaysFromCivil(int y, int m, int d)
+{
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const int yoe = y - era * 400;
+    const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// ------------------- Parser -------------------
+static bool tzParseName(const char *&p, char *name)
+{
+    uint8_t n = 0;
+    if (*p == '<')
+    {
+        p++;
+        while (*p && *p != '>')
+        {
+            if (n < TZ_NAME_MAX - 1)
+                name[n++] = *p;
+            p++;
+        }
+        if (*p != '>')
+            return false;
+        p++;
+    }
+    else
+    {
+        while (isalpha((unsigned char)*p))
+        {
+            if (n < TZ_NAME_MAX - 1)
+                name[n++] = *p;
+            p++;
+        }
+    }
+    name[n] = '\0';
+    return n >= 3;
+}
+
+static bool tzParseNumber(const char *&p, int32_t &value, int32_t maxValue)
+{
+    if (!isdigit((unsigned char)*p))
+        return false;
+    value = 0;
+    while (isdigit((unsigned char)*p))
+    {
+        value = value * 10 + (*p++ - '0');
+        if (value > maxValue)
+            return false;
+    }
+    return true;
+}
+
+// [+-]hh[:mm[:ss]] in seconds
+static bool tzParseTime(const char *&p, int32_t &seconds, int32_t maxHours)
+{
+    int32_t sign = 1, h, m = 0, s = 0;
+    if (*p == '+' || *p == '-')
+        sign = (*p++ == '-') ? -1 : 1;
+    if (!tzParseNumber(p, h, maxHours))
+        return false;
+    if (*p == ':')
+    {
+        p++;
+        if (!tzParseNumber(p, m, 59))
+            return false;
+        if (*p == ':')
+        {
+            p++;
+            if (!tzParseNumber(p, s, 59))
+                return false;
+        }
+    }
+    seconds = sign * (h * 3600 + m * 60 + s);
+    return true;
+}
+
+static bool tzParseRule(const char *&p, TzRule &rule)
+{
+    int32_t v;
+    if (*p == 'M')
+    {
+        p++;
+        int32_t m, w, d;
+        if (!tzParseNumber(p, m, 12) || m < 1 || *p++ != '.' ||
+            !tzParseNumber(p, w, 5) || w < 1 || *p++ != '.' || !tzParseNumber(p, d, 6))
+            return false;
+        rule.kind = TZ_RULE_MWD;
+        rule.month = m;
+        rule.week = w;
+        rule.weekday = d;
+    }
+    else if (*p == 'J')
+    {
+        p++;
+        if (!tzParseNumber(p, v, 365) || v < 1)
+            return false;
+        rule.kind = TZ_RULE_JULIAN1;
+        rule.day = v;
+    }
+    else
+    {
+        if (!tzParseNumber(p, v, 365))
+            return false;
+        rule.kind = TZ_RULE_JULIAN0;
+        rule.day = v;
+    }
+    rule.timeS = 2 * 3600;
+    if (*p == '/')
+    {
+        p++;
+        if (!tzParseTime(p, rule.timeS, 167))
+            return false;
+    }
+    return true;
+}
+
+// Parse a POSIX TZ string. `tz` is only changed on success.
+bool tzParse(const char *spec, TimeZone &tz)
+{
+    TimeZone t;
+    memset(&t, 0, sizeof(t));
+    const char *p = spec;
+    int32_t offset;
+    if (!tzParseName(p, t.stdName) || !tzParseTime(p, offset, 24))
+        return false;
+    t.stdOffsetS = -offset;
+
+    if (*p != '\0')
+    {
+        if (!tzParseName(p, t.dstName))
+            return false;
+        t.hasDst = true;
+        t.dstOffsetS = t.stdOffsetS + 3600;
+        if (*p != ',' && *p != '\0')
+        {
+            if (!tzParseTime(p, offset, 24))
+                return false;
+            t.dstOffsetS = -offset;
+        }
+        if (*p == ',')
+        {
+            p++;
+            if (!tzParseRule(p, t.start) || *p++ != ',' || !tzParseRule(p, t.end))
+                return false;
+        }
+        else
+        {
+            // No rules given: use the US ones, as glibc does
+            const char *us = "M3.2.0,M11.1.0";
+            tzParseRule(us, t.start);
+            us++;
+            tzParseRule(us, t.end);
+        }
+    }
+    else
+    {
+        t.dstOffsetS = t.stdOffsetS;
+    }
+    if (*p != '\0')
+        return false;
+    tz = t;
+    return true;
+}
+
+// ------------------- Transitions -------------------
+// Local seconds since 1970 at which `rule` fires in year y
+static int64_t tzRuleLocal(const TzRule &rule, int y)
+{
+    int32_t days;
+    if (rule.kind == TZ_RULE_JULIAN1)
+    {
+        days = tzDaysFromCivil(y, 1, 1) + rule.day - 1;
+        if (tzLeapYear(y) && rule.day >= 60)
+            days++;
+    }
+    else if (rule.kind == TZ_RULE_JULIAN0)
+    {
+        days = tzDaysFromCivil(y, 1, 1) + rule.day;
+    }
+    else
+    {
+        int32_t first = tzDaysFromCivil(y, rule.month, 1);
+        int firstWeekday = (first % 7 + 11) % 7; // 1970-01-01 was a Thursday
+        int day = 1 + (rule.weekday - firstWeekday + 7) % 7 + (rule.week - 1) * 7;
+        while (day > tzMonthDays(y, rule.month))
+            day -= 7;
+        days = first + day - 1;
+    }
+    return (int64_t)days * 86400 + rule.timeS;
+}
+
+static void tzFillCache(const TimeZone &tz, TzCache &cache, int y)
+{
+    cache.year = y;
+    cache.yearStartUtc = (uint32_t)tzDaysFromCivil(y, 1, 1) * 86400;
+    cache.yearEndUtc = (uint32_t)tzDaysFromCivil(y + 1, 1, 1) * 86400;
+    if (tz.hasDst)
+    {
+        // The start fires in standard time, the end in daylight time
+        cache.dstStartUtc = (uint32_t)(tzRuleLocal(tz.start, y) - tz.stdOffsetS);
+        cache.dstEndUtc = (uint32_t)(tzRuleLocal(tz.end, y) - tz.dstOffsetS);
+    }
+}
+
+// Is DST in effect at `utc`?
+bool tzIsDst(const TimeZone &tz, TzCache &cache, uint32_t utc)
+{
+    if (!tz.hasDst)
+        return false;
+    if (cache.year == 0 || utc < cache.yearStartUtc || utc >= cache.yearEndUtc)
+    {
+        int y = 1970 + (int)(utc / 31556952UL); // average Gregorian year, then fix up
+        tzFillCache(tz, cache, y);
+        while (utc < cache.yearStartUtc)
+            tzFillCache(tz, cache, --y);
+        while (utc >= cache.yearEndUtc)
+            tzFillCache(tz, cache, ++y);
+    }
+    if (cache.dstStartUtc < cache.dstEndUtc)
+        return utc >= cache.dstStartUtc && utc < cache.dstEndUtc;
+    // Southern hemisphere: DST spans the new year
+    return utc >= cache.dstStartUtc || utc < cache.dstEndUtc;
+}
+
+// Seconds to add to UTC for local time at `utc`
+int32_t tzOffset(const TimeZone &tz, TzCache &cache, uint32_t utc)
+{
+    return tzIsDst(tz, cache, utc) ? tz.dstOffsetS : tz.stdOffsetS;
+}
+
+// Offset for local time `local` (for turning a local time into UTC).
+// In the hour skipped at DST start the standard offset is used; in the hour
+// that repeats at DST end the first (daylight) one is.
+int32_t tzOffsetForLocal(const TimeZone &tz, TzCache &cache, uint32_t local)
+{
+    int32_t dstGuess = tz.dstOffsetS;
+    if (tz.hasDst && tzIsDst(tz, cache, local - dstGuess))
+        return dstGuess;
+    return tz.stdOffsetS;
+}
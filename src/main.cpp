@@ -22,6 +22,24 @@ void setup()
   brightnessIndex = preferences.getInt("brightIdx", 0); // Safety check: ensure index is 0-2
   if (brightnessIndex < 0 || brightnessIndex > 2)
     brightnessIndex = 0;
+  uint8_t levels[3];
+  if (preferences.getBytes("brightLvls", levels, sizeof(levels)) == sizeof(levels))
+    for (int i = 0; i < 3; i++)
+      brightnessValues[i] = levels[i];
+  nightStartHour = preferences.getInt("nightStart", nightStartHour);
+  nightEndHour = preferences.getInt("nightEnd", nightEndHour);
+  nightLevel = preferences.getInt("nightLevel", nightLevel);
+  char lang[3] = "en";
+  preferences.getString("lang", lang, sizeof(lang));
+  banglaText = strcmp(lang, "bn") == 0;
+
+  preferences.getString("tz", tzString, sizeof(tzString));
+  if (!tzParse(tzString, timeZone))
+  {
+    Serial.println("Bad saved time zone, using default");
+    strcpy(tzString, TZ_DEFAULT);
+    tzParse(tzString, timeZone);
+  }
 
   Serial.print("Restored Mode: ");
   Serial.println(currentMode);
@@ -38,25 +56,19 @@ void setup()
 
   // 3. Start Display Refresh
   xTaskCreatePinnedToCore(refreshDisplay, "refreshDisplay", 4096, NULL, 20, &refreshTaskHandle, 1);
+  // The render task is the only writer of dmd; everything else queues draw commands
+  xTaskCreatePinnedToCore(renderTask, "render", 4096, NULL, 1, &renderTaskHandle, 1);
+  RenderClient gfx;
 
-  // 4. Initialize RTC
-  Wire.begin();
-
-  // Create I2C mutex to serialize all Wire/RTC usage (prevents heap corruption)
-  i2cMutex = xSemaphoreCreateMutex();
-  if (i2cMutex == NULL)
-  {
-    Serial.println("ERROR: Failed to create I2C mutex");
-    while (1)
-      vTaskDelay(pdMS_TO_TICKS(1000));
-  }
+  // 4. Initialize RTC (free the bus if a reset left it stuck, then start Wire at 400 kHz)
+  i2cBusRecover();
 
   if (!rtc.begin())
   {
     Serial.println("Couldn't find RTC");
-    dmd.clearScreen(true);
-    dmd.selectFont(SystemFont5x7);
-    dmd.drawString(0, 4, "NO RTC", 6, GRAPHICS_NORMAL);
+    gfx.clearScreen(true);
+    gfx.selectFont(SystemFont5x7);
+    gfx.drawString(0, 4, "NO RTC", 6, GRAPHICS_NORMAL);
     while (1)
       ;
   }
@@ -64,14 +76,38 @@ void setup()
   if (rtc.lostPower())
   {
     Serial.println("RTC lost power, setting compile time");
-    rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
+    DateTime built(F(__DATE__), F(__TIME__));
+    TzCache tzCache = {0};
+    rtc.adjust(built - TimeSpan(tzOffsetForLocal(timeZone, tzCache, built.unixtime())));
+    preferences.putBool("rtcUtc", true);
+  }
+  else if (!preferences.getBool("rtcUtc", false))
+  {
+    // Older firmware kept local time in the RTC
+    Serial.println("Moving RTC to UTC");
+    rtc.adjust(rtc.now() - TimeSpan(LEGACY_RTC_OFFSET_SEC));
+    preferences.putBool("rtcUtc", true);
+  }
+  // Restore the oscillator trim found by the NTP calibration (the RTC forgets it without power)
+  syncStats.aging = preferences.getChar("aging", 0);
+  ds3231WriteAging(Wire, syncStats.aging);
+  // From here on only the I2C task touches Wire/RTC (prevents heap corruption)
+  if (!startI2cService())
+  {
+    Serial.println("ERROR: Failed to start I2C task");
+    while (1)
+      vTaskDelay(pdMS_TO_TICKS(1000));
   }
   // 4. clear screen
-  dmd.clearScreen(true);
+  gfx.clearScreen(true);
   // 5. Start the saved clock mode
   changeClockMode(currentMode);
   // 6. WiFi Manager
   xTaskCreatePinnedToCore(backgroundSyncTask, "bkSync", 8192, NULL, 1, &ntpTaskHandle, 0);
+  // 7. HTTP API, frame mirror and frame sync (each only if switched on)
+  startApi();
+  startMirror();
+  startFrameSync();
 }
 void loop()
 {
@@ -99,10 +135,23 @@ void loop()
   // BUTTON 32: BRIGHTNESS (Short Press)
   // ==========================================
 
-  if(_hour24 >= 0 && _hour24 <= 7)
-    setBrightness(5);
-  else if(_hour24 >= 8 && _hour24 <= 23)
+  if(isNightHour(_hour24) && (long)(now - brightPreviewUntil) >= 0)
+    setBrightness(nightLevel);
+  else
     setBrightness(brightnessValues[brightnessIndex]);
+
+  // Mode change requested over the HTTP API; taken in one step, so a request that
+  // lands meanwhile is not wiped out
+  int requestedMode = apiRequestedMode.exchange(-1);
+  if (requestedMode >= 0)
+  {
+    currentMode = requestedMode;
+    preferences.putInt("mode", currentMode);
+    changeClockMode(currentMode);
+  }
+  // The last status icon went: redraw the face, cut in at once
+  if (faceRedrawRequested.exchange(false))
+    changeClockMode(currentMode, TRANSITION_NONE);
   static int lastState32 = HIGH;
   static unsigned long pressStart32 = 0;
   int currentState32 = digitalRead(DOWN_PIN);
@@ -120,6 +169,8 @@ void loop()
   }
 
   lastState32 = currentState32;
+  // Serve the WiFi setup portal while it is open
+  wifiPortalLoop();
   // Small delay to prevent CPU hogging and assist debounce
   vTaskDelay(pdMS_TO_TICKS(20));
 }
\ No newline at end of file
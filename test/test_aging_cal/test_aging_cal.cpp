@@ -0,0 +1,159 @@
+/*--------------------------------------------------------------------------------------
+ Aging calibration in ntpSync.h, in real time: synthetic RTC-minus-NTP series with a
+ known rate are fed into the drift fit ahead of a real ntpSyncStep(), which has to
+ write the fitted aging value to the DS3231 model, clamped to the register's range,
+ and leave short, sparse or small-error series alone.
+--------------------------------------------------------------------------------------*/
+#include <unity.h>
+#include "functions/ntpSync.h"
+
+Preferences preferences;
+void mirrorCapture() {}
+
+#define SERIES_SPAN_S (8 * 3600)
+
+// A series at `ppm` spread over `spanS` up to now, ending where the RTC is now (on the
+// edge, offset 0). `noiseMs` is added as +,-,-,+ per group of four, which has no slope of
+// its own.
+static void feedSeries(float ppm, int samples, uint32_t spanS, double noiseMs = 0)
+{
+    driftFit.reset();
+    offsetCorrectionMs = 0;
+    syncStats.driftKnown = false;
+    const double nowS = ntpNowUs() / 1e6;
+    for (int i = 0; i < samples; i++)
+    {
+        double t = nowS - spanS + (double)i * spanS / samples;
+        double noise = ((i + 1) & 2) ? -noiseMs : noiseMs;
+        driftFit.add(t, ppm * (t - nowS) / 1000.0 + noise);
+    }
+}
+
+static bool setAging(int8_t value)
+{
+    if (!i2cTransact(agingWriteJob, &value, I2C_PRIO_HIGH))
+        return false;
+    syncStats.aging = value;
+    vTaskDelay(pdMS_TO_TICKS(I2C_TIME_POLL_MS * 3)); // into the snapshot calibrateAging() reads
+    return true;
+}
+
+static int8_t agingRegister()
+{
+    return (int8_t)ds3231Sim.regs[DS3231_REG_AGING];
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_fit_recovers_rate_through_noise()
+{
+    static const float rates[] = {0.0f, 1.37f, -4.2f, 25.0f};
+    for (float ppm : rates)
+    {
+        feedSeries(ppm, 12, SERIES_SPAN_S, 4.0);
+        float fitted;
+        TEST_ASSERT_TRUE(driftFit.ppm(fitted));
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, ppm, fitted);
+        TEST_ASSERT_FLOAT_WITHIN(1.0f, SERIES_SPAN_S * 11 / 12.0f, driftFit.spanS());
+    }
+    // One time, or one sample, gives no rate
+    driftFit.reset();
+    driftFit.add(1000, 5);
+    float fitted;
+    TEST_ASSERT_FALSE(driftFit.ppm(fitted));
+    driftFit.add(1000, 9);
+    TEST_ASSERT_FALSE(driftFit.ppm(fitted));
+}
+
+void test_fitted_rate_written_to_aging()
+{
+    TEST_ASSERT_TRUE(setAging(0));
+    uint32_t calibrations = syncStats.calibrations;
+    feedSeries(2.34f, 8, SERIES_SPAN_S, 2.0);
+    uint32_t next = ntpSyncStep();
+    TEST_ASSERT_EQUAL_UINT32(calibrations + 1, syncStats.calibrations);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 2.34f, syncStats.driftPpm);
+    TEST_ASSERT_EQUAL_INT8(23, agingRegister());
+    TEST_ASSERT_EQUAL_INT8(23, syncStats.aging);
+    TEST_ASSERT_EQUAL_INT8(23, preferences.getChar("aging", 0));
+    // The old line is dropped and the next fit starts soon
+    TEST_ASSERT_EQUAL(0, driftFit.count);
+    TEST_ASSERT_FALSE(syncStats.driftKnown);
+    TEST_ASSERT_EQUAL_UINT32(SYNC_MIN_INTERVAL_S * 2, next);
+}
+
+void test_aging_step_is_relative()
+{
+    // A slow RTC on top of the trim already there
+    TEST_ASSERT_TRUE(setAging(23));
+    feedSeries(-1.06f, 8, SERIES_SPAN_S, 2.0);
+    ntpSyncStep();
+    TEST_ASSERT_EQUAL_INT8(12, agingRegister());
+    TEST_ASSERT_EQUAL_INT8(12, preferences.getChar("aging", 0));
+}
+
+void test_aging_clamped_to_register_range()
+{
+    TEST_ASSERT_TRUE(setAging(120));
+    feedSeries(2.0f, 8, SERIES_SPAN_S);
+    ntpSyncStep();
+    TEST_ASSERT_EQUAL_INT8(127, agingRegister());
+
+    TEST_ASSERT_TRUE(setAging(-120));
+    feedSeries(-3.0f, 8, SERIES_SPAN_S);
+    ntpSyncStep();
+    TEST_ASSERT_EQUAL_INT8(-127, agingRegister());
+
+    // Already at the limit: nothing to write
+    uint32_t calibrations = syncStats.calibrations;
+    uint32_t writes = ds3231Sim.registerWrites;
+    feedSeries(-3.0f, 8, SERIES_SPAN_S);
+    ntpSyncStep();
+    TEST_ASSERT_EQUAL_INT8(-127, agingRegister());
+    TEST_ASSERT_EQUAL_UINT32(calibrations, syncStats.calibrations);
+    TEST_ASSERT_EQUAL_UINT32(writes, ds3231Sim.registerWrites);
+}
+
+void test_weak_series_left_alone()
+{
+    TEST_ASSERT_TRUE(setAging(0));
+    uint32_t calibrations = syncStats.calibrations;
+    feedSeries(SYNC_CAL_MIN_PPM * 0.8f, 8, SERIES_SPAN_S); // under one step's worth
+    ntpSyncStep();
+    TEST_ASSERT_TRUE(syncStats.driftKnown);
+    feedSeries(3.0f, 8, SYNC_CAL_MIN_SPAN_S - 1800); // too short
+    ntpSyncStep();
+    TEST_ASSERT_TRUE(syncStats.driftKnown);
+    feedSeries(3.0f, SYNC_CAL_MIN_SAMPLES - 2, SERIES_SPAN_S); // too few, with the step's own
+    ntpSyncStep();
+    TEST_ASSERT_TRUE(syncStats.driftKnown);
+    TEST_ASSERT_EQUAL_UINT32(calibrations, syncStats.calibrations);
+    TEST_ASSERT_EQUAL_INT8(0, agingRegister());
+}
+
+static void testsTask(void *pvParameters)
+{
+    // Put the RTC on the system clock's second edge, so the real sample each step adds is 0
+    writeRtcFromNtp();
+    UNITY_BEGIN();
+    RUN_TEST(test_fit_recovers_rate_through_noise);
+    RUN_TEST(test_fitted_rate_written_to_aging);
+    RUN_TEST(test_aging_step_is_relative);
+    RUN_TEST(test_aging_clamped_to_register_range);
+    RUN_TEST(test_weak_series_left_alone);
+    exit(UNITY_END());
+}
+
+int main(int argc, char **argv)
+{
+    preferences.begin("clock-app", false);
+    Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN, I2C_FAST_HZ);
+    rtc.begin();
+    rtc.adjust(DateTime((uint32_t)(ntpNowUs() / 1000000)));
+    if (!startI2cService())
+        return 2;
+    xTaskCreatePinnedToCore(testsTask, "tests", 8192, NULL, 1, NULL, 1);
+    for (;;)
+        vTaskDelay(portMAX_DELAY);
+}
@@ -0,0 +1,230 @@
+/*--------------------------------------------------------------------------------------
+ DrawRing under load, in real time (tasks are host threads running at once): producer
+ tasks push numbered commands while a render stand-in drains them the way renderTask()
+ does. Every command must arrive exactly once, intact and in its producer's order.
+--------------------------------------------------------------------------------------*/
+#include <unity.h>
+#include <atomic>
+#include "functions/renderQueue.h"
+
+DMD dmd(1, 1);
+void mirrorCapture() {}
+
+#define PRODUCERS 4
+#define PUSHES 70000 // past 65536, so the 16 bit indices wrap
+#define HANDOVERS 24
+#define OWNER_ID 0xFF // changeClockMode() pushing between two faces
+
+struct Tally
+{
+    uint32_t next[256]; // next sequence number expected from each producer
+    uint32_t received;
+    uint32_t torn;      // payload does not match its sequence number
+    uint32_t outOfOrder;
+};
+
+static Tally tally;
+static std::atomic<bool> producersDone{false};
+static SemaphoreHandle_t consumerDone;
+
+static DrawCommand makeCommand(uint8_t producer, uint32_t seq)
+{
+    DrawCommand cmd;
+    cmd.op = DRAW_LINE;
+    cmd.mode = producer;
+    cmd.x1 = (int16_t)(seq & 0xFFFF);
+    cmd.y1 = (int16_t)(seq >> 16);
+    cmd.x2 = cmd.y2 = 0;
+    cmd.font = NULL;
+    cmd.length = DRAW_TEXT_MAX;
+    for (int i = 0; i < DRAW_TEXT_MAX; i++)
+        cmd.text[i] = (char)(seq * 31 + i);
+    return cmd;
+}
+
+static void check(const DrawCommand &cmd)
+{
+    uint32_t seq = (uint16_t)cmd.x1 | (uint32_t)(uint16_t)cmd.y1 << 16;
+    DrawCommand expect = makeCommand(cmd.mode, seq);
+    if (cmd.op != DRAW_LINE || cmd.length != DRAW_TEXT_MAX || memcmp(cmd.text, expect.text, DRAW_TEXT_MAX) != 0)
+        tally.torn++;
+    if (seq != tally.next[cmd.mode])
+        tally.outOfOrder++;
+    tally.next[cmd.mode] = seq + 1;
+    tally.received++;
+}
+
+// ------------------- Render stand-in -------------------
+// renderTask()'s loop, over a set of rings, checking instead of drawing
+struct ConsumerArgs
+{
+    DrawRing **rings;
+    int count;
+};
+
+static void consumerTask(void *pvParameters)
+{
+    ConsumerArgs *args = (ConsumerArgs *)pvParameters;
+    DrawCommand cmd;
+    for (;;)
+    {
+        bool finished = producersDone.load();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+        bool any = false;
+        for (int r = 0; r < args->count; r++)
+        {
+            while (args->rings[r]->pop(cmd))
+            {
+                check(cmd);
+                any = true;
+            }
+        }
+        if (finished && !any)
+            break;
+    }
+    xSemaphoreGive(consumerDone);
+    vTaskDelete(NULL);
+}
+
+static void startConsumer(ConsumerArgs &args)
+{
+    memset(&tally, 0, sizeof(tally));
+    producersDone = false;
+    consumerDone = xSemaphoreCreateBinary();
+    xTaskCreatePinnedToCore(consumerTask, "render", 4096, &args, 2, &renderTaskHandle, 1);
+}
+
+static void waitForConsumer()
+{
+    producersDone = true;
+    xTaskNotifyGive(renderTaskHandle);
+    xSemaphoreTake(consumerDone, portMAX_DELAY);
+}
+
+// ------------------- Producers -------------------
+struct ProducerArgs
+{
+    DrawRing *ring;
+    uint8_t id;
+    uint32_t limit;              // stop after this many; 0 = until deleted
+    std::atomic<uint32_t> pushed; // pushes that returned
+    std::atomic<bool> gone;
+};
+
+// Set when the task ends, deleted or not
+struct GoneFlag
+{
+    std::atomic<bool> &flag;
+    ~GoneFlag() { flag = true; }
+};
+
+static void producerTask(void *pvParameters)
+{
+    ProducerArgs *args = (ProducerArgs *)pvParameters;
+    GoneFlag gone{args->gone};
+    for (uint32_t seq = 0; args->limit == 0 || seq < args->limit; seq++)
+    {
+        args->ring->push(makeCommand(args->id, seq));
+        args->pushed++;
+        if (args->limit == 0)
+            taskYIELD(); // a face gives up the CPU between frames; it can be deleted there too
+    }
+    vTaskDelete(NULL);
+}
+
+void setUp() {}
+void tearDown() {}
+
+// One ring per producer, all drained by one consumer at once
+void test_rings_under_concurrent_load()
+{
+    static DrawRing rings[PRODUCERS];
+    static ProducerArgs producers[PRODUCERS];
+    DrawRing *ringList[PRODUCERS];
+    for (int p = 0; p < PRODUCERS; p++)
+        ringList[p] = &rings[p];
+    ConsumerArgs consumer = {ringList, PRODUCERS};
+    startConsumer(consumer);
+
+    for (int p = 0; p < PRODUCERS; p++)
+    {
+        producers[p].ring = &rings[p];
+        producers[p].id = p;
+        producers[p].limit = PUSHES;
+        producers[p].pushed = 0;
+        producers[p].gone = false;
+        xTaskCreatePinnedToCore(producerTask, "producer", 4096, &producers[p], 1, NULL, p & 1);
+    }
+    for (int p = 0; p < PRODUCERS; p++)
+        while (!producers[p].gone)
+            vTaskDelay(pdMS_TO_TICKS(10));
+    waitForConsumer();
+
+    TEST_ASSERT_EQUAL_UINT32(0, tally.torn);
+    TEST_ASSERT_EQUAL_UINT32(0, tally.outOfOrder);
+    TEST_ASSERT_EQUAL_UINT32(PRODUCERS * PUSHES, tally.received);
+    for (int p = 0; p < PRODUCERS; p++)
+        TEST_ASSERT_EQUAL_UINT32(PUSHES, tally.next[p]);
+    uint32_t stalls = 0;
+    for (int p = 0; p < PRODUCERS; p++)
+        stalls += rings[p].stalls;
+    TEST_ASSERT_GREATER_THAN(0, stalls); // the full-ring path was taken
+}
+
+// faceRing handed from face to face the way changeClockMode() does it: each producer is
+// deleted wherever it happens to be, then the owner pushes, then the next one starts
+void test_handover_between_producers()
+{
+    static ProducerArgs producers[HANDOVERS];
+    DrawRing *ringList[1] = {&faceRing};
+    ConsumerArgs consumer = {ringList, 1};
+    startConsumer(consumer);
+
+    uint32_t ownerPushes = 0;
+    for (int h = 0; h < HANDOVERS; h++)
+    {
+        ProducerArgs &face = producers[h];
+        face.ring = &faceRing;
+        face.id = h;
+        face.limit = 0;
+        face.pushed = 0;
+        face.gone = false;
+        TaskHandle_t task;
+        xTaskCreatePinnedToCore(producerTask, "face", 4096, &face, 1, &task, 1);
+        vTaskDelay(pdMS_TO_TICKS(20 + h % 7));
+        vTaskDelete(task);
+        while (!face.gone)
+            vTaskDelay(pdMS_TO_TICKS(1));
+        faceRing.push(makeCommand(OWNER_ID, ownerPushes++));
+    }
+    waitForConsumer();
+
+    TEST_ASSERT_EQUAL_UINT32(0, tally.torn);
+    TEST_ASSERT_EQUAL_UINT32(0, tally.outOfOrder);
+    uint32_t total = ownerPushes;
+    for (int h = 0; h < HANDOVERS; h++)
+    {
+        // Nothing a deleted producer had not finished pushing shows up
+        TEST_ASSERT_GREATER_THAN(0, producers[h].pushed.load());
+        TEST_ASSERT_EQUAL_UINT32(producers[h].pushed.load(), tally.next[h]);
+        total += producers[h].pushed;
+    }
+    TEST_ASSERT_EQUAL_UINT32(ownerPushes, tally.next[OWNER_ID]);
+    TEST_ASSERT_EQUAL_UINT32(total, tally.received);
+}
+
+static void testsTask(void *pvParameters)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_rings_under_concurrent_load);
+    RUN_TEST(test_handover_between_producers);
+    exit(UNITY_END());
+}
+
+int main(int argc, char **argv)
+{
+    // Tasks block and get deleted through the FreeRTOS shims, so the tests run in one too
+    xTaskCreatePinnedToCore(testsTask, "tests", 8192, NULL, 1, NULL, 1);
+    for (;;)
+        vTaskDelay(portMAX_DELAY);
+}
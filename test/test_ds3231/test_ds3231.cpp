@@ -0,0 +1,257 @@
+/*--------------------------------------------------------------------------------------
+ ds3231.h against a fake register file: BCD and range checks, 12/24 hour modes, the
+ century bit, temperature sign and the bounds of the burst read.
+--------------------------------------------------------------------------------------*/
+#include <unity.h>
+#include "functions/ds3231.h"
+
+// A DS3231 that serves a fixed register image and logs every transfer
+class FakeRegs : public I2CDevice
+{
+public:
+    uint8_t regs[DS3231_REG_COUNT];
+    uint8_t pointer = 0;
+    size_t shortBy = 0; // bytes to leave off each read
+    uint32_t writes = 0, reads = 0;
+    size_t lastReadLen = 0;
+    uint8_t lastReadFrom = 0;
+
+    bool onWrite(const uint8_t *data, size_t len) override
+    {
+        writes++;
+        pointer = data[0];
+        for (size_t i = 1; i < len; i++)
+        {
+            regs[pointer] = data[i];
+            pointer = (pointer + 1) % DS3231_REG_COUNT;
+        }
+        return true;
+    }
+
+    size_t onRead(uint8_t *data, size_t len) override
+    {
+        reads++;
+        lastReadFrom = pointer;
+        lastReadLen = len;
+        len = len > shortBy ? len - shortBy : 0;
+        for (size_t i = 0; i < len; i++)
+        {
+            data[i] = regs[pointer];
+            pointer = (pointer + 1) % DS3231_REG_COUNT; // the chip wraps after 0x12
+        }
+        return len;
+    }
+};
+
+static FakeRegs fake;
+
+// 2031-07-15 21:45:09, 24 hour mode, 25.50 C
+static const uint8_t sampleRegs[DS3231_REG_COUNT] = {
+    0x09, 0x45, 0x21, 0x03, 0x15, 0x07, 0x31, // time
+    0x00, 0x00, 0x00, 0x00,                   // alarm 1
+    0x00, 0x00, 0x00,                         // alarm 2
+    0x1C, 0x00, 0x00,                         // control, status, aging
+    0x19, 0x80};                              // temperature
+
+static I2CFault nackAll(uint8_t address, bool isRead)
+{
+    (void)address;
+    (void)isRead;
+    return I2C_FAULT_NACK;
+}
+
+void setUp()
+{
+    memcpy(fake.regs, sampleRegs, sizeof(sampleRegs));
+    fake.pointer = 0x0A;
+    fake.shortBy = 0;
+    fake.writes = fake.reads = 0;
+    Wire.faultHook = nullptr;
+}
+
+void tearDown() {}
+
+static Ds3231State decode(const uint8_t *regs, bool &ok)
+{
+    Ds3231State state{};
+    ok = ds3231Decode(regs, state);
+    return state;
+}
+
+void test_bcd_time_fields()
+{
+    bool ok;
+    Ds3231State s = decode(sampleRegs, ok);
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_EQUAL(2031, s.time.year());
+    TEST_ASSERT_EQUAL(7, s.time.month());
+    TEST_ASSERT_EQUAL(15, s.time.day());
+    TEST_ASSERT_EQUAL(21, s.time.hour());
+    TEST_ASSERT_EQUAL(45, s.time.minute());
+    TEST_ASSERT_EQUAL(9, s.time.second());
+    TEST_ASSERT_EQUAL_UINT8(0x1C, s.control);
+    TEST_ASSERT_FALSE(s.oscStopped);
+}
+
+void test_invalid_bcd_and_ranges_rejected()
+{
+    // register, bad value
+    static const uint8_t cases[][2] = {
+        {0x00, 0x5A}, {0x00, 0x60}, {0x01, 0x0F}, {0x01, 0x60}, {0x02, 0x24}, {0x02, 0x1A},
+        {0x04, 0x00}, {0x04, 0x32}, {0x05, 0x00}, {0x05, 0x13}, {0x06, 0xA0}, {0x06, 0x3B}};
+    for (const auto &c : cases)
+    {
+        uint8_t regs[DS3231_REG_COUNT];
+        memcpy(regs, sampleRegs, sizeof(regs));
+        regs[c[0]] = c[1];
+        bool ok;
+        decode(regs, ok);
+        TEST_ASSERT_FALSE(ok);
+    }
+}
+
+void test_12_hour_mode()
+{
+    // hour register, expected 24 hour value
+    static const uint8_t cases[][2] = {
+        {0x52, 0},  // 12 AM
+        {0x41, 1},  // 1 AM
+        {0x51, 11}, // 11 AM
+        {0x72, 12}, // 12 PM
+        {0x61, 13}, // 1 PM
+        {0x71, 23}, // 11 PM
+    };
+    for (const auto &c : cases)
+    {
+        uint8_t regs[DS3231_REG_COUNT];
+        memcpy(regs, sampleRegs, sizeof(regs));
+        regs[0x02] = c[0];
+        bool ok;
+        Ds3231State s = decode(regs, ok);
+        TEST_ASSERT_TRUE(ok);
+        TEST_ASSERT_EQUAL(c[1], s.time.hour());
+    }
+    // 24 hour mode: bit 5 is the 20-hours digit, not PM
+    uint8_t regs[DS3231_REG_COUNT];
+    memcpy(regs, sampleRegs, sizeof(regs));
+    regs[0x02] = 0x23;
+    bool ok;
+    TEST_ASSERT_EQUAL(23, decode(regs, ok).time.hour());
+    TEST_ASSERT_TRUE(ok);
+}
+
+void test_century_bit()
+{
+    // The chip sets bit 7 of the month register when the year rolls from 99 to 00.
+    // DateTime only covers 2000-2099, so the bit is masked off the month and ignored.
+    uint8_t regs[DS3231_REG_COUNT];
+    memcpy(regs, sampleRegs, sizeof(regs));
+    regs[0x05] = 0x80 | 0x12;
+    regs[0x06] = 0x99;
+    bool ok;
+    Ds3231State s = decode(regs, ok);
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_EQUAL(12, s.time.month());
+    TEST_ASSERT_EQUAL(2099, s.time.year());
+}
+
+void test_temperature_sign()
+{
+    // MSB, LSB (top two bits are quarters), expected degrees
+    static const struct
+    {
+        uint8_t msb, lsb;
+        float c;
+    } cases[] = {
+        {0x19, 0x80, 25.5f}, {0x00, 0x00, 0.0f}, {0x00, 0x40, 0.25f}, {0xFF, 0xC0, -0.25f},
+        {0xFF, 0x00, -1.0f}, {0xE7, 0x40, -24.75f}, {0x7F, 0xC0, 127.75f}, {0x80, 0x00, -128.0f}};
+    for (const auto &c : cases)
+    {
+        uint8_t regs[DS3231_REG_COUNT];
+        memcpy(regs, sampleRegs, sizeof(regs));
+        regs[DS3231_REG_TEMP_MSB] = c.msb;
+        regs[DS3231_REG_TEMP_MSB + 1] = c.lsb;
+        bool ok;
+        TEST_ASSERT_FLOAT_WITHIN(0.001f, c.c, decode(regs, ok).temperature);
+    }
+}
+
+void test_status_and_aging()
+{
+    uint8_t regs[DS3231_REG_COUNT];
+    memcpy(regs, sampleRegs, sizeof(regs));
+    regs[DS3231_REG_STATUS] = DS3231_STATUS_OSF | DS3231_STATUS_A2F;
+    regs[DS3231_REG_AGING] = 0xF6;
+    bool ok;
+    Ds3231State s = decode(regs, ok);
+    TEST_ASSERT_TRUE(s.oscStopped);
+    TEST_ASSERT_FALSE(s.alarm1Fired);
+    TEST_ASSERT_TRUE(s.alarm2Fired);
+    TEST_ASSERT_EQUAL_INT8(-10, s.aging);
+}
+
+void test_burst_read_covers_register_map()
+{
+    Ds3231State s;
+    uint8_t raw[DS3231_REG_COUNT];
+    TEST_ASSERT_TRUE(ds3231ReadAll(Wire, s, raw));
+    // One pointer write, then one read of exactly 0x00-0x12
+    TEST_ASSERT_EQUAL_UINT32(1, fake.writes);
+    TEST_ASSERT_EQUAL_UINT32(1, fake.reads);
+    TEST_ASSERT_EQUAL_UINT8(DS3231_REG_SECONDS, fake.lastReadFrom);
+    TEST_ASSERT_EQUAL(DS3231_REG_COUNT, fake.lastReadLen);
+    TEST_ASSERT_EQUAL_MEMORY(sampleRegs, raw, DS3231_REG_COUNT);
+    TEST_ASSERT_EQUAL(45, s.time.minute());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 25.5f, s.temperature);
+}
+
+void test_burst_read_short_or_nacked()
+{
+    Ds3231State s;
+    fake.shortBy = 1; // last byte (temperature LSB) missing
+    TEST_ASSERT_FALSE(ds3231ReadAll(Wire, s));
+    fake.shortBy = DS3231_REG_COUNT;
+    TEST_ASSERT_FALSE(ds3231ReadAll(Wire, s));
+    fake.shortBy = 0;
+    Wire.faultHook = nackAll;
+    TEST_ASSERT_FALSE(ds3231ReadAll(Wire, s));
+    uint8_t sec;
+    TEST_ASSERT_FALSE(ds3231ReadSeconds(Wire, sec));
+}
+
+void test_seconds_read()
+{
+    uint8_t sec = 0;
+    TEST_ASSERT_TRUE(ds3231ReadSeconds(Wire, sec));
+    TEST_ASSERT_EQUAL_UINT8(9, sec);
+    TEST_ASSERT_EQUAL(1, fake.lastReadLen);
+    fake.regs[0x00] = 0x80 | 0x59; // bit 7 is not part of the seconds
+    TEST_ASSERT_TRUE(ds3231ReadSeconds(Wire, sec));
+    TEST_ASSERT_EQUAL_UINT8(59, sec);
+    fake.regs[0x00] = 0x4F;
+    TEST_ASSERT_FALSE(ds3231ReadSeconds(Wire, sec));
+}
+
+void test_aging_write_starts_conversion()
+{
+    TEST_ASSERT_TRUE(ds3231WriteAging(Wire, -7));
+    TEST_ASSERT_EQUAL_INT8(-7, (int8_t)fake.regs[DS3231_REG_AGING]);
+    TEST_ASSERT_EQUAL_UINT8(0x1C | DS3231_CONTROL_CONV, fake.regs[DS3231_REG_CONTROL]);
+}
+
+int main(int argc, char **argv)
+{
+    Wire.attach(DS3231_I2C_ADDR, &fake);
+    UNITY_BEGIN();
+    RUN_TEST(test_bcd_time_fields);
+    RUN_TEST(test_invalid_bcd_and_ranges_rejected);
+    RUN_TEST(test_12_hour_mode);
+    RUN_TEST(test_century_bit);
+    RUN_TEST(test_temperature_sign);
+    RUN_TEST(test_status_and_aging);
+    RUN_TEST(test_burst_read_covers_register_map);
+    RUN_TEST(test_burst_read_short_or_nacked);
+    RUN_TEST(test_seconds_read);
+    RUN_TEST(test_aging_write_starts_conversion);
+    return UNITY_END();
+}
@@ -0,0 +1,243 @@
+/*--------------------------------------------------------------------------------------
+ frameCodec.h round trips: random, all-on and all-off frames, single-pixel deltas and
+ long random delta chains decode to the frame that was encoded; truncated, corrupted and
+ malformed packets are rejected without touching the receiver's frame.
+--------------------------------------------------------------------------------------*/
+#include <unity.h>
+#include <vector>
+#include "functions/frameCodec.h"
+
+#define PANEL_BYTES 64 // one P10 panel: 32 x 16 pixels, 1 bit each
+#define LIT 0x00       // 0 bit = lit
+#define DARK 0xFF
+
+static uint32_t rng = 12345;
+
+static uint8_t nextByte()
+{
+    rng = rng * 1103515245 + 12345;
+    return rng >> 16;
+}
+
+static std::vector<uint8_t> randomFrame(size_t len)
+{
+    std::vector<uint8_t> f(len);
+    for (auto &b : f)
+        b = nextByte();
+    return f;
+}
+
+static std::vector<uint8_t> encode(const std::vector<uint8_t> *prev, const std::vector<uint8_t> &cur, uint16_t seq = 0)
+{
+    std::vector<uint8_t> pkt(FRAME_PACKET_MAX(cur.size()));
+    size_t n = frameEncode(prev ? prev->data() : NULL, cur.data(), cur.size(), seq, prev == NULL, pkt.data(), pkt.size());
+    TEST_ASSERT_NOT_EQUAL(0, n);
+    pkt.resize(n);
+    return pkt;
+}
+
+// Decode onto a copy of `have` and check it becomes `want`
+static void roundTrip(const std::vector<uint8_t> &have, const std::vector<uint8_t> &want, const std::vector<uint8_t> &pkt)
+{
+    std::vector<uint8_t> frame = have;
+    TEST_ASSERT_TRUE(frameDecode(pkt.data(), pkt.size(), frame.data(), frame.size()));
+    TEST_ASSERT_EQUAL_MEMORY(want.data(), frame.data(), want.size());
+}
+
+// Must fail and leave the frame as it was
+static void rejected(const std::vector<uint8_t> &pkt, size_t n, const std::vector<uint8_t> &have)
+{
+    std::vector<uint8_t> frame = have;
+    TEST_ASSERT_FALSE(frameDecode(pkt.data(), n, frame.data(), frame.size()));
+    TEST_ASSERT_EQUAL_MEMORY(have.data(), frame.data(), have.size());
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_keyframes_round_trip()
+{
+    const size_t sizes[] = {1, PANEL_BYTES, PANEL_BYTES * 2, PANEL_BYTES * 8};
+    for (size_t len : sizes)
+    {
+        std::vector<uint8_t> garbage = randomFrame(len);
+        std::vector<uint8_t> f = randomFrame(len);
+        std::vector<uint8_t> pkt = encode(NULL, f);
+        TEST_ASSERT_LESS_OR_EQUAL(FRAME_PACKET_MAX(len), pkt.size()); // incompressible: the worst case
+        roundTrip(garbage, f, pkt);
+
+        // All on and all off are one repeat op per FRAME_RUN_MAX bytes
+        size_t runs = (len + FRAME_RUN_MAX - 1) / FRAME_RUN_MAX;
+        for (uint8_t fill : {LIT, DARK})
+        {
+            std::vector<uint8_t> solid(len, fill);
+            pkt = encode(NULL, solid);
+            if (len >= FRAME_REPEAT_MIN)
+                TEST_ASSERT_EQUAL(FRAME_HEADER_SIZE + 2 * runs + FRAME_CRC_SIZE, pkt.size());
+            roundTrip(garbage, solid, pkt);
+        }
+    }
+}
+
+void test_single_pixel_deltas()
+{
+    std::vector<uint8_t> base(PANEL_BYTES, DARK);
+    for (int pixel = 0; pixel < PANEL_BYTES * 8; pixel++)
+    {
+        std::vector<uint8_t> cur = base;
+        cur[pixel / 8] ^= 0x80 >> (pixel % 8);
+        std::vector<uint8_t> pkt = encode(&base, cur, pixel);
+        // Header, skips up to the byte, a 1 byte literal, CRC; a lone unchanged
+        // byte at the very end rides along in the literal
+        size_t skips = (pixel / 8 + FRAME_RUN_MAX - 1) / FRAME_RUN_MAX;
+        size_t tail = pixel / 8 == PANEL_BYTES - 2 ? 1 : 0;
+        TEST_ASSERT_EQUAL(FRAME_HEADER_SIZE + skips + 2 + tail + FRAME_CRC_SIZE, pkt.size());
+        roundTrip(base, cur, pkt);
+    }
+    // Nothing changed: just the header and CRC
+    TEST_ASSERT_EQUAL(FRAME_HEADER_SIZE + FRAME_CRC_SIZE, encode(&base, base).size());
+}
+
+void test_random_delta_chain()
+{
+    // Sender and receiver stay in step over many deltas of every size
+    const size_t len = PANEL_BYTES * 2;
+    std::vector<uint8_t> sent = randomFrame(len);
+    std::vector<uint8_t> received(len, 0);
+    std::vector<uint8_t> pkt = encode(NULL, sent);
+    TEST_ASSERT_TRUE(frameDecode(pkt.data(), pkt.size(), received.data(), len));
+    for (int step = 0; step < 2000; step++)
+    {
+        std::vector<uint8_t> cur = sent;
+        int changes = nextByte() % 40;
+        for (int c = 0; c < changes; c++)
+        {
+            size_t at = nextByte() % len;
+            size_t run = nextByte() % 8 + 1;
+            uint8_t v = (nextByte() & 1) ? nextByte() : cur[at] ^ 0xFF;
+            for (size_t k = at; k < at + run && k < len; k++)
+                cur[k] = (c & 1) ? v : nextByte();
+        }
+        pkt = encode(&sent, cur, step);
+        TEST_ASSERT_LESS_OR_EQUAL(FRAME_PACKET_MAX(len), pkt.size());
+        TEST_ASSERT_TRUE(frameDecode(pkt.data(), pkt.size(), received.data(), len));
+        TEST_ASSERT_EQUAL_MEMORY(cur.data(), received.data(), len);
+        sent = cur;
+    }
+}
+
+void test_truncated_packets_rejected()
+{
+    std::vector<uint8_t> base = randomFrame(PANEL_BYTES);
+    std::vector<uint8_t> cur = base;
+    for (int i = 0; i < PANEL_BYTES; i += 5)
+        cur[i] ^= 0x11;
+    std::vector<uint8_t> delta = encode(&base, cur);
+    std::vector<uint8_t> key = encode(NULL, cur);
+    for (size_t n = 0; n < delta.size(); n++)
+        rejected(delta, n, base);
+    for (size_t n = 0; n < key.size(); n++)
+        rejected(key, n, base);
+}
+
+void test_corrupted_packets_rejected()
+{
+    std::vector<uint8_t> base = randomFrame(PANEL_BYTES);
+    std::vector<uint8_t> cur = base;
+    cur[10] ^= 0x01;
+    cur[40] = 0x00;
+    std::vector<uint8_t> packets[] = {encode(&base, cur), encode(NULL, cur), encode(NULL, std::vector<uint8_t>(PANEL_BYTES, LIT))};
+    for (auto &good : packets)
+    {
+        // Every single bit flip, header, ops, literals and CRC alike
+        for (size_t bit = 0; bit < good.size() * 8; bit++)
+        {
+            std::vector<uint8_t> bad = good;
+            bad[bit / 8] ^= 1 << (bit % 8);
+            rejected(bad, bad.size(), base);
+        }
+        // Bursts of random bytes
+        for (int trial = 0; trial < 2000; trial++)
+        {
+            std::vector<uint8_t> bad = good;
+            size_t at = nextByte() % bad.size();
+            for (int k = 0; k < 3 && at + k < bad.size(); k++)
+                bad[at + k] ^= nextByte() | 1;
+            rejected(bad, bad.size(), base);
+        }
+        // Extra bytes on the end
+        std::vector<uint8_t> longer = good;
+        longer.push_back(0x40);
+        longer.push_back(0x00);
+        rejected(longer, longer.size(), base);
+    }
+}
+
+// Packets with a good CRC but impossible contents: what a broken encoder would send
+static std::vector<uint8_t> sealed(std::vector<uint8_t> body)
+{
+    uint16_t crc = frameCrc(body.data(), body.size());
+    body.push_back(crc & 0xFF);
+    body.push_back(crc >> 8);
+    return body;
+}
+
+void test_malformed_packets_rejected()
+{
+    std::vector<uint8_t> have(PANEL_BYTES, DARK);
+    const uint8_t key[] = {'P', 'M', FRAME_VERSION, FRAME_FLAG_KEY, 0, 0, PANEL_BYTES, 0};
+    const uint8_t delta[] = {'P', 'M', FRAME_VERSION, 0, 0, 0, PANEL_BYTES, 0};
+    std::vector<uint8_t> k(key, key + 8), d(delta, delta + 8);
+    std::vector<uint8_t> frame = have;
+    auto decodes = [&](std::vector<uint8_t> body) {
+        std::vector<uint8_t> pkt = sealed(body);
+        frame = have;
+        return frameDecode(pkt.data(), pkt.size(), frame.data(), frame.size());
+    };
+    auto with = [](std::vector<uint8_t> v, std::initializer_list<uint8_t> ops) {
+        v.insert(v.end(), ops);
+        return v;
+    };
+    TEST_ASSERT_TRUE(decodes(with(k, {FRAME_OP_REPEAT | 63, 0x00})));
+    TEST_ASSERT_FALSE(decodes(with(k, {FRAME_OP_REPEAT | 62, 0x00})));                 // keyframe short of the frame
+    TEST_ASSERT_FALSE(decodes(with(k, {FRAME_OP_SKIP | 0, FRAME_OP_REPEAT | 62, 0})));  // keyframe with a skip
+    TEST_ASSERT_FALSE(decodes(with(d, {FRAME_OP_SKIP | 63, FRAME_OP_LITERAL | 0, 1}))); // past the end
+    TEST_ASSERT_FALSE(decodes(with(d, {FRAME_OP_LITERAL | 3, 1, 2})));                 // literal cut short
+    TEST_ASSERT_FALSE(decodes(with(d, {FRAME_OP_REPEAT | 3})));                        // repeat without its byte
+    TEST_ASSERT_FALSE(decodes(with(d, {0xC0})));                                        // unknown op
+    TEST_ASSERT_TRUE(decodes(with(d, {FRAME_OP_SKIP | 9, FRAME_OP_LITERAL | 0, 0x5A})));
+    TEST_ASSERT_EQUAL_UINT8(0x5A, frame[10]);
+
+    // Header: magic, version, frame size
+    std::vector<uint8_t> ok = with(k, {FRAME_OP_REPEAT | 63, 0x00});
+    for (int field : {0, 1, 2, 6, 7})
+    {
+        std::vector<uint8_t> bad = ok;
+        bad[field] ^= 0x04;
+        TEST_ASSERT_FALSE(decodes(bad));
+    }
+}
+
+void test_encoder_respects_buffer()
+{
+    std::vector<uint8_t> f = randomFrame(PANEL_BYTES);
+    std::vector<uint8_t> pkt(FRAME_PACKET_MAX(PANEL_BYTES));
+    size_t need = frameEncode(NULL, f.data(), f.size(), 0, true, pkt.data(), pkt.size());
+    TEST_ASSERT_NOT_EQUAL(0, need);
+    for (size_t outMax = 0; outMax < need; outMax++)
+        TEST_ASSERT_EQUAL(0, frameEncode(NULL, f.data(), f.size(), 0, true, pkt.data(), outMax));
+    TEST_ASSERT_EQUAL(need, frameEncode(NULL, f.data(), f.size(), 0, true, pkt.data(), need));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_keyframes_round_trip);
+    RUN_TEST(test_single_pixel_deltas);
+    RUN_TEST(test_random_delta_chain);
+    RUN_TEST(test_truncated_packets_rejected);
+    RUN_TEST(test_corrupted_packets_rejected);
+    RUN_TEST(test_malformed_packets_rejected);
+    RUN_TEST(test_encoder_respects_buffer);
+    return UNITY_END();
+}
@@ -0,0 +1,177 @@
+/*--------------------------------------------------------------------------------------
+ frameSync.h across processes: three clocks, each its own process with its own
+ timebase, broadcast beacons over loopback (the WiFiUDP shim) and have to end up on
+ one master's timebase. Stray datagrams of other sizes are sent to the port all the
+ while; a clock that let one sit unread would never hear another beacon.
+--------------------------------------------------------------------------------------*/
+#include <unity.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "functions/frameSync.h"
+
+Preferences preferences;
+volatile bool portalActive = false;
+void mirrorCapture() {}
+
+#define CLOCKS 3
+#define JOIN_STAGGER_MS 300 // clock 0 first, so it is the master whatever its id
+#define RUN_MS 4500
+#define STRAY_EVERY_MS 20
+// The task sleeps in select() and timestamps a beacon when it wakes, so what is left is
+// loopback and thread wake-up delay (tens of us here). Polling instead would cost a
+// wake-up every poll and add up to a poll period to each sample; the margin is for a
+// loaded host.
+#define LOCK_TOLERANCE_US 3000
+
+struct ClockResult
+{
+    uint32_t id;
+    uint8_t role;
+    uint32_t masterId;
+    int64_t offsetUs; // frameOffset() at the end; the local timers all match (forked)
+    uint32_t steps;
+    uint32_t beaconsReceived;
+    uint32_t beaconsSent;
+    uint32_t jitterUs;
+};
+
+static ClockResult results[CLOCKS];
+static uint32_t straysSent = 0;
+
+// Clock 0 gets the highest id: a master that was there first keeps the role
+static uint64_t clockMac(int i)
+{
+    return 0x300 - i;
+}
+
+static int64_t clockStartOffset(int i)
+{
+    return i * 3000000LL + i * 12345;
+}
+
+// One clock, in a child process
+static void runClock(int i, int out)
+{
+    char mac[16];
+    snprintf(mac, sizeof(mac), "%llx", (unsigned long long)clockMac(i));
+    setenv("NATIVE_MAC", mac, 1);
+    delay(i * JOIN_STAGGER_MS);
+    WiFi.connectDelayMs = 0;
+    WiFi.begin();
+    frameSetOffset(clockStartOffset(i));
+    frameSyncSetEnabled(true);
+    delay(RUN_MS - i * JOIN_STAGGER_MS);
+
+    ClockResult r;
+    r.id = frameSyncId;
+    r.role = frameSyncStats.role;
+    r.masterId = frameSyncStats.masterId;
+    r.offsetUs = frameOffset();
+    r.steps = frameSyncStats.steps;
+    r.beaconsReceived = frameSyncStats.beaconsReceived;
+    r.beaconsSent = frameSyncStats.beaconsSent;
+    r.jitterUs = frameSyncStats.jitterUs;
+    _exit(write(out, &r, sizeof(r)) == sizeof(r) ? 0 : 1);
+}
+
+// Other traffic on the port: shorter and longer than a beacon
+static void sendStrays(int fd)
+{
+    static const uint8_t shortPkt[7] = {'F', 'S', FSYNC_VERSION};
+    static uint8_t longPkt[FSYNC_PACKET_SIZE + 20] = {'F', 'S', FSYNC_VERSION};
+    sockaddr_in to = {};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(FSYNC_PORT);
+    to.sin_addr.s_addr = inet_addr("127.255.255.255");
+    sendto(fd, shortPkt, sizeof(shortPkt), 0, (sockaddr *)&to, sizeof(to));
+    sendto(fd, longPkt, sizeof(longPkt), 0, (sockaddr *)&to, sizeof(to));
+    straysSent += 2;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_one_master()
+{
+    int masters = 0;
+    for (const auto &r : results)
+        if (r.role == FSYNC_MASTER)
+            masters++;
+    TEST_ASSERT_EQUAL(1, masters);
+    TEST_ASSERT_EQUAL(FSYNC_MASTER, results[0].role);
+    TEST_ASSERT_GREATER_THAN(RUN_MS / FSYNC_BEACON_MS / 2, results[0].beaconsSent);
+}
+
+void test_followers_locked_to_master()
+{
+    for (int i = 1; i < CLOCKS; i++)
+    {
+        const ClockResult &r = results[i];
+        printf("clock %d: offset %lld us from the master's, jitter %u us, %u beacons, %u steps\n", i,
+               (long long)(r.offsetUs - results[0].offsetUs), r.jitterUs, r.beaconsReceived, r.steps);
+        TEST_ASSERT_EQUAL(FSYNC_FOLLOWER, r.role);
+        TEST_ASSERT_EQUAL_UINT32(results[0].id, r.masterId);
+        TEST_ASSERT_INT64_WITHIN(LOCK_TOLERANCE_US, results[0].offsetUs, r.offsetUs);
+        TEST_ASSERT_EQUAL_UINT32(1, r.steps); // the first lock only, then slewing
+    }
+    // The master kept its own timebase
+    TEST_ASSERT_EQUAL_INT64(clockStartOffset(0), results[0].offsetUs);
+}
+
+void test_strays_do_not_deafen()
+{
+    // Strays went out from the start, so every beacon a follower got came after some
+    TEST_ASSERT_GREATER_THAN(0, straysSent);
+    for (int i = 1; i < CLOCKS; i++)
+        TEST_ASSERT_GREATER_THAN(results[0].beaconsSent / 2, results[i].beaconsReceived);
+}
+
+int main(int argc, char **argv)
+{
+    int pipes[CLOCKS];
+    pid_t pids[CLOCKS];
+    for (int i = 0; i < CLOCKS; i++)
+    {
+        int fds[2];
+        if (pipe(fds) != 0)
+            return 2;
+        pids[i] = fork();
+        if (pids[i] < 0)
+            return 2;
+        if (pids[i] == 0)
+        {
+            close(fds[0]);
+            runClock(i, fds[1]);
+        }
+        close(fds[1]);
+        pipes[i] = fds[0];
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &yes, sizeof(yes));
+    for (int t = 0; t < RUN_MS; t += STRAY_EVERY_MS)
+    {
+        sendStrays(fd);
+        usleep(STRAY_EVERY_MS * 1000);
+    }
+    close(fd);
+
+    bool collected = true;
+    for (int i = 0; i < CLOCKS; i++)
+    {
+        collected &= read(pipes[i], &results[i], sizeof(ClockResult)) == sizeof(ClockResult);
+        int status;
+        waitpid(pids[i], &status, 0);
+    }
+    if (!collected)
+        return 2;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_one_master);
+    RUN_TEST(test_followers_locked_to_master);
+    RUN_TEST(test_strays_do_not_deafen);
+    return UNITY_END();
+}
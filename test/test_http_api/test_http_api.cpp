@@ -0,0 +1,199 @@
+/*--------------------------------------------------------------------------------------
+ HTTP API (httpApi.h) over loopback, in real time, with face 1 running: the endpoints
+ answer, the sync history comes back oldest first, clients hammering it at once all get
+ served, and the latency they see is reported. Also the portal's API switch, which has
+ to be saved however often it flips.
+--------------------------------------------------------------------------------------*/
+#include <unity.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "main.cpp"
+#include "../../tools/frame-capture/faceHost.h"
+
+#define CLIENTS 8
+#define REQUESTS_PER_CLIENT 25
+#define LATENCY_LIMIT_MS 100 // slowest request any client may see
+#define MEDIAN_LIMIT_MS (API_POLL_MS * 3) // a queued request must not wait a poll per request ahead
+
+static int apiPort;
+
+// One HTTP/1.0 exchange. Returns the status code, 0 if the connection failed.
+static int httpRequest(const char *method, const char *path, const char *form, std::string *body = nullptr)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(apiPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        return 0;
+    }
+    char req[512];
+    int n = snprintf(req, sizeof(req), "%s %s HTTP/1.0\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+                                       "Content-Length: %u\r\n\r\n%s",
+                     method, path, (unsigned)strlen(form), form);
+    send(fd, req, n, MSG_NOSIGNAL);
+    std::string reply;
+    char buf[1024];
+    ssize_t got;
+    while ((got = recv(fd, buf, sizeof(buf), 0)) > 0)
+        reply.append(buf, got);
+    close(fd);
+    int status = 0;
+    sscanf(reply.c_str(), "HTTP/1.%*d %d", &status);
+    if (body)
+        *body = reply.substr(reply.find("\r\n\r\n") + 4);
+    return status;
+}
+
+static uint64_t hostMicros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_endpoints_answer()
+{
+    std::string body;
+    TEST_ASSERT_EQUAL(200, httpRequest("GET", "/api/status", "", &body));
+    TEST_ASSERT_NOT_EQUAL(std::string::npos, body.find("\"timeValid\":true"));
+    TEST_ASSERT_EQUAL(200, httpRequest("POST", "/api/mode", "mode=2", &body));
+    TEST_ASSERT_EQUAL_STRING("{\"mode\":2}", body.c_str());
+    TEST_ASSERT_EQUAL(400, httpRequest("POST", "/api/mode", "mode=9"));
+    TEST_ASSERT_EQUAL(400, httpRequest("GET", "/api/nothing", ""));
+    // Stats: the I2C poll counters, and the whole object (not cut off at API_JSON_MAX)
+    TEST_ASSERT_EQUAL(200, httpRequest("GET", "/api/stats", "", &body));
+    for (const char *key : {"\"retries\":", "\"implausible\":", "\"timeReadErrors\":", "\"timeJumps\":"})
+        TEST_ASSERT_NOT_EQUAL(std::string::npos, body.find(key));
+    TEST_ASSERT_EQUAL_STRING("}}", body.substr(body.size() - 2).c_str());
+}
+
+void test_sync_history_oldest_first()
+{
+    std::string body;
+    TEST_ASSERT_EQUAL(200, httpRequest("GET", "/api/sync", "", &body));
+    TEST_ASSERT_EQUAL_STRING("{\"history\":[]}", body.c_str());
+
+    // Wrap the ring: the first three samples are gone, the rest come back in order
+    for (int i = 0; i < SYNC_HISTORY_LEN + 3; i++)
+        recordSample(1800000000 + i * 600, i % 2 ? -i : i, i % 4 == 0);
+    std::string want = "{\"history\":[";
+    for (int i = 3; i < SYNC_HISTORY_LEN + 3; i++)
+    {
+        char sample[96];
+        snprintf(sample, sizeof(sample), "%s{\"t\":%d,\"offsetMs\":%d,\"written\":%s}", i > 3 ? "," : "",
+                 1800000000 + i * 600, i % 2 ? -i : i, i % 4 == 0 ? "true" : "false");
+        want += sample;
+    }
+    want += "]}";
+    TEST_ASSERT_EQUAL(200, httpRequest("GET", "/api/sync", "", &body));
+    TEST_ASSERT_EQUAL_STRING(want.c_str(), body.c_str());
+}
+
+// Clients on host threads (other devices on the LAN), all at once
+void test_latency_under_concurrent_clients()
+{
+    static const char *const paths[][3] = {
+        {"GET", "/api/status", ""},
+        {"GET", "/api/stats", ""},
+        {"POST", "/api/brightness", "index=1"},
+        {"POST", "/api/mode", "mode=1"},
+    };
+    std::vector<uint32_t> latencies[CLIENTS];
+    std::atomic<uint32_t> failures{0};
+    uint32_t handled = apiServer.requestsHandled;
+    uint64_t start = hostMicros();
+    std::vector<std::thread> clients;
+    for (int c = 0; c < CLIENTS; c++)
+    {
+        clients.emplace_back([c, &latencies, &failures]() {
+            for (int i = 0; i < REQUESTS_PER_CLIENT; i++)
+            {
+                const char *const *p = paths[(c + i) % 4];
+                uint64_t t = hostMicros();
+                if (httpRequest(p[0], p[1], p[2]) != 200)
+                    failures++;
+                latencies[c].push_back(hostMicros() - t);
+            }
+        });
+    }
+    for (auto &t : clients)
+        t.join();
+    uint64_t elapsed = hostMicros() - start;
+
+    std::vector<uint32_t> all;
+    for (auto &l : latencies)
+        all.insert(all.end(), l.begin(), l.end());
+    std::sort(all.begin(), all.end());
+    uint32_t p50 = all[all.size() / 2];
+    printf("API: %d clients x %d requests in %llu ms (%.0f req/s); latency p50 %u us, p95 %u us, max %u us; "
+           "handler avg %u us, max %u us\n",
+           CLIENTS, REQUESTS_PER_CLIENT, (unsigned long long)elapsed / 1000, all.size() * 1e6 / elapsed,
+           p50, all[all.size() * 95 / 100], all.back(), apiStats.avgLatencyUs, apiStats.maxLatencyUs);
+
+    TEST_ASSERT_EQUAL_UINT32(0, failures.load());
+    TEST_ASSERT_EQUAL_UINT32(handled + CLIENTS * REQUESTS_PER_CLIENT, apiServer.requestsHandled);
+    TEST_ASSERT_LESS_THAN(MEDIAN_LIMIT_MS * 1000, p50);
+    TEST_ASSERT_LESS_THAN(LATENCY_LIMIT_MS * 1000, all.back());
+}
+
+void test_api_switch_saved_every_time()
+{
+    // On from setup(); off waits for a restart, so the server keeps running
+    TaskHandle_t server = apiTaskHandle;
+    tzParam.setValue(tzString, TZ_STRING_MAX - 1);
+    apiParam.setValue("0", 1);
+    finishPortal();
+    TEST_ASSERT_FALSE(preferences.getBool("api", true));
+    TEST_ASSERT_TRUE(apiEnabled);
+    // Back on before the restart: saved again, and no second server
+    apiParam.setValue("1", 1);
+    finishPortal();
+    TEST_ASSERT_TRUE(preferences.getBool("api", false));
+    TEST_ASSERT_EQUAL_PTR(server, apiTaskHandle);
+    TEST_ASSERT_EQUAL(200, httpRequest("GET", "/api/status", ""));
+}
+
+static void testsTask(void *pvParameters)
+{
+    // Wait for the server to listen
+    for (int i = 0; i < 200 && httpRequest("GET", "/api/status", "") == 0; i++)
+        vTaskDelay(pdMS_TO_TICKS(10));
+    UNITY_BEGIN();
+    RUN_TEST(test_endpoints_answer);
+    RUN_TEST(test_sync_history_oldest_first);
+    RUN_TEST(test_latency_under_concurrent_clients);
+    RUN_TEST(test_api_switch_saved_every_time);
+    exit(UNITY_END());
+}
+
+int main(int argc, char **argv)
+{
+    apiPort = 20000 + getpid() % 20000;
+    char port[8];
+    snprintf(port, sizeof(port), "%d", apiPort);
+    setenv("WEBSERVER_PORT", port, 1);
+
+    DateTime utc;
+    if (!startFace(1, TZ_DEFAULT, DateTime(2027, 6, 1, 12, 0, 0), utc))
+        return 2;
+    WiFi.connectDelayMs = 0;
+    WiFi.begin();
+    preferences.putBool("api", true);
+    startApi();
+    xTaskCreatePinnedToCore(testsTask, "tests", 8192, NULL, 1, NULL, 1);
+    for (;;)
+        vTaskDelay(portMAX_DELAY);
+}
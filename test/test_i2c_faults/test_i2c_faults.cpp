@@ -0,0 +1,219 @@
+/*--------------------------------------------------------------------------------------
+ i2cService.h on a faulty bus, in real time (tasks are host threads running at once):
+ NACKs, timeouts and a slave holding SDA low are injected through the Wire shim, and the
+ retry and recovery path has to get the RTC snapshot going again. Readers hammering the
+ seqlock while it is republished must never see a torn snapshot.
+--------------------------------------------------------------------------------------*/
+#include <unity.h>
+#include <atomic>
+#include "functions/i2cService.h"
+
+RTC_DS3231 rtc;
+
+#define READERS 3
+
+static std::atomic<int> faultsLeft{0}; // transfers to the RTC still to fail
+static I2CFault injected = I2C_FAULT_NONE;
+
+static I2CFault injectFaults(uint8_t address, bool isRead)
+{
+    (void)isRead;
+    if (address != DS3231_I2C_ADDR || faultsLeft.load() <= 0)
+        return I2C_FAULT_NONE;
+    faultsLeft--;
+    return injected;
+}
+
+static void inject(I2CFault fault, int transfers)
+{
+    injected = fault;
+    faultsLeft = transfers;
+}
+
+// millis() of the newest snapshot, 0 if there is none
+static uint32_t snapshotMillis()
+{
+    RtcSnapshot snap = readSnapshot();
+    return snap.valid ? snap.readMillis : 0;
+}
+
+// Wait up to `limitMs` for a snapshot newer than `since`
+static bool freshSnapshot(uint32_t since, uint32_t limitMs)
+{
+    uint32_t start = millis();
+    while (millis() - start < limitMs)
+    {
+        if ((int32_t)(snapshotMillis() - since) > 0)
+            return true;
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return false;
+}
+
+// Wait until the injected faults are used up, then up to `limitMs` for a good read after that
+static bool recoveredAfterFaults(uint32_t limitMs)
+{
+    uint32_t start = millis();
+    while ((faultsLeft.load() > 0 || Wire.sdaHeldPulses) && millis() - start < limitMs)
+        vTaskDelay(pdMS_TO_TICKS(5));
+    return freshSnapshot(millis(), limitMs);
+}
+
+// ------------------- Torn snapshot check -------------------
+// Every published state carries time % 128 in its other fields, first to last, so a copy
+// mixing two publishes shows up
+static Ds3231State numbered(uint32_t n)
+{
+    Ds3231State s{};
+    uint8_t k = n % 128;
+    s.time = DateTime(1893456000UL + n); // 2030-01-01
+    s.control = k;
+    s.aging = k;
+    s.temperature = k;
+    s.status = k;
+    s.alarm1Fired = k & 1;
+    s.alarm2Fired = k & 2;
+    return s;
+}
+
+static std::atomic<bool> hammerDone{false};
+static std::atomic<uint32_t> reads{0}, torn{0};
+
+static void readerTask(void *pvParameters)
+{
+    (void)pvParameters;
+    while (!hammerDone.load())
+    {
+        Ds3231State s;
+        if (!readRtcState(s))
+            continue;
+        uint8_t k = s.time.unixtime() % 128;
+        if (s.control != k || s.aging != k || s.status != k || s.temperature != k ||
+            s.alarm1Fired != (bool)(k & 1) || s.alarm2Fired != (bool)(k & 2))
+            torn++;
+        reads++;
+    }
+    vTaskDelete(NULL);
+}
+
+void setUp()
+{
+    inject(I2C_FAULT_NONE, 0);
+}
+
+void tearDown() {}
+
+// Runs before the I2C task exists, so this test is the only writer
+void test_snapshot_never_torn()
+{
+    for (int i = 0; i < READERS; i++)
+        xTaskCreatePinnedToCore(readerTask, "reader", 4096, NULL, 1, NULL, i & 1);
+    uint32_t start = millis();
+    for (uint32_t n = 0; millis() - start < 2000; n++)
+        publishSnapshot(numbered(n));
+    hammerDone = true;
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_GREATER_THAN(1000, reads.load());
+    TEST_ASSERT_EQUAL_UINT32(0, torn.load());
+    rtcSnapshot.valid = false;
+}
+
+void test_service_starts()
+{
+    TEST_ASSERT_TRUE(startI2cService());
+    TEST_ASSERT_TRUE(freshSnapshot(0, 1000));
+    DateTime now;
+    TEST_ASSERT_TRUE(readClockUtc(now));
+    TEST_ASSERT_EQUAL(2030, now.year());
+}
+
+void test_nack_burst_is_retried()
+{
+    I2cStats before = i2cStats;
+    inject(I2C_FAULT_NACK, 2); // two failed attempts in one poll, the third goes through
+    TEST_ASSERT_TRUE(recoveredAfterFaults(500));
+    TEST_ASSERT_EQUAL_UINT32(0, faultsLeft.load());
+    TEST_ASSERT_GREATER_OR_EQUAL(before.busErrors + 2, i2cStats.busErrors);
+    TEST_ASSERT_GREATER_OR_EQUAL(before.retries + 2, i2cStats.retries);
+    TEST_ASSERT_EQUAL_UINT32(before.timeReadErrors, i2cStats.timeReadErrors);
+    TEST_ASSERT_EQUAL_UINT32(before.recoveries, i2cStats.recoveries);
+}
+
+void test_timeouts_lead_to_recovery()
+{
+    I2cStats before = i2cStats;
+    uint32_t timeouts = Wire.timeouts;
+    // Enough failing transfers for I2C_RECOVER_AFTER polls of I2C_READ_TRIES attempts
+    inject(I2C_FAULT_TIMEOUT, I2C_RECOVER_AFTER * I2C_READ_TRIES);
+    TEST_ASSERT_TRUE(recoveredAfterFaults(3000));
+    TEST_ASSERT_GREATER_OR_EQUAL(timeouts + I2C_RECOVER_AFTER * I2C_READ_TRIES, Wire.timeouts);
+    TEST_ASSERT_GREATER_OR_EQUAL(before.timeReadErrors + I2C_RECOVER_AFTER, i2cStats.timeReadErrors);
+    TEST_ASSERT_EQUAL_UINT32(before.recoveries + 1, i2cStats.recoveries);
+    // A failed poll keeps the last good time; it is never replaced with garbage
+    DateTime now;
+    TEST_ASSERT_TRUE(readClockUtc(now));
+    TEST_ASSERT_EQUAL(2030, now.year());
+}
+
+void test_stuck_sda_released_by_recovery()
+{
+    I2cStats before = i2cStats;
+    Wire.sdaHeldPulses = 5; // a slave reset mid-byte
+    TEST_ASSERT_TRUE(recoveredAfterFaults(5000));
+    TEST_ASSERT_EQUAL_UINT8(0, Wire.sdaHeldPulses);
+    TEST_ASSERT_EQUAL_UINT32(before.recoveries + 1, i2cStats.recoveries);
+}
+
+void test_stuck_sda_beyond_nine_pulses()
+{
+    // One recovery clocks at most 9 pulses: 20 take three of them
+    I2cStats before = i2cStats;
+    Wire.sdaHeldPulses = 20;
+    TEST_ASSERT_TRUE(recoveredAfterFaults(10000));
+    TEST_ASSERT_EQUAL_UINT8(0, Wire.sdaHeldPulses);
+    TEST_ASSERT_EQUAL_UINT32(before.recoveries + 3, i2cStats.recoveries);
+}
+
+static bool recoverJob(void *arg)
+{
+    *(bool *)arg = i2cBusRecover();
+    return true;
+}
+
+void test_recover_reports_release()
+{
+    bool released = false;
+    Wire.sdaHeldPulses = 9;
+    TEST_ASSERT_TRUE(i2cTransact(recoverJob, &released));
+    TEST_ASSERT_TRUE(released);
+    Wire.sdaHeldPulses = 10;
+    TEST_ASSERT_TRUE(i2cTransact(recoverJob, &released));
+    TEST_ASSERT_FALSE(released);
+    TEST_ASSERT_EQUAL_UINT8(1, Wire.sdaHeldPulses);
+    TEST_ASSERT_TRUE(i2cTransact(recoverJob, &released));
+    TEST_ASSERT_TRUE(released);
+}
+
+static void testsTask(void *pvParameters)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_snapshot_never_torn);
+    RUN_TEST(test_service_starts);
+    RUN_TEST(test_nack_burst_is_retried);
+    RUN_TEST(test_timeouts_lead_to_recovery);
+    RUN_TEST(test_stuck_sda_released_by_recovery);
+    RUN_TEST(test_stuck_sda_beyond_nine_pulses);
+    RUN_TEST(test_recover_reports_release);
+    exit(UNITY_END());
+}
+
+int main(int argc, char **argv)
+{
+    Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN, I2C_FAST_HZ);
+    rtc.begin();
+    rtc.adjust(DateTime(2030, 1, 1, 0, 0, 0));
+    Wire.faultHook = injectFaults;
+    xTaskCreatePinnedToCore(testsTask, "tests", 8192, NULL, 1, NULL, 1);
+    for (;;)
+        vTaskDelay(portMAX_DELAY);
+}
@@ -0,0 +1,210 @@
+/*--------------------------------------------------------------------------------------
+ i2cService.h job queue, in virtual time on the Wire shim: high priority jobs run before
+ normal ones and each in the order queued, completions get their job's result, a full
+ queue is counted, latency is averaged, and a run of long normal jobs does not leave
+ the faces reading a stale time.
+--------------------------------------------------------------------------------------*/
+#include <unity.h>
+#include <NativeTime.h>
+#include "functions/i2cService.h"
+
+RTC_DS3231 rtc;
+
+#define GATE_MS 30     // how long the gate job holds the queue
+#define LONG_JOB_MS 40 // a slow normal job (a big EEPROM write, say)
+#define LONG_JOBS I2C_QUEUE_LEN
+
+struct Probe
+{
+    int id;
+    bool result; // what the job returns
+    bool doneCalled;
+    bool doneOk;
+};
+
+static int order[16];
+static int ran = 0;
+
+static bool recordJob(void *arg)
+{
+    Probe *p = (Probe *)arg;
+    order[ran++] = p->id;
+    return p->result;
+}
+
+static void recordDone(bool ok, void *arg)
+{
+    Probe *p = (Probe *)arg;
+    p->doneCalled = true;
+    p->doneOk = ok;
+}
+
+// Holds the I2C task until the test opens it, so everything else queues up behind it
+static volatile bool gateOpen = false;
+static volatile bool gateRunning = false;
+
+static bool gateJob(void *arg)
+{
+    (void)arg;
+    gateRunning = true;
+    while (!gateOpen)
+        vTaskDelay(1);
+    gateRunning = false;
+    return true;
+}
+
+static void closeGate()
+{
+    gateOpen = false;
+    TEST_ASSERT_TRUE(i2cSubmit(gateJob, NULL, NULL));
+    vTaskDelay(pdMS_TO_TICKS(5));
+    TEST_ASSERT_TRUE(gateRunning);
+}
+
+static void openGate(uint32_t afterMs)
+{
+    vTaskDelay(pdMS_TO_TICKS(afterMs));
+    gateOpen = true;
+    vTaskDelay(pdMS_TO_TICKS(10));
+    TEST_ASSERT_FALSE(gateRunning);
+}
+
+void setUp()
+{
+    ran = 0;
+    i2cStats = {};
+}
+
+void tearDown() {}
+
+static Probe submitted[7];
+
+// Queued from inside the first normal job: it still goes ahead of the normal ones left
+static bool submitHighJob(void *arg)
+{
+    recordJob(arg);
+    return i2cSubmit(recordJob, recordDone, &submitted[6], I2C_PRIO_HIGH);
+}
+
+void test_high_first_then_in_order()
+{
+    for (int i = 0; i < 7; i++)
+        submitted[i] = {i + 1, true, false, false};
+    closeGate();
+    // N1 H2 N3 H4 H5 N6, then H7 from inside N1
+    TEST_ASSERT_TRUE(i2cSubmit(submitHighJob, recordDone, &submitted[0]));
+    TEST_ASSERT_TRUE(i2cSubmit(recordJob, recordDone, &submitted[1], I2C_PRIO_HIGH));
+    TEST_ASSERT_TRUE(i2cSubmit(recordJob, recordDone, &submitted[2]));
+    TEST_ASSERT_TRUE(i2cSubmit(recordJob, recordDone, &submitted[3], I2C_PRIO_HIGH));
+    TEST_ASSERT_TRUE(i2cSubmit(recordJob, recordDone, &submitted[4], I2C_PRIO_HIGH));
+    TEST_ASSERT_TRUE(i2cSubmit(recordJob, recordDone, &submitted[5]));
+    openGate(0);
+
+    static const int expected[] = {2, 4, 5, 1, 7, 3, 6};
+    TEST_ASSERT_EQUAL(7, ran);
+    TEST_ASSERT_EQUAL_INT_ARRAY(expected, order, 7);
+}
+
+void test_done_gets_result()
+{
+    Probe probes[6];
+    for (int i = 0; i < 6; i++)
+        probes[i] = {i, i % 3 != 0, false, false};
+    closeGate();
+    for (int i = 0; i < 6; i++)
+        TEST_ASSERT_TRUE(i2cSubmit(recordJob, recordDone, &probes[i], i & 1 ? I2C_PRIO_HIGH : I2C_PRIO_NORMAL));
+    openGate(0);
+    for (const Probe &p : probes)
+    {
+        TEST_ASSERT_TRUE(p.doneCalled);
+        TEST_ASSERT_EQUAL(p.result, p.doneOk);
+    }
+    TEST_ASSERT_EQUAL_UINT32(7, i2cStats.jobs); // and the gate
+    TEST_ASSERT_EQUAL_UINT32(2, i2cStats.jobErrors);
+    // No completion is fine
+    TEST_ASSERT_TRUE(i2cSubmit(recordJob, NULL, &probes[1]));
+    vTaskDelay(pdMS_TO_TICKS(5));
+    TEST_ASSERT_EQUAL_UINT32(8, i2cStats.jobs);
+}
+
+void test_full_queue_rejected()
+{
+    Probe p = {0, true, false, false};
+    closeGate();
+    for (int i = 0; i < I2C_QUEUE_LEN; i++)
+        TEST_ASSERT_TRUE(i2cSubmit(recordJob, NULL, &p));
+    TEST_ASSERT_FALSE(i2cSubmit(recordJob, NULL, &p));
+    TEST_ASSERT_EQUAL_UINT32(1, i2cStats.rejected);
+    // The high queue has its own room
+    TEST_ASSERT_TRUE(i2cSubmit(recordJob, NULL, &p, I2C_PRIO_HIGH));
+    openGate(0);
+    TEST_ASSERT_EQUAL(I2C_QUEUE_LEN + 1, ran);
+    TEST_ASSERT_EQUAL_UINT32(1, i2cStats.rejected);
+}
+
+void test_latency_average()
+{
+    Probe p = {0, true, false, false};
+    closeGate();
+    i2cStats = {};
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT_TRUE(i2cSubmit(recordJob, NULL, &p));
+    openGate(GATE_MS);
+    // Queued behind the gate: each waited at least GATE_MS
+    printf("i2c latency: avg %u us, max %u us\n", i2cStats.avgLatencyUs, i2cStats.maxLatencyUs);
+    TEST_ASSERT_EQUAL_UINT32(5, i2cStats.jobs);
+    TEST_ASSERT_GREATER_OR_EQUAL(GATE_MS * 1000, i2cStats.avgLatencyUs);
+    TEST_ASSERT_LESS_OR_EQUAL(i2cStats.maxLatencyUs, i2cStats.avgLatencyUs);
+}
+
+// Each long job notes how old the snapshot is when it starts: what a face would read then
+static uint32_t worstAgeMs = 0;
+
+static bool longJob(void *arg)
+{
+    (void)arg;
+    RtcSnapshot snap = readSnapshot(); // runs in the I2C task: no asserts here
+    uint32_t age = snap.valid ? millis() - snap.readMillis : UINT32_MAX;
+    if (age > worstAgeMs)
+        worstAgeMs = age;
+    delayMicroseconds(LONG_JOB_MS * 1000);
+    return true;
+}
+
+void test_time_poll_not_held_by_long_jobs()
+{
+    uint32_t reads = i2cStats.timeReads;
+    uint32_t start = millis();
+    for (int i = 0; i < LONG_JOBS; i++)
+        TEST_ASSERT_TRUE(i2cSubmit(longJob, NULL, NULL));
+    while (i2cStats.jobs < LONG_JOBS)
+        vTaskDelay(pdMS_TO_TICKS(10));
+    uint32_t spanMs = millis() - start;
+    printf("%d jobs of %d ms: %u ms, %u time polls, snapshot at most %u ms old\n", LONG_JOBS, LONG_JOB_MS,
+           spanMs, i2cStats.timeReads - reads, worstAgeMs);
+    // The poll goes in between jobs once it is due, never after the whole run
+    TEST_ASSERT_LESS_OR_EQUAL(I2C_TIME_POLL_MS + LONG_JOB_MS, worstAgeMs);
+    TEST_ASSERT_GREATER_OR_EQUAL(spanMs / (I2C_TIME_POLL_MS + LONG_JOB_MS), i2cStats.timeReads - reads);
+    DateTime now;
+    TEST_ASSERT_TRUE(readClock(now));
+    TEST_ASSERT_EQUAL(2030, now.year());
+}
+
+int main(int argc, char **argv)
+{
+    nativeVirtualTime();
+    Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN, I2C_FAST_HZ);
+    rtc.begin();
+    rtc.adjust(DateTime(2030, 1, 1, 0, 0, 0));
+    if (!startI2cService())
+        return 2;
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    UNITY_BEGIN();
+    RUN_TEST(test_high_first_then_in_order);
+    RUN_TEST(test_done_gets_result);
+    RUN_TEST(test_full_queue_rejected);
+    RUN_TEST(test_latency_average);
+    RUN_TEST(test_time_poll_not_held_by_long_jobs);
+    return UNITY_END();
+}
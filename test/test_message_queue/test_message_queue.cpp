@@ -0,0 +1,200 @@
+/*--------------------------------------------------------------------------------------
+ messageQueue.h in virtual time: messages come off in priority order (oldest first on a
+ tie), an interrupted one resumes where it stopped, messages leave after their passes
+ or at expiry, a full table gives way only to higher priorities, and what one post,
+ top and pass costs on the host.
+--------------------------------------------------------------------------------------*/
+#include <unity.h>
+#include <NativeTime.h>
+#include <chrono>
+#include "functions/messageQueue.h"
+
+#define THROUGHPUT_CYCLES 200000
+#define CYCLE_LIMIT_NS 5000 // post + top + pass; the ticker does one top per scroll step
+
+static uint32_t post(const char *text, uint8_t priority, uint8_t repeats = 1, uint32_t ttlMs = 0)
+{
+    return tickerPost(text, priority, repeats, TICKER_SPEED_DEFAULT_MS, ttlMs);
+}
+
+// What the ticker would show now, "" for the date
+static const char *top()
+{
+    static TickerMessage m;
+    return tickerTop(m) ? m.text : "";
+}
+
+// Show the top message through one full pass
+static const char *passTop()
+{
+    static TickerMessage m;
+    if (!tickerTop(m))
+        return "";
+    tickerPassDone(m.id);
+    return m.text;
+}
+
+static void advance(uint32_t ms)
+{
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+void setUp()
+{
+    memset(tickerSlots, 0, sizeof(tickerSlots));
+    tickerStats = {};
+}
+
+void tearDown() {}
+
+void test_priority_then_age_order()
+{
+    post("low", 1);
+    post("high", 7);
+    post("mid a", 4);
+    post("mid b", 4);
+    post("top", 9);
+    post("mid c", 4);
+    static const char *const order[] = {"top", "high", "mid a", "mid b", "mid c", "low", ""};
+    for (const char *want : order)
+        TEST_ASSERT_EQUAL_STRING(want, passTop());
+    TEST_ASSERT_EQUAL_UINT32(6, tickerStats.posted);
+}
+
+void test_repeats_counted_off()
+{
+    post("thrice", 5, 3);
+    post("once", 2);
+    for (int pass = 0; pass < 3; pass++)
+        TEST_ASSERT_EQUAL_STRING("thrice", passTop());
+    TEST_ASSERT_EQUAL_STRING("once", passTop());
+    TEST_ASSERT_EQUAL_STRING("", top());
+    // Out-of-range priority is clamped, not wrapped
+    post("loud", 200);
+    TickerMessage m;
+    TEST_ASSERT_TRUE(tickerTop(m));
+    TEST_ASSERT_EQUAL_UINT8(TICKER_PRIORITY_MAX, m.priority);
+}
+
+void test_preempted_message_resumes()
+{
+    uint32_t low = post("long message", 2);
+    TickerMessage m;
+    TEST_ASSERT_TRUE(tickerTop(m));
+    TEST_ASSERT_EQUAL_INT16(TICKER_START_X, m.resumeX);
+
+    // Something urgent arrives mid-scroll; the ticker parks the old one
+    post("urgent", 8);
+    TEST_ASSERT_TRUE(tickerTop(m));
+    TEST_ASSERT_EQUAL_STRING("urgent", m.text);
+    tickerPause(low, -37);
+    TEST_ASSERT_EQUAL_UINT32(1, tickerStats.preempted);
+    TEST_ASSERT_EQUAL_STRING("urgent", passTop());
+
+    TEST_ASSERT_TRUE(tickerTop(m));
+    TEST_ASSERT_EQUAL_UINT32(low, m.id);
+    TEST_ASSERT_EQUAL_INT16(-37, m.resumeX);
+    // A finished pass starts the next one from the edge
+    tickerPassDone(low);
+    TEST_ASSERT_EQUAL_STRING("", top());
+    // Ids that are gone are ignored
+    tickerPause(low, 5);
+    tickerPassDone(low);
+    TEST_ASSERT_EQUAL_UINT32(1, tickerStats.preempted);
+}
+
+void test_expiry_on_virtual_clock()
+{
+    post("short", 6, 0, 1000); // until it expires
+    post("long", 3, 0, 5000);
+    post("forever", 1, 0, 0);  // repeats 0 and no ttl: one pass
+    // Expiry times are kept odd (0 is never), so one may come a millisecond late
+    advance(999);
+    TEST_ASSERT_EQUAL_STRING("short", top());
+    TEST_ASSERT_EQUAL_STRING("short", passTop()); // passes do not count it off
+    advance(2);
+    TEST_ASSERT_EQUAL_STRING("long", top());
+    TEST_ASSERT_EQUAL_UINT32(1, tickerStats.expired);
+    advance(3998);
+    TEST_ASSERT_EQUAL_STRING("long", passTop());
+    advance(2);
+    TEST_ASSERT_EQUAL_STRING("forever", passTop());
+    TEST_ASSERT_EQUAL_STRING("", top());
+    TEST_ASSERT_EQUAL_UINT32(2, tickerStats.expired);
+
+    // Repeats left do not keep an expired message, and expired slots are reused first
+    post("stale", 9, 5, 100);
+    advance(101);
+    for (int i = 0; i < TICKER_QUEUE_LEN; i++)
+        TEST_ASSERT_NOT_EQUAL(0, post("filler", 0));
+    TEST_ASSERT_EQUAL_UINT32(0, tickerStats.replaced);
+    TEST_ASSERT_EQUAL_STRING("filler", top());
+}
+
+void test_full_table_gives_way_to_priority()
+{
+    for (int i = 0; i < TICKER_QUEUE_LEN; i++)
+        TEST_ASSERT_NOT_EQUAL(0, post(i == 3 ? "lowest" : "keep", i == 3 ? 1 : 5));
+    // Equal or lower priority is turned away
+    TEST_ASSERT_EQUAL(0, post("also low", 1));
+    TEST_ASSERT_EQUAL(0, post("nothing", 0));
+    TEST_ASSERT_EQUAL_UINT32(2, tickerStats.rejected);
+    // Higher replaces the lowest-ranked one
+    TEST_ASSERT_NOT_EQUAL(0, post("news", 2));
+    TEST_ASSERT_EQUAL_UINT32(1, tickerStats.replaced);
+    for (int i = 0; i < TICKER_QUEUE_LEN - 1; i++)
+        TEST_ASSERT_EQUAL_STRING("keep", passTop());
+    TEST_ASSERT_EQUAL_STRING("news", passTop());
+    TEST_ASSERT_EQUAL_STRING("", top());
+
+    // Among equals the newest is replaced, so older messages keep their turn
+    for (int i = 0; i < TICKER_QUEUE_LEN; i++)
+    {
+        char text[8];
+        snprintf(text, sizeof(text), "m%d", i);
+        post(text, 4);
+    }
+    post("boss", 6);
+    for (int i = 0; i < TICKER_QUEUE_LEN - 1; i++)
+        passTop();
+    TEST_ASSERT_EQUAL_STRING("m6", passTop());
+    TEST_ASSERT_EQUAL_STRING("", top());
+}
+
+void test_throughput()
+{
+    // The table stays half full, as under a steady stream of API posts
+    for (int i = 0; i < TICKER_QUEUE_LEN / 2; i++)
+        post("background", 0, 0, 0);
+    auto start = std::chrono::steady_clock::now();
+    uint32_t shown = 0;
+    for (int i = 0; i < THROUGHPUT_CYCLES; i++)
+    {
+        post("message", 1 + i % TICKER_PRIORITY_MAX, 1);
+        TickerMessage m;
+        if (tickerTop(m))
+        {
+            tickerPassDone(m.id);
+            shown++;
+        }
+    }
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("ticker queue: %d post/top/pass cycles, %lld ns each\n", THROUGHPUT_CYCLES, (long long)(ns / THROUGHPUT_CYCLES));
+    TEST_ASSERT_EQUAL_UINT32(THROUGHPUT_CYCLES, shown);
+    TEST_ASSERT_EQUAL_UINT32(THROUGHPUT_CYCLES + TICKER_QUEUE_LEN / 2, tickerStats.posted);
+    TEST_ASSERT_EQUAL_UINT32(0, tickerStats.rejected + tickerStats.replaced);
+    TEST_ASSERT_LESS_THAN(CYCLE_LIMIT_NS, ns / THROUGHPUT_CYCLES);
+}
+
+int main(int argc, char **argv)
+{
+    nativeVirtualTime();
+    UNITY_BEGIN();
+    RUN_TEST(test_priority_then_age_order);
+    RUN_TEST(test_repeats_counted_off);
+    RUN_TEST(test_preempted_message_resumes);
+    RUN_TEST(test_expiry_on_virtual_clock);
+    RUN_TEST(test_full_table_gives_way_to_priority);
+    RUN_TEST(test_throughput);
+    return UNITY_END();
+}
@@ -0,0 +1,76 @@
+/*--------------------------------------------------------------------------------------
+ Mode switch, in virtual time: every face gets its first frame onto the panel within
+ a frame deadline of changeClockMode(), the slide keeps its step rate, and a dead RTC
+ does not leave the switch pending.
+--------------------------------------------------------------------------------------*/
+#include <unity.h>
+#include <NativeTime.h>
+#include "main.cpp"
+#include "../../tools/frame-capture/faceHost.h"
+
+#define SWITCH_DEADLINE_MS 250 // changeClockMode() to the first frame presented
+#define STEP_DEADLINE_MS 20    // between two steps of the slide (one step every 15 ms)
+#define SLIDE_STEPS (32 / TRANSITION_STEP_PIXELS)
+
+static I2CFault nackRtc(uint8_t address, bool isRead)
+{
+    (void)isRead;
+    return address == DS3231_I2C_ADDR ? I2C_FAULT_NACK : I2C_FAULT_NONE;
+}
+
+// Let the firmware run until the pending switch is shown, or `limitMs` passes
+static void waitForPresent(uint32_t limitMs)
+{
+    for (uint32_t waited = 0; transitionPending && waited < limitMs; waited += 10)
+        vTaskDelay(pdMS_TO_TICKS(10));
+    vTaskDelay(pdMS_TO_TICKS(SLIDE_STEPS * STEP_DEADLINE_MS)); // let the slide finish
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_every_face_presents_within_deadline()
+{
+    for (int mode = 0; mode < 8; mode++)
+    {
+        uint32_t presents = renderStats.presents;
+        changeClockMode(mode);
+        waitForPresent(2000);
+        TEST_ASSERT_FALSE(transitionPending);
+        TEST_ASSERT_LESS_OR_EQUAL(SWITCH_DEADLINE_MS, lastSwitchLatency);
+        TEST_ASSERT_EQUAL_UINT32(presents + 1, renderStats.presents);
+        TEST_ASSERT_LESS_OR_EQUAL(SLIDE_STEPS * STEP_DEADLINE_MS, renderStats.lastPresentMs);
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(STEP_DEADLINE_MS, renderStats.maxStepMs);
+}
+
+void test_dead_rtc_does_not_hold_switch()
+{
+    // No valid read published yet, and none coming: the state a dead RTC leaves at boot
+    Wire.faultHook = nackRtc;
+    vTaskDelay(pdMS_TO_TICKS(I2C_TIME_POLL_MS * 2));
+    rtcSnapshot.valid = false;
+
+    for (int mode = 0; mode < 8; mode++)
+    {
+        changeClockMode(mode);
+        waitForPresent(2000);
+        TEST_ASSERT_FALSE(transitionPending);
+        TEST_ASSERT_LESS_OR_EQUAL(1000, lastSwitchLatency);
+    }
+    Wire.faultHook = nullptr;
+}
+
+int main(int argc, char **argv)
+{
+    nativeVirtualTime();
+    DateTime utc;
+    if (!startFace(1, TZ_DEFAULT, DateTime(2027, 6, 1, 12, 0, 0), utc))
+        return 2;
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    UNITY_BEGIN();
+    RUN_TEST(test_every_face_presents_within_deadline);
+    RUN_TEST(test_dead_rtc_does_not_hold_switch);
+    return UNITY_END();
+}
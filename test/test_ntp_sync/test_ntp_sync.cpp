@@ -0,0 +1,173 @@
+/*--------------------------------------------------------------------------------------
+ ntpSync.h against a local NTP stand-in (NativeNtp.h), in real time. The stand-in serves
+ chosen clock offsets over paths with chosen delays; the firmware's SNTP client sets the
+ system time from it and the sync scheduler has to:
+ - leave offsets under SYNC_WRITE_THRESHOLD_MS alone and step larger ones,
+ - write the RTC on the NTP second edge, so it then ticks with NTP.
+--------------------------------------------------------------------------------------*/
+#include <unity.h>
+#include <NativeNtp.h>
+#include <lwip/apps/sntp.h>
+#include "functions/ntpSync.h"
+
+Preferences preferences;
+void mirrorCapture() {}
+
+#define EDGE_TOLERANCE_US 2000 // RTC tick to NTP edge after a write
+#define MEASURE_TOLERANCE_MS 3 // measureRtcOffset() against the offset that was set up
+#define SNTP_TOLERANCE_US 5000 // system clock step against what the stand-in served
+
+static NativeNtpServer ntp;
+
+// Serve `offsetMs` over the given one-way delays and wait for the SNTP client to take it
+static bool serveAndSync(int32_t offsetMs, uint32_t requestDelayMs = 0, uint32_t replyDelayMs = 0)
+{
+    ntp.offsetUs = offsetMs * 1000LL;
+    ntp.requestDelayMs = requestDelayMs;
+    ntp.replyDelayMs = replyDelayMs;
+    sntp_get_sync_status(); // clear a completion left from before
+    configTime(0, 0, ntpServer1, ntpServer2, ntpServer3);
+    for (int i = 0; i < 300; i++)
+    {
+        if (sntp_get_sync_status() == SNTP_SYNC_STATUS_COMPLETED)
+            return true;
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return false;
+}
+
+// System time minus the stand-in's reference, us
+static int64_t systemErrorUs()
+{
+    return nativeSystemMicros() - nativeTrueMicros();
+}
+
+static const SyncSample &lastSample()
+{
+    return syncHistory[(syncHistoryNext + SYNC_HISTORY_LEN - 1) % SYNC_HISTORY_LEN];
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_sntp_takes_served_offset()
+{
+    TEST_ASSERT_TRUE(serveAndSync(2500));
+    TEST_ASSERT_INT64_WITHIN(SNTP_TOLERANCE_US, 2500000, systemErrorUs());
+    TEST_ASSERT_TRUE(serveAndSync(0));
+    TEST_ASSERT_INT64_WITHIN(SNTP_TOLERANCE_US, 0, systemErrorUs());
+}
+
+void test_sntp_delay_error_is_half_the_asymmetry()
+{
+    // Symmetric delay cancels out
+    TEST_ASSERT_TRUE(serveAndSync(0, 60, 60));
+    TEST_ASSERT_INT64_WITHIN(SNTP_TOLERANCE_US, 0, systemErrorUs());
+    // A slow request path makes the server's time look late by half the difference
+    TEST_ASSERT_TRUE(serveAndSync(0, 100, 0));
+    TEST_ASSERT_INT64_WITHIN(SNTP_TOLERANCE_US, 50000, systemErrorUs());
+    TEST_ASSERT_TRUE(serveAndSync(0));
+}
+
+void test_stale_rtc_is_stepped()
+{
+    // The RTC was set 5 s slow at boot
+    TEST_ASSERT_TRUE(serveAndSync(0));
+    uint32_t writes = syncStats.rtcWrites;
+    uint32_t next = ntpSyncStep();
+    TEST_ASSERT_EQUAL_UINT32(writes + 1, syncStats.rtcWrites);
+    TEST_ASSERT_TRUE(lastSample().rtcWritten);
+    TEST_ASSERT_INT_WITHIN(1000, -5000, lastSample().offsetMs);
+    TEST_ASSERT_EQUAL_UINT32(SYNC_MIN_INTERVAL_S, next);
+
+    double offsetMs;
+    TEST_ASSERT_TRUE(measureRtcOffset(offsetMs));
+    TEST_ASSERT_INT_WITHIN(MEASURE_TOLERANCE_MS, 0, (int)lround(offsetMs));
+}
+
+void test_rtc_write_lands_on_ntp_edge()
+{
+    TEST_ASSERT_TRUE(serveAndSync(0));
+    writeRtcFromNtp();
+    TEST_ASSERT_TRUE(syncStats.residualKnown);
+    TEST_ASSERT_INT32_WITHIN(EDGE_TOLERANCE_US, 0, syncStats.lastResidualUs);
+
+    double offsetMs;
+    TEST_ASSERT_TRUE(measureRtcOffset(offsetMs));
+    TEST_ASSERT_INT_WITHIN(MEASURE_TOLERANCE_MS, 0, (int)lround(offsetMs));
+    DateTime rtcNow;
+    TEST_ASSERT_TRUE(readClockUtc(rtcNow));
+    TEST_ASSERT_INT_WITHIN(1, (int32_t)(ntpNowUs() / 1000000), (int32_t)rtcNow.unixtime());
+}
+
+void test_small_offset_left_alone()
+{
+    // RTC on the edge from the test before; NTP now says it is 400 ms behind
+    TEST_ASSERT_TRUE(serveAndSync(400));
+    uint32_t writes = syncStats.rtcWrites;
+    uint32_t interval = syncStats.intervalS;
+    uint32_t next = ntpSyncStep();
+    TEST_ASSERT_EQUAL_UINT32(writes, syncStats.rtcWrites);
+    TEST_ASSERT_FALSE(lastSample().rtcWritten);
+    TEST_ASSERT_INT_WITHIN(MEASURE_TOLERANCE_MS, -400, lastSample().offsetMs);
+    TEST_ASSERT_EQUAL_UINT32(interval * 2, next); // in tolerance: back off
+}
+
+void test_large_offset_steps_rtc()
+{
+    // NTP moves 700 ms the other way: the RTC is now 700 ms ahead
+    TEST_ASSERT_TRUE(serveAndSync(-700));
+    uint32_t writes = syncStats.rtcWrites;
+    uint32_t next = ntpSyncStep();
+    TEST_ASSERT_EQUAL_UINT32(writes + 1, syncStats.rtcWrites);
+    TEST_ASSERT_TRUE(lastSample().rtcWritten);
+    TEST_ASSERT_INT_WITHIN(MEASURE_TOLERANCE_MS, 700, lastSample().offsetMs);
+    TEST_ASSERT_EQUAL_UINT32(SYNC_MIN_INTERVAL_S, next);
+    TEST_ASSERT_TRUE(syncStats.residualKnown);
+    TEST_ASSERT_INT32_WITHIN(EDGE_TOLERANCE_US, 0, syncStats.lastResidualUs);
+
+    double offsetMs;
+    TEST_ASSERT_TRUE(measureRtcOffset(offsetMs));
+    TEST_ASSERT_INT_WITHIN(MEASURE_TOLERANCE_MS, 0, (int)lround(offsetMs));
+}
+
+void test_delay_asymmetry_stays_under_threshold()
+{
+    // Same server time, but 300 ms more on the way out: NTP is read 150 ms late
+    TEST_ASSERT_TRUE(serveAndSync(-700, 300, 0));
+    uint32_t writes = syncStats.rtcWrites;
+    ntpSyncStep();
+    TEST_ASSERT_EQUAL_UINT32(writes, syncStats.rtcWrites);
+    TEST_ASSERT_INT_WITHIN(MEASURE_TOLERANCE_MS + 5, -150, lastSample().offsetMs);
+}
+
+static void testsTask(void *pvParameters)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_sntp_takes_served_offset);
+    RUN_TEST(test_sntp_delay_error_is_half_the_asymmetry);
+    RUN_TEST(test_stale_rtc_is_stepped);
+    RUN_TEST(test_rtc_write_lands_on_ntp_edge);
+    RUN_TEST(test_small_offset_left_alone);
+    RUN_TEST(test_large_offset_steps_rtc);
+    RUN_TEST(test_delay_asymmetry_stays_under_threshold);
+    ntp.stop();
+    exit(UNITY_END());
+}
+
+int main(int argc, char **argv)
+{
+    uint16_t port = ntp.start();
+    if (port == 0)
+        return 2;
+    nativeSntpServer("127.0.0.1", port);
+    preferences.begin("clock-app", false);
+    Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN, I2C_FAST_HZ);
+    rtc.begin();
+    rtc.adjust(DateTime((uint32_t)(nativeTrueMicros() / 1000000) - 5));
+    if (!startI2cService())
+        return 2;
+    xTaskCreatePinnedToCore(testsTask, "tests", 8192, NULL, 1, NULL, 1);
+    for (;;)
+        vTaskDelay(portMAX_DELAY);
+}
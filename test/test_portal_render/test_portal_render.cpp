@@ -0,0 +1,137 @@
+/*--------------------------------------------------------------------------------------
+ WiFi setup portal and the display, in virtual time: with the portal open and serviced
+ from loop(), Clock7 keeps its frame period, the WiFi icon shows in the top right
+ corner, and finishPortal() takes it away and gives the corner back to the face.
+--------------------------------------------------------------------------------------*/
+#include <unity.h>
+#include <NativeTime.h>
+#include <vector>
+#include "main.cpp"
+#include "../../tools/frame-capture/frameImage.h"
+#include "../../tools/frame-capture/faceHost.h"
+
+#define FACE 7
+#define FRAME_PERIOD_MS 100 // Clock7's scroll step, the face's shortest redraw
+#define FRAME_SLACK_MS 2    // the watcher's tick, and the redraw restarting the face's timers
+#define PORTAL_RUN_MS 3000
+#define ICON_X 26 // the corner drawStatusIcons() owns while an icon is on
+#define ICON_Y 3
+
+// Watches the panel every millisecond and notes when what it shows changes
+static std::vector<uint32_t> frameTimes;
+static Frame lastShown;
+static volatile bool watching = false;
+static std::string faceCorner; // before the portal opened
+
+static void frameWatchTask(void *pvParameters)
+{
+    (void)pvParameters;
+    for (;;)
+    {
+        Frame shown = frameFromDmd(dmd.shownFrame(), 1, 1);
+        if (watching && shown != lastShown)
+            frameTimes.push_back(millis());
+        lastShown = shown;
+        vTaskDelay(1);
+    }
+}
+
+static Frame shownFrame()
+{
+    return frameFromDmd(dmd.shownFrame(), 1, 1);
+}
+
+// The top right corner, as text
+static std::string corner(const Frame &f)
+{
+    std::string s;
+    for (int y = 0; y <= ICON_Y; y++)
+    {
+        for (int x = ICON_X; x < f.width; x++)
+            s += f.at(x, y) ? '#' : '.';
+        s += '\n';
+    }
+    return s;
+}
+
+// loop() for `ms` of virtual time (it sleeps 20 ms a pass)
+static void runLoop(uint32_t ms)
+{
+    for (uint32_t start = millis(); millis() - start < ms;)
+        loop();
+}
+
+static uint32_t longestGap()
+{
+    uint32_t longest = 0;
+    for (size_t i = 1; i < frameTimes.size(); i++)
+        longest = std::max(longest, frameTimes[i] - frameTimes[i - 1]);
+    return longest;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_face_keeps_its_period_with_portal_open()
+{
+    faceCorner = corner(shownFrame());
+    wifimanager();
+    TEST_ASSERT_TRUE(portalActive);
+    frameTimes.clear();
+    watching = true;
+    runLoop(PORTAL_RUN_MS);
+    watching = false;
+    printf("portal open: %u frames in %d ms, longest gap %u ms\n", (unsigned)frameTimes.size(), PORTAL_RUN_MS,
+           longestGap());
+    TEST_ASSERT_TRUE(portalActive); // still open: wifiPortalLoop() only services it
+    TEST_ASSERT_GREATER_OR_EQUAL(PORTAL_RUN_MS / FRAME_PERIOD_MS - 1, frameTimes.size());
+    TEST_ASSERT_LESS_OR_EQUAL(FRAME_PERIOD_MS + FRAME_SLACK_MS, longestGap());
+
+    // The icon, on a blank corner
+    TEST_ASSERT_EQUAL_STRING("..###.\n"
+                             ".#...#\n"
+                             "...#..\n"
+                             "......\n",
+                             corner(shownFrame()).c_str());
+    TEST_ASSERT_NOT_EQUAL(0, faceCorner.compare(corner(shownFrame())));
+}
+
+void test_finish_portal_gives_corner_back()
+{
+    uint32_t presents = renderStats.presents;
+    frameTimes.clear();
+    watching = true;
+    wifimanager(); // a second long press closes it
+    TEST_ASSERT_FALSE(portalActive);
+    TEST_ASSERT_EQUAL(0, statusIcons.load());
+
+    // One pass of loop() later the face has been redrawn, cut in rather than slid, and
+    // the corner is what the face draws there (not blank until its next second)
+    loop();
+    TEST_ASSERT_FALSE(faceRedrawRequested.load());
+    TEST_ASSERT_EQUAL_UINT32(presents + 1, renderStats.presents);
+    TEST_ASSERT_EQUAL(TRANSITION_NONE, switchTransition);
+    TEST_ASSERT_EQUAL_STRING(faceCorner.c_str(), corner(shownFrame()).c_str());
+
+    runLoop(500);
+    watching = false;
+    TEST_ASSERT_LESS_OR_EQUAL(FRAME_PERIOD_MS + FRAME_SLACK_MS, longestGap());
+}
+
+int main(int argc, char **argv)
+{
+    nativeVirtualTime();
+    pinMode(UP_PIN, INPUT_PULLUP);
+    pinMode(DOWN_PIN, INPUT_PULLUP);
+    DateTime utc;
+    // 12:58: the minutes reach into the icon corner and do not change during the run
+    if (!startFace(FACE, TZ_DEFAULT, DateTime(2027, 6, 1, 12, 58, 0), utc))
+        return 2;
+    xTaskCreatePinnedToCore(frameWatchTask, "watch", 4096, NULL, 2, NULL, 1);
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    UNITY_BEGIN();
+    RUN_TEST(test_face_keeps_its_period_with_portal_open);
+    RUN_TEST(test_finish_portal_gives_corner_back);
+    return UNITY_END();
+}
@@ -0,0 +1,123 @@
+/*--------------------------------------------------------------------------------------
+ radioScheduler.h sync windows with the WiFi shim's station and the NTP stand-in, in
+ real time: a window has to wait for SNTP to actually set the clock, however long the
+ reply takes, and must not run a sync step on a clock that was not synced in it.
+--------------------------------------------------------------------------------------*/
+#include <unity.h>
+#include <NativeNtp.h>
+#include "functions/radioScheduler.h"
+
+Preferences preferences;
+volatile bool portalActive = false;
+void mirrorCapture() {}
+
+static NativeNtpServer ntp;
+
+struct WindowResult
+{
+    uint32_t next;
+    bool failed;
+    bool stepped;
+};
+
+static WindowResult runWindow()
+{
+    uint32_t failed = radioStats.failedWindows;
+    uint32_t measured = syncStats.measurements + syncStats.failedMeasurements;
+    radioSyncNow();
+    WindowResult r;
+    r.next = radioSyncWindow();
+    r.failed = radioStats.failedWindows != failed;
+    r.stepped = syncStats.measurements + syncStats.failedMeasurements != measured;
+    return r;
+}
+
+void setUp()
+{
+    ntp.silent = false;
+    ntp.requestDelayMs = 0;
+    ntp.replyDelayMs = 0;
+    WiFi.linkAvailable = true;
+    WiFi.connectDelayMs = 300;
+}
+
+void tearDown() {}
+
+void test_window_waits_for_sync()
+{
+    ntp.requestDelayMs = 600; // symmetric, so the time served stays right
+    ntp.replyDelayMs = 600;
+    WindowResult r = runWindow();
+    TEST_ASSERT_FALSE(r.failed);
+    TEST_ASSERT_TRUE(r.stepped);
+    TEST_ASSERT_GREATER_OR_EQUAL(1200, radioStats.ntpWaitMs);
+    TEST_ASSERT_LESS_THAN(1200 + 200, radioStats.ntpWaitMs);
+    TEST_ASSERT_EQUAL(WIFI_OFF, WiFi.getMode());
+}
+
+void test_quick_reply_is_not_held_up()
+{
+    WindowResult r = runWindow();
+    TEST_ASSERT_FALSE(r.failed);
+    TEST_ASSERT_TRUE(r.stepped);
+    TEST_ASSERT_LESS_THAN(100, radioStats.ntpWaitMs);
+}
+
+void test_sync_from_before_the_window_does_not_count()
+{
+    // The last window's sync (flag and status) is still about; this one gets no answer
+    ntp.silent = true;
+    uint32_t requests = ntp.requests;
+    uint32_t writes = syncStats.rtcWrites;
+    unsigned long start = millis();
+    WindowResult r = runWindow();
+    TEST_ASSERT_TRUE(r.failed);
+    TEST_ASSERT_FALSE(r.stepped);
+    TEST_ASSERT_EQUAL_UINT32(writes, syncStats.rtcWrites);
+    TEST_ASSERT_EQUAL_UINT32(RADIO_RETRY_MIN_S, r.next);
+    TEST_ASSERT_GREATER_OR_EQUAL(RADIO_NTP_TIMEOUT_MS, millis() - start);
+    TEST_ASSERT_GREATER_THAN(requests, ntp.requests); // it did ask
+    TEST_ASSERT_EQUAL(WIFI_OFF, WiFi.getMode());
+}
+
+void test_answer_after_silence()
+{
+    // A retry backs off while SNTP stays silent, and a sync puts it back to normal
+    ntp.silent = true;
+    TEST_ASSERT_EQUAL_UINT32(RADIO_RETRY_MIN_S * 2, runWindow().next);
+    ntp.silent = false;
+    WindowResult r = runWindow();
+    TEST_ASSERT_FALSE(r.failed);
+    TEST_ASSERT_TRUE(r.stepped);
+    ntp.silent = true;
+    TEST_ASSERT_EQUAL_UINT32(RADIO_RETRY_MIN_S, runWindow().next);
+}
+
+static void testsTask(void *pvParameters)
+{
+    radioBegin();
+    UNITY_BEGIN();
+    RUN_TEST(test_window_waits_for_sync);
+    RUN_TEST(test_quick_reply_is_not_held_up);
+    RUN_TEST(test_sync_from_before_the_window_does_not_count);
+    RUN_TEST(test_answer_after_silence);
+    ntp.stop();
+    exit(UNITY_END());
+}
+
+int main(int argc, char **argv)
+{
+    uint16_t port = ntp.start();
+    if (port == 0)
+        return 2;
+    nativeSntpServer("127.0.0.1", port);
+    preferences.begin("clock-app", false);
+    Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN, I2C_FAST_HZ);
+    rtc.begin();
+    rtc.adjust(DateTime((uint32_t)(nativeTrueMicros() / 1000000)));
+    if (!startI2cService())
+        return 2;
+    xTaskCreatePinnedToCore(testsTask, "tests", 8192, NULL, 1, NULL, 1);
+    for (;;)
+        vTaskDelay(portMAX_DELAY);
+}
@@ -0,0 +1,203 @@
+/*--------------------------------------------------------------------------------------
+ timezone.h: DST transition instants for London, New York and Sydney and a zone with
+ no DST, the skipped and repeated local hours, and the TzCache moving across year
+ boundaries. The host C library's own POSIX TZ handling is the reference for a sweep.
+--------------------------------------------------------------------------------------*/
+#include <unity.h>
+#include <time.h>
+#include "functions/timezone.h"
+
+#define TZ_LONDON "GMT0BST,M3.5.0/1,M10.5.0"
+#define TZ_NEW_YORK "EST5EDT,M3.2.0,M11.1.0"
+#define TZ_SYDNEY "AEST-10AEDT,M10.1.0,M4.1.0/3"
+#define TZ_DHAKA TZ_DEFAULT
+
+static uint32_t utcOf(int y, int mo, int d, int h, int mi, int s = 0)
+{
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_year = y - 1900;
+    tm.tm_mon = mo - 1;
+    tm.tm_mday = d;
+    tm.tm_hour = h;
+    tm.tm_min = mi;
+    tm.tm_sec = s;
+    return (uint32_t)timegm(&tm);
+}
+
+static TimeZone zone(const char *spec)
+{
+    TimeZone tz;
+    TEST_ASSERT_TRUE_MESSAGE(tzParse(spec, tz), spec);
+    return tz;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_transition_instants()
+{
+    // zone, UTC instant of the change, offset before, offset after
+    static const struct
+    {
+        const char *spec;
+        uint32_t at;
+        int32_t before, after;
+    } cases[] = {
+        {TZ_LONDON, utcOf(2027, 3, 28, 1, 0), 0, 3600},        // 01:00 GMT -> 02:00 BST
+        {TZ_LONDON, utcOf(2027, 10, 31, 1, 0), 3600, 0},       // 02:00 BST -> 01:00 GMT
+        {TZ_LONDON, utcOf(2028, 3, 26, 1, 0), 0, 3600},
+        {TZ_NEW_YORK, utcOf(2027, 3, 14, 7, 0), -18000, -14400}, // 02:00 EST -> 03:00 EDT
+        {TZ_NEW_YORK, utcOf(2027, 11, 7, 6, 0), -14400, -18000}, // 02:00 EDT -> 01:00 EST
+        {TZ_NEW_YORK, utcOf(2028, 3, 12, 7, 0), -18000, -14400},
+        {TZ_SYDNEY, utcOf(2027, 4, 3, 16, 0), 39600, 36000},   // 03:00 AEDT -> 02:00 AEST
+        {TZ_SYDNEY, utcOf(2027, 10, 2, 16, 0), 36000, 39600},  // 02:00 AEST -> 03:00 AEDT
+        {TZ_SYDNEY, utcOf(2028, 4, 1, 16, 0), 39600, 36000},
+    };
+    for (const auto &c : cases)
+    {
+        TimeZone tz = zone(c.spec);
+        TzCache cache = {};
+        TEST_ASSERT_EQUAL_INT32_MESSAGE(c.before, tzOffset(tz, cache, c.at - 1), c.spec);
+        TEST_ASSERT_EQUAL_INT32_MESSAGE(c.after, tzOffset(tz, cache, c.at), c.spec);
+        TEST_ASSERT_EQUAL_INT32_MESSAGE(c.after, tzOffset(tz, cache, c.at + 3600), c.spec);
+    }
+}
+
+void test_skipped_local_hour()
+{
+    // A local time inside the hour that never shows takes the standard offset,
+    // so it lands one hour later on the wall clock
+    static const struct
+    {
+        const char *spec;
+        uint32_t local, utc;
+    } cases[] = {
+        {TZ_LONDON, utcOf(2027, 3, 28, 1, 30), utcOf(2027, 3, 28, 1, 30)},
+        {TZ_NEW_YORK, utcOf(2027, 3, 14, 2, 30), utcOf(2027, 3, 14, 7, 30)},
+        {TZ_SYDNEY, utcOf(2027, 10, 3, 2, 30), utcOf(2027, 10, 2, 16, 30)},
+    };
+    for (const auto &c : cases)
+    {
+        TimeZone tz = zone(c.spec);
+        TzCache cache = {};
+        TEST_ASSERT_EQUAL_INT32_MESSAGE(tz.stdOffsetS, tzOffsetForLocal(tz, cache, c.local), c.spec);
+        uint32_t utc = c.local - tzOffsetForLocal(tz, cache, c.local);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(c.utc, utc, c.spec);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(c.local + 3600, utc + tzOffset(tz, cache, utc), c.spec);
+        // Either side of the gap is unambiguous
+        TEST_ASSERT_EQUAL_INT32_MESSAGE(tz.stdOffsetS, tzOffsetForLocal(tz, cache, c.local - 1801), c.spec);
+        TEST_ASSERT_EQUAL_INT32_MESSAGE(tz.dstOffsetS, tzOffsetForLocal(tz, cache, c.local + 1800), c.spec);
+    }
+}
+
+void test_repeated_local_hour()
+{
+    // A local time inside the hour that shows twice takes the first (daylight) offset
+    static const struct
+    {
+        const char *spec;
+        uint32_t local, utc;
+    } cases[] = {
+        {TZ_LONDON, utcOf(2027, 10, 31, 1, 30), utcOf(2027, 10, 31, 0, 30)},
+        {TZ_NEW_YORK, utcOf(2027, 11, 7, 1, 30), utcOf(2027, 11, 7, 5, 30)},
+        {TZ_SYDNEY, utcOf(2027, 4, 4, 2, 30), utcOf(2027, 4, 3, 15, 30)},
+    };
+    for (const auto &c : cases)
+    {
+        TimeZone tz = zone(c.spec);
+        TzCache cache = {};
+        TEST_ASSERT_EQUAL_INT32_MESSAGE(tz.dstOffsetS, tzOffsetForLocal(tz, cache, c.local), c.spec);
+        uint32_t utc = c.local - tzOffsetForLocal(tz, cache, c.local);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(c.utc, utc, c.spec);
+        // Both UTC instants an hour apart show the same wall clock
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(c.local, utc + tzOffset(tz, cache, utc), c.spec);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(c.local, utc + 3600 + tzOffset(tz, cache, utc + 3600), c.spec);
+        // After the repeat it is standard time again
+        TEST_ASSERT_EQUAL_INT32_MESSAGE(tz.stdOffsetS, tzOffsetForLocal(tz, cache, c.local + 1800), c.spec);
+    }
+}
+
+void test_zone_without_dst()
+{
+    TimeZone tz = zone(TZ_DHAKA);
+    TEST_ASSERT_FALSE(tz.hasDst);
+    TzCache cache = {};
+    for (uint32_t utc = utcOf(2027, 1, 1, 0, 0); utc < utcOf(2029, 1, 1, 0, 0); utc += 6 * 3600 + 17)
+    {
+        TEST_ASSERT_FALSE(tzIsDst(tz, cache, utc));
+        TEST_ASSERT_EQUAL_INT32(6 * 3600, tzOffset(tz, cache, utc));
+        TEST_ASSERT_EQUAL_INT32(6 * 3600, tzOffsetForLocal(tz, cache, utc));
+    }
+    TEST_ASSERT_EQUAL(0, cache.year); // never needs one
+}
+
+void test_cache_year_rollover()
+{
+    // Sydney is in DST across the new year, so a stale cache shows up as a wrong offset
+    TimeZone tz = zone(TZ_SYDNEY);
+    TzCache cache = {};
+    const uint32_t newYear = utcOf(2028, 1, 1, 0, 0);
+    TEST_ASSERT_EQUAL_INT32(39600, tzOffset(tz, cache, newYear - 1));
+    TEST_ASSERT_EQUAL(2027, cache.year);
+    TEST_ASSERT_EQUAL_INT32(39600, tzOffset(tz, cache, newYear));
+    TEST_ASSERT_EQUAL(2028, cache.year);
+    TEST_ASSERT_EQUAL_INT32(39600, tzOffset(tz, cache, newYear - 1)); // and back
+    TEST_ASSERT_EQUAL(2027, cache.year);
+    // Local new year comes 11 hours before UTC's, still in the 2027 cache
+    TEST_ASSERT_EQUAL_INT32(39600, tzOffset(tz, cache, utcOf(2027, 12, 31, 13, 0)));
+    TEST_ASSERT_EQUAL(2027, cache.year);
+    // A jump of several years, either way, refills rather than reusing
+    TEST_ASSERT_EQUAL_INT32(36000, tzOffset(tz, cache, utcOf(2035, 7, 1, 0, 0)));
+    TEST_ASSERT_EQUAL(2035, cache.year);
+    TEST_ASSERT_EQUAL_INT32(39600, tzOffset(tz, cache, utcOf(2027, 4, 3, 15, 59, 59)));
+    TEST_ASSERT_EQUAL(2027, cache.year);
+    // Right at the edges of the guessed year
+    TimeZone london = zone(TZ_LONDON);
+    for (int y = 2024; y <= 2040; y++)
+    {
+        TzCache fresh = {};
+        TEST_ASSERT_EQUAL_INT32(0, tzOffset(london, fresh, utcOf(y, 1, 1, 0, 0)));
+        TEST_ASSERT_EQUAL(y, fresh.year);
+        fresh = {};
+        TEST_ASSERT_EQUAL_INT32(0, tzOffset(london, fresh, utcOf(y, 12, 31, 23, 59, 59)));
+        TEST_ASSERT_EQUAL(y, fresh.year);
+    }
+}
+
+// One cache walked through five years, against the C library's answer for every step
+void test_sweep_against_libc()
+{
+    static const char *specs[] = {TZ_LONDON, TZ_NEW_YORK, TZ_SYDNEY, TZ_DHAKA};
+    for (const char *spec : specs)
+    {
+        setenv("TZ", spec, 1);
+        tzset();
+        TimeZone tz = zone(spec);
+        TzCache cache = {};
+        uint32_t mismatches = 0;
+        for (uint32_t utc = utcOf(2026, 1, 1, 0, 0); utc < utcOf(2031, 1, 1, 0, 0); utc += 1800)
+        {
+            time_t t = utc;
+            struct tm local;
+            localtime_r(&t, &local);
+            if (tzOffset(tz, cache, utc) != local.tm_gmtoff || tzIsDst(tz, cache, utc) != (local.tm_isdst > 0))
+                mismatches++;
+        }
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, mismatches, spec);
+    }
+    unsetenv("TZ");
+    tzset();
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_transition_instants);
+    RUN_TEST(test_skipped_local_hour);
+    RUN_TEST(test_repeated_local_hour);
+    RUN_TEST(test_zone_without_dst);
+    RUN_TEST(test_cache_year_rollover);
+    RUN_TEST(test_sweep_against_libc);
+    return UNITY_END();
+}
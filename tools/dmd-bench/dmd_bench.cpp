@@ -0,0 +1,410 @@
+/*--------------------------------------------------------------------------------------
+ dmd_bench - micro-benchmarks for the DMD32 drawing primitives, run on the host against
+ lib/NativeShims. Times writePixel, drawLine, drawBox, drawFilledBox, drawChar,
+ drawString, stepMarquee and clearScreen on the workloads the faces actually draw
+ (fonts, coordinates and modes from src/Clocks.h), plus every font in src/fonts.
+
+ Build (Linux, from the repository root):
+   g++ -std=gnu++17 -O2 -pthread -Ilib/NativeShims/include -Ilib/DMD32-main/src -Isrc \
+       tools/dmd-bench/dmd_bench.cpp lib/DMD32-main/src/DMD32.cpp lib/NativeShims/src/arduino.cpp \
+       lib/NativeShims/src/freertos.cpp lib/NativeShims/src/sntp.cpp -o dmd_bench
+
+ Run:
+   ./dmd_bench [--filter text] [--min-ms n] [--save file.json] [--compare file.json] [--threshold pct]
+
+ Each case is timed in REPEATS batches of about --min-ms / REPEATS ms, taken in rounds
+ over all cases; the fastest batch gives ns/op (the least disturbed by the host). pixels/op is the area the call covers, so ns/pixel can be compared
+ across primitives.
+
+ Regression check: save a baseline on the known-good tree, then compare against it on
+ the same machine. Any case slower than the baseline by more than --threshold percent
+ (default 10) is listed and the exit status is 1. Times are scaled by the reference/cpu
+ case first, so a host that is busier than it was for the baseline does not show up as
+ a regression. Host numbers are not ESP32 numbers; only compare runs from one machine
+ and one compiler.
+--------------------------------------------------------------------------------------*/
+#include <Arduino.h>
+#include <DMD32.h>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "fonts/SystemFont5x7.h"
+#include "fonts/Font_12x6.h"
+#include "fonts/Font5x7Nbox.h"
+#include "fonts/Font5x7NboxC.h"
+#include "fonts/Font6x16.h"
+#include "fonts/SystemFont3x5.h"
+#include "fonts/Font5x10Nbox.h"
+#include "fonts/Font5x10Sbox.h"
+#include "fonts/Bangla8.h"
+
+#define REPEATS 7
+#define DEFAULT_MIN_MS 300
+#define DEFAULT_THRESHOLD 10.0
+#define REFERENCE_CASE "reference/cpu"
+
+DMD dmd(1, 1);
+
+struct Font
+{
+    const char *name;
+    const uint8_t *data;
+};
+
+static const Font fonts[] = {
+    {"System5x7", System5x7},       {"SystemFont3x5", SystemFont3x5}, {"Font5x7Nbox", Font5x7Nbox},
+    {"Font5x7NboxC", Font5x7NboxC}, {"Font5x10Nbox", Font5x10Nbox},   {"Font5x10Sbox", Font5x10Sbox},
+    {"Font6x16", Font6x16},         {"Font12x6", Font12x6},           {"Bangla8", Bangla8},
+};
+
+// One case: `setup` once before timing, then `run(n)` does n operations
+struct Case
+{
+    std::string name;
+    long pixels; // per op
+    std::function<void()> setup;
+    std::function<void(long)> run;
+    long batch;  // ops per timed batch
+    double best; // fastest ns/op so far
+};
+
+struct Result
+{
+    double nsPerOp;
+    long pixels;
+};
+
+static std::vector<Case> cases;
+
+static void add(const std::string &name, long pixels, std::function<void()> setup, std::function<void(long)> run)
+{
+    cases.push_back({name, pixels, setup, run, 0, 0});
+}
+
+static int fontHeight(const uint8_t *font)
+{
+    return pgm_read_byte(font + FONT_HEIGHT);
+}
+
+// Text is UTF-8, as drawString() takes it
+static long stringPixels(const uint8_t *font, const char *text)
+{
+    long width = 0;
+    int len = strlen(text);
+    for (int i = 0; i < len;)
+        width += DMD::codePointWidth(font, DMD::nextCodePoint(text, len, &i)) + 1;
+    return width * fontHeight(font);
+}
+
+// A character the font has: '8' for digit fonts, else 'W', else a Bengali 8
+static uint16_t sampleCodePoint(const uint8_t *font)
+{
+    if (DMD::codePointWidth(font, '8'))
+        return '8';
+    return DMD::codePointWidth(font, 'W') ? 'W' : 0x09EE;
+}
+
+// Four digits the font has
+static const char *sampleDigits(const uint8_t *font)
+{
+    return DMD::codePointWidth(font, '1') ? "1234" : "\u09E7\u09E8\u09E9\u09EA";
+}
+
+static void addString(const std::string &name, const uint8_t *font, int x, int y, const char *text, byte mode)
+{
+    add("drawString/" + name, stringPixels(font, text), [font] { dmd.selectFont(font); },
+        [=](long n) {
+            for (long i = 0; i < n; i++)
+                dmd.drawString(x, y, text, strlen(text), mode);
+        });
+}
+
+static void addBox(const std::string &name, int x1, int y1, int x2, int y2, byte mode)
+{
+    add("drawFilledBox/" + name, (long)(x2 - x1 + 1) * (y2 - y1 + 1), [] {},
+        [=](long n) {
+            for (long i = 0; i < n; i++)
+                dmd.drawFilledBox(x1, y1, x2, y2, mode);
+        });
+}
+
+static void addLine(const std::string &name, int x1, int y1, int x2, int y2)
+{
+    long len = std::max(abs(x2 - x1), abs(y2 - y1)) + 1;
+    add("drawLine/" + name, len, [] {},
+        [=](long n) {
+            for (long i = 0; i < n; i++)
+                dmd.drawLine(x1, y1, x2, y2, GRAPHICS_NORMAL);
+        });
+}
+
+static void addMarquee(const std::string &name, int left, int dx, int dy)
+{
+    static const char text[] = "TUESDAY 19 OCTOBER 2026";
+    add("stepMarquee/" + name, DMD_PIXELS_ACROSS * DMD_PIXELS_DOWN,
+        [=] {
+            dmd.clearScreen(true);
+            dmd.selectFont(System5x7);
+            dmd.drawMarquee(text, strlen(text), left, 9);
+        },
+        [=](long n) {
+            for (long i = 0; i < n; i++)
+                dmd.stepMarquee(dx, dy);
+        });
+}
+
+// Fixed work that no DMD change can affect, timed in the same rounds as the cases;
+// comparisons are scaled by it to cancel out the host running faster or slower
+static uint8_t referenceBuf[64];
+
+static void buildCases()
+{
+    add(REFERENCE_CASE, 0, [] {},
+        [](long n) {
+            for (long i = 0; i < n; i++)
+                for (int j = 0; j < 64; j++)
+                    referenceBuf[j] = (referenceBuf[j] << 1) ^ referenceBuf[(j + 1) & 63] ^ (uint8_t)i;
+        });
+
+    // ------------------- Whole screen -------------------
+    add("clearScreen/normal", DMD_PIXELS_ACROSS * DMD_PIXELS_DOWN, [] {},
+        [](long n) {
+            for (long i = 0; i < n; i++)
+                dmd.clearScreen(i & 1);
+        });
+
+    // ------------------- Pixels -------------------
+    add("writePixel/sweep", 1, [] {},
+        [](long n) {
+            for (long i = 0; i < n; i++)
+                dmd.writePixel(i & 31, (i >> 5) & 15, GRAPHICS_NORMAL, i & 1);
+        });
+    add("writePixel/wifi-icon", 1, [] {},
+        [](long n) {
+            for (long i = 0; i < n; i++)
+                dmd.writePixel(27, 1, GRAPHICS_NORMAL, 1);
+        });
+    add("writePixel/toggle", 1, [] {},
+        [](long n) {
+            for (long i = 0; i < n; i++)
+                dmd.writePixel(i & 31, (i >> 5) & 15, GRAPHICS_TOGGLE, 1);
+        });
+
+    // ------------------- Lines and boxes (face coordinates) -------------------
+    addLine("wifi-icon", 28, 0, 30, 0);
+    addLine("vertical", 13, 0, 13, 15);
+    addLine("diagonal", 0, 0, 31, 15);
+    addBox("colon-or", 15, 2, 16, 3, GRAPHICS_OR);
+    addBox("colon-nor", 15, 12, 16, 13, GRAPHICS_NOR);
+    addBox("date-dot", 8, 15, 8, 15, GRAPHICS_OR);
+    addBox("divider", 13, 0, 13, 15, GRAPHICS_OR);
+    addBox("icon-background", 26, 0, 31, 3, GRAPHICS_INVERSE);
+    addBox("ticker-row-clear", 0, 9, 31, 15, GRAPHICS_NOR);
+    addBox("seconds-clear", 20, 0, 31, 15, GRAPHICS_NOR);
+    add("drawBox/degree", 4, [] {},
+        [](long n) {
+            for (long i = 0; i < n; i++)
+                dmd.drawBox(18, 9, 19, 10, GRAPHICS_OR);
+        });
+
+    // ------------------- Every font -------------------
+    for (const Font &f : fonts)
+    {
+        const uint8_t *font = f.data;
+        uint16_t c = sampleCodePoint(font);
+        add(std::string("drawChar/") + f.name, (long)DMD::codePointWidth(font, c) * fontHeight(font),
+            [font] { dmd.selectFont(font); },
+            [c](long n) {
+                for (long i = 0; i < n; i++)
+                    dmd.drawCodePoint(0, 0, c, GRAPHICS_NORMAL); // what drawChar() calls
+            });
+        addString(std::string(f.name) + "-1234", font, 0, 0, sampleDigits(font), GRAPHICS_NORMAL);
+    }
+
+    // ------------------- Face strings -------------------
+    addString("clock1-hours", Font6x16, 1, 0, "12", GRAPHICS_NORMAL);
+    addString("clock2-minutes", Font12x6, 18, 2, "34", GRAPHICS_NORMAL);
+    addString("clock3-hours", Font5x7Nbox, 3, -1, "12", GRAPHICS_NORMAL);
+    addString("clock3-seconds-roll", Font12x6, 25, -1, "5", GRAPHICS_OR);
+    addString("clock4-weekday", System5x7, 0, 9, "TUE", GRAPHICS_NORMAL);
+    addString("clock4-bn-minutes", Bangla8, 18, 0, "\u09E9\u09EA", GRAPHICS_NORMAL);
+    addString("clock4-bn-weekday", Bangla8, 0, 8, "\uE002", GRAPHICS_NORMAL);
+    addString("clock5-hours", Font5x10Nbox, 0, 0, "12", GRAPHICS_NORMAL);
+    addString("clock5-date", SystemFont3x5, 0, 11, "19", GRAPHICS_NORMAL);
+    addString("clock6-month", System5x7, 15, 0, "OCT", GRAPHICS_NORMAL);
+    addString("clock7-ticker", System5x7, -7, 9, "TUESDAY 19", GRAPHICS_NORMAL);
+    addString("clock8-year", Font5x7Nbox, 5, 8, "2026", GRAPHICS_NORMAL);
+
+    // ------------------- Marquee -------------------
+    addMarquee("left", 32, -1, 0);
+    addMarquee("right", 0, 1, 0);
+    addMarquee("up", 0, 0, -1);
+}
+
+// ------------------- Timing -------------------
+static double nowNs()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Grow the batch until one takes about `batchNs`
+static void calibrate(Case &c, double batchNs)
+{
+    c.setup();
+    long n = 1;
+    for (;;)
+    {
+        double t0 = nowNs();
+        c.run(n);
+        double took = nowNs() - t0;
+        if (took >= batchNs / 4)
+        {
+            c.batch = std::max(1L, (long)(n * batchNs / took));
+            return;
+        }
+        n *= 4;
+    }
+}
+
+static void measure(Case &c)
+{
+    c.setup();
+    double t0 = nowNs();
+    c.run(c.batch);
+    double ns = (nowNs() - t0) / c.batch;
+    if (c.best == 0 || ns < c.best)
+        c.best = ns;
+}
+
+// ------------------- Baselines -------------------
+// One case per line, so the baseline can be read back without a JSON library
+static bool saveJson(const char *path, const std::vector<std::string> &names, const std::map<std::string, Result> &results)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+        return false;
+    fprintf(f, "{\n  \"tool\": \"dmd_bench\",\n  \"cases\": [\n");
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        const Result &r = results.at(names[i]);
+        fprintf(f, "    {\"name\": \"%s\", \"ns_per_op\": %.2f, \"pixels_per_op\": %ld}%s\n", names[i].c_str(), r.nsPerOp,
+                r.pixels, i + 1 < names.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+static bool loadJson(const char *path, std::map<std::string, double> &out)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+    char line[512], name[256];
+    double ns;
+    while (fgets(line, sizeof(line), f))
+        if (sscanf(line, " {\"name\": \"%255[^\"]\", \"ns_per_op\": %lf", name, &ns) == 2)
+            out[name] = ns;
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *filter = nullptr, *savePath = nullptr, *comparePath = nullptr;
+    double minMs = DEFAULT_MIN_MS, threshold = DEFAULT_THRESHOLD;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            fprintf(stderr, "usage: %s [--filter text] [--min-ms n] [--save file] [--compare file] [--threshold pct]\n", argv[0]);
+            return 2;
+        }
+        if (arg == "--filter")
+            filter = argv[++i];
+        else if (arg == "--min-ms")
+            minMs = atof(argv[++i]);
+        else if (arg == "--save")
+            savePath = argv[++i];
+        else if (arg == "--compare")
+            comparePath = argv[++i];
+        else if (arg == "--threshold")
+            threshold = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return 2;
+        }
+    }
+
+    std::map<std::string, double> baseline;
+    if (comparePath && !loadJson(comparePath, baseline))
+    {
+        perror(comparePath);
+        return 2;
+    }
+
+    buildCases();
+    std::vector<Case *> selected;
+    for (Case &c : cases)
+        if (!filter || c.name.find(filter) != std::string::npos || c.name == REFERENCE_CASE)
+            selected.push_back(&c);
+    for (Case *c : selected)
+        calibrate(*c, minMs * 1e6 / REPEATS);
+    // Round-robin, so a burst of host load spoils one batch of several cases rather than every batch of one
+    for (int r = 0; r < REPEATS; r++)
+        for (Case *c : selected)
+            measure(*c);
+
+    std::vector<std::string> names;
+    std::map<std::string, Result> results;
+    int regressions = 0;
+    double scale = 1; // host speed now relative to the baseline run
+    if (baseline.count(REFERENCE_CASE) && cases[0].best > 0)
+        scale = baseline[REFERENCE_CASE] / cases[0].best;
+
+    printf("%-36s %10s %10s %10s", "case", "ns/op", "pixels/op", "ns/pixel");
+    printf(comparePath ? " %10s\n" : "\n", "vs base");
+    for (Case *c : selected)
+    {
+        double ns = c->best;
+        names.push_back(c->name);
+        results[c->name] = {ns, c->pixels};
+        printf("%-36s %10.2f %10ld %10.3f", c->name.c_str(), ns, c->pixels, c->pixels ? ns / c->pixels : 0);
+
+        auto base = baseline.find(c->name);
+        if (base != baseline.end() && base->second > 0)
+        {
+            double change = (ns * scale - base->second) * 100 / base->second;
+            bool slower = change > threshold;
+            regressions += slower;
+            printf(" %+9.1f%%%s", change, slower ? "  REGRESSION" : "");
+        }
+        else if (comparePath)
+        {
+            printf(" %10s", "new");
+        }
+        putchar('\n');
+    }
+
+    if (savePath)
+    {
+        if (!saveJson(savePath, names, results))
+        {
+            perror(savePath);
+            return 2;
+        }
+        printf("Saved %zu cases to %s\n", names.size(), savePath);
+    }
+    if (comparePath)
+    {
+        printf("%d case(s) more than %.0f%% slower than %s (host speed %.2fx the baseline run)\n", regressions, threshold,
+               comparePath, scale);
+        return regressions ? 1 : 0;
+    }
+    return 0;
+}
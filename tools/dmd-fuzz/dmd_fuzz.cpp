@@ -0,0 +1,373 @@
+/*--------------------------------------------------------------------------------------
+ dmd_fuzz - bounds-safety fuzz target for the DMD32 text and pixel primitives: drawString,
+ drawChar, drawCodePoint, writePixel, drawMarquee/stepMarquee, with every font in src/fonts, every panel
+ layout the firmware can be built for, any coordinate a DrawCommand can carry (int16) and
+ any graphics mode byte, on screen and offscreen.
+
+ Each font is copied to a heap block of exactly the size its header declares, and each
+ string to a block of exactly `length` bytes, so AddressSanitizer stops on any read past
+ the font data or the caller's text as well as on writes past the frame buffers. A font
+ array shorter than its header declares is reported before anything runs.
+
+ libFuzzer (clang):
+   clang++ -std=gnu++17 -g -O1 -fsanitize=fuzzer,address,undefined -DDMD_FUZZ_LIBFUZZER \
+       -Ilib/NativeShims/include -Ilib/DMD32-main/src -Isrc tools/dmd-fuzz/dmd_fuzz.cpp \
+       lib/DMD32-main/src/DMD32.cpp lib/NativeShims/src/arduino.cpp \
+       lib/NativeShims/src/freertos.cpp lib/NativeShims/src/sntp.cpp -o dmd_fuzz
+   ./dmd_fuzz -max_len=512 corpus-new tools/dmd-fuzz/corpus
+
+ Without libFuzzer (gcc or clang), a built-in driver runs random inputs or replays files:
+   g++ -std=gnu++17 -g -O1 -pthread -fsanitize=address,undefined -fno-sanitize-recover=all \
+       -Ilib/NativeShims/include -Ilib/DMD32-main/src -Isrc tools/dmd-fuzz/dmd_fuzz.cpp \
+       lib/DMD32-main/src/DMD32.cpp lib/NativeShims/src/arduino.cpp \
+       lib/NativeShims/src/freertos.cpp lib/NativeShims/src/sntp.cpp -o dmd_fuzz
+   ./dmd_fuzz [--runs n] [--seed n] [--max-len n]     random inputs (default 200000 runs)
+   ./dmd_fuzz crash-file...                           replay inputs
+
+ tools/dmd-fuzz/corpus holds hand-made seeds, one per kind of use: clock digits, every
+ font, Bengali UTF-8 (whole, cut off and malformed), marquee steps, offscreen
+ transitions, int16 edge coordinates and pixel modes. libFuzzer writes what it finds to
+ the first directory (corpus-new above), so the seeds stay as they are. Replay them with
+ the built-in driver after a change to DMD32.
+
+ Input layout: layout byte, font byte, then operations until the input runs out
+ (see runOps()). Strings are random bytes, so drawString() also gets valid, cut-off and
+ malformed UTF-8. Besides the sanitizers, drawChar() and drawCodePoint() must return what
+ charWidth() and codePointWidth() say.
+--------------------------------------------------------------------------------------*/
+#include <Arduino.h>
+#include <DMD32.h>
+#include <string>
+#include <vector>
+#if defined(__SANITIZE_ADDRESS__)
+#define FUZZ_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define FUZZ_ASAN 1
+#endif
+#endif
+#ifdef FUZZ_ASAN
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+#include "fonts/SystemFont5x7.h"
+#include "fonts/Font_12x6.h"
+#include "fonts/Font5x7Nbox.h"
+#include "fonts/Font5x7NboxC.h"
+#include "fonts/Font6x16.h"
+#include "fonts/SystemFont3x5.h"
+#include "fonts/Font5x10Nbox.h"
+#include "fonts/Font5x10Sbox.h"
+#include "fonts/Bangla8.h"
+
+#define FUZZ_DEFAULT_RUNS 200000
+#define FUZZ_DEFAULT_MAX_LEN 512
+
+struct Font
+{
+    const char *name;
+    const uint8_t *data;
+    size_t size;
+};
+
+#define FONT(f) {#f, f, sizeof(f)}
+static const Font fonts[] = {
+    FONT(System5x7),   FONT(SystemFont3x5), FONT(Font5x7Nbox),  FONT(Font5x7NboxC),
+    FONT(Font5x10Nbox), FONT(Font5x10Sbox), FONT(Font6x16),     FONT(Font12x6),
+    FONT(Bangla8),
+};
+#define FONT_COUNT (sizeof(fonts) / sizeof(fonts[0]))
+
+// Panel layouts (wide x high)
+static const uint8_t layouts[][2] = {{1, 1}, {2, 1}, {1, 2}, {2, 2}, {3, 1}, {4, 1}};
+#define LAYOUT_COUNT (sizeof(layouts) / sizeof(layouts[0]))
+
+static DMD *displays[LAYOUT_COUNT];
+static const uint8_t *fontCopies[FONT_COUNT];
+
+// Bytes a font's header says it has: header, width table, glyph columns (packed fonts:
+// header, glyph table, the furthest glyph's columns; none of them is compressed)
+static size_t fontDeclaredSize(const uint8_t *f)
+{
+    if (DMD::isPackedFont(f))
+    {
+        bool bbox = f[FONT_PACKED_FLAGS] & FONT_PACKED_BBOX, sparse = f[FONT_PACKED_FLAGS] & FONT_PACKED_SPARSE;
+        size_t entry = (bbox ? 5 : 3) + (sparse ? 2 : 0);
+        size_t table = sparse ? FONT_PACKED_HASH + 2 : FONT_PACKED_TABLE;
+        size_t data = table + f[FONT_CHAR_COUNT] * entry, end = data;
+        for (size_t i = 0; i < f[FONT_CHAR_COUNT]; i++)
+        {
+            const uint8_t *e = f + table + i * entry + (sparse ? 2 : 0);
+            size_t cols = bbox ? e[4] : e[2];
+            end = std::max(end, data + (e[0] | e[1] << 8) + cols * ((f[FONT_PACKED_ROWS] + 7) / 8));
+        }
+        return end;
+    }
+    size_t bytes = (f[FONT_HEIGHT] + 7) / 8;
+    size_t count = f[FONT_CHAR_COUNT];
+    if (f[FONT_LENGTH] == 0 && f[FONT_LENGTH + 1] == 0)
+        return FONT_WIDTH_TABLE + count * bytes * f[FONT_FIXED_WIDTH];
+    size_t columns = 0;
+    for (size_t i = 0; i < count; i++)
+        columns += f[FONT_WIDTH_TABLE + i];
+    return FONT_WIDTH_TABLE + count + columns * bytes;
+}
+
+static void setupTargets()
+{
+    for (size_t i = 0; i < FONT_COUNT; i++)
+    {
+        size_t declared = fontDeclaredSize(fonts[i].data);
+        if (declared > fonts[i].size)
+        {
+            fprintf(stderr, "%s: header declares %zu bytes, array has %zu\n", fonts[i].name, declared,
+                    fonts[i].size);
+            abort();
+        }
+        uint8_t *copy = (uint8_t *)malloc(declared);
+        memcpy(copy, fonts[i].data, declared);
+        fontCopies[i] = copy;
+    }
+    for (size_t i = 0; i < LAYOUT_COUNT; i++)
+        displays[i] = new DMD(layouts[i][0], layouts[i][1]);
+}
+
+// ------------------- Input -------------------
+static const std::vector<uint8_t> *currentInput = nullptr; // standalone driver only
+
+// Leave the input that failed behind for replay, then stop
+static void saveCurrentInput()
+{
+    if (!currentInput)
+        return;
+    FILE *fp = fopen("dmd_fuzz-crash.bin", "wb");
+    if (!fp)
+        return;
+    fwrite(currentInput->data(), 1, currentInput->size(), fp);
+    fclose(fp);
+    fprintf(stderr, "input saved to dmd_fuzz-crash.bin (%zu bytes)\n", currentInput->size());
+}
+
+static void failed()
+{
+    saveCurrentInput();
+    abort();
+}
+
+class Input
+{
+public:
+    Input(const uint8_t *data, size_t size) : p(data), end(data + size) {}
+
+    bool empty() const { return p >= end; }
+    uint8_t u8() { return p < end ? *p++ : 0; }
+    // Mostly near the panels (-64..175), sometimes anywhere in int16
+    int coord()
+    {
+        uint8_t b = u8();
+        if (b < 0xF0)
+            return b - 64;
+        uint16_t lo = u8();
+        return (int16_t)(lo | (u8() << 8));
+    }
+    // Exactly `n` bytes on the heap (zero-filled past the end of the input)
+    char *text(size_t n)
+    {
+        char *t = (char *)malloc(n ? n : 1);
+        for (size_t i = 0; i < n; i++)
+            t[i] = (char)u8();
+        return t;
+    }
+
+private:
+    const uint8_t *p, *end;
+};
+
+enum FuzzOp : uint8_t
+{
+    OP_WRITE_PIXEL,
+    OP_DRAW_CHAR,
+    OP_DRAW_STRING,
+    OP_SELECT_FONT,
+    OP_MARQUEE,
+    OP_OFFSCREEN,
+    OP_DRAW_CODE_POINT,
+    OP_COUNT
+};
+
+static void runOps(Input &in)
+{
+    DMD &dmd = *displays[in.u8() % LAYOUT_COUNT];
+    dmd.clearScreen(true);
+    const uint8_t *font = fontCopies[in.u8() % FONT_COUNT];
+    dmd.selectFont(font);
+    bool offscreen = false;
+
+    while (!in.empty())
+    {
+        switch (in.u8() % OP_COUNT)
+        {
+        case OP_WRITE_PIXEL:
+        {
+            // Negative coordinates reach writePixel() as large unsigned values
+            int x = in.coord(), y = in.coord();
+            uint8_t mode = in.u8();
+            dmd.writePixel((unsigned int)x, (unsigned int)y, mode, in.u8() & 1);
+            break;
+        }
+        case OP_DRAW_CHAR:
+        {
+            int x = in.coord(), y = in.coord();
+            unsigned char c = in.u8();
+            int width = dmd.drawChar(x, y, c, in.u8());
+            if (width >= 0 && width != dmd.charWidth(c))
+            {
+                fprintf(stderr, "drawChar(%d, %d, 0x%02x) drew %d columns, charWidth says %d\n", x, y, c, width,
+                        dmd.charWidth(c));
+                failed();
+            }
+            break;
+        }
+        case OP_DRAW_STRING:
+        {
+            int x = in.coord(), y = in.coord();
+            uint8_t mode = in.u8();
+            uint8_t length = in.u8();
+            char *text = in.text(length);
+            dmd.drawString(x, y, text, length, mode);
+            free(text);
+            break;
+        }
+        case OP_SELECT_FONT:
+            font = fontCopies[in.u8() % FONT_COUNT];
+            dmd.selectFont(font);
+            break;
+        case OP_MARQUEE:
+        {
+            int left = in.coord(), top = in.coord();
+            uint8_t length = in.u8();
+            char *text = in.text(length);
+            dmd.drawMarquee(text, length, left, top);
+            free(text);
+            for (int steps = in.u8() % 8; steps > 0; steps--)
+                dmd.stepMarquee((int8_t)in.u8(), (int8_t)in.u8());
+            break;
+        }
+        case OP_DRAW_CODE_POINT:
+        {
+            // Mostly Bengali digits, the rest anywhere in the BMP
+            int x = in.coord(), y = in.coord();
+            uint16_t c = in.u8();
+            c = c < 0x80 ? 0x09E0 + c % 16 : (c << 8) | in.u8();
+            int width = dmd.drawCodePoint(x, y, c, in.u8());
+            if (width >= 0 && width != DMD::codePointWidth(font, c))
+            {
+                fprintf(stderr, "drawCodePoint(%d, %d, U+%04X) drew %d columns, codePointWidth says %d\n", x, y, c,
+                        width, DMD::codePointWidth(font, c));
+                failed();
+            }
+            break;
+        }
+        case OP_OFFSCREEN:
+            // Drawing goes to the back buffer until the transition has finished
+            if (!offscreen)
+                dmd.beginOffscreen();
+            else
+                while (!dmd.presentStep(in.u8() % 3))
+                    ;
+            offscreen = !offscreen;
+            break;
+        }
+    }
+    if (offscreen)
+        while (!dmd.presentStep(TRANSITION_NONE))
+            ;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static bool ready = false;
+    if (!ready)
+    {
+        setupTargets();
+        ready = true;
+    }
+    Input in(data, size);
+    runOps(in);
+    return 0;
+}
+
+// ------------------- Standalone driver -------------------
+#ifndef DMD_FUZZ_LIBFUZZER
+static bool readFile(const char *path, std::vector<uint8_t> &data)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+        return false;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        data.insert(data.end(), buf, buf + n);
+    fclose(fp);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    long runs = FUZZ_DEFAULT_RUNS;
+    unsigned long seed = 1;
+    size_t maxLen = FUZZ_DEFAULT_MAX_LEN;
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc)
+            runs = atol(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = strtoul(argv[++i], nullptr, 0);
+        else if (arg == "--max-len" && i + 1 < argc)
+            maxLen = atol(argv[++i]);
+        else if (arg[0] == '-')
+        {
+            fprintf(stderr, "usage: %s [--runs n] [--seed n] [--max-len n] [input-file...]\n", argv[0]);
+            return 2;
+        }
+        else
+            files.push_back(argv[i]);
+    }
+
+    if (!files.empty())
+    {
+        for (const char *path : files)
+        {
+            std::vector<uint8_t> data;
+            if (!readFile(path, data))
+            {
+                perror(path);
+                return 2;
+            }
+            LLVMFuzzerTestOneInput(data.data(), data.size());
+            printf("%s: ok\n", path);
+        }
+        return 0;
+    }
+
+    // Random inputs; a sanitizer report saves the one that caused it
+#ifdef FUZZ_ASAN
+    __sanitizer_set_death_callback(saveCurrentInput);
+#endif
+    srand(seed);
+    std::vector<uint8_t> data;
+    currentInput = &data;
+    for (long run = 0; run < runs; run++)
+    {
+        data.resize(rand() % (maxLen + 1));
+        for (uint8_t &b : data)
+            b = rand();
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+    }
+    currentInput = nullptr;
+    printf("%ld runs, seed %lu: ok\n", runs, seed);
+    return 0;
+}
+#endif
@@ -0,0 +1,426 @@
+/*--------------------------------------------------------------------------------------
+ face_soak - runs the clock faces of the firmware on the host in virtual time through a
+ whole day, or every midnight of a year, checks what the panel shows as it goes, and
+ reports the CPU each face costs per simulated day.
+
+ Build (Linux, from the repository root):
+   g++ -std=gnu++17 -O2 -pthread -Ilib/NativeShims/include -Ilib/DMD32-main/src -Isrc \
+       tools/face-soak/face_soak.cpp lib/DMD32-main/src/DMD32.cpp \
+       $(find lib/NativeShims/src -name '*.cpp' ! -name main.cpp) -o face_soak
+
+ Run:
+   ./face_soak                          all eight faces, 24 h from 2027-12-31 12:00:00
+   ./face_soak --year                   every midnight from there to 2029, leap day included
+   ./face_soak --face 7 --days 3 --golden-dir golden/ --update
+
+   --face N        only ClockN, 1..8 (default all)
+   --start T       local time at the start, "YYYY-MM-DD HH:MM:SS" (default 2027-12-31 12:00:00)
+   --tz SPEC       POSIX time zone (default TZ_DEFAULT)
+   --days N        simulated days (default 1)
+   --around S      simulate only S seconds either side of each local midnight; the firmware
+                   is frozen over the rest of the day, RTC included (default 0: all of it)
+   --year          --days 367 --around 60
+   --step MS       sampling interval for the checks (default 100)
+   --golden-dir D  compare the frame 2.5 s after each midnight with D/clockN-YYYY-MM-DD.pbm
+   --update        (re)write those goldens instead of comparing
+   --jobs N        faces run at once, one process each (default: CPUs)
+
+ Checks, on every sample:
+   blank           nothing lit for more than 2 s
+   stuck           2.5 s into a minute the frame is the same as 2.5 s into the one before
+   golden          the frame after midnight differs from its golden image
+   rtc             the firmware's RTC poll reported a read error or an implausible time
+
+ CPU is host CPU time of the face task, the render task (which draws for it) and the I2C
+ task, scaled to one simulated day; wakeups are the face task's turns per day. Use them
+ to compare faces and firmware versions on one machine, not as ESP32 figures.
+ Exit status: 0 all checks passed, 1 a check failed, 2 a face could not run.
+--------------------------------------------------------------------------------------*/
+#include <NativeTime.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <chrono>
+#include "main.cpp"
+#include "../frame-capture/frameImage.h"
+#include "../frame-capture/faceHost.h"
+
+#define SOAK_FACES 8
+#define SOAK_BLANK_MS 2000
+#define SOAK_PHASE_MS 2500 // where in a minute frames are compared, clear of the second's edge
+#define SOAK_MAX_REPORTS 20 // failures printed per face
+
+struct SoakOptions
+{
+    int face = 0; // 0 = all
+    const char *start = "2027-12-31 12:00:00";
+    const char *tz = TZ_DEFAULT;
+    double days = 1;
+    int aroundS = 0;
+    int stepMs = 100;
+    const char *goldenDir = nullptr;
+    bool update = false;
+    int jobs = 0;
+};
+
+// Sent back from each face's process
+struct SoakResult
+{
+    int face;
+    double simulatedS; // skipped time not included
+    uint32_t samples;
+    uint32_t failures;
+    uint32_t goldens; // compared or written
+    NativeTaskUsage faceUsage, renderUsage, i2cUsage;
+    double wallS;
+};
+
+static void usage(const char *self)
+{
+    fprintf(stderr,
+            "usage: %s [--face 1-8] [--start \"YYYY-MM-DD HH:MM:SS\"] [--tz spec] [--days n] [--around s]\n"
+            "          [--year] [--step ms] [--golden-dir dir [--update]] [--jobs n]\n",
+            self);
+}
+
+static bool parseOptions(int argc, char **argv, SoakOptions &o)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--update")
+        {
+            o.update = true;
+            continue;
+        }
+        if (arg == "--year")
+        {
+            o.days = 367;
+            o.aroundS = 60;
+            continue;
+        }
+        if (i + 1 >= argc)
+            return false;
+        const char *val = argv[++i];
+        if (arg == "--face")
+            o.face = atoi(val);
+        else if (arg == "--start")
+            o.start = val;
+        else if (arg == "--tz")
+            o.tz = val;
+        else if (arg == "--days")
+            o.days = atof(val);
+        else if (arg == "--around")
+            o.aroundS = atoi(val);
+        else if (arg == "--step")
+            o.stepMs = atoi(val);
+        else if (arg == "--golden-dir")
+            o.goldenDir = val;
+        else if (arg == "--jobs")
+            o.jobs = atoi(val);
+        else
+            return false;
+    }
+    return o.face >= 0 && o.face <= SOAK_FACES && o.days > 0 && o.aroundS >= 0 && o.aroundS < 43200 &&
+           o.stepMs > 0 && o.stepMs < SOAK_PHASE_MS;
+}
+
+// ------------------- One face -------------------
+// Local time as seconds since 1970, fractional, for a virtual instant
+struct LocalClock
+{
+    uint32_t utc0;
+    int64_t us0;
+    TzCache cache = {0};
+
+    double utcAt(int64_t us) const { return utc0 + (us - us0) / 1e6; }
+    double localAt(int64_t us)
+    {
+        double utc = utcAt(us);
+        return utc + tzOffset(timeZone, cache, (uint32_t)utc);
+    }
+    // Virtual instant of local time `local` (offset as at `us`)
+    int64_t usAt(double local, int64_t us)
+    {
+        double offset = localAt(us) - utcAt(us);
+        return us0 + (int64_t)((local - offset - utc0) * 1e6);
+    }
+};
+
+static bool anyLit(const Frame &f)
+{
+    return std::find(f.lit.begin(), f.lit.end(), 1) != f.lit.end();
+}
+
+class FaceSoak
+{
+public:
+    FaceSoak(const SoakOptions &o, SoakResult &r) : o(o), r(r) {}
+
+    void fail(double local, const char *what, const char *detail = "")
+    {
+        if (r.failures++ < SOAK_MAX_REPORTS)
+        {
+            DateTime t((uint32_t)local);
+            fprintf(stderr, "Clock%d %04d-%02d-%02d %02d:%02d:%02d %s%s\n", r.face, t.year(), t.month(), t.day(),
+                    t.hour(), t.minute(), t.second(), what, detail);
+        }
+    }
+
+    void checkGolden(const Frame &frame, double midnight)
+    {
+        DateTime day((uint32_t)midnight);
+        char path[512];
+        snprintf(path, sizeof(path), "%s/clock%d-%04d-%02d-%02d.pbm", o.goldenDir, r.face, day.year(), day.month(),
+                 day.day());
+        r.goldens++;
+        if (o.update)
+        {
+            if (!writePbm(path, frame))
+                fail(midnight, "golden: cannot write ", path);
+            return;
+        }
+        Frame expected;
+        if (!readPbm(path, expected))
+            fail(midnight, "golden: cannot read ", path);
+        else if (expected != frame)
+            fail(midnight, "golden: differs from ",
+                 (std::string(path) + "\nexpected:\n" + frameText(expected) + "got:\n" + frameText(frame)).c_str());
+    }
+
+    // A sample taken at virtual time `us`
+    void sample(int64_t us, const Frame &frame)
+    {
+        double local = clock.localAt(us);
+        r.samples++;
+        if (!sampling)
+        {
+            sampling = true;
+            sampledSinceUs = lastLitUs = us;
+            minuteStart = -1;
+            lastMinuteFrameAt = -1;
+            goldenDue = floor(local / 86400) * 86400 + 86400;
+        }
+
+        if (anyLit(frame))
+            lastLitUs = us;
+        else if (us - lastLitUs > SOAK_BLANK_MS * 1000LL)
+        {
+            fail(local, "blank: nothing lit for 2 s");
+            lastLitUs = us;
+        }
+
+        // Same point in consecutive minutes: the minute digits, at least, must differ
+        double minute = floor(local / 60) * 60;
+        if (minute != minuteStart)
+        {
+            minuteStart = minute;
+            minuteStartUs = clock.usAt(minute, us);
+            minuteChecked = false;
+        }
+        int64_t phaseUs = minuteStartUs + SOAK_PHASE_MS * 1000LL;
+        if (!minuteChecked && us >= phaseUs)
+        {
+            minuteChecked = true;
+            if (us - o.stepMs * 1000LL >= phaseUs || sampledSinceUs > phaseUs - o.stepMs * 1000LL)
+            {
+                lastMinuteFrameAt = -1; // came in late, not the same point
+            }
+            else
+            {
+                if (lastMinuteFrameAt == minute - 60 && frame == lastMinuteFrame)
+                    fail(minute, "stuck: same frame as a minute ago");
+                lastMinuteFrame = frame;
+                lastMinuteFrameAt = minute;
+            }
+        }
+
+        if (o.goldenDir && local >= goldenDue + SOAK_PHASE_MS / 1000.0)
+        {
+            // Only a midnight that was simulated through, not skipped over
+            if (sampledSinceUs < clock.usAt(goldenDue, us))
+                checkGolden(frame, goldenDue);
+            goldenDue = floor(local / 86400) * 86400 + 86400;
+        }
+    }
+
+    // The firmware was frozen from now on; sampling starts afresh after the gap
+    void gap() { sampling = false; }
+
+    LocalClock clock;
+
+private:
+    const SoakOptions &o;
+    SoakResult &r;
+    bool sampling = false;
+    Frame lastMinuteFrame;
+    int64_t sampledSinceUs = 0, lastLitUs = 0, minuteStartUs = 0;
+    double minuteStart = -1, lastMinuteFrameAt = -1, goldenDue = 0;
+    bool minuteChecked = true;
+};
+
+static bool runFace(const SoakOptions &o, SoakResult &r)
+{
+    DateTime local, utc;
+    if (!parseLocalTime(o.start, local))
+    {
+        fprintf(stderr, "bad --start %s\n", o.start);
+        return false;
+    }
+    auto started = std::chrono::steady_clock::now();
+    nativeVirtualTime();
+    if (!startFace(r.face, o.tz, local, utc))
+        return false;
+
+    FaceSoak soak(o, r);
+    soak.clock.utc0 = utc.unixtime();
+    soak.clock.us0 = nativeVirtualMicros();
+    int64_t endUs = soak.clock.us0 + (int64_t)(o.days * 86400e6);
+    int64_t skippedUs = 0;
+    for (;;)
+    {
+        int64_t us = nativeVirtualMicros();
+        if (o.aroundS > 0)
+        {
+            // Freeze everything until shortly before the next midnight
+            double now = soak.clock.localAt(us);
+            double midnight = floor((now + o.aroundS) / 86400) * 86400;
+            if (now >= midnight + o.aroundS)
+            {
+                int64_t windowUs = soak.clock.usAt(midnight + 86400 - o.aroundS, us);
+                if (windowUs >= endUs)
+                    break;
+                nativeVirtualBusy(windowUs - us);
+                skippedUs += windowUs - us;
+                soak.gap();
+            }
+        }
+        if (nativeVirtualMicros() >= endUs)
+            break;
+        vTaskDelay(pdMS_TO_TICKS(o.stepMs)); // the firmware runs meanwhile
+        soak.sample(nativeVirtualMicros(), frameFromDmd(dmd.shownFrame(), 1, 1));
+    }
+
+    if (i2cStats.timeReadErrors || i2cStats.implausible)
+    {
+        char detail[64];
+        snprintf(detail, sizeof(detail), "%u read errors, %u implausible reads", (unsigned)i2cStats.timeReadErrors,
+                 (unsigned)i2cStats.implausible);
+        soak.fail(soak.clock.localAt(nativeVirtualMicros()), "rtc: ", detail);
+    }
+    r.simulatedS = (nativeVirtualMicros() - soak.clock.us0 - skippedUs) / 1e6;
+    nativeTaskUsage(clockTaskHandle, r.faceUsage);
+    nativeTaskUsage(renderTaskHandle, r.renderUsage);
+    nativeTaskUsage(i2cTaskHandle, r.i2cUsage);
+    r.wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return true;
+}
+
+// ------------------- All faces -------------------
+// Each face gets a fresh process: the firmware's globals and tasks start clean
+static pid_t spawnFace(const SoakOptions &o, int face, int &readFd)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+        return -1;
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(fds[0]);
+        SoakResult r = {};
+        r.face = face;
+        bool ok = runFace(o, r);
+        if (ok && write(fds[1], &r, sizeof(r)) != sizeof(r))
+            ok = false;
+        fflush(stderr);
+        _exit(ok ? 0 : 2); // the firmware's tasks never return
+    }
+    close(fds[1]);
+    readFd = fds[0];
+    return pid;
+}
+
+static double perDay(double value, double simulatedS)
+{
+    return simulatedS > 0 ? value * 86400 / simulatedS : 0;
+}
+
+int main(int argc, char **argv)
+{
+    SoakOptions o;
+    if (!parseOptions(argc, argv, o))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    int jobs = o.jobs > 0 ? o.jobs : std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+
+    std::vector<int> faces;
+    for (int f = 1; f <= SOAK_FACES; f++)
+        if (o.face == 0 || o.face == f)
+            faces.push_back(f);
+
+    std::vector<SoakResult> results;
+    std::vector<int> broken;
+    size_t next = 0;
+    std::vector<std::pair<pid_t, int>> running; // pid, pipe
+    std::vector<int> runningFace;
+    while (next < faces.size() || !running.empty())
+    {
+        while (next < faces.size() && (int)running.size() < jobs)
+        {
+            int fd;
+            pid_t pid = spawnFace(o, faces[next], fd);
+            if (pid < 0)
+            {
+                perror("fork");
+                return 2;
+            }
+            running.push_back({pid, fd});
+            runningFace.push_back(faces[next++]);
+        }
+        int status;
+        pid_t done = wait(&status);
+        for (size_t i = 0; i < running.size(); i++)
+        {
+            if (running[i].first != done)
+                continue;
+            SoakResult r;
+            bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                      read(running[i].second, &r, sizeof(r)) == sizeof(r);
+            close(running[i].second);
+            if (ok)
+                results.push_back(r);
+            else
+                broken.push_back(runningFace[i]);
+            running.erase(running.begin() + i);
+            runningFace.erase(runningFace.begin() + i);
+            break;
+        }
+    }
+    std::sort(results.begin(), results.end(), [](const SoakResult &a, const SoakResult &b) { return a.face < b.face; });
+
+    printf("%-7s %9s %9s %6s %12s %12s %12s %12s %12s %8s\n", "face", "sim h", "samples", "fail", "face ms/d",
+           "render ms/d", "i2c ms/d", "total ms/d", "wakeups/d", "wall s");
+    uint32_t failures = 0;
+    for (const SoakResult &r : results)
+    {
+        double face = perDay(r.faceUsage.cpuNs / 1e6, r.simulatedS);
+        double render = perDay(r.renderUsage.cpuNs / 1e6, r.simulatedS);
+        double i2c = perDay(r.i2cUsage.cpuNs / 1e6, r.simulatedS);
+        char name[16];
+        snprintf(name, sizeof(name), "Clock%d", r.face);
+        printf("%-7s %9.2f %9u %6u %12.1f %12.1f %12.1f %12.1f %12.0f %8.1f\n", name, r.simulatedS / 3600, r.samples,
+               r.failures, face, render, i2c, face + render + i2c, perDay(r.faceUsage.turns, r.simulatedS), r.wallS);
+        failures += r.failures;
+    }
+    for (int f : broken)
+        printf("Clock%d  did not run\n", f);
+    if (o.goldenDir && o.update)
+        for (const SoakResult &r : results)
+            fprintf(stderr, "Clock%d: %u goldens written to %s\n", r.face, r.goldens, o.goldenDir);
+    if (!broken.empty())
+        return 2;
+    return failures ? 1 : 0;
+}
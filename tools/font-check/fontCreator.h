@@ -0,0 +1,118 @@
+/*--------------------------------------------------------------------------------------
+ fontCreator.h - reads a FontCreator font header (the src/fonts layout, see DMD32.h
+ FONT_*) as text, for the host tools that check and convert fonts.
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+
+struct FontFile
+{
+    std::string path;
+    std::string name;
+    std::vector<std::string> aliases; // #define X <name>
+    std::vector<uint8_t> data;
+    std::map<std::string, long> comment; // "Font height" -> -16
+};
+
+// Text of a file with comments blanked out
+static std::string stripComments(const std::string &s)
+{
+    std::string out = s;
+    for (size_t i = 0; i < out.size(); i++)
+    {
+        if (out.compare(i, 2, "//") == 0)
+            while (i < out.size() && out[i] != '\n')
+                out[i++] = ' ';
+        else if (out.compare(i, 2, "/*") == 0)
+        {
+            size_t end = out.find("*/", i + 2);
+            end = end == std::string::npos ? out.size() : end + 2;
+            for (; i < end; i++)
+                if (out[i] != '\n')
+                    out[i] = ' ';
+        }
+    }
+    return out;
+}
+
+static bool readText(const std::string &path, std::string &text)
+{
+    FILE *fp = fopen(path.c_str(), "r");
+    if (!fp)
+        return false;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        text.append(buf, n);
+    fclose(fp);
+    return true;
+}
+
+// The first `uint8_t name[] ... = { ... };` in a header
+static bool parseFont(const std::string &path, FontFile &font)
+{
+    std::string raw;
+    if (!readText(path, raw))
+        return false;
+    font.path = path;
+
+    // " * Font height         : -16"
+    size_t pos = 0;
+    while ((pos = raw.find("* Font ", pos)) != std::string::npos)
+    {
+        size_t colon = raw.find(':', pos);
+        size_t eol = raw.find('\n', pos);
+        if (colon != std::string::npos && colon < eol)
+        {
+            std::string key = raw.substr(pos + 2, colon - pos - 2);
+            key.erase(key.find_last_not_of(' ') + 1);
+            char *end;
+            long value = strtol(raw.c_str() + colon + 1, &end, 10);
+            if (end != raw.c_str() + colon + 1)
+                font.comment[key] = value;
+        }
+        pos = eol;
+    }
+
+    std::string text = stripComments(raw);
+    size_t bracket = text.find("[]");
+    size_t open = text.find('{', bracket);
+    size_t close = text.find('}', open);
+    if (bracket == std::string::npos || open == std::string::npos || close == std::string::npos)
+        return false;
+    size_t nameEnd = bracket;
+    while (nameEnd > 0 && text[nameEnd - 1] == ' ')
+        nameEnd--;
+    size_t nameStart = nameEnd;
+    while (nameStart > 0 && (isalnum((unsigned char)text[nameStart - 1]) || text[nameStart - 1] == '_'))
+        nameStart--;
+    font.name = text.substr(nameStart, nameEnd - nameStart);
+
+    for (size_t i = open + 1; i < close;)
+    {
+        if (!isdigit((unsigned char)text[i]))
+        {
+            i++;
+            continue;
+        }
+        const char *start = text.c_str() + i;
+        char *end;
+        long v = text.compare(i, 2, "0b") == 0 ? strtol(start + 2, &end, 2) : strtol(start, &end, 0);
+        font.data.push_back((uint8_t)v);
+        i += end - start;
+    }
+
+    // #define SystemFont5x7 System5x7
+    pos = 0;
+    while ((pos = text.find("#define ", pos)) != std::string::npos)
+    {
+        char alias[128], target[128];
+        if (sscanf(text.c_str() + pos, "#define %127s %127s", alias, target) == 2 && font.name == target &&
+            font.name != alias)
+            font.aliases.push_back(alias);
+        pos += 8;
+    }
+    return !font.data.empty();
+}
@@ -0,0 +1,533 @@
+/*--------------------------------------------------------------------------------------
+ font_check - validates the font headers in src/fonts, renders every glyph with the real
+ DMD::drawChar() into a glyph sheet, and reports what each font costs in flash.
+
+ Build (Linux, from the repository root):
+   g++ -std=gnu++17 -O2 -pthread -Ilib/NativeShims/include -Ilib/DMD32-main/src \
+       tools/font-check/font_check.cpp lib/DMD32-main/src/DMD32.cpp \
+       lib/NativeShims/src/arduino.cpp lib/NativeShims/src/freertos.cpp \
+       lib/NativeShims/src/sntp.cpp -o font_check
+
+ Run (from the repository root):
+   ./font_check                                  check every header in src/fonts against golden/
+   ./font_check --golden-dir /tmp/golden         compare glyph sheets with /tmp/golden/<Font>.pbm
+   ./font_check --png-dir /tmp/sheets             glyph sheets to look at
+   ./font_check --keep Font6x16=0123456789:       flash left if only those glyphs were kept
+   ./font_check src/fonts/Font6x16.h              just the files given
+
+ golden/ holds the glyph sheet of every font in src/fonts, and is where the sheets are
+ compared when --golden-dir is left out. Check them after a change to a font or to
+ DMD::drawChar(), and add --update when a font changed on purpose:
+   ./font_check --golden-dir tools/font-check/golden
+
+ The arrays are read from the header text (FontCreator layout, see DMD32.h FONT_*, or
+ the packed layout tools/font-compiler writes), so a font is checked exactly as written,
+ whether or not the firmware includes it.
+
+ Errors (exit status 1):
+   - the array is shorter than its header says (drawChar() reads past it)
+   - height 0 or over 32, fixed width 0, first char + count past 255
+   - a sparse packed font with a code point in a slot its hash does not pick
+ Warnings:
+   - trailing bytes after the last glyph
+   - the size field, or the "Font ... :" comment block, disagrees with the array
+   - a glyph with bits set below the font height: drawChar() draws one row more than
+     the height for fonts under 8 rows, so such a bit shows up on the panel
+   - blank glyphs other than space, and fonts nothing in src/ selects
+--------------------------------------------------------------------------------------*/
+#include <Arduino.h>
+#include <DMD32.h>
+#include <dirent.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "../frame-capture/frameImage.h"
+#include "fontCreator.h"
+
+#define SHEET_COLUMNS 16
+#define GLYPH_MAX_W 64 // the render canvas, DMD(2, 2)
+
+struct FontReport
+{
+    int errors = 0;
+    int warnings = 0;
+    bool fixed = false;
+    bool packed = false;     // tools/font-compiler layout
+    int rows = 0;            // packed: glyph cell rows
+    bool sparse = false;     // packed: hashed code points, first = hash bits, count = slots
+    int height = 0, first = 0, count = 0;
+    size_t declared = 0;     // bytes the header implies
+    size_t glyphBytes = 0;   // glyph data only
+    int blank = 0;           // empty glyphs other than space
+    bool referenced = false; // selected somewhere in src/
+};
+
+static DMD canvas(2, 2);
+
+// ------------------- Sources -------------------
+// Every .h/.cpp under `dir` except the fonts themselves, comments blanked
+static void collectSources(const std::string &dir, std::vector<std::string> &texts)
+{
+    DIR *d = opendir(dir.c_str());
+    if (!d)
+        return;
+    while (struct dirent *e = readdir(d))
+    {
+        std::string name = e->d_name;
+        if (name[0] == '.')
+            continue;
+        std::string path = dir + "/" + name;
+        if (e->d_type == DT_DIR)
+        {
+            if (name != "fonts")
+                collectSources(path, texts);
+        }
+        else if (name.size() > 2 && (name.rfind(".h") == name.size() - 2 || name.rfind(".cpp") == name.size() - 4))
+        {
+            std::string text;
+            if (!readText(path, text))
+                continue;
+            text = stripComments(text);
+            for (size_t pos = 0; (pos = text.find("#include", pos)) != std::string::npos;)
+                while (pos < text.size() && text[pos] != '\n')
+                    text[pos++] = ' '; // including a font is not using it
+            texts.push_back(text);
+        }
+    }
+    closedir(d);
+}
+
+// Is `word` used as an identifier in any of them?
+static bool usesIdentifier(const std::vector<std::string> &texts, const std::string &word)
+{
+    for (const std::string &t : texts)
+        for (size_t pos = t.find(word); pos != std::string::npos; pos = t.find(word, pos + 1))
+        {
+            bool before = pos > 0 && (isalnum((unsigned char)t[pos - 1]) || t[pos - 1] == '_');
+            size_t after = pos + word.size();
+            bool behind = after < t.size() && (isalnum((unsigned char)t[after]) || t[after] == '_');
+            if (!before && !behind)
+                return true;
+        }
+    return false;
+}
+
+// ------------------- Checks -------------------
+static void error(const FontFile &f, FontReport &r, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "%s: error: ", f.name.c_str());
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+    r.errors++;
+}
+
+static void warning(const FontFile &f, FontReport &r, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "%s: warning: ", f.name.c_str());
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+    r.warnings++;
+}
+
+// Code point of glyph `i`: table slot `i` of a sparse font (FONT_PACKED_NO_GLYPH if empty)
+static int codePoint(const FontFile &f, const FontReport &r, int i)
+{
+    if (!r.sparse)
+        return r.first + i;
+    size_t entry = ((f.data[FONT_PACKED_FLAGS] & FONT_PACKED_BBOX) ? 5 : 3) + 2;
+    size_t at = FONT_PACKED_HASH + 2 + i * entry;
+    return f.data[at] | f.data[at + 1] << 8;
+}
+
+static void appendUtf8(std::string &s, int c)
+{
+    if (c < 0x80)
+        s += (char)c;
+    else if (c < 0x800)
+        s += {(char)(0xC0 | c >> 6), (char)(0x80 | (c & 0x3F))};
+    else
+        s += {(char)(0xE0 | c >> 12), (char)(0x80 | (c >> 6 & 0x3F)), (char)(0x80 | (c & 0x3F))};
+}
+
+static int glyphWidth(const FontFile &f, const FontReport &r, int i)
+{
+    if (r.packed)
+        return DMD::codePointWidth(f.data.data(), codePoint(f, r, i));
+    return r.fixed ? f.data[FONT_FIXED_WIDTH] : f.data[FONT_WIDTH_TABLE + i];
+}
+
+// Bytes a compressed glyph's data takes (see DMD::decodeGlyph()); 0 if it runs past the array
+static size_t compressedBytes(const std::vector<uint8_t> &d, size_t start, bool rle, int pixels)
+{
+    if (!rle)
+        return start + (pixels + 7) / 8 <= d.size() ? (pixels + 7) / 8 : 0;
+    int done = 0;
+    size_t nibble = 0;
+    for (bool lit = false; done < pixels; nibble++)
+    {
+        if (start + nibble / 2 >= d.size())
+            return 0;
+        int run = nibble & 1 ? d[start + nibble / 2] >> 4 : d[start + nibble / 2] & 0x0F;
+        done += run;
+        if (run != 15)
+            lit = !lit;
+    }
+    return (nibble + 1) / 2;
+}
+
+// Packed font (FONT_PACKED_*): table and glyph data inside the array
+static bool checkPacked(const FontFile &f, FontReport &r)
+{
+    const std::vector<uint8_t> &d = f.data;
+    r.packed = true;
+    if (d.size() < FONT_PACKED_TABLE)
+    {
+        error(f, r, "%zu bytes, shorter than the 8-byte packed header", d.size());
+        return false;
+    }
+    r.height = d[FONT_HEIGHT];
+    r.first = d[FONT_FIRST_CHAR];
+    r.count = d[FONT_CHAR_COUNT];
+    r.rows = d[FONT_PACKED_ROWS];
+    r.sparse = d[FONT_PACKED_FLAGS] & FONT_PACKED_SPARSE;
+    if (r.rows == 0 || r.rows > 32)
+        error(f, r, "%d rows", r.rows);
+    if (r.sparse && (r.first < 1 || r.first > 7 || r.count != 1 << r.first))
+        error(f, r, "%d hash slots for %d hash bits", r.count, r.first);
+    else if (!r.sparse && r.first + r.count > 256)
+        error(f, r, "chars 0x%02x + %d run past 0xff", r.first, r.count);
+    size_t entry = (d[FONT_PACKED_FLAGS] & FONT_PACKED_BBOX) ? 5 : 3;
+    bool compressed = d[FONT_PACKED_FLAGS] & FONT_PACKED_COMPRESSED;
+    size_t table = r.sparse ? FONT_PACKED_HASH + 2 : FONT_PACKED_TABLE;
+    size_t data = table + r.count * (entry + (r.sparse ? 2 : 0));
+    if (r.errors || d.size() < data)
+    {
+        error(f, r, "glyph table needs %zu bytes, array has %zu", data, d.size());
+        return false;
+    }
+    size_t end = data;
+    for (int i = 0; i < r.count; i++)
+    {
+        const uint8_t *e = &d[table + i * (entry + (r.sparse ? 2 : 0))];
+        if (r.sparse)
+        {
+            int c = e[0] | e[1] << 8;
+            e += 2;
+            // a code point in another slot than its hash picks is never found
+            if (c != FONT_PACKED_NO_GLYPH && DMD::codePointWidth(d.data(), c) != e[2])
+                error(f, r, "char 0x%02x in slot %d, hashed elsewhere", c, i);
+        }
+        size_t cols = entry == 5 ? e[4] : e[2];
+        if (entry == 5 && e[3] + e[4] > e[2])
+            error(f, r, "char 0x%02x stores columns %d..%d of %d", codePoint(f, r, i), e[3], e[3] + e[4] - 1, e[2]);
+        if (e[2] > GLYPH_MAX_W)
+            error(f, r, "char 0x%02x is %d columns wide", codePoint(f, r, i), e[2]);
+        size_t offset = e[0] | e[1] << 8;
+        if (!compressed)
+        {
+            end = std::max(end, data + offset + cols * ((r.rows + 7) / 8));
+            continue;
+        }
+        if (!cols)
+            continue;
+        if (cols * ((r.rows + 7) / 8) > GLYPH_CACHE_BYTES)
+            error(f, r, "char 0x%02x decodes to more than GLYPH_CACHE_BYTES, drawChar() skips it",
+                  codePoint(f, r, i));
+        offset &= ~FONT_PACKED_RLE;
+        size_t bytes = compressedBytes(d, data + offset, e[1] & 0x80, cols * r.rows);
+        if (!bytes)
+            error(f, r, "char 0x%02x: compressed data runs past the array", codePoint(f, r, i));
+        end = std::max(end, data + offset + bytes);
+    }
+    r.glyphBytes = end - data;
+    r.declared = end;
+    if (d.size() < r.declared)
+        error(f, r, "glyph data ends at %zu bytes, array has %zu (drawChar() reads past it)", r.declared, d.size());
+    else if (d.size() > r.declared)
+        warning(f, r, "%zu bytes after the last glyph", d.size() - r.declared);
+    return r.errors == 0;
+}
+
+// Header and table checks; false if glyphs cannot be drawn safely
+static bool checkHeader(const FontFile &f, FontReport &r)
+{
+    const std::vector<uint8_t> &d = f.data;
+    if (d.size() < FONT_WIDTH_TABLE)
+    {
+        error(f, r, "%zu bytes, shorter than the 6-byte header", d.size());
+        return false;
+    }
+    if (DMD::isPackedFont(d.data()))
+        return checkPacked(f, r);
+    r.fixed = d[FONT_LENGTH] == 0 && d[FONT_LENGTH + 1] == 0;
+    r.height = d[FONT_HEIGHT];
+    r.first = d[FONT_FIRST_CHAR];
+    r.count = d[FONT_CHAR_COUNT];
+    if (r.height == 0 || r.height > 32)
+        error(f, r, "height %d", r.height);
+    if (r.first + r.count > 256)
+        error(f, r, "chars 0x%02x + %d run past 0xff", r.first, r.count);
+    if (r.fixed && d[FONT_FIXED_WIDTH] == 0)
+        error(f, r, "fixed width 0");
+    if (!r.fixed && d.size() < (size_t)FONT_WIDTH_TABLE + r.count)
+    {
+        error(f, r, "width table needs %d entries, array ends after %zu", r.count, d.size() - FONT_WIDTH_TABLE);
+        return false;
+    }
+
+    size_t bytes = (r.height + 7) / 8;
+    size_t columns = 0;
+    for (int i = 0; i < r.count; i++)
+    {
+        int w = glyphWidth(f, r, i);
+        if (w > GLYPH_MAX_W)
+            error(f, r, "char 0x%02x is %d columns wide", r.first + i, w);
+        columns += w;
+    }
+    r.glyphBytes = columns * bytes;
+    r.declared = FONT_WIDTH_TABLE + (r.fixed ? 0 : r.count) + r.glyphBytes;
+    if (d.size() < r.declared)
+        error(f, r, "header implies %zu bytes, array has %zu (drawChar() reads past it)", r.declared, d.size());
+    else if (d.size() > r.declared)
+        warning(f, r, "%zu bytes after the last glyph", d.size() - r.declared);
+
+    size_t sizeField = (d[FONT_LENGTH] << 8) | d[FONT_LENGTH + 1];
+    if (!r.fixed && sizeField != d.size())
+        warning(f, r, "size field says %zu bytes, array has %zu", sizeField, d.size());
+
+    // The FontCreator comment block
+    auto says = [&](const char *key, long actual) {
+        auto it = f.comment.find(key);
+        if (it != f.comment.end() && labs(it->second) != actual) // FontCreator writes some heights negative
+            warning(f, r, "comment \"%s: %ld\", font has %ld", key, it->second, actual);
+    };
+    says("Font size in bytes", d.size());
+    says("Font height", r.height);
+    says("Font first char", r.first);
+    says("Font last char", r.first + r.count - 1);
+    return r.errors == 0;
+}
+
+// Rows drawChar() draws: one past the height for single-byte fonts (`offset + k <= height`)
+static int drawnRows(const FontReport &r)
+{
+    if (r.packed)
+        return r.rows;
+    return r.height < 8 ? r.height + 1 : r.height;
+}
+
+// Draw glyph `i` with the firmware's renderer
+static Frame drawGlyph(const FontFile &f, const FontReport &r, int i)
+{
+    canvas.clearScreen(true);
+    canvas.selectFont(f.data.data());
+    canvas.drawCodePoint(0, 0, codePoint(f, r, i), GRAPHICS_NORMAL);
+    Frame all = frameFromDmd(canvas.shownFrame(), 2, 2);
+    Frame g;
+    g.width = glyphWidth(f, r, i);
+    g.height = drawnRows(r);
+    g.lit.resize(g.width * g.height);
+    for (int y = 0; y < g.height; y++)
+        for (int x = 0; x < g.width; x++)
+            g.lit[y * g.width + x] = all.at(x, y);
+    return g;
+}
+
+// Every glyph as the panel shows it, SHEET_COLUMNS to a row, one blank pixel between cells
+static Frame checkGlyphs(const FontFile &f, FontReport &r)
+{
+    int cellW = 1, cellH = drawnRows(r) + 1;
+    for (int i = 0; i < r.count; i++)
+        cellW = std::max(cellW, glyphWidth(f, r, i) + 1);
+    Frame sheet;
+    sheet.width = SHEET_COLUMNS * cellW - 1;
+    sheet.height = (r.count + SHEET_COLUMNS - 1) / SHEET_COLUMNS * cellH - 1;
+    sheet.lit.assign(sheet.width * sheet.height, 0);
+
+    std::string spill, blank;
+    for (int i = 0; i < r.count; i++)
+    {
+        Frame g = drawGlyph(f, r, i);
+        int c = codePoint(f, r, i);
+        std::string name;
+        appendUtf8(name, c);
+        bool any = false;
+        for (int y = 0; y < g.height; y++)
+            for (int x = 0; x < g.width; x++)
+            {
+                if (!g.at(x, y))
+                    continue;
+                any = true;
+                if (y >= r.height && spill.find(name) == std::string::npos)
+                    spill += name;
+                int sx = (i % SHEET_COLUMNS) * cellW + x, sy = (i / SHEET_COLUMNS) * cellH + y;
+                sheet.lit[sy * sheet.width + sx] = 1;
+            }
+        if (!any && c != ' ' && !(r.packed && g.width == 0)) // packed: chars not kept
+        {
+            blank += name;
+            r.blank++;
+        }
+    }
+    if (!spill.empty())
+        warning(f, r, "row %d (below the height) is set and drawn in \"%s\"", r.height, spill.c_str());
+    if (!blank.empty())
+        warning(f, r, "%d blank glyphs: \"%s\"", r.blank, blank.c_str());
+    return sheet;
+}
+
+// Bytes left if only the range covering `keep` stayed in the font
+static size_t trimmedSize(const FontFile &f, const FontReport &r, const std::string &keep)
+{
+    int lo = 255, hi = 0;
+    for (unsigned char c : keep)
+        if (c >= r.first && c < r.first + r.count)
+        {
+            lo = std::min<int>(lo, c);
+            hi = std::max<int>(hi, c);
+        }
+    if (lo > hi)
+        return FONT_WIDTH_TABLE;
+    size_t bytes = (r.height + 7) / 8, columns = 0;
+    for (int c = lo; c <= hi; c++)
+        columns += glyphWidth(f, r, c - r.first);
+    return FONT_WIDTH_TABLE + (r.fixed ? 0 : hi - lo + 1) + columns * bytes;
+}
+
+// ------------------- Main -------------------
+static void listFonts(const std::string &dir, std::vector<std::string> &paths)
+{
+    DIR *d = opendir(dir.c_str());
+    if (!d)
+        return;
+    while (struct dirent *e = readdir(d))
+    {
+        std::string name = e->d_name;
+        if (name.size() > 2 && name.rfind(".h") == name.size() - 2)
+            paths.push_back(dir + "/" + name);
+    }
+    closedir(d);
+    std::sort(paths.begin(), paths.end());
+}
+
+int main(int argc, char **argv)
+{
+    const char *goldenDir = "tools/font-check/golden", *pngDir = nullptr, *srcDir = "src";
+    bool update = false;
+    std::map<std::string, std::string> keep;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--update")
+            update = true;
+        else if (arg == "--golden-dir" && i + 1 < argc)
+            goldenDir = argv[++i];
+        else if (arg == "--png-dir" && i + 1 < argc)
+            pngDir = argv[++i];
+        else if (arg == "--src" && i + 1 < argc)
+            srcDir = argv[++i];
+        else if (arg == "--keep" && i + 1 < argc)
+        {
+            std::string spec = argv[++i];
+            size_t eq = spec.find('=');
+            if (eq == std::string::npos)
+            {
+                fprintf(stderr, "--keep Font=chars\n");
+                return 2;
+            }
+            keep[spec.substr(0, eq)] = spec.substr(eq + 1);
+        }
+        else if (arg[0] == '-')
+        {
+            fprintf(stderr,
+                    "usage: %s [--golden-dir dir [--update]] [--png-dir dir] [--keep Font=chars] [--src dir] "
+                    "[font.h...]\n",
+                    argv[0]);
+            return 2;
+        }
+        else
+            paths.push_back(arg);
+    }
+    if (paths.empty())
+        listFonts(std::string(srcDir) + "/fonts", paths);
+    std::vector<std::string> sources;
+    collectSources(srcDir, sources);
+
+    printf("%-14s %-6s %6s %-9s %6s %6s %9s %9s %6s\n", "font", "kind", "height", "chars", "glyphs", "blank",
+           "bytes/gl", "flash", "used");
+    int errors = 0, mismatches = 0;
+    size_t flashAll = 0, flashUsed = 0;
+    for (const std::string &path : paths)
+    {
+        FontFile f;
+        FontReport r;
+        if (!parseFont(path, f))
+        {
+            fprintf(stderr, "%s: no font array found\n", path.c_str());
+            errors++;
+            continue;
+        }
+        r.referenced = usesIdentifier(sources, f.name);
+        for (const std::string &a : f.aliases)
+            r.referenced = r.referenced || usesIdentifier(sources, a);
+        if (!r.referenced)
+            warning(f, r, "not used anywhere in %s", srcDir);
+
+        bool drawable = checkHeader(f, r);
+        Frame sheet;
+        if (drawable)
+            sheet = checkGlyphs(f, r);
+        errors += r.errors;
+
+        char chars[16];
+        if (r.sparse)
+            snprintf(chars, sizeof(chars), "hashed");
+        else
+            snprintf(chars, sizeof(chars), "%02x-%02x", r.first, r.first + r.count - 1);
+        printf("%-14s %-6s %6d %-9s %6d %6d %9.1f %9zu %6s\n", f.name.c_str(), r.packed ? "packed" : r.fixed ? "fixed" : "var", r.height,
+               chars, r.count, r.blank, r.count ? (double)r.glyphBytes / r.count : 0.0, f.data.size(),
+               r.referenced ? "yes" : "no");
+        flashAll += f.data.size();
+        if (r.referenced)
+            flashUsed += f.data.size();
+        auto k = keep.find(f.name);
+        if (k != keep.end() && drawable && !r.packed)
+            printf("%-14s keeping \"%s\": %zu bytes, saves %zu\n", "", k->second.c_str(),
+                   trimmedSize(f, r, k->second), f.data.size() - trimmedSize(f, r, k->second));
+
+        if (!drawable)
+            continue;
+        if (pngDir && !writePng((std::string(pngDir) + "/" + f.name + ".png").c_str(), sheet, 8))
+            perror(pngDir);
+        std::string golden = std::string(goldenDir) + "/" + f.name + ".pbm";
+        Frame expected;
+        if (update)
+        {
+            if (!writePbm(golden.c_str(), sheet))
+            {
+                perror(golden.c_str());
+                errors++;
+            }
+        }
+        else if (!readPbm(golden.c_str(), expected))
+        {
+            fprintf(stderr, "%s: no golden sheet %s\n", f.name.c_str(), golden.c_str());
+            mismatches++;
+        }
+        else if (expected != sheet)
+        {
+            fprintf(stderr, "%s: glyph sheet differs from %s\nexpected:\n%sgot:\n%s", f.name.c_str(), golden.c_str(),
+                    frameText(expected).c_str(), frameText(sheet).c_str());
+            mismatches++;
+        }
+    }
+    printf("flash: %zu bytes in all fonts, %zu in the ones src/ uses\n", flashAll, flashUsed);
+    return errors || mismatches ? 1 : 0;
+}
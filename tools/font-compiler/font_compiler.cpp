@@ -0,0 +1,996 @@
+/*--------------------------------------------------------------------------------------
+ font_compiler - converts a BDF font, a TTF/OTF font or a FontCreator header into a
+ packed DMD32 font header (FONT_PACKED_*, see DMD32.h), keeping only the glyphs asked
+ for. The packed layout is what drawPackedChar() wants: a glyph table with each glyph's
+ data offset, so finding a glyph is O(1) instead of summing the width table, column
+ masks a glyph cell high, and optionally each glyph's stored column range, so empty
+ columns cost neither flash nor drawing time, and compressed glyph data. Fonts with
+ code points past 0xFF (Bengali digits for UTF-8 text) are sparse: the table is a perfect
+ hash of the kept code points, so a lookup is still one multiply and one compare.
+
+ Build (Linux, from the repository root):
+   g++ -std=gnu++17 -O2 -pthread -Ilib/NativeShims/include -Ilib/DMD32-main/src -Isrc \
+       tools/font-compiler/font_compiler.cpp lib/DMD32-main/src/DMD32.cpp \
+       lib/NativeShims/src/arduino.cpp lib/NativeShims/src/freertos.cpp \
+       lib/NativeShims/src/sntp.cpp -o font_compiler
+ TTF/OTF input needs FreeType; add:
+       -DFONTC_FREETYPE $(pkg-config --cflags --libs freetype2)
+
+ Run:
+   ./font_compiler clock.bdf --chars "0-9:" --name ClockDigits -o src/fonts/ClockDigits.h
+   ./font_compiler Lato-Regular.ttf --size 16 --chars "0-9:" --trim --bbox -o src/fonts/Lato16.h
+   ./font_compiler src/fonts/Font5x7Nbox.h --bbox -o src/fonts/Font5x7NboxP.h
+   ./font_compiler src/fonts/Bangla8.bdf -o src/fonts/Bangla8.h
+   ./font_compiler --compare --chars "0-9:" src/fonts/SystemFont5x7.h src/fonts/Font5x7Nbox.h
+
+   --chars SET   glyphs to keep: characters, a-b for a range ("0-9:APM", "--" for '-' itself),
+                 UTF-8 or U+XXXX past 0x7e ("U+09E6-U+09EF"); default 0x20..0x7e, every
+                 glyph of a FontCreator font, or every glyph of a BDF with code points past 0xFF
+   --name NAME   array name (default from the file name)
+   --size PX     pixel size for TTF/OTF (default 16)
+   --bbox        store each glyph's column range, skip empty columns
+   --compress    store each glyph bit-packed or as nibble runs, whichever is smaller;
+                 drawChar() decodes into a small LRU cache in RAM (GLYPH_CACHE_*)
+   --trim        drop rows no kept glyph uses (TTF/BDF cells include accents and descenders)
+   --sparse      hashed code point table even if every glyph is under 0x100 (automatic past it)
+   -o FILE       output header (default stdout)
+   --compare     for FontCreator headers: check that the packed conversions draw exactly
+                 what the original draws, then compare flash and drawString() speed;
+                 with --chars, also the flash of just those glyphs packed
+
+ BDF and TTF advances are the ink width: drawString() puts one blank column between
+ characters itself. Space is not stored; its advance goes in the header. A converted
+ FontCreator font keeps drawChar()'s quirks (space as wide as 'n', one row past the
+ height for fonts under 8 rows), so it can replace the original without moving a pixel.
+ Every glyph of the output is drawn back with the real drawChar() before it is written.
+--------------------------------------------------------------------------------------*/
+#include <Arduino.h>
+#include <DMD32.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "../frame-capture/frameImage.h"
+#include "../font-check/fontCreator.h"
+#ifdef FONTC_FREETYPE
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#endif
+
+#define MAX_ROWS 32       // column masks are uint32_t
+#define MAX_ADVANCE 64    // the verify canvas, DMD(2, 2)
+#define DEFAULT_SIZE 16
+#define COMPARE_MIN_MS 200
+#define MAX_SLOTS_BITS 7  // FONT_CHAR_COUNT is a byte, drawPackedChar() takes the slot as one
+
+static DMD canvas(2, 2);
+
+struct Glyph
+{
+    int advance = 0;
+    std::vector<uint32_t> cols; // advance masks, bit 0 = top row
+};
+
+struct SourceFont
+{
+    std::string source;       // description for the header comment
+    int height = 0;           // FONT_HEIGHT
+    int rows = 0;             // glyph cell rows
+    int space = 0;            // advance of ' '
+    std::map<int, Glyph> glyphs;
+};
+
+// ------------------- Sources -------------------
+static std::string fileName(const std::string &path)
+{
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// Glyph from pixels: `ink(x, y)` for x < width, y < rows; advance = ink width unless given
+template <typename Ink>
+static Glyph makeGlyph(int width, int rows, Ink ink, int advance = -1)
+{
+    Glyph g;
+    std::vector<uint32_t> cols(width, 0);
+    int right = 0;
+    for (int x = 0; x < width; x++)
+        for (int y = 0; y < rows; y++)
+            if (ink(x, y))
+            {
+                cols[x] |= 1u << y;
+                right = x + 1;
+            }
+    g.advance = advance >= 0 ? advance : right;
+    cols.resize(g.advance, 0);
+    g.cols = cols;
+    return g;
+}
+
+// FontCreator header, drawn glyph by glyph with the real drawChar()
+static bool loadFontCreator(const std::string &path, SourceFont &font, std::string &name)
+{
+    FontFile f;
+    if (!parseFont(path, f) || f.data.size() < FONT_WIDTH_TABLE)
+        return false;
+    name = f.name;
+    const uint8_t *d = f.data.data();
+    font.source = fileName(path);
+    font.height = d[FONT_HEIGHT];
+    font.rows = font.height < 8 ? font.height + 1 : font.height; // rows drawChar() draws
+    if (font.height == 0 || font.rows > MAX_ROWS)
+        return false;
+    font.space = DMD::charWidth(d, ' ');
+    canvas.selectFont(d);
+    for (int c = d[FONT_FIRST_CHAR]; c < d[FONT_FIRST_CHAR] + d[FONT_CHAR_COUNT] && c < 256; c++)
+    {
+        if (c == ' ')
+            continue;
+        int width = DMD::charWidth(d, c);
+        if (width > MAX_ADVANCE)
+            return false;
+        canvas.clearScreen(true);
+        canvas.drawChar(0, 0, c, GRAPHICS_NORMAL);
+        Frame all = frameFromDmd(canvas.shownFrame(), 2, 2);
+        font.glyphs[c] = makeGlyph(width, font.rows, [&](int x, int y) { return all.at(x, y); }, width);
+    }
+    return true;
+}
+
+// Glyph BITMAP rows (hex, MSB first) placed on the cell: origin column `x0`, top row `y0`
+static Glyph bdfGlyph(const std::vector<std::string> &bitmap, int w, int x0, int y0, int rows, int dwidth)
+{
+    int width = std::max(0, x0 + w);
+    auto ink = [&](int x, int y) {
+        int bx = x - x0, by = y - y0;
+        if (bx < 0 || bx >= w || by < 0 || by >= (int)bitmap.size())
+            return false;
+        const std::string &hex = bitmap[by];
+        if ((size_t)(bx / 4) >= hex.size())
+            return false;
+        int nibble = strtol(hex.substr(bx / 4, 1).c_str(), nullptr, 16);
+        return (nibble & (8 >> (bx % 4))) != 0;
+    };
+    Glyph g = makeGlyph(width, rows, ink);
+    if (g.advance == 0)
+        g.advance = std::max(1, dwidth - 1);
+    g.cols.resize(g.advance, 0);
+    return g;
+}
+
+static bool loadBdf(const std::string &path, SourceFont &font)
+{
+    std::string text;
+    if (!readText(path, text))
+        return false;
+    int ascent = -1, descent = -1, fbbH = 0, fbbY = 0, space = -1;
+    bool haveBox = false;
+    std::vector<std::pair<int, std::vector<std::string>>> chars; // encoding, lines STARTCHAR..ENDCHAR
+    std::vector<std::string> current;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string::npos)
+            eol = text.size();
+        std::string line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        int a, b, c, d;
+        if (sscanf(line.c_str(), "FONTBOUNDINGBOX %d %d %d %d", &a, &b, &c, &d) == 4)
+        {
+            fbbH = b;
+            fbbY = d;
+            haveBox = true;
+        }
+        else if (sscanf(line.c_str(), "FONT_ASCENT %d", &a) == 1)
+            ascent = a;
+        else if (sscanf(line.c_str(), "FONT_DESCENT %d", &a) == 1)
+            descent = a;
+        else if (line.compare(0, 9, "STARTCHAR") == 0)
+            current.assign(1, line);
+        else if (!current.empty())
+        {
+            current.push_back(line);
+            if (line == "ENDCHAR")
+            {
+                int encoding = -1;
+                for (const std::string &l : current)
+                    sscanf(l.c_str(), "ENCODING %d", &encoding);
+                if (encoding >= 0 && encoding < FONT_PACKED_NO_GLYPH)
+                    chars.push_back({encoding, current});
+                current.clear();
+            }
+        }
+    }
+    if (ascent < 0 || descent < 0)
+    {
+        if (!haveBox)
+            return false;
+        ascent = fbbH + fbbY;
+        descent = -fbbY;
+    }
+    font.source = fileName(path);
+    font.rows = font.height = ascent + descent;
+    if (font.rows <= 0 || font.rows > MAX_ROWS)
+        return false;
+
+    for (auto &ch : chars)
+    {
+        int dwidth = 0, w = 0, h = 0, xoff = 0, yoff = 0;
+        std::vector<std::string> bitmap;
+        bool inBitmap = false;
+        for (const std::string &l : ch.second)
+        {
+            if (inBitmap && l != "ENDCHAR")
+                bitmap.push_back(l);
+            else if (l == "BITMAP")
+                inBitmap = true;
+            else
+            {
+                sscanf(l.c_str(), "DWIDTH %d", &dwidth);
+                sscanf(l.c_str(), "BBX %d %d %d %d", &w, &h, &xoff, &yoff);
+            }
+        }
+        bitmap.resize(h);
+        if (ch.first == ' ')
+        {
+            space = std::max(1, dwidth - 1);
+            continue;
+        }
+        // BBX y offset is from the baseline up to the bottom of the bitmap
+        Glyph g = bdfGlyph(bitmap, w, std::max(0, xoff), ascent - (yoff + h), font.rows, dwidth);
+        if (g.advance > MAX_ADVANCE)
+            return false;
+        font.glyphs[ch.first] = g;
+    }
+    font.space = space >= 0 ? space : (font.glyphs.count('n') ? font.glyphs['n'].advance : font.rows / 3);
+    return true;
+}
+
+#ifdef FONTC_FREETYPE
+static bool loadTtf(const std::string &path, int size, const std::vector<bool> &keep, SourceFont &font)
+{
+    FT_Library lib;
+    FT_Face face;
+    if (FT_Init_FreeType(&lib))
+        return false;
+    if (FT_New_Face(lib, path.c_str(), 0, &face))
+    {
+        FT_Done_FreeType(lib);
+        return false;
+    }
+    FT_Set_Pixel_Sizes(face, 0, size);
+    int ascent = (face->size->metrics.ascender + 63) >> 6;
+    int descent = (-face->size->metrics.descender + 63) >> 6;
+    font.source = fileName(path) + " at " + std::to_string(size) + " px";
+    font.rows = font.height = ascent + descent;
+    bool ok = font.rows > 0 && font.rows <= MAX_ROWS;
+    for (int c = 0x20; ok && c < FONT_PACKED_NO_GLYPH; c++)
+    {
+        if (!keep[c] && c != 'n')
+            continue;
+        FT_UInt index = FT_Get_Char_Index(face, c);
+        if (!index || FT_Load_Glyph(face, index, FT_LOAD_RENDER | FT_LOAD_TARGET_MONO))
+            continue;
+        FT_GlyphSlot slot = face->glyph;
+        const FT_Bitmap &bm = slot->bitmap;
+        int dwidth = (slot->advance.x + 32) >> 6;
+        if (c == ' ')
+        {
+            font.space = std::max(1, dwidth - 1);
+            continue;
+        }
+        int x0 = std::max(0, slot->bitmap_left), y0 = ascent - slot->bitmap_top;
+        auto ink = [&](int x, int y) {
+            int bx = x - x0, by = y - y0;
+            if (bx < 0 || bx >= (int)bm.width || by < 0 || by >= (int)bm.rows)
+                return false;
+            return (bm.buffer[by * bm.pitch + bx / 8] & (0x80 >> (bx % 8))) != 0;
+        };
+        Glyph g = makeGlyph(x0 + bm.width, font.rows, ink);
+        if (g.advance == 0)
+            g.advance = std::max(1, dwidth - 1);
+        g.cols.resize(g.advance, 0);
+        if (g.advance > MAX_ADVANCE)
+            ok = false;
+        font.glyphs[c] = g;
+    }
+    if (!font.space)
+        font.space = font.glyphs.count('n') ? font.glyphs['n'].advance : size / 4;
+    FT_Done_Face(face);
+    FT_Done_FreeType(lib);
+    return ok;
+}
+#endif
+
+// "0-9:" -> {'0'..'9', ':'}; "--" is '-' itself; UTF-8 or U+XXXX for any code point
+static bool parseChars(const std::string &spec, std::vector<bool> &keep)
+{
+    std::vector<int> cps;
+    for (int i = 0; i < (int)spec.size();)
+    {
+        int digits = 0;
+        while (digits < 4 && i + 2 + digits < (int)spec.size() && isxdigit((unsigned char)spec[i + 2 + digits]))
+            digits++;
+        if (spec.compare(i, 2, "U+") == 0 && digits)
+        {
+            cps.push_back(strtol(spec.substr(i + 2, digits).c_str(), nullptr, 16));
+            i += 2 + digits;
+        }
+        else
+        {
+            int n = 0;
+            cps.push_back(DMD::nextCodePoint(spec.c_str() + i, std::min<int>(spec.size() - i, 255), &n));
+            i += n;
+        }
+    }
+    keep.assign(0x10000, false);
+    for (size_t i = 0; i < cps.size(); i++)
+    {
+        int a = cps[i];
+        if (i + 2 < cps.size() && cps[i + 1] == '-')
+        {
+            int b = cps[i + 2];
+            if (b < a)
+                return false;
+            for (int c = a; c <= b; c++)
+                keep[c] = true;
+            i += 2;
+        }
+        else if (a == '-' && i + 1 < cps.size() && cps[i + 1] == '-')
+        {
+            keep['-'] = true;
+            i++;
+        }
+        else
+            keep[a] = true;
+    }
+    keep[FONT_PACKED_NO_GLYPH] = false;
+    return true;
+}
+
+// Drop rows no glyph uses, top and bottom
+static void trimRows(SourceFont &font)
+{
+    uint32_t used = 0;
+    for (auto &g : font.glyphs)
+        for (uint32_t m : g.second.cols)
+            used |= m;
+    if (!used)
+        return;
+    int top = __builtin_ctz(used), bottom = 31 - __builtin_clz(used);
+    for (auto &g : font.glyphs)
+        for (uint32_t &m : g.second.cols)
+            m >>= top;
+    font.rows = font.height = bottom - top + 1;
+}
+
+// ------------------- Packing -------------------
+struct Packed
+{
+    std::vector<uint8_t> bytes;
+    int first = 0, count = 0, stored = 0; // sparse: first = hash bits, count = slots
+    bool sparse = false;
+    std::vector<int> codes; // code point of each table entry, -1 for an empty slot
+    int tooBig = 0; // compressed glyphs over GLYPH_CACHE_BYTES decoded, drawChar() skips them
+};
+
+// Pixels of columns [left, left + cols) in DMD::decodeGlyph() order
+static std::vector<bool> glyphBits(const Glyph &g, int left, int cols, int rows)
+{
+    std::vector<bool> bits;
+    for (int j = left; j < left + cols; j++)
+        for (int y = 0; y < rows; y++)
+            bits.push_back(g.cols[j] >> y & 1);
+    return bits;
+}
+
+static std::vector<uint8_t> bitPacked(const std::vector<bool> &bits)
+{
+    std::vector<uint8_t> out((bits.size() + 7) / 8, 0);
+    for (size_t i = 0; i < bits.size(); i++)
+        if (bits[i])
+            out[i / 8] |= 1 << (i % 8);
+    return out;
+}
+
+// Alternating unlit/lit runs, a nibble each; 15 continues the run
+static std::vector<uint8_t> nibbleRuns(const std::vector<bool> &bits)
+{
+    std::vector<uint8_t> nibbles;
+    bool lit = false;
+    for (size_t i = 0; i < bits.size();)
+    {
+        size_t run = 0;
+        while (i + run < bits.size() && bits[i + run] == lit)
+            run++;
+        i += run;
+        for (; run >= 15; run -= 15)
+            nibbles.push_back(15);
+        nibbles.push_back(run);
+        lit = !lit;
+    }
+    std::vector<uint8_t> out((nibbles.size() + 1) / 2, 0);
+    for (size_t i = 0; i < nibbles.size(); i++)
+        out[i / 2] |= nibbles[i] << (i % 2 ? 4 : 0);
+    return out;
+}
+
+// Fewest slots (1 << bits) and an odd multiplier that put every code point in a slot of its
+// own with DMD::packedGlyphIndex()'s hash
+static bool findHash(const std::vector<int> &codes, int &bits, int &multiplier)
+{
+    for (bits = 1; bits <= MAX_SLOTS_BITS; bits++)
+    {
+        if ((1 << bits) < (int)codes.size())
+            continue;
+        for (multiplier = 1; multiplier < 0x10000; multiplier += 2)
+        {
+            std::vector<bool> used(1 << bits, false);
+            bool unique = true;
+            for (int c : codes)
+            {
+                int slot = (uint16_t)((uint32_t)c * multiplier) >> (16 - bits);
+                if (used[slot])
+                {
+                    unique = false;
+                    break;
+                }
+                used[slot] = true;
+            }
+            if (unique)
+                return true;
+        }
+    }
+    return false;
+}
+
+static Packed pack(const SourceFont &font, bool bbox, bool compress = false, bool sparse = false)
+{
+    Packed p;
+    p.first = 255;
+    int last = 0;
+    for (auto &g : font.glyphs)
+    {
+        p.first = std::min(p.first, g.first);
+        last = std::max(last, g.first);
+    }
+    if (font.glyphs.empty())
+        p.first = last = ' ';
+    p.sparse = sparse || last > 0xFF;
+    int bytesPerColumn = (font.rows + 7) / 8;
+    int entrySize = (bbox ? 5 : 3) + (p.sparse ? 2 : 0);
+    int multiplier = 0;
+    if (p.sparse)
+    {
+        std::vector<int> kept;
+        for (auto &g : font.glyphs)
+            kept.push_back(g.first);
+        if (!findHash(kept, p.first, multiplier))
+            return p;
+        p.count = 1 << p.first;
+        p.codes.assign(p.count, -1);
+        for (int c : kept)
+            p.codes[(uint16_t)((uint32_t)c * multiplier) >> (16 - p.first)] = c;
+    }
+    else
+    {
+        p.count = last - p.first + 1;
+        for (int c = p.first; c <= last; c++)
+            p.codes.push_back(c);
+    }
+
+    std::vector<uint8_t> table, data;
+    std::map<std::pair<std::vector<uint8_t>, int>, int> seen; // identical glyph data is stored once
+    for (int c : p.codes)
+    {
+        auto it = font.glyphs.find(c);
+        int advance = 0, left = 0, cols = 0;
+        if (it != font.glyphs.end())
+        {
+            const Glyph &g = it->second;
+            advance = cols = g.advance;
+            if (bbox)
+            {
+                while (cols > 0 && !g.cols[cols - 1])
+                    cols--;
+                while (left < cols && !g.cols[left])
+                    left++;
+                cols -= left;
+            }
+            if (cols)
+                p.stored++;
+        }
+        std::vector<uint8_t> glyph;
+        int rle = 0;
+        if (compress && cols)
+        {
+            // whichever is smaller for this glyph
+            std::vector<bool> bits = glyphBits(it->second, left, cols, font.rows);
+            glyph = bitPacked(bits);
+            std::vector<uint8_t> runs = nibbleRuns(bits);
+            if (runs.size() < glyph.size())
+            {
+                glyph = runs;
+                rle = FONT_PACKED_RLE;
+            }
+            if (cols * bytesPerColumn > GLYPH_CACHE_BYTES)
+                p.tooBig++;
+        }
+        else
+            for (int j = left; j < left + cols; j++)
+                for (int b = 0; b < bytesPerColumn; b++)
+                    glyph.push_back(it->second.cols[j] >> (8 * b));
+        int offset = 0;
+        if (!glyph.empty())
+        {
+            auto s = seen.find({glyph, rle});
+            if (s != seen.end())
+                offset = s->second;
+            else
+            {
+                offset = seen[{glyph, rle}] = (int)data.size();
+                data.insert(data.end(), glyph.begin(), glyph.end());
+            }
+            offset |= rle;
+        }
+        if (p.sparse)
+        {
+            int code = c < 0 ? FONT_PACKED_NO_GLYPH : c;
+            table.push_back(code & 0xFF);
+            table.push_back(code >> 8);
+        }
+        table.push_back(offset & 0xFF);
+        table.push_back(offset >> 8);
+        table.push_back(advance);
+        if (bbox)
+        {
+            table.push_back(left);
+            table.push_back(cols);
+        }
+    }
+    uint8_t flags = (bbox ? FONT_PACKED_BBOX : 0) | (compress ? FONT_PACKED_COMPRESSED : 0) |
+                    (p.sparse ? FONT_PACKED_SPARSE : 0);
+    p.bytes = {FONT_PACKED_MAGIC0, FONT_PACKED_MAGIC1, flags, (uint8_t)font.height,
+               (uint8_t)p.first, (uint8_t)p.count, (uint8_t)font.rows, (uint8_t)font.space};
+    if (p.sparse)
+    {
+        p.bytes.push_back(multiplier & 0xFF);
+        p.bytes.push_back(multiplier >> 8);
+    }
+    p.bytes.insert(p.bytes.end(), table.begin(), table.end());
+    p.bytes.insert(p.bytes.end(), data.begin(), data.end());
+    if (data.size() > (compress ? 0x7FFF : 0xFFFF) || (int)table.size() != p.count * entrySize)
+        p.bytes.clear();
+    return p;
+}
+
+static std::string charName(int c)
+{
+    char buf[16];
+    if (c == '\\' || c == '\'')
+        snprintf(buf, sizeof(buf), "'\\%c'", c);
+    else if (c > ' ' && c < 0x7f)
+        snprintf(buf, sizeof(buf), "'%c'", c);
+    else if (c < 0)
+        snprintf(buf, sizeof(buf), "empty");
+    else if (c > 0xFF)
+        snprintf(buf, sizeof(buf), "U+%04X", c);
+    else
+        snprintf(buf, sizeof(buf), "0x%02x", c);
+    return buf;
+}
+
+// Draw every glyph back with drawChar() and compare with the source
+static bool verify(const SourceFont &font, const Packed &p)
+{
+    canvas.selectFont(p.bytes.data());
+    canvas.flushGlyphCache(); // keyed by font address, which a freed font may have had
+    for (int c = 0; c < 0x10000; c++)
+    {
+        auto it = font.glyphs.find(c);
+        int expected = c == ' ' ? font.space : it == font.glyphs.end() ? 0 : it->second.advance;
+        int width = DMD::codePointWidth(p.bytes.data(), c);
+        if (width != expected)
+        {
+            fprintf(stderr, "char %s: charWidth %d, expected %d\n", charName(c).c_str(), width, expected);
+            return false;
+        }
+        if (it == font.glyphs.end())
+            continue;
+        canvas.clearScreen(true);
+        canvas.drawCodePoint(0, 0, c, GRAPHICS_NORMAL);
+        Frame all = frameFromDmd(canvas.shownFrame(), 2, 2);
+        for (int y = 0; y < all.height; y++)
+            for (int x = 0; x < all.width; x++)
+            {
+                bool want = x < it->second.advance && y < font.rows && (it->second.cols[x] >> y & 1);
+                if (all.at(x, y) != want)
+                {
+                    fprintf(stderr, "char %s: pixel %d,%d drawn %d, expected %d\n", charName(c).c_str(), x, y,
+                            all.at(x, y), want);
+                    return false;
+                }
+            }
+    }
+    return true;
+}
+
+// ------------------- Output -------------------
+static void writeHeader(FILE *out, const std::string &name, const SourceFont &font, const Packed &p,
+                        const std::string &command)
+{
+    const std::vector<uint8_t> &b = p.bytes;
+    bool bbox = b[FONT_PACKED_FLAGS] & FONT_PACKED_BBOX, compressed = b[FONT_PACKED_FLAGS] & FONT_PACKED_COMPRESSED;
+    int entrySize = (bbox ? 5 : 3) + (p.sparse ? 2 : 0);
+    size_t tableStart = p.sparse ? FONT_PACKED_HASH + 2 : FONT_PACKED_TABLE;
+    size_t dataStart = tableStart + p.count * entrySize;
+    char chars[64];
+    if (p.sparse)
+        snprintf(chars, sizeof(chars), "%zu code points in %d hash slots", font.glyphs.size(), p.count);
+    else
+        snprintf(chars, sizeof(chars), "chars %s..%s", charName(p.first).c_str(),
+                 charName(p.first + p.count - 1).c_str());
+    fprintf(out,
+            "/*--------------------------------------------------------------------------------------\n"
+            " %s - packed DMD32 font (FONT_PACKED_*, see DMD32.h), generated from\n"
+            " %s by tools/font-compiler. Do not edit; regenerate with\n"
+            "   %s\n"
+            " height %d, rows %d, %s, %d glyphs stored, %zu bytes%s\n"
+            "--------------------------------------------------------------------------------------*/\n"
+            "#pragma once\n"
+            "#include <Arduino.h>\n\n"
+            "static constexpr uint8_t %s[] PROGMEM = {\n",
+            name.c_str(), font.source.c_str(), command.c_str(), font.height, font.rows, chars, p.stored, b.size(),
+            compressed ? ", compressed" : bbox ? ", column ranges" : "", name.c_str());
+    fprintf(out, "    ");
+    for (int i = 0; i < FONT_PACKED_TABLE; i++)
+        fprintf(out, "0x%02X, ", b[i]);
+    fprintf(out, "// magic, flags, height, %s, rows, space\n", p.sparse ? "hash bits, slots" : "first, count");
+    if (p.sparse)
+        fprintf(out, "    0x%02X, 0x%02X, // hash multiplier\n", b[FONT_PACKED_HASH], b[FONT_PACKED_HASH + 1]);
+    fprintf(out, "    // %soffset, advance%s\n", p.sparse ? "code point, " : "", bbox ? ", first column, columns" : "");
+    for (int i = 0; i < p.count; i++)
+    {
+        fprintf(out, "    ");
+        for (int k = 0; k < entrySize; k++)
+            fprintf(out, "0x%02X, ", b[tableStart + i * entrySize + k]);
+        fprintf(out, "// %s\n", charName(p.codes[i]).c_str());
+    }
+    if (compressed)
+        fprintf(out, "    // glyph data: bit-packed, or nibble runs where the offset has bit 15 set\n");
+    else
+        fprintf(out, "    // column masks, %d byte%s per column, bit 0 = top row\n", (font.rows + 7) / 8,
+                font.rows > 8 ? "s" : "");
+    for (size_t i = dataStart; i < b.size(); i += 16)
+    {
+        fprintf(out, "   ");
+        for (size_t k = i; k < b.size() && k < i + 16; k++)
+            fprintf(out, " 0x%02X,", b[k]);
+        fprintf(out, "\n");
+    }
+    fprintf(out, "};\n");
+}
+
+// ------------------- Compare -------------------
+static uint32_t rng = 1;
+static uint8_t nextRandom()
+{
+    rng = rng * 1103515245 + 12345;
+    return rng >> 16;
+}
+
+// drawChar() with both fonts over the same random frame, at positions around every edge
+static long compareDrawing(const std::vector<uint8_t> &original, const Packed &p)
+{
+    static DMD a(2, 1), b(2, 1);
+    static const int xs[] = {-70, -9, -6, -5, -1, 0, 1, 7, 8, 30, 58, 59, 60, 63, 64, 65};
+    static const int ys[] = {-40, -17, -9, -8, -3, 0, 1, 7, 8, 9, 12, 15, 16, 17};
+    long mismatches = 0;
+    b.flushGlyphCache();
+    for (int c = 0; c < 256; c++)
+        for (int mode = 0; mode <= GRAPHICS_NOR + 1; mode++)
+            for (int x : xs)
+                for (int y : ys)
+                {
+                    uint8_t *fa = (uint8_t *)a.shownFrame(), *fb = (uint8_t *)b.shownFrame();
+                    for (int i = 0; i < a.frameBytes(); i++)
+                        fa[i] = fb[i] = nextRandom();
+                    a.selectFont(original.data());
+                    b.selectFont(p.bytes.data());
+                    int wa = a.drawChar(x, y, c, mode), wb = b.drawChar(x, y, c, mode);
+                    if (wa != wb || memcmp(fa, fb, a.frameBytes()) != 0)
+                    {
+                        if (!mismatches)
+                            fprintf(stderr, "char 0x%02x mode %d at %d,%d: returned %d/%d, frames %s\n", c, mode, x, y,
+                                    wa, wb, memcmp(fa, fb, a.frameBytes()) ? "differ" : "match");
+                        mismatches++;
+                    }
+                }
+    return mismatches;
+}
+
+static DMD timing(2, 1);
+
+// Fastest of five rounds of `batch` (which returns the characters it drew), in ns per character
+template <typename Batch>
+static double timeBest(Batch batch)
+{
+    double best = 1e30;
+    for (int round = 0; round < 5; round++)
+    {
+        long chars = 0;
+        auto start = std::chrono::steady_clock::now();
+        double ms = 0;
+        while (ms < COMPARE_MIN_MS / 5.0)
+        {
+            chars += batch();
+            ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        best = std::min(best, ms * 1e6 / chars);
+    }
+    return best;
+}
+
+// drawString() over strings the faces draw
+static double timeDrawString(const uint8_t *font)
+{
+    static const char *texts[] = {"12:34", "23:59:58", "MON 17", "0123456789", "Temp 23C", "The quick fox"};
+    timing.selectFont(font);
+    timing.flushGlyphCache();
+    return timeBest([&] {
+        long chars = 0;
+        for (int i = 0; i < 100; i++)
+            for (const char *t : texts)
+            {
+                timing.drawString(i % 8, i % 4, t, strlen(t), GRAPHICS_NORMAL);
+                chars += strlen(t);
+            }
+        return chars;
+    });
+}
+
+// drawChar() of the digits and colon, the glyphs a clock draws every second; `cold`
+// empties the glyph cache before each one
+static double timeGlyphs(const uint8_t *font, bool cold)
+{
+    timing.selectFont(font);
+    timing.flushGlyphCache();
+    return timeBest([&] {
+        for (int i = 0; i < 100; i++)
+            for (const char *c = "0123456789:"; *c; c++)
+            {
+                if (cold)
+                    timing.flushGlyphCache();
+                timing.drawChar(i % 8, i % 4, *c, GRAPHICS_NORMAL);
+            }
+        return 1100L;
+    });
+}
+
+// Glyph cache hit rate over a day of "HH:MM:SS" redrawn every second
+static double clockHitRate(const uint8_t *font)
+{
+    uint32_t hits0, misses0, hits, misses;
+    timing.selectFont(font);
+    timing.flushGlyphCache();
+    timing.glyphCacheStats(&hits0, &misses0);
+    for (long t = 0; t < 86400; t++)
+    {
+        char text[9];
+        snprintf(text, sizeof(text), "%02ld:%02ld:%02ld", t / 3600, t / 60 % 60, t % 60);
+        timing.drawString(0, 0, text, 8, GRAPHICS_NORMAL);
+    }
+    timing.glyphCacheStats(&hits, &misses);
+    return 100.0 * (hits - hits0) / std::max<uint32_t>(1, hits - hits0 + misses - misses0);
+}
+
+static int compare(const std::vector<std::string> &paths, const std::string &chars)
+{
+    int failures = 0;
+    printf("%-14s %-13s %7s %9s %9s %9s %11s\n", "font", "layout", "flash", "ns/char", "glyph", "cold", "mismatches");
+    for (const std::string &path : paths)
+    {
+        FontFile f;
+        SourceFont font;
+        std::string name;
+        if (!parseFont(path, f) || !loadFontCreator(path, font, name))
+        {
+            fprintf(stderr, "%s: not a FontCreator font\n", path.c_str());
+            failures++;
+            continue;
+        }
+        printf("%-14s %-13s %7zu %9.1f %9.1f %9s %11s\n", name.c_str(), "FontCreator", f.data.size(),
+               timeDrawString(f.data.data()), timeGlyphs(f.data.data(), false), "-", "-");
+        Packed compressed;
+        for (int layout = 0; layout < 3; layout++)
+        {
+            Packed p = pack(font, layout == 1, layout == 2);
+            long mismatches = compareDrawing(f.data, p);
+            failures += mismatches != 0;
+            char cold[16] = "-";
+            if (layout == 2)
+                snprintf(cold, sizeof(cold), "%.1f", timeGlyphs(p.bytes.data(), true));
+            printf("%-14s %-13s %7zu %9.1f %9.1f %9s %11ld\n", "",
+                   layout == 0 ? "packed" : layout == 1 ? "packed+bbox" : "compressed", p.bytes.size(),
+                   timeDrawString(p.bytes.data()), timeGlyphs(p.bytes.data(), false), cold, mismatches);
+            if (layout == 2)
+                compressed = p;
+        }
+        printf("%-14s compressed: %.2f%% glyph cache hits drawing HH:MM:SS every second for a day\n", "",
+               clockHitRate(compressed.bytes.data()));
+        // What a face that only draws `chars` would carry
+        std::vector<bool> keep;
+        if (chars.empty() || !parseChars(chars, keep))
+            continue;
+        for (auto it = font.glyphs.begin(); it != font.glyphs.end();)
+            it = keep[it->first] ? std::next(it) : font.glyphs.erase(it);
+        printf("%-14s %-13s %7zu  (packed+bbox), %zu (compressed)\n", "", ("\"" + chars + "\"").c_str(),
+               pack(font, true).bytes.size(), pack(font, false, true).bytes.size());
+    }
+    return failures ? 1 : 0;
+}
+
+// ------------------- Main -------------------
+static bool endsWith(const std::string &s, const char *tail)
+{
+    size_t n = strlen(tail);
+    return s.size() >= n && strcasecmp(s.c_str() + s.size() - n, tail) == 0;
+}
+
+static std::string baseName(const std::string &path)
+{
+    size_t slash = path.find_last_of('/');
+    std::string name = path.substr(slash == std::string::npos ? 0 : slash + 1);
+    name = name.substr(0, name.find('.'));
+    for (char &ch : name)
+        if (!isalnum((unsigned char)ch))
+            ch = '_';
+    if (name.empty() || isdigit((unsigned char)name[0]))
+        name = "Font" + name;
+    return name;
+}
+
+int main(int argc, char **argv)
+{
+    std::string input, name, output, chars;
+    int size = DEFAULT_SIZE;
+    bool bbox = false, compress = false, trim = false, sparse = false, comparing = false;
+    std::vector<std::string> paths;
+    std::string command = "font_compiler"; // for the header comment, without -o
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-o")
+            i++;
+        else
+            command += arg.find_first_of(" \"\\") == std::string::npos ? " " + arg : " '" + arg + "'";
+    }
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--bbox")
+            bbox = true;
+        else if (arg == "--compress")
+            compress = true;
+        else if (arg == "--trim")
+            trim = true;
+        else if (arg == "--sparse")
+            sparse = true;
+        else if (arg == "--compare")
+            comparing = true;
+        else if (arg == "--chars" && i + 1 < argc)
+            chars = argv[++i];
+        else if (arg == "--name" && i + 1 < argc)
+            name = argv[++i];
+        else if (arg == "--size" && i + 1 < argc)
+            size = atoi(argv[++i]);
+        else if (arg == "-o" && i + 1 < argc)
+            output = argv[++i];
+        else if (arg[0] == '-')
+        {
+            fprintf(stderr,
+                    "usage: %s font.bdf|font.ttf|font.h [--chars set] [--name name] [--size px] [--bbox] [--compress] "
+                    "[--trim] [--sparse] [-o out.h]\n"
+                    "       %s --compare [--chars set] fontcreator.h...\n",
+                    argv[0], argv[0]);
+            return 2;
+        }
+        else
+            paths.push_back(arg);
+    }
+    if (comparing)
+        return compare(paths, chars);
+    if (paths.size() != 1)
+    {
+        fprintf(stderr, "one input font\n");
+        return 2;
+    }
+    input = paths[0];
+
+    bool bdf = endsWith(input, ".bdf"), ttf = endsWith(input, ".ttf") || endsWith(input, ".otf");
+    std::vector<bool> keep;
+    if (!parseChars(!chars.empty() ? chars : bdf || ttf ? " -~" : "\x01-\xff", keep))
+    {
+        fprintf(stderr, "bad --chars %s\n", chars.c_str());
+        return 2;
+    }
+
+    SourceFont font;
+    std::string parsedName;
+    bool loaded;
+    if (bdf)
+        loaded = loadBdf(input, font);
+    else if (ttf)
+    {
+#ifdef FONTC_FREETYPE
+        loaded = loadTtf(input, size, keep, font);
+#else
+        (void)size;
+        fprintf(stderr, "%s: built without FreeType (-DFONTC_FREETYPE)\n", input.c_str());
+        return 2;
+#endif
+    }
+    else
+        loaded = loadFontCreator(input, font, parsedName);
+    if (!loaded)
+    {
+        fprintf(stderr, "%s: cannot read the font (or a glyph is over %d x %d)\n", input.c_str(), MAX_ADVANCE, MAX_ROWS);
+        return 1;
+    }
+    if (name.empty())
+        name = parsedName.empty() ? baseName(input) : parsedName + "P";
+
+    if (bdf && chars.empty() && !font.glyphs.empty() && font.glyphs.rbegin()->first > 0xFF)
+        keep.assign(0x10000, true); // a font made for code points past 0xFF, all of it
+    for (int c = 0; c < 0x10000 && !chars.empty(); c++)
+        if (keep[c] && c != ' ' && !font.glyphs.count(c))
+            fprintf(stderr, "%s: no glyph for %s\n", input.c_str(), charName(c).c_str());
+    for (auto it = font.glyphs.begin(); it != font.glyphs.end();)
+        it = keep[it->first] ? std::next(it) : font.glyphs.erase(it);
+    if (trim)
+        trimRows(font);
+
+    Packed p = pack(font, bbox, compress, sparse);
+    if (p.sparse && p.codes.empty())
+    {
+        fprintf(stderr, "%s: %zu glyphs, a sparse font holds at most %d\n", input.c_str(), font.glyphs.size(),
+                1 << MAX_SLOTS_BITS);
+        return 1;
+    }
+    if (p.bytes.empty())
+    {
+        fprintf(stderr, "%s: glyph data over %d KiB\n", input.c_str(), compress ? 32 : 64);
+        return 1;
+    }
+    if (p.tooBig)
+    {
+        fprintf(stderr, "%s: %d glyphs decode to more than GLYPH_CACHE_BYTES (%d)\n", input.c_str(), p.tooBig,
+                GLYPH_CACHE_BYTES);
+        return 1;
+    }
+    if (!verify(font, p))
+    {
+        fprintf(stderr, "%s: packed font does not draw like the source\n", input.c_str());
+        return 1;
+    }
+    FILE *out = output.empty() ? stdout : fopen(output.c_str(), "w");
+    if (!out)
+    {
+        perror(output.c_str());
+        return 2;
+    }
+    writeHeader(out, name, font, p, command);
+    if (out != stdout)
+        fclose(out);
+    fprintf(stderr, "%s: %d glyphs, %d rows, %zu bytes", name.c_str(), p.stored, font.rows, p.bytes.size());
+    if (p.sparse)
+        fprintf(stderr, " (%d code points hashed into %d slots)", (int)font.glyphs.size(), p.count);
+    else if (p.count > (int)font.glyphs.size())
+        fprintf(stderr, " (%d table entries for chars in between that are not kept)",
+                p.count - (int)font.glyphs.size());
+    fprintf(stderr, "\n");
+    return 0;
+}
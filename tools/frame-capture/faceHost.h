@@ -0,0 +1,47 @@
+/*--------------------------------------------------------------------------------------
+ faceHost.h - starts one clock face of the firmware on the host, for tools that include
+ src/main.cpp. Include it after main.cpp.
+--------------------------------------------------------------------------------------*/
+#pragma once
+
+// "YYYY-MM-DD HH:MM:SS"
+inline bool parseLocalTime(const char *text, DateTime &local)
+{
+    int y, mo, d, h, mi, s;
+    if (sscanf(text, "%d-%d-%d %d:%d:%d", &y, &mo, &d, &h, &mi, &s) != 6)
+        return false;
+    local = DateTime(y, mo, d, h, mi, s);
+    return true;
+}
+
+// The display half of setup(): time zone, render task, RTC set to `local`, I2C service and
+// face 1..8. The scan task, WiFi and the network services are left out. `utc` is what the
+// RTC was set to.
+inline bool startFace(int face, const char *tz, const DateTime &local, DateTime &utc)
+{
+    strncpy(tzString, tz, sizeof(tzString) - 1);
+    if (!tzParse(tzString, timeZone))
+    {
+        fprintf(stderr, "bad time zone %s\n", tz);
+        return false;
+    }
+
+    preferences.begin("clock-app", false);
+    preferences.putBool("rtcUtc", true);
+    xTaskCreatePinnedToCore(renderTask, "render", 4096, NULL, 1, &renderTaskHandle, 1);
+
+    i2cBusRecover();
+    if (!rtc.begin())
+        return false;
+    TzCache tzCache = {0};
+    utc = local - TimeSpan(tzOffsetForLocal(timeZone, tzCache, local.unixtime()));
+    rtc.adjust(utc);
+    if (!startI2cService())
+        return false;
+
+    RenderClient gfx;
+    gfx.clearScreen(true);
+    currentMode = face - 1;
+    changeClockMode(currentMode);
+    return true;
+}
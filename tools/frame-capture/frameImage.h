@@ -0,0 +1,398 @@
+/*--------------------------------------------------------------------------------------
+ frameImage.h - DMD framebuffer to image files, for host tools. No dependencies.
+
+   PBM (P1, one pixel per LED, 1 = lit)  readable text, used for golden images
+   PNG (scaled, LED look)                single frames for tickets
+   GIF (scaled, LED look, animated)      recordings; identical frames are merged
+--------------------------------------------------------------------------------------*/
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#define FRAME_PANEL_W 32
+#define FRAME_PANEL_H 16
+
+// 0 = gap between LEDs, 1 = LED off, 2 = LED lit
+static const uint8_t framePalette[4][3] = {{0x00, 0x00, 0x00}, {0x2A, 0x08, 0x04}, {0xFF, 0x30, 0x10}, {0x00, 0x00, 0x00}};
+
+struct Frame
+{
+    int width = 0, height = 0;
+    std::vector<uint8_t> lit; // row-major, 1 = lit
+
+    bool operator==(const Frame &o) const { return width == o.width && height == o.height && lit == o.lit; }
+    bool operator!=(const Frame &o) const { return !(*this == o); }
+    bool at(int x, int y) const { return lit[y * width + x]; }
+};
+
+// Decode a DMD32 buffer (see DMD::writePixel: 0 bit = lit, MSB = leftmost, panels side by side in each row)
+inline Frame frameFromDmd(const uint8_t *buf, int panelsWide, int panelsHigh)
+{
+    Frame f;
+    f.width = FRAME_PANEL_W * panelsWide;
+    f.height = FRAME_PANEL_H * panelsHigh;
+    f.lit.resize(f.width * f.height);
+    int stride = panelsWide * panelsHigh * FRAME_PANEL_W / 8;
+    for (int y = 0; y < f.height; y++)
+        for (int x = 0; x < f.width; x++)
+        {
+            int panel = x / FRAME_PANEL_W + panelsWide * (y / FRAME_PANEL_H);
+            int bx = x % FRAME_PANEL_W + panel * FRAME_PANEL_W;
+            int by = y % FRAME_PANEL_H;
+            f.lit[y * f.width + x] = !(buf[bx / 8 + by * stride] & (0x80 >> (bx & 7)));
+        }
+    return f;
+}
+
+// ------------------- PBM -------------------
+inline bool writePbm(const char *path, const Frame &f)
+{
+    FILE *fp = fopen(path, "w");
+    if (!fp)
+        return false;
+    fprintf(fp, "P1\n%d %d\n", f.width, f.height);
+    for (int y = 0; y < f.height; y++)
+    {
+        for (int x = 0; x < f.width; x++)
+            fputs(f.at(x, y) ? (x ? " 1" : "1") : (x ? " 0" : "0"), fp);
+        fputc('\n', fp);
+    }
+    return fclose(fp) == 0;
+}
+
+// P1 or P4
+inline bool readPbm(const char *path, Frame &f)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+        return false;
+    char magic[3] = {};
+    bool ok = fscanf(fp, "%2s", magic) == 1 && (!strcmp(magic, "P1") || !strcmp(magic, "P4"));
+    // Skip comments between header fields
+    auto number = [fp](int &v) {
+        int c;
+        while ((c = fgetc(fp)) != EOF)
+        {
+            if (c == '#')
+                while ((c = fgetc(fp)) != EOF && c != '\n')
+                    ;
+            else if (c > ' ')
+            {
+                ungetc(c, fp);
+                return fscanf(fp, "%d", &v) == 1;
+            }
+        }
+        return false;
+    };
+    ok = ok && number(f.width) && number(f.height) && f.width > 0 && f.height > 0;
+    if (ok)
+    {
+        f.lit.assign(f.width * f.height, 0);
+        if (magic[1] == '1')
+        {
+            for (size_t i = 0; ok && i < f.lit.size(); i++)
+            {
+                int c;
+                while ((c = fgetc(fp)) != EOF && c != '0' && c != '1')
+                    ;
+                ok = c != EOF;
+                f.lit[i] = c == '1';
+            }
+        }
+        else
+        {
+            fgetc(fp); // the single whitespace after the height
+            int rowBytes = (f.width + 7) / 8;
+            std::vector<uint8_t> row(rowBytes);
+            for (int y = 0; ok && y < f.height; y++)
+            {
+                ok = fread(row.data(), 1, rowBytes, fp) == (size_t)rowBytes;
+                for (int x = 0; ok && x < f.width; x++)
+                    f.lit[y * f.width + x] = (row[x / 8] >> (7 - x % 8)) & 1;
+            }
+        }
+    }
+    fclose(fp);
+    return ok;
+}
+
+// ------------------- Scaled rendering -------------------
+// Palette indices, `scale` image pixels per LED with a one-pixel gap from scale 3 up
+inline std::vector<uint8_t> frameRender(const Frame &f, int scale, int &w, int &h)
+{
+    if (scale < 1)
+        scale = 1;
+    w = f.width * scale;
+    h = f.height * scale;
+    int gap = scale >= 3 ? 1 : 0;
+    std::vector<uint8_t> out(w * h);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+        {
+            bool inGap = gap && (x % scale == scale - 1 || y % scale == scale - 1);
+            out[y * w + x] = inGap ? 0 : f.at(x / scale, y / scale) ? 2 : 1;
+        }
+    return out;
+}
+
+// ------------------- PNG -------------------
+inline uint32_t pngCrc(const uint8_t *data, size_t len, uint32_t crc = 0)
+{
+    static uint32_t table[256];
+    if (!table[1])
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+inline void pngPut32(std::vector<uint8_t> &v, uint32_t x)
+{
+    for (int i = 3; i >= 0; i--)
+        v.push_back(x >> (8 * i));
+}
+
+inline void pngChunk(FILE *fp, const char *type, const std::vector<uint8_t> &data)
+{
+    std::vector<uint8_t> c;
+    pngPut32(c, data.size());
+    c.insert(c.end(), type, type + 4);
+    c.insert(c.end(), data.begin(), data.end());
+    pngPut32(c, pngCrc(c.data() + 4, c.size() - 4));
+    fwrite(c.data(), 1, c.size(), fp);
+}
+
+// Palette PNG; the zlib stream uses stored (uncompressed) blocks, which every reader accepts
+inline bool writePng(const char *path, const Frame &f, int scale)
+{
+    int w, h;
+    std::vector<uint8_t> px = frameRender(f, scale, w, h);
+    FILE *fp = fopen(path, "wb");
+    if (!fp)
+        return false;
+    static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(sig, 1, 8, fp);
+
+    std::vector<uint8_t> ihdr;
+    pngPut32(ihdr, w);
+    pngPut32(ihdr, h);
+    ihdr.insert(ihdr.end(), {8, 3, 0, 0, 0}); // 8-bit palette
+    pngChunk(fp, "IHDR", ihdr);
+    std::vector<uint8_t> plte(&framePalette[0][0], &framePalette[0][0] + 9);
+    pngChunk(fp, "PLTE", plte);
+
+    std::vector<uint8_t> raw;
+    for (int y = 0; y < h; y++)
+    {
+        raw.push_back(0); // no filter
+        raw.insert(raw.end(), px.begin() + y * w, px.begin() + (y + 1) * w);
+    }
+    std::vector<uint8_t> z = {0x78, 0x01};
+    uint32_t a = 1, b = 0;
+    for (uint8_t c : raw)
+    {
+        a = (a + c) % 65521;
+        b = (b + a) % 65521;
+    }
+    for (size_t pos = 0; pos < raw.size() || pos == 0; pos += 65535)
+    {
+        size_t n = std::min<size_t>(65535, raw.size() - pos);
+        z.push_back(pos + n >= raw.size() ? 1 : 0);
+        z.insert(z.end(), {(uint8_t)n, (uint8_t)(n >> 8), (uint8_t)~n, (uint8_t)(~n >> 8)});
+        z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + n);
+    }
+    pngPut32(z, b << 16 | a);
+    pngChunk(fp, "IDAT", z);
+    pngChunk(fp, "IEND", {});
+    return fclose(fp) == 0;
+}
+
+// ------------------- GIF -------------------
+// Animated GIF, looping. A frame is written when the next different one arrives (or at
+// close), so runs of identical frames become one frame with a longer delay.
+class GifWriter
+{
+public:
+    bool open(const char *path, int scale)
+    {
+        fp = fopen(path, "wb");
+        this->scale = scale;
+        frames = 0;
+        return fp != nullptr;
+    }
+
+    // Add `f`, shown for `ms` milliseconds
+    void add(const Frame &f, unsigned ms)
+    {
+        if (pendingMs && f == pending)
+        {
+            pendingMs += ms;
+            return;
+        }
+        flush();
+        pending = f;
+        pendingMs = ms;
+    }
+
+    int close()
+    {
+        flush();
+        if (fp)
+        {
+            fputc(0x3B, fp);
+            fclose(fp);
+            fp = nullptr;
+        }
+        return frames;
+    }
+
+private:
+    void put16(unsigned v)
+    {
+        fputc(v & 0xFF, fp);
+        fputc(v >> 8, fp);
+    }
+
+    void flush()
+    {
+        if (!fp || !pendingMs)
+            return;
+        int w, h;
+        std::vector<uint8_t> px = frameRender(pending, scale, w, h);
+        if (frames == 0)
+        {
+            fwrite("GIF89a", 1, 6, fp);
+            put16(w);
+            put16(h);
+            fputc(0x91, fp); // global table of 4 colours
+            fputc(0, fp);
+            fputc(0, fp);
+            fwrite(framePalette, 1, sizeof(framePalette), fp);
+            static const uint8_t loop[] = {0x21, 0xFF, 0x0B, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0', 3, 1, 0, 0, 0};
+            fwrite(loop, 1, sizeof(loop), fp);
+        }
+        // Delays are in centiseconds; carry the rounding into the next frame
+        unsigned cs = (pendingMs + carryMs) / 10;
+        carryMs = (pendingMs + carryMs) % 10;
+        while (cs > 0xFFFF)
+        {
+            writeImage(px, w, h, 0xFFFF);
+            cs -= 0xFFFF;
+        }
+        writeImage(px, w, h, cs);
+        pendingMs = 0;
+    }
+
+    void writeImage(const std::vector<uint8_t> &px, int w, int h, unsigned cs)
+    {
+        static const uint8_t gce[] = {0x21, 0xF9, 4, 0};
+        fwrite(gce, 1, sizeof(gce), fp);
+        put16(cs);
+        fputc(0, fp);
+        fputc(0, fp);
+        fputc(0x2C, fp);
+        put16(0);
+        put16(0);
+        put16(w);
+        put16(h);
+        fputc(0, fp);
+
+        std::vector<uint8_t> data;
+        lzw(px, data);
+        fputc(MIN_CODE, fp);
+        for (size_t pos = 0; pos < data.size(); pos += 255)
+        {
+            size_t n = std::min<size_t>(255, data.size() - pos);
+            fputc(n, fp);
+            fwrite(data.data() + pos, 1, n, fp);
+        }
+        fputc(0, fp);
+        frames++;
+    }
+
+    static const int MIN_CODE = 2;
+
+    static void lzw(const std::vector<uint8_t> &px, std::vector<uint8_t> &out)
+    {
+        const int clear = 1 << MIN_CODE, end = clear + 1;
+        int codeSize = MIN_CODE + 1, next = end + 1;
+        std::unordered_map<uint32_t, int> dict;
+        uint32_t bitBuf = 0;
+        int bits = 0;
+        auto emit = [&](int code) {
+            bitBuf |= (uint32_t)code << bits;
+            bits += codeSize;
+            while (bits >= 8)
+            {
+                out.push_back(bitBuf & 0xFF);
+                bitBuf >>= 8;
+                bits -= 8;
+            }
+        };
+
+        emit(clear);
+        int prefix = px[0];
+        for (size_t i = 1; i < px.size(); i++)
+        {
+            uint32_t key = (uint32_t)prefix << 8 | px[i];
+            auto it = dict.find(key);
+            if (it != dict.end())
+            {
+                prefix = it->second;
+                continue;
+            }
+            emit(prefix);
+            if (next < 4095)
+            {
+                dict[key] = next++;
+                if (next > (1 << codeSize))
+                    codeSize++;
+            }
+            else
+            {
+                emit(clear); // table full: start over
+                dict.clear();
+                codeSize = MIN_CODE + 1;
+                next = end + 1;
+            }
+            prefix = px[i];
+        }
+        emit(prefix);
+        emit(end);
+        if (bits)
+            out.push_back(bitBuf & 0xFF);
+    }
+
+    FILE *fp = nullptr;
+    int scale = 1;
+    int frames = 0;
+    Frame pending;
+    unsigned pendingMs = 0;
+    unsigned carryMs = 0;
+};
+
+// ------------------- Text -------------------
+// For terminals and failure reports: '#' lit, '.' off
+inline std::string frameText(const Frame &f)
+{
+    std::string s;
+    for (int y = 0; y < f.height; y++)
+    {
+        for (int x = 0; x < f.width; x++)
+            s += f.at(x, y) ? '#' : '.';
+        s += '\n';
+    }
+    return s;
+}
@@ -0,0 +1,180 @@
+/*--------------------------------------------------------------------------------------
+ frame_capture - runs one clock face of the firmware on the host in virtual time and
+ saves what the panel showed: the last frame as PBM/PNG, the whole run as an animated
+ GIF. A minute of Clock3 rolling seconds or Clock7 scrolling takes milliseconds.
+
+ Build (Linux, from the repository root):
+   g++ -std=gnu++17 -O2 -pthread -Ilib/NativeShims/include -Ilib/DMD32-main/src -Isrc \
+       tools/frame-capture/frame_capture.cpp lib/DMD32-main/src/DMD32.cpp \
+       $(find lib/NativeShims/src -name '*.cpp' ! -name main.cpp) -o frame_capture
+
+ Run:
+   ./frame_capture --face 7 --run 60 --gif clock7.gif
+   ./frame_capture --face 3 --time "2026-12-31 23:59:58" --run 5 --png roll.png --pbm roll.pbm
+
+   --face N        ClockN, 1..8 (default 1)
+   --time T        local time at the start, "YYYY-MM-DD HH:MM:SS" (default 2025-12-31 23:59:30)
+   --tz SPEC       POSIX time zone (default TZ_DEFAULT)
+   --run S         seconds of virtual time to run (default 60)
+   --step MS       capture interval for the GIF (default 10, the GIF resolution)
+   --scale N       image pixels per LED for PNG/GIF (default 8)
+   --gif/--png/--pbm FILE
+   --golden FILE   compare the last frame with a PBM; exit 1 and print both if they differ
+   --update        (re)write the golden instead of comparing
+
+ golden/ holds the last frame of every face after 5 s from 2026-12-31 23:59:50. Check
+ them after a change to the display path, and add --update when a face changed on purpose:
+   for f in 1 2 3 4 5 6 7 8; do ./frame_capture --face $f --time "2026-12-31 23:59:50" \
+       --run 5 --golden tools/frame-capture/golden/clock$f.pbm; done
+
+ The firmware is compiled in as it is (src/main.cpp is included, one translation unit
+ like on the ESP32). Only the display path is started: render task, I2C/RTC service and
+ the face. The scan task, WiFi and the network services are left out.
+--------------------------------------------------------------------------------------*/
+#include <NativeTime.h>
+#include <unistd.h>
+#include <chrono>
+#include "main.cpp"
+#include "frameImage.h"
+#include "faceHost.h"
+
+struct CaptureOptions
+{
+    int face = 1;
+    const char *time = "2025-12-31 23:59:30";
+    const char *tz = TZ_DEFAULT;
+    double runS = 60;
+    int stepMs = 10;
+    int scale = 8;
+    const char *gif = nullptr;
+    const char *png = nullptr;
+    const char *pbm = nullptr;
+    const char *golden = nullptr;
+    bool update = false;
+};
+
+static void usage(const char *self)
+{
+    fprintf(stderr,
+            "usage: %s [--face 1-8] [--time \"YYYY-MM-DD HH:MM:SS\"] [--tz spec] [--run s] [--step ms]\n"
+            "          [--scale n] [--gif file] [--png file] [--pbm file] [--golden file [--update]]\n",
+            self);
+}
+
+static bool parseOptions(int argc, char **argv, CaptureOptions &o)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--update")
+        {
+            o.update = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+            return false;
+        const char *val = argv[++i];
+        if (arg == "--face")
+            o.face = atoi(val);
+        else if (arg == "--time")
+            o.time = val;
+        else if (arg == "--tz")
+            o.tz = val;
+        else if (arg == "--run")
+            o.runS = atof(val);
+        else if (arg == "--step")
+            o.stepMs = atoi(val);
+        else if (arg == "--scale")
+            o.scale = atoi(val);
+        else if (arg == "--gif")
+            o.gif = val;
+        else if (arg == "--png")
+            o.png = val;
+        else if (arg == "--pbm")
+            o.pbm = val;
+        else if (arg == "--golden")
+            o.golden = val;
+        else
+            return false;
+    }
+    return o.face >= 1 && o.face <= 8 && o.runS > 0 && o.stepMs > 0;
+}
+
+static int capture(const CaptureOptions &o)
+{
+    GifWriter gif;
+    if (o.gif && !gif.open(o.gif, o.scale))
+    {
+        perror(o.gif);
+        return 2;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    long runMs = (long)(o.runS * 1000);
+    Frame frame;
+    for (long t = 0; t < runMs; t += o.stepMs)
+    {
+        vTaskDelay(pdMS_TO_TICKS(o.stepMs)); // the firmware runs meanwhile
+        frame = frameFromDmd(dmd.shownFrame(), 1, 1);
+        if (o.gif)
+            gif.add(frame, o.stepMs);
+    }
+    double tookMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    fprintf(stderr, "Clock%d: %.1f s of virtual time in %.0f ms\n", o.face, o.runS, tookMs);
+
+    if (o.gif)
+        fprintf(stderr, "%s: %d frames\n", o.gif, gif.close());
+    if (o.png && !writePng(o.png, frame, o.scale))
+        perror(o.png);
+    if (o.pbm && !writePbm(o.pbm, frame))
+        perror(o.pbm);
+
+    if (!o.golden)
+        return 0;
+    if (o.update)
+    {
+        if (!writePbm(o.golden, frame))
+        {
+            perror(o.golden);
+            return 2;
+        }
+        fprintf(stderr, "%s: updated\n", o.golden);
+        return 0;
+    }
+    Frame expected;
+    if (!readPbm(o.golden, expected))
+    {
+        fprintf(stderr, "%s: cannot read golden image\n", o.golden);
+        return 2;
+    }
+    if (expected == frame)
+    {
+        fprintf(stderr, "%s: match\n", o.golden);
+        return 0;
+    }
+    fprintf(stderr, "%s: MISMATCH\nexpected:\n%sgot:\n%s", o.golden, frameText(expected).c_str(),
+            frameText(frame).c_str());
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    CaptureOptions o;
+    if (!parseOptions(argc, argv, o))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    DateTime local, utc;
+    if (!parseLocalTime(o.time, local))
+    {
+        fprintf(stderr, "bad --time %s\n", o.time);
+        return 2;
+    }
+    nativeVirtualTime();
+    int status = startFace(o.face, o.tz, local, utc) ? capture(o) : 2;
+    // The firmware's tasks never return; leave without running destructors under them
+    fflush(stdout);
+    fflush(stderr);
+    _exit(status);
+}
@@ -0,0 +1,119 @@
+/*--------------------------------------------------------------------------------------
+ mirror_decoder - shows the clock's framebuffer mirror (src/functions/mirror.h) in a
+ terminal. Listens for mirror packets on UDP, rebuilds each sender's frame and prints
+ it as text whenever it changes.
+
+ Build (Linux/macOS, from the repository root):
+   g++ -std=c++11 -O2 -Isrc/functions tools/mirror-decoder/mirror_decoder.cpp -o mirror_decoder
+
+ Run:
+   ./mirror_decoder [port]        (default 5005)
+
+ Turn the stream on with:  curl -d enabled=1 -d host=<this PC> http://<clock>/api/mirror
+ or leave host out to broadcast to the whole network.
+
+ A lost packet leaves a gap in the sequence; the sender's frame is then marked stale
+ and ignored until the next keyframe (at most MIRROR_KEYFRAME_MS later).
+--------------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <vector>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "frameCodec.h"
+
+#define PANEL_ROWS 16 // P10: 16 rows, 32 columns per panel
+#define DEFAULT_PORT 5005
+
+struct Source
+{
+    std::vector<uint8_t> frame;
+    uint16_t nextSeq;
+    bool synced;  // frame is complete and current
+    unsigned long packets, gaps, errors;
+};
+
+// One panel: byte x/8 + y*4, MSB = leftmost pixel, 0 bit = lit
+static void printFrame(const char *from, const Source &src)
+{
+    size_t stride = src.frame.size() / PANEL_ROWS;
+    printf("\x1b[H\x1b[2J%s  packets %lu  gaps %lu  errors %lu\n", from, src.packets, src.gaps, src.errors);
+    for (int y = 0; y < PANEL_ROWS; y++)
+    {
+        for (size_t x = 0; x < stride * 8; x++)
+        {
+            bool lit = !(src.frame[y * stride + x / 8] & (0x80 >> (x & 7)));
+            fputs(lit ? "##" : " .", stdout);
+        }
+        putchar('\n');
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    int port = argc > 1 ? atoi(argv[1]) : DEFAULT_PORT;
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+    {
+        perror("socket");
+        return 1;
+    }
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        perror("bind");
+        return 1;
+    }
+    fprintf(stderr, "Listening on UDP port %d\n", port);
+
+    std::map<uint32_t, Source> sources;
+    uint8_t pkt[2048];
+    for (;;)
+    {
+        sockaddr_in from;
+        socklen_t fromLen = sizeof(from);
+        ssize_t n = recvfrom(fd, pkt, sizeof(pkt), 0, (sockaddr *)&from, &fromLen);
+        if (n <= 0)
+            continue;
+
+        bool keyframe;
+        uint16_t seq, len;
+        if (!frameHeader(pkt, n, keyframe, seq, len) || len == 0 || len % PANEL_ROWS != 0)
+            continue; // not ours
+
+        Source &src = sources[from.sin_addr.s_addr];
+        src.packets++;
+        if (src.frame.size() != len)
+        {
+            src.frame.assign(len, 0xFF);
+            src.synced = false;
+        }
+        if (src.synced && seq != src.nextSeq)
+        {
+            src.gaps++;
+            src.synced = false;
+        }
+        src.nextSeq = seq + 1;
+        if (!keyframe && !src.synced)
+            continue; // wait for the next keyframe
+
+        if (!frameDecode(pkt, n, src.frame.data(), len))
+        {
+            src.errors++;
+            src.synced = false;
+            continue;
+        }
+        src.synced = true;
+        printFrame(inet_ntoa(from.sin_addr), src);
+    }
+}
@@ -0,0 +1,368 @@
+/*--------------------------------------------------------------------------------------
+ scan_sim - scan timing simulator for P10 panels. Runs the real DMD::scanDisplayBySPI()
+ on the host (lib/NativeShims) against a modelled SPI peripheral and GPIO timeline, and
+ reports what the panel would see: how long each of the four row phases is lit, the
+ refresh rate, the duty cycle of a row, latch ghosting and how much of core 1 the scan
+ takes.
+
+ Build (Linux, from the repository root):
+   g++ -std=gnu++17 -O2 -pthread -Ilib/NativeShims/include -Ilib/DMD32-main/src \
+       tools/scan-sim/scan_sim.cpp lib/DMD32-main/src/DMD32.cpp lib/NativeShims/src/arduino.cpp \
+       lib/NativeShims/src/freertos.cpp lib/NativeShims/src/sntp.cpp -o scan_sim
+
+ Run:
+   ./scan_sim [--panels 1,2,4|2x2] [--spi-hz 4e6,8e6] [options]    one row per combination
+
+ Model (times in ns, all overridable):
+   SPI byte      8 bits at the SPI clock + --byte-ns     (polled transfer(), CPU busy)
+   transaction   --txn-ns per beginTransaction()/endTransaction() pair
+   GPIO write    --gpio-ns per w1ts/w1tc store
+   call          --call-ns per scanDisplayBySPI() call (digitalRead of the foreign CS)
+ The scan is driven like refreshDisplay(): one call, then vTaskDelay(1), i.e. the next
+ call starts on the next --tick-hz tick. --timer-us N models a hardware timer ISR instead.
+
+ Output enable:
+   --oe pwm   (default) the firmware attaches PANEL_OE to LEDC, so the panel is lit while
+              the --pwm-hz PWM is high (--brightness/255 of the period); OE writes from
+              the scan macros do not reach the pin.
+   --oe gpio  stock DMD32: lit while the scan macros hold nOE high.
+
+ The defaults for the per-operation costs are estimates for an ESP32 at 240 MHz on the
+ Arduino core; calibrate them against a logic analyser trace before trusting absolute
+ numbers. Differences between configurations hold up without that.
+--------------------------------------------------------------------------------------*/
+#include <Arduino.h>
+#include <DMD32.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#define PHASES 4 // rows 1/5/9/13, 2/6/10/14, 3/7/11/15, 4/8/12/16
+
+struct Model
+{
+    double byteNs = 600;
+    double txnNs = 2000;
+    double gpioNs = 50;
+    double callNs = 300;
+    double spiHz = 0;   // 0 = whatever the library asks for
+    double tickHz = 1000;
+    double timerUs = 0; // 0 = tick driven
+    bool pwmOe = true;
+    double pwmHz = 1000;
+    int brightness = 255;
+    int frames = 2000;
+    bool verbose = false;
+};
+
+struct Report
+{
+    double simNs;
+    double busyNs;
+    uint32_t scans;
+    uint32_t overruns;      // timer mode: a scan ran into the next period
+    double litNs[PHASES];   // totals
+    double minFrame[PHASES], maxFrame[PHASES];
+    double ghostNs;         // lit while the latched data and the selected row disagree
+    uint32_t libraryClock;
+};
+
+// ------------------- Simulated time -------------------
+static Model model;
+static double simNs;
+static uint32_t pins;            // GPIO.out as the panel sees it
+static int latchedPhase = -1;    // rows whose data is in the output registers
+static uint32_t seenTransactions;
+static double frameLit[PHASES];
+static Report report;
+
+static int selectedPhase()
+{
+    return ((pins >> PIN_DMD_B) & 1) * 2 + ((pins >> PIN_DMD_A) & 1);
+}
+
+// Time the PWM output is high in [0, t)
+static double pwmHighBefore(double t)
+{
+    double period = 1e9 / model.pwmHz;
+    double high = period * model.brightness / 255.0;
+    double whole = floor(t / period);
+    return whole * high + std::min(t - whole * period, high);
+}
+
+// Move simulated time on by dt with the pins as they are now
+static void advance(double dt)
+{
+    if (dt <= 0)
+        return;
+    double lit;
+    if (model.pwmOe)
+        lit = pwmHighBefore(simNs + dt) - pwmHighBefore(simNs);
+    else
+        lit = (pins >> PIN_DMD_nOE) & 1 ? dt : 0;
+    if (latchedPhase >= 0 && lit > 0)
+    {
+        int row = selectedPhase();
+        frameLit[row] += lit;
+        report.litNs[row] += lit;
+        if (row != latchedPhase)
+            report.ghostNs += lit;
+    }
+    simNs += dt;
+}
+
+static void onSpiByte(uint8_t data, uint32_t clock)
+{
+    (void)data;
+    report.libraryClock = clock;
+    if (SPIClass::transactions != seenTransactions)
+    {
+        seenTransactions = SPIClass::transactions;
+        advance(model.txnNs);
+    }
+    double hz = model.spiHz > 0 ? model.spiHz : clock;
+    advance(8e9 / hz + model.byteNs);
+}
+
+static void onGpioWrite(uint32_t setMask, uint32_t clearMask)
+{
+    advance(model.gpioNs);
+    if (setMask & (1 << PIN_DMD_SCLK))
+        latchedPhase = report.scans % PHASES; // the rows just shifted out reach the outputs
+    pins = (pins | setMask) & ~clearMask;
+}
+
+// ------------------- Driver -------------------
+static void flushFrame(bool record)
+{
+    for (int p = 0; p < PHASES; p++)
+    {
+        if (record)
+        {
+            report.minFrame[p] = std::min(report.minFrame[p], frameLit[p]);
+            report.maxFrame[p] = std::max(report.maxFrame[p], frameLit[p]);
+        }
+        frameLit[p] = 0;
+    }
+}
+
+static Report simulate(int wide, int high)
+{
+    DMD dmd(wide, high);
+    dmd.drawTestPattern(PATTERN_ALT_0);
+
+    report = Report();
+    for (int p = 0; p < PHASES; p++)
+        report.minFrame[p] = 1e18;
+    simNs = 0;
+    pins = 0;
+    latchedPhase = -1;
+    seenTransactions = SPIClass::transactions;
+    flushFrame(false);
+    SPIClass::hook = onSpiByte;
+    gpio_dev_t::hook = onGpioWrite;
+
+    // One frame to settle, then count from the first scan of the next
+    const int warmup = PHASES;
+    double start = 0, busy = 0;
+    int total = warmup + model.frames * PHASES;
+    for (int i = 0; i < total; i++)
+    {
+        if (i % PHASES == 0)
+            flushFrame(i > warmup);
+        if (i == warmup)
+        {
+            start = simNs;
+            busy = report.busyNs;
+            for (int p = 0; p < PHASES; p++)
+                report.litNs[p] = 0;
+            report.ghostNs = 0;
+        }
+
+        double callStart = simNs;
+        advance(model.callNs);
+        dmd.scanDisplayBySPI();
+        report.scans++;
+        report.busyNs += simNs - callStart;
+
+        double next;
+        if (model.timerUs > 0)
+        {
+            double period = model.timerUs * 1000;
+            next = callStart + period;
+            if (simNs > next)
+            {
+                report.overruns++;
+                next = simNs;
+            }
+        }
+        else
+        {
+            double tick = 1e9 / model.tickHz;
+            next = (floor(simNs / tick) + 1) * tick; // vTaskDelay(1) wakes on the next tick
+        }
+        advance(next - simNs);
+    }
+    flushFrame(true);
+
+    SPIClass::hook = nullptr;
+    gpio_dev_t::hook = nullptr;
+    report.simNs = simNs - start;
+    report.busyNs -= busy;
+    report.scans -= warmup;
+    return report;
+}
+
+// ------------------- Output -------------------
+static void printHeader()
+{
+    printf("%-7s %10s %10s %10s %11s %9s %9s %10s %8s\n", "panels", "spi Hz", "scan us", "refresh Hz",
+           "on us/frame", "row duty", "balance", "ghost us", "CPU %");
+}
+
+static void printReport(int wide, int high, const Report &r)
+{
+    double frames = r.scans / (double)PHASES;
+    double scanUs = r.busyNs / r.scans / 1000;
+    double refreshHz = frames / (r.simNs / 1e9);
+    double lit = 0, least = 1e18, most = 0;
+    for (int p = 0; p < PHASES; p++)
+    {
+        lit += r.litNs[p];
+        least = std::min(least, r.litNs[p]);
+        most = std::max(most, r.litNs[p]);
+    }
+    double onUs = lit / PHASES / frames / 1000;      // one row's on-time per frame
+    double duty = lit / PHASES / r.simNs * 100;      // share of the time one row is lit
+    double balance = most > 0 ? least / most : 0;    // 1 = all four phases equally bright
+    double hz = model.spiHz > 0 ? model.spiHz : r.libraryClock;
+
+    printf("%dx%-5d %10.0f %10.1f %10.1f %11.1f %8.1f%% %9.3f %10.2f %7.1f%%", wide, high, hz, scanUs, refreshHz, onUs,
+           duty, balance, r.ghostNs / frames / 1000, r.busyNs / r.simNs * 100);
+    if (r.overruns)
+        printf("  %u overruns", r.overruns);
+    putchar('\n');
+
+    if (model.verbose)
+        for (int p = 0; p < PHASES; p++)
+            printf("    phase %d (rows %d,%d,%d,%d): %.1f us/frame, min %.1f max %.1f\n", p, p + 1, p + 5, p + 9, p + 13,
+                   r.litNs[p] / frames / 1000, r.minFrame[p] / 1000, r.maxFrame[p] / 1000);
+}
+
+// "1,2,4" or "2x2,4x1": panels across [x down]
+static std::vector<std::pair<int, int>> parsePanels(const char *s)
+{
+    std::vector<std::pair<int, int>> out;
+    std::string list = s;
+    size_t pos = 0;
+    while (pos <= list.size())
+    {
+        size_t end = list.find(',', pos);
+        std::string item = list.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        int w = 0, h = 1;
+        if (sscanf(item.c_str(), "%dx%d", &w, &h) >= 1 && w > 0 && h > 0)
+            out.push_back({w, h});
+        if (end == std::string::npos)
+            break;
+        pos = end + 1;
+    }
+    return out;
+}
+
+static std::vector<double> parseList(const char *s)
+{
+    std::vector<double> out;
+    for (const char *p = s; *p;)
+    {
+        char *end;
+        double v = strtod(p, &end);
+        if (end == p)
+            break;
+        out.push_back(v);
+        p = *end == ',' ? end + 1 : end;
+    }
+    return out;
+}
+
+static void usage(const char *self)
+{
+    fprintf(stderr,
+            "usage: %s [--panels 1,2,4|2x2] [--spi-hz list] [--frames n] [--tick-hz n | --timer-us n]\n"
+            "          [--oe pwm|gpio] [--pwm-hz n] [--brightness 0-255]\n"
+            "          [--byte-ns n] [--txn-ns n] [--gpio-ns n] [--call-ns n] [-v]\n",
+            self);
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::pair<int, int>> panels = {{1, 1}};
+    std::vector<double> clocks = {0};
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-v")
+        {
+            model.verbose = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        const char *val = argv[++i];
+        if (arg == "--panels")
+            panels = parsePanels(val);
+        else if (arg == "--spi-hz")
+            clocks = parseList(val);
+        else if (arg == "--frames")
+            model.frames = std::max(1, atoi(val));
+        else if (arg == "--tick-hz")
+            model.tickHz = atof(val);
+        else if (arg == "--timer-us")
+            model.timerUs = atof(val);
+        else if (arg == "--oe")
+            model.pwmOe = strcmp(val, "gpio") != 0;
+        else if (arg == "--pwm-hz")
+            model.pwmHz = atof(val);
+        else if (arg == "--brightness")
+            model.brightness = constrain(atoi(val), 0, 255);
+        else if (arg == "--byte-ns")
+            model.byteNs = atof(val);
+        else if (arg == "--txn-ns")
+            model.txnNs = atof(val);
+        else if (arg == "--gpio-ns")
+            model.gpioNs = atof(val);
+        else if (arg == "--call-ns")
+            model.callNs = atof(val);
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (panels.empty() || clocks.empty() || model.tickHz <= 0 || model.pwmHz <= 0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (model.timerUs > 0)
+        printf("Driven by a %.0f us timer", model.timerUs);
+    else
+        printf("Driven by vTaskDelay(1) at %.0f Hz", model.tickHz);
+    if (model.pwmOe)
+        printf(", OE from %.0f Hz PWM at %d/255\n", model.pwmHz, model.brightness);
+    else
+        printf(", OE from the scan macros\n");
+    printHeader();
+    for (auto &p : panels)
+        for (double hz : clocks)
+        {
+            model.spiHz = hz;
+            Report r = simulate(p.first, p.second);
+            printReport(p.first, p.second, r);
+        }
+    return 0;
+}